@@ -38,6 +38,12 @@
 using namespace caret;
 using namespace std;
 
+namespace
+{
+    const int MOVING_TILE = 16;//moving rows per parallel work item, and per reuse of a tile of cached rows
+    const int CHUNK_TILE = 32;//cached rows that are reused against all the moving rows in a work item, ~0.6MB at 4800 timepoints
+}
+
 AString AlgorithmCiftiCorrelation::getCommandSwitch()
 {
     return "-cifti-correlation";
@@ -216,6 +222,8 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
         CaretLogInfo("computing " + AString::number(numCacheRows) + " rows at a time, reading rows as needed during processing");
     }
     vector<CaretArray<float> > outRows;
+    vector<int> chunkIndices;
+    CaretArray<int> chunkReverse(numRows, -1);
     if (cacheFullInput)
     {
         for (int i = 0; i < numRows; ++i)
@@ -228,6 +236,7 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
         int endrow = startrow + numCacheRows;
         if (endrow > numRows) endrow = numRows;
         outRows.resize(endrow - startrow);
+        chunkIndices.resize(endrow - startrow);
         for (int i = startrow; i < endrow; ++i)
         {
             if (!cacheFullInput)
@@ -238,41 +247,14 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
             {
                 outRows[i - startrow] = CaretArray<float>(numRows);
             }
+            chunkIndices[i - startrow] = i;
+            chunkReverse[i] = i - startrow;
         }
-        int curRow = 0;//because we can't trust the order threads hit the critical section
-#pragma omp CARET_PARFOR schedule(dynamic)
-        for (int i = 0; i < numRows; ++i)
-        {
-            float movingRrs;
-            int myrow;
-            const float* movingRow;
-#pragma omp critical
-            {//CiftiFile may explode if we request multiple rows concurrently (needs mutexes), but we should force sequential requests anyway
-                myrow = curRow;//so, manually force it to read sequentially
-                ++curRow;
-                movingRow = getRow(myrow, movingRrs);
-            }
-            for (int j = startrow; j < endrow; ++j)
-            {
-                if (myrow >= startrow && myrow < endrow)//check whether we are in the output memory area
-                {
-                    if (j >= myrow)//if so, only compute one half, and store both places
-                    {
-                        float cacheRrs;
-                        const float* cacheRow = getRow(j, cacheRrs, true);
-                        outRows[j - startrow][myrow] = correlate(movingRow, movingRrs, cacheRow, cacheRrs, fisherZ);
-                        outRows[myrow - startrow][j] = outRows[j - startrow][myrow];
-                    }
-                } else {
-                    float cacheRrs;
-                    const float* cacheRow = getRow(j, cacheRrs, true);
-                    outRows[j - startrow][myrow] = correlate(movingRow, movingRrs, cacheRow, cacheRrs, fisherZ);
-                }
-            }
-        }
+        processChunk(chunkIndices, chunkReverse, outRows, fisherZ);
         for (int i = startrow; i < endrow; ++i)
         {
             myCiftiOut->setRow(outRows[i - startrow], i);
+            chunkReverse[i] = -1;
         }
         if (!cacheFullInput)
         {
@@ -402,6 +384,8 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
         CaretLogInfo("computing " + AString::number(numCacheRows) + " rows at a time, reading rows as needed during processing");
     }
     vector<CaretArray<float> > outRows;
+    vector<int> chunkIndices;
+    CaretArray<int> chunkReverse(numRows, -1);
     if (cacheFullInput)
     {
         for (int i = 0; i < numRows; ++i)
@@ -409,13 +393,12 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
             cacheRow(i);
         }
     }
-    CaretArray<int> indexReverse(numRows, -1);
     for (int startrow = 0; startrow < numSelected; startrow += numCacheRows)
     {
         int endrow = startrow + numCacheRows;
         if (endrow > numSelected) endrow = numSelected;
         outRows.resize(endrow - startrow);
-        int curRow = 0;//because we can't trust the order threads hit the critical section
+        chunkIndices.resize(endrow - startrow);
         for (int i = startrow; i < endrow; ++i)
         {
             if (!cacheFullInput)
@@ -426,42 +409,14 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
             {
                 outRows[i - startrow] = CaretArray<float>(numRows);
             }
-            indexReverse[ciftiIndexList[i].first] = i;
-        }
-#pragma omp CARET_PARFOR schedule(dynamic)
-        for (int i = 0; i < numRows; ++i)
-        {
-            float movingRrs;
-            int myrow;
-            const float* movingRow;
-#pragma omp critical
-            {//CiftiFile may explode if we request multiple rows concurrently (needs mutexes), but we should force sequential requests anyway
-                myrow = curRow;//so, manually force it to read sequentially
-                ++curRow;
-                movingRow = getRow(myrow, movingRrs);
-            }
-            for (int j = startrow; j < endrow; ++j)
-            {
-                if (indexReverse[myrow] != -1)//check if we are on a row that is in the output memory range
-                {
-                    if (indexReverse[myrow] <= j)//if so, only compute one of the elements, then store it both places
-                    {
-                        float cacheRrs;
-                        const float* cacheRow = getRow(ciftiIndexList[j].first, cacheRrs, true);
-                        outRows[j - startrow][myrow] = correlate(movingRow, movingRrs, cacheRow, cacheRrs, fisherZ);
-                        outRows[indexReverse[myrow] - startrow][ciftiIndexList[j].first] = outRows[j - startrow][myrow];
-                    }
-                } else {
-                    float cacheRrs;
-                    const float* cacheRow = getRow(ciftiIndexList[j].first, cacheRrs, true);
-                    outRows[j - startrow][myrow] = correlate(movingRow, movingRrs, cacheRow, cacheRrs, fisherZ);
-                }
-            }
+            chunkIndices[i - startrow] = ciftiIndexList[i].first;
+            chunkReverse[ciftiIndexList[i].first] = i - startrow;
         }
+        processChunk(chunkIndices, chunkReverse, outRows, fisherZ);
         for (int i = startrow; i < endrow; ++i)
         {
             myCiftiOut->setRow(outRows[i - startrow], ciftiIndexList[i].second);
-            indexReverse[ciftiIndexList[i].first] = -1;
+            chunkReverse[ciftiIndexList[i].first] = -1;
         }
         if (!cacheFullInput)
         {
@@ -517,17 +472,96 @@ AlgorithmCiftiCorrelation::AlgorithmCiftiCorrelation(ProgressObject* myProgObj,
     AlgorithmCiftiCorrelation(myProgObj, myCifti, myCiftiOut, leftRoiPtr, rightRoiPtr, cerebRoiPtr, volRoiPtr, weights, fisherZ, memLimitGB, noDemean, covariance);//HACK: pass through our progress object
 }
 
-float AlgorithmCiftiCorrelation::correlate(const float* row1, const float& rrs1, const float* row2, const float& rrs2, const bool& fisherZ)
+void AlgorithmCiftiCorrelation::processChunk(const vector<int>& chunkIndices, const CaretArray<int>& chunkReverse, vector<CaretArray<float> >& outRows, const bool& fisherZ)
+{//chunkIndices are the cifti rows of the output rows currently in memory, which must be cached, chunkReverse maps a cifti row to its position in the chunk, or -1
+    const int numRows = m_inputCifti->getNumberOfRows();
+    const int chunkSize = (int)chunkIndices.size();
+    const int dotLength = (m_weightedMode ? (int)m_weightIndexes.size() : m_numCols);//because we compacted the data in the row to not include any zero weights
+    vector<const float*> chunkRows(chunkSize), bandRows;
+    vector<float> chunkRrs(chunkSize), bandRrs;
+    for (int p = 0; p < chunkSize; ++p)
+    {
+        chunkRows[p] = getRow(chunkIndices[p], chunkRrs[p]);
+    }
+    for (int bandStart = 0; bandStart < numRows; bandStart += m_bandSize)
+    {
+        int bandEnd = min(bandStart + m_bandSize, numRows);
+        int bandCount = bandEnd - bandStart;
+        bandRows.resize(bandCount);
+        bandRrs.resize(bandCount);
+        for (int i = bandStart; i < bandEnd; ++i)
+        {//read the moving rows sequentially, outside the parallel region
+            float* scratchRow = NULL;
+            if (m_rowInfo[i].m_cacheIndex == -1) scratchRow = getBandRow(i - bandStart);//cached rows don't need scratch space
+            bandRows[i - bandStart] = getRow(i, bandRrs[i - bandStart], scratchRow);
+        }
+        int numMovingTiles = (bandCount + MOVING_TILE - 1) / MOVING_TILE;
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int tile = 0; tile < numMovingTiles; ++tile)
+        {
+            int tileStart = tile * MOVING_TILE;
+            int tileEnd = min(tileStart + MOVING_TILE, bandCount);
+            for (int chunkTileStart = 0; chunkTileStart < chunkSize; chunkTileStart += CHUNK_TILE)
+            {//use a tile of chunk rows against all moving rows in this tile while it is still in cache
+                int chunkTileEnd = min(chunkTileStart + CHUNK_TILE, chunkSize);
+                for (int m = tileStart; m < tileEnd; m += 2)
+                {
+                    int numMoving = min(2, tileEnd - m);
+                    const float* a[2] = { bandRows[m], bandRows[m + numMoving - 1] };//duplicate the last row in a partial block, and ignore the extra results
+                    int movingRow[2] = { bandStart + m, bandStart + m + numMoving - 1 };
+                    for (int p = chunkTileStart; p < chunkTileEnd; p += 4)
+                    {
+                        int numChunk = min(4, chunkTileEnd - p);
+                        bool needed = false;
+                        for (int i = 0; i < numMoving; ++i)
+                        {//in the output memory area, only compute one half, and store both places
+                            int reverse = chunkReverse[movingRow[i]];
+                            if (reverse == -1 || reverse <= p + numChunk - 1) needed = true;
+                        }
+                        if (!needed) continue;
+                        const float* b[4];
+                        for (int q = 0; q < 4; ++q)
+                        {
+                            b[q] = chunkRows[p + min(q, numChunk - 1)];
+                        }
+                        double accum[8];
+                        sddot2x4(a, b, dotLength, accum);
+                        for (int i = 0; i < numMoving; ++i)
+                        {
+                            int myrow = movingRow[i];
+                            int reverse = chunkReverse[myrow];
+                            for (int q = 0; q < numChunk; ++q)
+                            {
+                                int pos = p + q;
+                                if (reverse != -1)//check whether we are in the output memory area
+                                {
+                                    if (reverse <= pos)
+                                    {
+                                        outRows[pos][myrow] = finishCorrelation(accum[4 * i + q], bandRrs[m + i], chunkRrs[pos], myrow == chunkIndices[pos], fisherZ);
+                                        outRows[reverse][chunkIndices[pos]] = outRows[pos][myrow];
+                                    }
+                                } else {
+                                    outRows[pos][myrow] = finishCorrelation(accum[4 * i + q], bandRrs[m + i], chunkRrs[pos], false, fisherZ);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+float AlgorithmCiftiCorrelation::finishCorrelation(const double& accum, const float& rrs1, const float& rrs2, const bool& sameRow, const bool& fisherZ)
 {
     double r;
-    if (row1 == row2 && !m_covariance)
+    if (sameRow && !m_covariance)
     {
         r = 1.0;//short circuit for same row
     } else {
         if (m_weightedMode)
         {
-            int numWeights = (int)m_weightIndexes.size();//because we compacted the data in the row to not include any zero weights
-            double accum = sddot(row1, row2, numWeights);//these have already had the weighted row means subtracted out, and weights applied
+            int numWeights = (int)m_weightIndexes.size();
             if (m_covariance)
             {
                 if (m_binaryWeights)
@@ -537,15 +571,14 @@ float AlgorithmCiftiCorrelation::correlate(const float* row1, const float& rrs1,
                     r = accum / rrs1;//NOTE: will equal rrs2 as it only depends on weights, and is not square root
                 }
             } else {
-                r = accum / (rrs1 * rrs2);//as do these
+                r = accum / (rrs1 * rrs2);//these have already had the weighted row means subtracted out, and weights applied
             }
         } else {
-            double accum = sddot(row1, row2, m_numCols);//these have already had the row means subtracted out
             if (m_covariance)
             {
                 r = accum / m_numCols;
             } else {
-                r = accum / (rrs1 * rrs2);
+                r = accum / (rrs1 * rrs2);//these have already had the row means subtracted out
             }
         }
     }
@@ -572,6 +605,11 @@ void AlgorithmCiftiCorrelation::init(const CiftiFile* input, const vector<float>
     m_rowInfo.resize(m_inputCifti->getNumberOfRows());
     m_cacheUsed = 0;
     m_numCols = m_inputCifti->getNumberOfColumns();
+#ifdef CARET_OMP
+    m_bandSize = MOVING_TILE * 4 * omp_get_max_threads();//enough moving rows per band to keep all threads busy between sequential reads
+#else
+    m_bandSize = MOVING_TILE * 4;
+#endif
     if (weights != NULL)
     {
         m_weightedMode = true;
@@ -638,7 +676,7 @@ void AlgorithmCiftiCorrelation::clearCache()
     m_cacheUsed = 0;
 }
 
-const float* AlgorithmCiftiCorrelation::getRow(const int& ciftiIndex, float& rootResidSqr, const bool& mustBeCached)
+const float* AlgorithmCiftiCorrelation::getRow(const int& ciftiIndex, float& rootResidSqr, float* scratchRow)
 {
     float* ret;
     CaretAssertVectorIndex(m_rowInfo, ciftiIndex);
@@ -646,12 +684,12 @@ const float* AlgorithmCiftiCorrelation::getRow(const int& ciftiIndex, float& roo
     {
         ret = m_rowCache[m_rowInfo[ciftiIndex].m_cacheIndex].m_row.data();
     } else {
-        CaretAssert(!mustBeCached);
-        if (mustBeCached)//largely so it doesn't give warning about unused when compiled in release
+        CaretAssert(scratchRow != NULL);
+        if (scratchRow == NULL)//largely so it doesn't give warning about unused when compiled in release
         {
             throw AlgorithmException("something very bad happened, notify the developers");
         }
-        ret = getTempRow();
+        ret = scratchRow;
         m_inputCifti->getRow(ret, ciftiIndex);
         if (!m_rowInfo[ciftiIndex].m_haveCalculated)
         {
@@ -769,28 +807,19 @@ void AlgorithmCiftiCorrelation::doSubtract(float* row, const float& mean)
     }
 }
 
-float* AlgorithmCiftiCorrelation::getTempRow()
+float* AlgorithmCiftiCorrelation::getBandRow(const int& bandIndex)
 {
-#ifdef CARET_OMP
-    int oldsize = (int)m_tempRows.size();
-    int threadNum = omp_get_thread_num();
-    if (threadNum >= oldsize)
+    CaretAssert(bandIndex >= 0 && bandIndex < m_bandSize);
+    int oldsize = (int)m_bandRows.size();
+    if (bandIndex >= oldsize)
     {
-        m_tempRows.resize(threadNum + 1);
-        for (int i = oldsize; i <= threadNum; ++i)
+        m_bandRows.resize(bandIndex + 1);
+        for (int i = oldsize; i <= bandIndex; ++i)
         {
-            m_tempRows[i] = CaretArray<float>(m_numCols);
+            m_bandRows[i] = CaretArray<float>(m_numCols);
         }
     }
-    return m_tempRows[threadNum].getArray();
-#else
-    if (m_tempRows.size() == 0)
-    {
-        m_tempRows.resize(1);
-        m_tempRows[0] = CaretArray<float>(m_numCols);
-    }
-    return m_tempRows[0].getArray();
-#endif
+    return m_bandRows[bandIndex].getArray();
 }
 
 int AlgorithmCiftiCorrelation::numRowsForMem(const float& memLimitGB, bool& cacheFullInput)
@@ -799,11 +828,6 @@ int AlgorithmCiftiCorrelation::numRowsForMem(const float& memLimitGB, bool& cach
     int inrowBytes = m_numCols * sizeof(float), outrowBytes = numRows * sizeof(float);
     int64_t targetBytes = (int64_t)(memLimitGB * 1024 * 1024 * 1024);
     if (m_inputCifti->isInMemory()) targetBytes -= numRows * m_numCols * 4;//count in-memory input against the total too
-#ifdef CARET_OMP
-    targetBytes -= inrowBytes * omp_get_max_threads();
-#else
-    targetBytes -= inrowBytes;//1 row in memory that isn't a reference to cache
-#endif
     targetBytes -= numRows * sizeof(RowInfo);//storage for mean, stdev, and info about caching
     int64_t perRowBytes = inrowBytes + outrowBytes;//cache and memory collation for output rows
     if (numRows * m_numCols * 4 < targetBytes * 0.7f)//if caching the entire input file would take less than 70% of remaining allotted memory, do it to reduce IO
@@ -813,6 +837,7 @@ int AlgorithmCiftiCorrelation::numRowsForMem(const float& memLimitGB, bool& cach
         perRowBytes = outrowBytes;//don't need to count input rows against the remaining memory total
     } else {
         cacheFullInput = false;
+        targetBytes -= (int64_t)inrowBytes * min(m_bandSize, numRows);//band of moving rows that aren't a reference to cache
     }
     if (perRowBytes == 0) return 1;//protect against integer div by zero
     int ret = targetBytes / perRowBytes;//integer divide rounds down
@@ -29,12 +29,54 @@
 #include "ReductionOperation.h"
 #include "SurfaceFile.h"
 
+#include <algorithm>
 #include <cmath>
 #include <map>
 
 using namespace caret;
 using namespace std;
 
+namespace
+{
+    void addParcelRow(vector<vector<float> >& parcelRef, const float* rowData, const int64_t& numCols, const bool& isLabel)
+    {
+        for (int64_t j = 0; j < numCols; ++j)
+        {
+            if (isLabel)
+            {
+                parcelRef[j].push_back(floor(rowData[j] + 0.5f));//round to nearest integer to be safe
+            } else {
+                parcelRef[j].push_back(rowData[j]);
+            }
+        }
+    }
+    
+    //parcellating a 2D file along column needs every row that is in a parcel, so fetch them with getRows in batches, which turns runs of adjacent rows into single reads
+    void addParcelRows2D(vector<vector<vector<float> > >& parcelData, const CiftiFile* myCiftiIn, const vector<int>& indexToParcel, const bool& isLabel)
+    {
+        const int64_t numCols = myCiftiIn->getNumberOfColumns();
+        vector<int64_t> rowList;
+        for (int64_t i = 0; i < (int64_t)indexToParcel.size(); ++i)
+        {
+            if (indexToParcel[i] != -1) rowList.push_back(i);
+        }
+        const int64_t numRows = (int64_t)rowList.size();
+        if (numRows == 0) return;
+        const int64_t batchSize = max((int64_t)1, min(numRows, (int64_t)(1 << 26) / (numCols * (int64_t)sizeof(float))));//64MB of rows at a time
+        vector<float> batchData(batchSize * numCols);
+        for (int64_t batchStart = 0; batchStart < numRows; batchStart += batchSize)
+        {
+            int64_t batchEnd = min(batchStart + batchSize, numRows);
+            vector<int64_t> batchRows(rowList.begin() + batchStart, rowList.begin() + batchEnd);
+            myCiftiIn->getRows(batchData.data(), batchRows);
+            for (int64_t i = 0; i < batchEnd - batchStart; ++i)
+            {//rows are added in increasing index order, same as reading them one at a time
+                addParcelRow(parcelData[indexToParcel[batchRows[i]]], batchData.data() + i * numCols, numCols, isLabel);
+            }
+        }
+    }
+}
+
 AString AlgorithmCiftiParcellate::getCommandSwitch()
 {
     return "-cifti-parcellate";
@@ -410,22 +452,18 @@ AlgorithmCiftiParcellate::AlgorithmCiftiParcellate(ProgressObject* myProgObj, co
                     parcelData[i][j].clear();//doesn't change allocation
                 }
             }
-            for (int64_t i = 0; i < dims[direction]; ++i)
+            if (dims.size() == 2)
             {
-                int parcel = indexToParcel[i];
-                if (parcel != -1)
+                addParcelRows2D(parcelData, myCiftiIn, indexToParcel, isLabel);
+            } else {
+                for (int64_t i = 0; i < dims[direction]; ++i)
                 {
-                    indices[direction - 1] = i;
-                    myCiftiIn->getRow(scratchRow.data(), indices);
-                    vector<vector<float> >& parcelRef = parcelData[parcel];
-                    for (int j = 0; j < numCols; ++j)
+                    int parcel = indexToParcel[i];
+                    if (parcel != -1)
                     {
-                        if (isLabel)
-                        {
-                            parcelRef[j].push_back(floor(scratchRow[j] + 0.5f));
-                        } else {
-                            parcelRef[j].push_back(scratchRow[j]);
-                        }
+                        indices[direction - 1] = i;
+                        myCiftiIn->getRow(scratchRow.data(), indices);
+                        addParcelRow(parcelData[parcel], scratchRow.data(), numCols, isLabel);
                     }
                 }
             }
@@ -609,22 +647,18 @@ namespace
                         parcelData[i][j].clear();//doesn't change allocation
                     }
                 }
-                for (int64_t i = 0; i < dims[direction]; ++i)
+                if (dims.size() == 2)
                 {
-                    int parcel = indexToParcel[i];
-                    if (parcel != -1)
+                    addParcelRows2D(parcelData, myCiftiIn, indexToParcel, isLabel);
+                } else {
+                    for (int64_t i = 0; i < dims[direction]; ++i)
                     {
-                        indices[direction - 1] = i;
-                        myCiftiIn->getRow(scratchRow.data(), indices);
-                        vector<vector<float> >& parcelRef = parcelData[parcel];
-                        for (int j = 0; j < numCols; ++j)
+                        int parcel = indexToParcel[i];
+                        if (parcel != -1)
                         {
-                            if (isLabel)
-                            {
-                                parcelRef[j].push_back(floor(scratchRow[j] + 0.5f));
-                            } else {
-                                parcelRef[j].push_back(scratchRow[j]);
-                            }
+                            indices[direction - 1] = i;
+                            myCiftiIn->getRow(scratchRow.data(), indices);
+                            addParcelRow(parcelData[parcel], scratchRow.data(), numCols, isLabel);
                         }
                     }
                 }
@@ -22,10 +22,13 @@
 #include "AlgorithmException.h"
 #include "CaretAssert.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "CiftiFile.h"
 #include "MultiDimIterator.h"
 #include "ReductionOperation.h"
 
+#include <algorithm>
+#include <exception>
 #include <vector>
 
 using namespace caret;
@@ -92,119 +95,147 @@ void AlgorithmCiftiReduce::useParameters(OperationParameters* myParams, Progress
     }
 }
 
-AlgorithmCiftiReduce::AlgorithmCiftiReduce(ProgressObject* myProgObj, const CiftiFile* ciftiIn, const ReductionEnum::Enum& myReduce, CiftiFile* ciftiOut,
-                                           const bool& onlyNumeric, const int& direction) : AbstractAlgorithm(myProgObj)
+namespace
 {
-    LevelProgress myProgress(myProgObj);
-    CaretAssert(direction >= 0);
-    const CiftiXML& inputXML = ciftiIn->getCiftiXML();
-    CiftiXML myOutXML = inputXML;
-    if (direction >= myOutXML.getNumberOfDimensions()) throw AlgorithmException("specified reduction direction doesn't exist in input cifti file");
-    CiftiScalarsMap newMap;
-    newMap.setLength(1);
-    newMap.setMapName(0, ReductionEnum::toName(myReduce));
-    myOutXML.setMap(direction, newMap);
-    ciftiOut->setCiftiXML(myOutXML);
-    vector<int64_t> inDims = inputXML.getDimensions();
-    if (direction == CiftiXML::ALONG_ROW)
+    const int64_t ROW_BLOCK_FLOATS = 1 << 24;//how much input to read before reducing it in parallel, 64MB
+    
+    struct ReduceSettings
+    {
+        ReductionEnum::Enum type;
+        bool onlyNumeric, excludeDev;
+        float sigmaBelow, sigmaAbove;
+    };
+    
+    float reduceOne(const float* data, const int64_t& numElems, const ReduceSettings& settings)
     {
-        vector<float> scratchInRow(inDims[0]);
-        for (MultiDimIterator<int64_t> iter(vector<int64_t>(inDims.begin() + 1, inDims.end())); !iter.atEnd(); ++iter)
-        {// + 1 to exclude row dimension, because getRow/setRow
-            ciftiIn->getRow(scratchInRow.data(), *iter);
-            float result = -1;
-            if (onlyNumeric)
+        if (settings.excludeDev) return ReductionOperation::reduceExcludeDev(data, numElems, settings.type, settings.sigmaBelow, settings.sigmaAbove);
+        if (settings.onlyNumeric) return ReductionOperation::reduceOnlyNumeric(data, numElems, settings.type);
+        return ReductionOperation::reduce(data, numElems, settings.type);
+    }
+    
+    //reduce numArrays contiguous arrays of the same length, in parallel
+    void reduceMany(const float* data, const int64_t& arrayLength, const int64_t& numArrays, float* resultsOut, const ReduceSettings& settings)
+    {
+        bool failed = false;
+        AString errorMessage;
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int64_t i = 0; i < numArrays; ++i)
+        {
+            try
             {
-                result = ReductionOperation::reduceOnlyNumeric(scratchInRow.data(), inDims[0], myReduce);
-            } else {
-                result = ReductionOperation::reduce(scratchInRow.data(), inDims[0], myReduce);
+                resultsOut[i] = reduceOne(data + i * arrayLength, arrayLength, settings);
+            } catch (CaretException& e) {//exceptions can't leave a parallel region
+#pragma omp critical
+                {
+                    failed = true;
+                    errorMessage = e.whatString();
+                }
+            } catch (std::exception& e) {
+#pragma omp critical
+                {
+                    failed = true;
+                    errorMessage = AString("exception during reduction: ") + e.what();
+                }
+            } catch (...) {
+#pragma omp critical
+                {
+                    failed = true;
+                    errorMessage = "unknown exception during reduction";
+                }
             }
-            ciftiOut->setRow(&result, *iter);//if reducing along row, length of output row is 1
         }
-    } else {
-        vector<vector<float> > scratchInRows(inDims[direction], vector<float>(inDims[0]));
-        vector<float> outRow(inDims[0]), reduceScratch(inDims[direction]);//reduction isn't along row, so out rows will be same length as in rows
-        vector<int64_t> otherDims = inDims;
-        otherDims.erase(otherDims.begin() + direction);//direction isn't 0
-        otherDims.erase(otherDims.begin());//remove row direction because getRow/setRow
-        for (MultiDimIterator<int64_t> iter(otherDims); !iter.atEnd(); ++iter)
-        {
-            vector<int64_t> indexvec = *iter;
-            indexvec.insert(indexvec.begin() + direction - 1, -1);//dummy value in place of reduce direction
-            for (int64_t i = 0; i < inDims[direction]; ++i)
+        if (failed) throw AlgorithmException(errorMessage);
+    }
+    
+    void reduceCifti(const CiftiFile* ciftiIn, CiftiFile* ciftiOut, const int& direction, const ReduceSettings& settings)
+    {
+        CaretAssert(direction >= 0);
+        const CiftiXML& inputXML = ciftiIn->getCiftiXML();
+        CiftiXML myOutXML = inputXML;
+        if (direction >= myOutXML.getNumberOfDimensions()) throw AlgorithmException("specified reduction direction doesn't exist in input cifti file");
+        CiftiScalarsMap newMap;
+        newMap.setLength(1);
+        newMap.setMapName(0, ReductionEnum::toName(settings.type));
+        myOutXML.setMap(direction, newMap);
+        ciftiOut->setCiftiXML(myOutXML);
+        vector<int64_t> inDims = inputXML.getDimensions();
+        if (direction == CiftiXML::ALONG_ROW)
+        {//read a block of rows serially, reduce them in parallel, then write the results
+            const int64_t rowsPerBlock = max((int64_t)1, ROW_BLOCK_FLOATS / inDims[0]);
+            vector<float> scratchInRows, results;
+            vector<vector<int64_t> > blockIndices;
+            MultiDimIterator<int64_t> iter(vector<int64_t>(inDims.begin() + 1, inDims.end()));// + 1 to exclude row dimension, because getRow/setRow
+            while (!iter.atEnd())
             {
-                indexvec[direction - 1] = i;
-                ciftiIn->getRow(scratchInRows[i].data(), indexvec);
+                blockIndices.clear();
+                for (; !iter.atEnd() && (int64_t)blockIndices.size() < rowsPerBlock; ++iter)
+                {
+                    blockIndices.push_back(*iter);
+                }
+                const int64_t blockRows = (int64_t)blockIndices.size();
+                scratchInRows.resize(blockRows * inDims[0]);
+                results.resize(blockRows);
+                for (int64_t i = 0; i < blockRows; ++i)
+                {
+                    ciftiIn->getRow(scratchInRows.data() + i * inDims[0], blockIndices[i]);
+                }
+                reduceMany(scratchInRows.data(), inDims[0], blockRows, results.data(), settings);
+                for (int64_t i = 0; i < blockRows; ++i)
+                {
+                    ciftiOut->setRow(&(results[i]), blockIndices[i]);//if reducing along row, length of output row is 1
+                }
             }
-            for (int64_t i = 0; i < inDims[0]; ++i)
+        } else {
+            vector<float> scratchInRow(inDims[0]), transposed(inDims[0] * inDims[direction]);
+            vector<float> outRow(inDims[0]);//reduction isn't along row, so out rows will be same length as in rows
+            vector<int64_t> otherDims = inDims;
+            otherDims.erase(otherDims.begin() + direction);//direction isn't 0
+            otherDims.erase(otherDims.begin());//remove row direction because getRow/setRow
+            for (MultiDimIterator<int64_t> iter(otherDims); !iter.atEnd(); ++iter)
             {
+                vector<int64_t> indexvec = *iter;
+                indexvec.insert(indexvec.begin() + direction - 1, -1);//dummy value in place of reduce direction
                 for (int64_t j = 0; j < inDims[direction]; ++j)
-                {//need reduction input in contiguous array
-                    reduceScratch[j] = scratchInRows[j][i];
-                }
-                if (onlyNumeric)
                 {
-                    outRow[i] = ReductionOperation::reduceOnlyNumeric(reduceScratch.data(), inDims[direction], myReduce);
-                } else {
-                    outRow[i] = ReductionOperation::reduce(reduceScratch.data(), inDims[direction], myReduce);
+                    indexvec[direction - 1] = j;
+                    ciftiIn->getRow(scratchInRow.data(), indexvec);
+                    for (int64_t i = 0; i < inDims[0]; ++i)
+                    {//need reduction input in contiguous arrays
+                        transposed[i * inDims[direction] + j] = scratchInRow[i];
+                    }
                 }
+                reduceMany(transposed.data(), inDims[direction], inDims[0], outRow.data(), settings);
+                indexvec[direction - 1] = 0;//only one element along reduce output direction
+                ciftiOut->setRow(outRow.data(), indexvec);
             }
-            indexvec[direction - 1] = 0;//only one element along reduce output direction
-            ciftiOut->setRow(outRow.data(), indexvec);
         }
     }
 }
 
+AlgorithmCiftiReduce::AlgorithmCiftiReduce(ProgressObject* myProgObj, const CiftiFile* ciftiIn, const ReductionEnum::Enum& myReduce, CiftiFile* ciftiOut,
+                                           const bool& onlyNumeric, const int& direction) : AbstractAlgorithm(myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    ReduceSettings settings;
+    settings.type = myReduce;
+    settings.onlyNumeric = onlyNumeric;
+    settings.excludeDev = false;
+    settings.sigmaBelow = 0.0f;
+    settings.sigmaAbove = 0.0f;
+    reduceCifti(ciftiIn, ciftiOut, direction, settings);
+}
+
 AlgorithmCiftiReduce::AlgorithmCiftiReduce(ProgressObject* myProgObj, const CiftiFile* ciftiIn, const ReductionEnum::Enum& myReduce, CiftiFile* ciftiOut,
                                            const float& sigmaBelow, const float& sigmaAbove, const int& direction) : AbstractAlgorithm(myProgObj)
 {
     LevelProgress myProgress(myProgObj);
-    CaretAssert(direction >= 0);
-    const CiftiXML& inputXML = ciftiIn->getCiftiXML();
-    CiftiXML myOutXML = inputXML;
-    if (direction >= myOutXML.getNumberOfDimensions()) throw AlgorithmException("specified reduction direction doesn't exist in input cifti file");
-    CiftiScalarsMap newMap;
-    newMap.setLength(1);
-    newMap.setMapName(0, ReductionEnum::toName(myReduce));
-    myOutXML.setMap(direction, newMap);
-    ciftiOut->setCiftiXML(myOutXML);
-    vector<int64_t> inDims = inputXML.getDimensions();
-    if (direction == CiftiXML::ALONG_ROW)
-    {
-        vector<float> scratchInRow(inDims[0]);
-        for (MultiDimIterator<int64_t> iter(vector<int64_t>(inDims.begin() + 1, inDims.end())); !iter.atEnd(); ++iter)
-        {// + 1 to exclude row dimension, because getRow/setRow
-            ciftiIn->getRow(scratchInRow.data(), *iter);
-            float result = ReductionOperation::reduceExcludeDev(scratchInRow.data(), inDims[0], myReduce, sigmaBelow, sigmaAbove);
-            ciftiOut->setRow(&result, *iter);//if reducing along row, length of output row is 1
-        }
-    } else {
-        vector<vector<float> > scratchInRows(inDims[direction], vector<float>(inDims[0]));
-        vector<float> outRow(inDims[0]), reduceScratch(inDims[direction]);//reduction isn't along row, so out rows will be same length as in rows
-        vector<int64_t> otherDims = inDims;
-        otherDims.erase(otherDims.begin() + direction);//direction isn't 0
-        otherDims.erase(otherDims.begin());//remove row direction because getRow/setRow
-        for (MultiDimIterator<int64_t> iter(otherDims); !iter.atEnd(); ++iter)
-        {
-            vector<int64_t> indexvec = *iter;
-            indexvec.insert(indexvec.begin() + direction - 1, -1);//dummy value in place of reduce direction
-            for (int64_t i = 0; i < inDims[direction]; ++i)
-            {
-                indexvec[direction - 1] = i;
-                ciftiIn->getRow(scratchInRows[i].data(), indexvec);
-            }
-            for (int64_t i = 0; i < inDims[0]; ++i)
-            {
-                for (int64_t j = 0; j < inDims[direction]; ++j)
-                {//need reduction input in contiguous array
-                    reduceScratch[j] = scratchInRows[j][i];
-                }
-                outRow[i] = ReductionOperation::reduceExcludeDev(reduceScratch.data(), inDims[direction], myReduce, sigmaBelow, sigmaAbove);
-            }
-            indexvec[direction - 1] = 0;//only one element along reduce output direction
-            ciftiOut->setRow(outRow.data(), indexvec);
-        }
-    }
+    ReduceSettings settings;
+    settings.type = myReduce;
+    settings.onlyNumeric = false;
+    settings.excludeDev = true;
+    settings.sigmaBelow = sigmaBelow;
+    settings.sigmaAbove = sigmaAbove;
+    reduceCifti(ciftiIn, ciftiOut, direction, settings);
 }
 
 float AlgorithmCiftiReduce::getAlgorithmInternalWeight()
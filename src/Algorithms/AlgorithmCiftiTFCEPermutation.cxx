@@ -0,0 +1,441 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AlgorithmMetricTFCEPermutation.h"
+#include "AlgorithmException.h"
+
+#include "AlgorithmCiftiTFCEPermutation.h"
+#include "AlgorithmException.h"
+
+#include "AlgorithmMetricTFCE.h"
+#include "AlgorithmMetricTFCEPermutation.h"
+#include "AlgorithmVolumeTFCE.h"
+#include "CaretPointer.h"
+#include "CiftiFile.h"
+#include "MetricFile.h"
+#include "SurfaceFile.h"
+#include "TopologyHelper.h"
+#include "VolumeSpace.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+AString AlgorithmCiftiTFCEPermutation::getCommandSwitch()
+{
+    return "-cifti-tfce-permutation";
+}
+
+AString AlgorithmCiftiTFCEPermutation::getShortDescription()
+{
+    return "PERMUTATION TEST OF TFCE ON A CIFTI FILE";
+}
+
+OperationParameters* AlgorithmCiftiTFCEPermutation::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+    
+    ret->addCiftiParameter(1, "cifti-in", "the cifti with one map per subject");
+    
+    ret->addCiftiOutputParameter(2, "cifti-out", "the output cifti");
+    
+    OptionalParameter* groupOpt = ret->createOptionalParameter(3, "-two-sample", "shuffle group labels instead of flipping signs");
+    groupOpt->addStringParameter(1, "group-file", "text file containing a 0 or 1 for each map");
+    
+    OptionalParameter* permOpt = ret->createOptionalParameter(4, "-permutations", "set the number of permutations");
+    permOpt->addIntegerParameter(1, "num", "number of permutations including the unpermuted data (default 1000)");
+    
+    OptionalParameter* seedOpt = ret->createOptionalParameter(5, "-seed", "set the random seed");
+    seedOpt->addIntegerParameter(1, "seed", "the seed for generating permutations (default 0)");
+    
+    OptionalParameter* roiOpt = ret->createOptionalParameter(6, "-cifti-roi", "select a region of interest to run TFCE on");
+    roiOpt->addCiftiParameter(1, "roi-cifti", "the area to run TFCE on, as a cifti file");
+    
+    OptionalParameter* leftSurfOpt = ret->createOptionalParameter(7, "-left-surface", "specify the left surface to use");
+    leftSurfOpt->addSurfaceParameter(1, "surface", "the left surface file");
+    OptionalParameter* leftCorrAreasOpt = leftSurfOpt->createOptionalParameter(2, "-corrected-areas", "vertex areas to use instead of computing them from the surface");
+    leftCorrAreasOpt->addMetricParameter(1, "area-metric", "the corrected vertex areas, as a metric");
+    
+    OptionalParameter* rightSurfOpt = ret->createOptionalParameter(8, "-right-surface", "specify the right surface to use");
+    rightSurfOpt->addSurfaceParameter(1, "surface", "the right surface file");
+    OptionalParameter* rightCorrAreasOpt = rightSurfOpt->createOptionalParameter(2, "-corrected-areas", "vertex areas to use instead of computing them from the surface");
+    rightCorrAreasOpt->addMetricParameter(1, "area-metric", "the corrected vertex areas, as a metric");
+    
+    OptionalParameter* cerebSurfOpt = ret->createOptionalParameter(9, "-cerebellum-surface", "specify the cerebellum surface to use");
+    cerebSurfOpt->addSurfaceParameter(1, "surface", "the cerebellum surface file");
+    OptionalParameter* cerebCorrAreasOpt = cerebSurfOpt->createOptionalParameter(2, "-corrected-areas", "vertex areas to use instead of computing them from the surface");
+    cerebCorrAreasOpt->addMetricParameter(1, "area-metric", "the corrected vertex areas, as a metric");
+    
+    OptionalParameter* surfParamsOpt = ret->createOptionalParameter(10, "-surface-parameters", "set parameters for the TFCE integral on surfaces");
+    surfParamsOpt->addDoubleParameter(1, "E", "exponent for cluster area (default 1.0)");
+    surfParamsOpt->addDoubleParameter(2, "H", "exponent for threshold value (default 2.0)");
+    
+    OptionalParameter* volParamsOpt = ret->createOptionalParameter(11, "-volume-parameters", "set parameters for the TFCE integral in volume");
+    volParamsOpt->addDoubleParameter(1, "E", "exponent for cluster volume (default 0.5)");
+    volParamsOpt->addDoubleParameter(2, "H", "exponent for threshold value (default 2.0)");
+    
+    ret->createOptionalParameter(12, "-merged-volume", "treat volume components as if they were a single component");
+    
+    OptionalParameter* distOpt = ret->createOptionalParameter(13, "-max-distribution", "output the maximum absolute TFCE value of each permutation");
+    distOpt->addStringParameter(1, "text-out", "output - text file to write the distribution to");
+    
+    ret->setHelpText(
+        AString("Computes a t-statistic at each brainordinate, runs TFCE on it, and builds a null distribution of the maximum absolute TFCE value by permutation.  ") +
+        "The tests, permutations, and outputs are the same as -metric-tfce-permutation, with maps in place of metric columns.  " +
+        "The input must have brain models along columns, like a dscalar file, and the output is a dscalar file with 3 maps: the t-statistic, its TFCE, and the familywise error corrected p-value of the TFCE.\n\n" +
+        "TFCE is computed separately on each surface structure and on each volume structure, or on all volume structures together if -merged-volume is specified.  " +
+        "The maximum for the null distribution is taken over all brainordinates, so the p-values are corrected across the whole file.  " +
+        "The roi cifti should have brain models along columns, exactly matching the mapping of the input file."
+    );
+    return ret;
+}
+
+void AlgorithmCiftiTFCEPermutation::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    CiftiFile* myCifti = myParams->getCifti(1);
+    CiftiFile* myCiftiOut = myParams->getOutputCifti(2);
+    vector<int>* groups = NULL, realGroups;//NOTE: realGroups is NOT a pointer
+    OptionalParameter* groupOpt = myParams->getOptionalParameter(3);
+    if (groupOpt->m_present)
+    {
+        groups = &realGroups;
+        AlgorithmMetricTFCEPermutation::readGroupFile(groupOpt->getString(1), realGroups);
+    }
+    int numPerms = 1000;
+    OptionalParameter* permOpt = myParams->getOptionalParameter(4);
+    if (permOpt->m_present)
+    {
+        numPerms = (int)permOpt->getInteger(1);
+    }
+    int seed = 0;
+    OptionalParameter* seedOpt = myParams->getOptionalParameter(5);
+    if (seedOpt->m_present)
+    {
+        seed = (int)seedOpt->getInteger(1);
+    }
+    CiftiFile* roiCifti = NULL;
+    OptionalParameter* roiOpt = myParams->getOptionalParameter(6);
+    if (roiOpt->m_present)
+    {
+        roiCifti = roiOpt->getCifti(1);
+    }
+    SurfaceFile* myLeftSurf = NULL, *myRightSurf = NULL, *myCerebSurf = NULL;
+    MetricFile* myLeftAreas = NULL, *myRightAreas = NULL, *myCerebAreas = NULL;
+    OptionalParameter* leftSurfOpt = myParams->getOptionalParameter(7);
+    if (leftSurfOpt->m_present)
+    {
+        myLeftSurf = leftSurfOpt->getSurface(1);
+        OptionalParameter* leftCorrAreasOpt = leftSurfOpt->getOptionalParameter(2);
+        if (leftCorrAreasOpt->m_present)
+        {
+            myLeftAreas = leftCorrAreasOpt->getMetric(1);
+        }
+    }
+    OptionalParameter* rightSurfOpt = myParams->getOptionalParameter(8);
+    if (rightSurfOpt->m_present)
+    {
+        myRightSurf = rightSurfOpt->getSurface(1);
+        OptionalParameter* rightCorrAreasOpt = rightSurfOpt->getOptionalParameter(2);
+        if (rightCorrAreasOpt->m_present)
+        {
+            myRightAreas = rightCorrAreasOpt->getMetric(1);
+        }
+    }
+    OptionalParameter* cerebSurfOpt = myParams->getOptionalParameter(9);
+    if (cerebSurfOpt->m_present)
+    {
+        myCerebSurf = cerebSurfOpt->getSurface(1);
+        OptionalParameter* cerebCorrAreasOpt = cerebSurfOpt->getOptionalParameter(2);
+        if (cerebCorrAreasOpt->m_present)
+        {
+            myCerebAreas = cerebCorrAreasOpt->getMetric(1);
+        }
+    }
+    float surf_e = 1.0f, surf_h = 2.0f, vol_e = 0.5f, vol_h = 2.0f;
+    OptionalParameter* surfParamsOpt = myParams->getOptionalParameter(10);
+    if (surfParamsOpt->m_present)
+    {
+        surf_e = (float)surfParamsOpt->getDouble(1);
+        surf_h = (float)surfParamsOpt->getDouble(2);
+    }
+    OptionalParameter* volParamsOpt = myParams->getOptionalParameter(11);
+    if (volParamsOpt->m_present)
+    {
+        vol_e = (float)volParamsOpt->getDouble(1);
+        vol_h = (float)volParamsOpt->getDouble(2);
+    }
+    bool mergedVol = myParams->getOptionalParameter(12)->m_present;
+    OptionalParameter* distOpt = myParams->getOptionalParameter(13);
+    vector<float> maxDist;
+    AlgorithmCiftiTFCEPermutation(myProgObj, myCifti, myCiftiOut, numPerms, groups, roiCifti, myLeftSurf, myLeftAreas, myRightSurf, myRightAreas, myCerebSurf, myCerebAreas,
+                                  surf_e, surf_h, vol_e, vol_h, mergedVol, seed, &maxDist);
+    if (distOpt->m_present)
+    {
+        AlgorithmMetricTFCEPermutation::writeMaxDistribution(distOpt->getString(1), maxDist);
+    }
+}
+
+namespace
+{
+    struct SurfacePart
+    {
+        CaretPointer<TopologyHelper> m_helper;
+        vector<float> m_areas;
+        vector<CiftiBrainModelsMap::SurfaceMap> m_map;
+        int64_t m_numNodes;
+    };
+    
+    struct VolumePart
+    {
+        VolumeSpace m_space;//bounding box of the part's voxels, so each permutation only touches the voxels near the structure
+        vector<int64_t> m_ciftiIndices, m_frameIndices;
+    };
+    
+    struct CiftiTFCEParts
+    {
+        vector<SurfacePart> m_surfaces;
+        vector<VolumePart> m_volumes;
+        float m_surf_e, m_surf_h, m_vol_e, m_vol_h;
+    };
+    
+    void makeVolumePart(const vector<CiftiBrainModelsMap::VolumeMap>& voxelMap, const VolumeSpace& fullSpace, VolumePart& partOut)
+    {
+        int64_t boxMin[3], boxDims[3];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            int64_t boxMax = voxelMap[0].m_ijk[axis];
+            boxMin[axis] = boxMax;
+            for (size_t i = 1; i < voxelMap.size(); ++i)
+            {
+                boxMin[axis] = min(boxMin[axis], voxelMap[i].m_ijk[axis]);
+                boxMax = max(boxMax, voxelMap[i].m_ijk[axis]);
+            }
+            boxDims[axis] = boxMax - boxMin[axis] + 1;
+        }
+        partOut.m_space = VolumeSpace(boxDims, fullSpace.getSform());//TFCE only uses the spacing, so the offset of the box doesn't matter
+        partOut.m_ciftiIndices.resize(voxelMap.size());
+        partOut.m_frameIndices.resize(voxelMap.size());
+        for (size_t i = 0; i < voxelMap.size(); ++i)
+        {
+            partOut.m_ciftiIndices[i] = voxelMap[i].m_ciftiIndex;
+            partOut.m_frameIndices[i] = partOut.m_space.getIndex(voxelMap[i].m_ijk[0] - boxMin[0], voxelMap[i].m_ijk[1] - boxMin[1], voxelMap[i].m_ijk[2] - boxMin[2]);
+        }
+    }
+    
+    //brainordinates of other structures are left out, so their clusters don't touch, and brainordinates outside the roi already have a statistic of 0, so they don't join clusters either
+    class CiftiTFCEMapper : public AlgorithmMetricTFCEPermutation::TFCEMapper
+    {
+        const CiftiTFCEParts* m_parts;
+        AlgorithmMetricTFCE::TFCEScratch m_scratch;
+        vector<float> m_inScratch, m_outScratch;
+    public:
+        CiftiTFCEMapper(const CiftiTFCEParts* parts) { m_parts = parts; }
+        TFCEMapper* clone() const { return new CiftiTFCEMapper(m_parts); }
+        void tfce(const float* statData, float* tfceOut)
+        {
+            for (size_t whichPart = 0; whichPart < m_parts->m_surfaces.size(); ++whichPart)
+            {
+                const SurfacePart& thisPart = m_parts->m_surfaces[whichPart];
+                m_inScratch.assign(thisPart.m_numNodes, 0.0f);
+                m_outScratch.resize(thisPart.m_numNodes);
+                for (size_t i = 0; i < thisPart.m_map.size(); ++i)
+                {
+                    m_inScratch[thisPart.m_map[i].m_surfaceNode] = statData[thisPart.m_map[i].m_ciftiIndex];
+                }
+                AlgorithmMetricTFCE::processColumn(thisPart.m_helper, m_inScratch.data(), m_outScratch.data(), NULL, m_parts->m_surf_e, m_parts->m_surf_h, thisPart.m_areas.data(), m_scratch);
+                for (size_t i = 0; i < thisPart.m_map.size(); ++i)
+                {
+                    tfceOut[thisPart.m_map[i].m_ciftiIndex] = m_outScratch[thisPart.m_map[i].m_surfaceNode];
+                }
+            }
+            for (size_t whichPart = 0; whichPart < m_parts->m_volumes.size(); ++whichPart)
+            {
+                const VolumePart& thisPart = m_parts->m_volumes[whichPart];
+                const int64_t* dims = thisPart.m_space.getDims();
+                int64_t frameSize = dims[0] * dims[1] * dims[2];
+                m_inScratch.assign(frameSize, 0.0f);
+                m_outScratch.resize(frameSize);
+                for (size_t i = 0; i < thisPart.m_ciftiIndices.size(); ++i)
+                {
+                    m_inScratch[thisPart.m_frameIndices[i]] = statData[thisPart.m_ciftiIndices[i]];
+                }
+                AlgorithmVolumeTFCE::processFrame(thisPart.m_space, m_inScratch.data(), m_outScratch.data(), NULL, m_parts->m_vol_e, m_parts->m_vol_h);
+                for (size_t i = 0; i < thisPart.m_ciftiIndices.size(); ++i)
+                {
+                    tfceOut[thisPart.m_ciftiIndices[i]] = m_outScratch[thisPart.m_frameIndices[i]];
+                }
+            }
+        }
+    };
+}
+
+AlgorithmCiftiTFCEPermutation::AlgorithmCiftiTFCEPermutation(ProgressObject* myProgObj, const CiftiFile* myCifti, CiftiFile* myCiftiOut, const int& numPerms,
+                                                             const vector<int>* groups, const CiftiFile* roiCifti,
+                                                             const SurfaceFile* myLeftSurf, const MetricFile* myLeftAreas,
+                                                             const SurfaceFile* myRightSurf, const MetricFile* myRightAreas,
+                                                             const SurfaceFile* myCerebSurf, const MetricFile* myCerebAreas,
+                                                             const float& surf_e, const float& surf_h, const float& vol_e, const float& vol_h,
+                                                             const bool& mergedVol, const int& seed, vector<float>* maxDistOut) : AbstractAlgorithm(myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    const CiftiXML& myXML = myCifti->getCiftiXML();
+    if (myXML.getNumberOfDimensions() != 2) throw AlgorithmException("cifti tfce permutation only supported on 2D cifti");
+    if (myXML.getMappingType(CiftiXML::ALONG_COLUMN) != CiftiMappingType::BRAIN_MODELS)
+    {
+        throw AlgorithmException("input cifti does not have brainordinates along columns");
+    }
+    const CiftiBrainModelsMap& myBrainMap = myXML.getBrainModelsMap(CiftiXML::ALONG_COLUMN);
+    if (roiCifti != NULL && myBrainMap != *(roiCifti->getCiftiXML().getMap(CiftiXML::ALONG_COLUMN)))
+    {
+        throw AlgorithmException("along-column mapping of roi cifti does not match the input cifti");
+    }
+    int64_t numElements = myXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
+    int numCols = (int)myXML.getDimensionLength(CiftiXML::ALONG_ROW);
+    CiftiTFCEParts myParts;
+    myParts.m_surf_e = surf_e;
+    myParts.m_surf_h = surf_h;
+    myParts.m_vol_e = vol_e;
+    myParts.m_vol_h = vol_h;
+    vector<StructureEnum::Enum> surfaceList = myBrainMap.getSurfaceStructureList();
+    myParts.m_surfaces.resize(surfaceList.size());
+    for (int whichStruct = 0; whichStruct < (int)surfaceList.size(); ++whichStruct)
+    {
+        const SurfaceFile* mySurf = NULL;
+        const MetricFile* myAreas = NULL;
+        AString surfType;
+        switch (surfaceList[whichStruct])
+        {
+            case StructureEnum::CORTEX_LEFT:
+                mySurf = myLeftSurf;
+                myAreas = myLeftAreas;
+                surfType = "left";
+                break;
+            case StructureEnum::CORTEX_RIGHT:
+                mySurf = myRightSurf;
+                myAreas = myRightAreas;
+                surfType = "right";
+                break;
+            case StructureEnum::CEREBELLUM:
+                mySurf = myCerebSurf;
+                myAreas = myCerebAreas;
+                surfType = "cerebellum";
+                break;
+            default:
+                throw AlgorithmException("found surface model with incorrect type: " + StructureEnum::toName(surfaceList[whichStruct]));
+                break;
+        }
+        if (mySurf == NULL)
+        {
+            throw AlgorithmException(surfType + " surface required but not provided");
+        }
+        if (mySurf->getNumberOfNodes() != myBrainMap.getSurfaceNumberOfNodes(surfaceList[whichStruct]))
+        {
+            throw AlgorithmException(surfType + " surface has the wrong number of vertices");
+        }
+        if (myAreas != NULL && myAreas->getNumberOfNodes() != mySurf->getNumberOfNodes())
+        {
+            throw AlgorithmException(surfType + " corrected areas metric has the wrong number of vertices");
+        }
+        SurfacePart& thisPart = myParts.m_surfaces[whichStruct];
+        thisPart.m_numNodes = mySurf->getNumberOfNodes();
+        thisPart.m_helper = mySurf->getTopologyHelper();//shared by all permutations and threads
+        if (myAreas == NULL)
+        {
+            mySurf->computeNodeAreas(thisPart.m_areas);
+        } else {
+            const float* areaData = myAreas->getValuePointerForColumn(0);
+            thisPart.m_areas.assign(areaData, areaData + thisPart.m_numNodes);
+        }
+        thisPart.m_map = myBrainMap.getSurfaceMap(surfaceList[whichStruct]);
+    }
+    if (myBrainMap.hasVolumeData())
+    {
+        const VolumeSpace& fullSpace = myBrainMap.getVolumeSpace();
+        vector<vector<CiftiBrainModelsMap::VolumeMap> > voxelMaps;
+        if (mergedVol)
+        {
+            voxelMaps.push_back(myBrainMap.getFullVolumeMap());
+        } else {
+            vector<StructureEnum::Enum> volumeList = myBrainMap.getVolumeStructureList();
+            for (int whichStruct = 0; whichStruct < (int)volumeList.size(); ++whichStruct)
+            {
+                voxelMaps.push_back(myBrainMap.getVolumeStructureMap(volumeList[whichStruct]));
+            }
+        }
+        for (size_t whichMap = 0; whichMap < voxelMaps.size(); ++whichMap)
+        {
+            if (voxelMaps[whichMap].empty()) continue;
+            myParts.m_volumes.push_back(VolumePart());
+            makeVolumePart(voxelMaps[whichMap], fullSpace, myParts.m_volumes.back());
+        }
+    }
+    vector<vector<float> > subjectData(numCols, vector<float>(numElements));//read by rows, which is the fast direction on disk
+    vector<float> scratchRow(numCols);
+    for (int64_t i = 0; i < numElements; ++i)
+    {
+        myCifti->getRow(scratchRow.data(), i);
+        for (int c = 0; c < numCols; ++c)
+        {
+            subjectData[c][i] = scratchRow[c];
+        }
+    }
+    vector<const float*> columns(numCols);
+    for (int c = 0; c < numCols; ++c)
+    {
+        columns[c] = subjectData[c].data();
+    }
+    vector<float> roiData;
+    if (roiCifti != NULL)
+    {
+        roiData.resize(numElements);
+        roiCifti->getColumn(roiData.data(), 0);
+    }
+    CiftiTFCEMapper myMapper(&myParts);
+    vector<float> observedStat, observedTFCE, pvals, maxDist;
+    AlgorithmMetricTFCEPermutation::permutationTest(myProgress, columns, numElements, (roiCifti == NULL ? NULL : roiData.data()), myMapper, numPerms, groups, seed,
+                                                    observedStat, observedTFCE, pvals, maxDist);
+    CiftiXML outXML = myXML;
+    CiftiScalarsMap newMap;
+    newMap.setLength(3);
+    newMap.setMapName(0, "t-statistic");
+    newMap.setMapName(1, "TFCE");
+    newMap.setMapName(2, "FWE corrected p");
+    outXML.setMap(CiftiXML::ALONG_ROW, newMap);
+    myCiftiOut->setCiftiXML(outXML);
+    for (int64_t i = 0; i < numElements; ++i)
+    {
+        float outRow[3] = { observedStat[i], observedTFCE[i], pvals[i] };
+        myCiftiOut->setRow(outRow, i);
+    }
+    if (maxDistOut != NULL) *maxDistOut = maxDist;
+}
+
+float AlgorithmCiftiTFCEPermutation::getAlgorithmInternalWeight()
+{
+    return 1.0f;//override this if needed, if the progress bar isn't smooth
+}
+
+float AlgorithmCiftiTFCEPermutation::getSubAlgorithmWeight()
+{
+    //return AlgorithmInsertNameHere::getAlgorithmWeight();//if you use a subalgorithm
+    return 0.0f;
+}
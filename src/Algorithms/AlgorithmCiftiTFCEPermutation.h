@@ -0,0 +1,57 @@
+#ifndef __ALGORITHM_CIFTI_TFCE_PERMUTATION_H__
+#define __ALGORITHM_CIFTI_TFCE_PERMUTATION_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AlgorithmMetricTFCEPermutation.h"
+#include "AlgorithmException.h"
+#include "AbstractAlgorithm.h"
+
+#include <vector>
+
+namespace caret {
+    
+    class AlgorithmCiftiTFCEPermutation : public AbstractAlgorithm
+    {
+        AlgorithmCiftiTFCEPermutation();
+    protected:
+        static float getSubAlgorithmWeight();
+        static float getAlgorithmInternalWeight();
+    public:
+        ///groups NULL means one-sample sign-flipping, otherwise one 0/1 label per map for a two-sample label shuffle
+        AlgorithmCiftiTFCEPermutation(ProgressObject* myProgObj, const CiftiFile* myCifti, CiftiFile* myCiftiOut, const int& numPerms = 1000,
+                                      const std::vector<int>* groups = NULL, const CiftiFile* roiCifti = NULL,
+                                      const SurfaceFile* myLeftSurf = NULL, const MetricFile* myLeftAreas = NULL,
+                                      const SurfaceFile* myRightSurf = NULL, const MetricFile* myRightAreas = NULL,
+                                      const SurfaceFile* myCerebSurf = NULL, const MetricFile* myCerebAreas = NULL,
+                                      const float& surf_e = 1.0f, const float& surf_h = 2.0f, const float& vol_e = 0.5f, const float& vol_h = 2.0f,
+                                      const bool& mergedVol = false, const int& seed = 0, std::vector<float>* maxDistOut = NULL);
+        static OperationParameters* getParameters();
+        static void useParameters(OperationParameters* myParams, ProgressObject* myProgObj);
+        static AString getCommandSwitch();
+        static AString getShortDescription();
+    };
+
+    typedef TemplateAutoOperation<AlgorithmCiftiTFCEPermutation> AutoAlgorithmCiftiTFCEPermutation;
+
+}
+
+#endif //__ALGORITHM_CIFTI_TFCE_PERMUTATION_H__
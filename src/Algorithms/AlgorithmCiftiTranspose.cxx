@@ -20,11 +20,59 @@
 
 #include "AlgorithmCiftiTranspose.h"
 #include "AlgorithmException.h"
+#include "CaretOMP.h"
 #include "CiftiFile.h"
 
+#include <QTemporaryFile>
+
 using namespace caret;
 using namespace std;
 
+namespace
+{
+    const int TILE_SIZE = 64;//for cache-friendly in-memory transposes
+    const int64_t TEMP_IO_MAX_BYTES = 1 << 24;//cap on scratch buffers when merging tiles
+    
+    void writeTemp(QTemporaryFile& tempFile, const float* data, const int64_t& count)
+    {
+        const int64_t byteCount = count * sizeof(float);
+        if (tempFile.write((const char*)data, byteCount) != byteCount)
+        {
+            throw AlgorithmException("failed to write to temporary file '" + tempFile.fileName() + "': " + tempFile.errorString());
+        }
+    }
+    
+    void readTemp(QTemporaryFile& tempFile, const int64_t& floatOffset, float* dataOut, const int64_t& count)
+    {
+        const int64_t byteCount = count * sizeof(float);
+        if (!tempFile.seek(floatOffset * sizeof(float)) || tempFile.read((char*)dataOut, byteCount) != byteCount)
+        {
+            throw AlgorithmException("failed to read from temporary file '" + tempFile.fileName() + "': " + tempFile.errorString());
+        }
+    }
+    
+    //transpose a band of numIn rows of length rowLength into rowLength rows of length numIn
+    void transposeBand(const float* bandIn, float* bandOut, const int64_t& numIn, const int64_t& rowLength)
+    {
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int64_t kBase = 0; kBase < rowLength; kBase += TILE_SIZE)
+        {
+            int64_t kEnd = min(kBase + TILE_SIZE, rowLength);
+            for (int64_t jBase = 0; jBase < numIn; jBase += TILE_SIZE)
+            {
+                int64_t jEnd = min(jBase + TILE_SIZE, numIn);
+                for (int64_t k = kBase; k < kEnd; ++k)
+                {
+                    for (int64_t j = jBase; j < jEnd; ++j)
+                    {
+                        bandOut[k * numIn + j] = bandIn[j * rowLength + k];
+                    }
+                }
+            }
+        }
+    }
+}
+
 AString AlgorithmCiftiTranspose::getCommandSwitch()
 {
     return "-cifti-transpose";
@@ -47,7 +95,8 @@ OperationParameters* AlgorithmCiftiTranspose::getParameters()
     
     ret->setHelpText(
         AString("The input must be a 2-dimensional cifti file.  ") +
-        "The output is a cifti file where every row in the input is a column in the output."
+        "The output is a cifti file where every row in the input is a column in the output.  " +
+        "When -mem-limit is smaller than the output, a temporary file the size of the input is written to the system temporary directory."
     );
     return ret;
 }
@@ -91,23 +140,89 @@ AlgorithmCiftiTranspose::AlgorithmCiftiTranspose(ProgressObject* myProgObj, cons
         if (numCacheRows < 1) numCacheRows = 1;
         if (numCacheRows > colSize) numCacheRows = colSize;
     }
-    vector<vector<float> > cacheRows(numCacheRows, vector<float>(rowSize));
-    vector<float> scratchInRow(colSize);
-    for (int i = 0; i < colSize; i += numCacheRows)//loop through cache chunks
+    if (numCacheRows >= colSize || ciftiIn->isInMemory())
     {
-        int end = i + numCacheRows;
-        if (end > colSize) end = colSize;
-        for (int j = 0; j < rowSize; ++j)//loop through all input rows
+        vector<vector<float> > cacheRows(numCacheRows, vector<float>(rowSize));
+        vector<float> scratchInRow(colSize);
+        for (int i = 0; i < colSize; i += numCacheRows)//loop through cache chunks
         {
-            ciftiIn->getRow(scratchInRow.data(), j);
+            int end = i + numCacheRows;
+            if (end > colSize) end = colSize;
+            for (int j = 0; j < rowSize; ++j)//loop through all input rows
+            {
+                ciftiIn->getRow(scratchInRow.data(), j);
+                for (int k = i; k < end; ++k)
+                {
+                    cacheRows[k - i][j] = scratchInRow[k];
+                }
+            }
             for (int k = i; k < end; ++k)
             {
-                cacheRows[k - i][j] = scratchInRow[k];
+                ciftiOut->setRow(cacheRows[k - i].data(), k);
             }
         }
-        for (int k = i; k < end; ++k)
+    } else {//rereading the input for every cache chunk is quadratic in file size, so go through a temporary file of transposed bands instead
+        //temp file layout: band b holds input rows [b * bandRows, b * bandRows + bandLength), stored as colSize rows of bandLength each
+        //so every band contributes one contiguous slice to each chunk of output rows, and every byte is read and written a fixed number of times
+        int64_t inRowBytes = colSize * sizeof(float);
+        int64_t bandRows = memLimitGB * 1024 * 1024 * 1024 / (2 * inRowBytes);//input band and its transpose
+        if (bandRows < 1) bandRows = 1;
+        if (bandRows > rowSize) bandRows = rowSize;
+        QTemporaryFile tempFile;
+        if (!tempFile.open())
+        {
+            throw AlgorithmException("failed to create temporary file for transpose: " + tempFile.errorString());
+        }
+        vector<int64_t> bandStarts;
         {
-            ciftiOut->setRow(cacheRows[k - i].data(), k);
+            vector<float> bandIn(bandRows * colSize), bandOut(bandRows * colSize);
+            vector<int64_t> indices;
+            for (int64_t bandStart = 0; bandStart < rowSize; bandStart += bandRows)
+            {
+                int64_t bandLength = min(bandRows, rowSize - bandStart);
+                indices.resize(bandLength);
+                for (int64_t j = 0; j < bandLength; ++j)
+                {
+                    indices[j] = bandStart + j;
+                }
+                ciftiIn->getRows(bandIn.data(), indices);//consecutive rows get coalesced into one read
+                transposeBand(bandIn.data(), bandOut.data(), bandLength, colSize);
+                writeTemp(tempFile, bandOut.data(), bandLength * colSize);
+                bandStarts.push_back(bandStart);
+            }
+        }
+        bandStarts.push_back(rowSize);
+        vector<float> cacheRows(numCacheRows * (int64_t)rowSize);
+        vector<float> scratch;
+        for (int i = 0; i < colSize; i += numCacheRows)
+        {
+            int end = i + numCacheRows;
+            if (end > colSize) end = colSize;
+            for (int b = 0; b < (int)bandStarts.size() - 1; ++b)
+            {
+                int64_t bandStart = bandStarts[b], bandLength = bandStarts[b + 1] - bandStart;
+                int64_t rowsPerRead = max((int64_t)1, TEMP_IO_MAX_BYTES / (int64_t)(bandLength * sizeof(float)));
+                scratch.resize(min(rowsPerRead, (int64_t)(end - i)) * bandLength);
+                for (int64_t k = i; k < end; k += rowsPerRead)
+                {
+                    int64_t readEnd = min(k + rowsPerRead, (int64_t)end);
+                    readTemp(tempFile, bandStart * colSize + k * bandLength, scratch.data(), (readEnd - k) * bandLength);
+#pragma omp CARET_PARFOR schedule(dynamic)
+                    for (int64_t r = k; r < readEnd; ++r)
+                    {
+                        const float* source = scratch.data() + (r - k) * bandLength;
+                        float* dest = cacheRows.data() + (r - i) * rowSize + bandStart;
+                        for (int64_t j = 0; j < bandLength; ++j)
+                        {
+                            dest[j] = source[j];
+                        }
+                    }
+                }
+            }
+            for (int k = i; k < end; ++k)
+            {
+                ciftiOut->setRow(cacheRows.data() + (int64_t)(k - i) * rowSize, k);
+            }
         }
     }
 }
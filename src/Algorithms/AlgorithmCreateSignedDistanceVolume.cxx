@@ -23,6 +23,7 @@
 #include "VolumeFile.h"
 #include "CaretOMP.h"
 #include "CaretHeap.h"
+#include "ConnectedComponentsHelper.h"
 #include "MathFunctions.h"
 #include "SurfaceFile.h"
 
@@ -70,10 +71,18 @@ OperationParameters* AlgorithmCreateSignedDistanceVolume::getParameters()
     OptionalParameter* windingMethodOpt = ret->createOptionalParameter(8, "-winding", "winding method for point inside surface test");
     windingMethodOpt->addStringParameter(1, "method", "name of the method (default EVEN_ODD)");
     
+    ret->createOptionalParameter(10, "-distance-transform", "propagate exact closest points outside the exact limit instead of using dijkstra's method");
+    
     ret->setHelpText(
         AString("Computes the signed distance function of the surface.  Exact distance is calculated by finding the closest point on any surface triangle ") +
         "to the center of the voxel.  Approximate distance is calculated starting with these distances, using dijkstra's method with a neighborhood of voxels.  " +
-        "Specifying too small of an exact distance may produce unexpected results.  Valid specifiers for winding methods are as follows:\n\n" +
+        "Specifying too small of an exact distance may produce unexpected results.  " +
+        "When -distance-transform is specified, the closest surface points found for voxels within the exact distance are instead passed outward by sweeps along the voxel axes and diagonals, " +
+        "repeated until no voxel finds a closer point, and the output is the distance to the best of these points, out to the approximate limit, ignoring -approx-neighborhood.  " +
+        "The sign outside the exact distance is the majority sign of the exact voxels bordering each connected region, so the exact voxels must enclose the surface: " +
+        "when needed, the exact distance is increased to the voxel size plus the longest triangle edge divided by sqrt(3).  " +
+        "A region with no majority sign is left at the fill value and excluded from the roi.  " +
+        "Valid specifiers for winding methods are as follows:\n\n" +
         "EVEN_ODD (default)\nNEGATIVE\nNONZERO\nNORMALS\n\nThe NORMALS method uses the normals of triangles and edges, or the closest triangle hit by a ray from the point.  " +
         "This method may be slightly faster, but is only reliable for a closed surface that does not cross through itself.  All other methods count entry (positive) and " +
         "exit (negative) crossings of a vertical ray from the point, then counts as inside if the total is odd, negative, or nonzero, respectively."
@@ -144,11 +153,103 @@ void AlgorithmCreateSignedDistanceVolume::useParameters(OperationParameters* myP
     {
         myRoiOut = roiOutOpt->getOutputVolume(1);
     }
-    AlgorithmCreateSignedDistanceVolume(myProgObj, mySurf, myVolOut, myRoiOut, fillValue, exactLim, approxLim, approxNeighborhood, myWinding);
+    bool useTransform = myParams->getOptionalParameter(10)->m_present;
+    AlgorithmCreateSignedDistanceVolume(myProgObj, mySurf, myVolOut, myRoiOut, fillValue, exactLim, approxLim, approxNeighborhood, myWinding, useTransform);
+}
+
+namespace
+{
+    //for -distance-transform: voxels outside the exact band take the closest surface point of the previous voxel along a line if it is closer than their own,
+    //sweeping both ways along lines in the 13 axis and diagonal directions, the lines of a sweep are independent, so each sweep runs in parallel
+    //rounds of sweeps repeat until no voxel changes, a change always moves a voxel to a strictly closer point, so this terminates
+    void sweepClosestPoints(const VolumeSpace& mySpace, const vector<Vector3D>& bandPoints, const CaretArray<int>& volMarked, vector<int32_t>& closestSource)
+    {
+        const int NUM_DIRECTIONS = 13;
+        const int directions[NUM_DIRECTIONS][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 },
+                                                    { 1, 1, 0 }, { 1, -1, 0 }, { 1, 0, 1 }, { 1, 0, -1 }, { 0, 1, 1 }, { 0, 1, -1 },
+                                                    { 1, 1, 1 }, { 1, 1, -1 }, { 1, -1, 1 }, { 1, -1, -1 } };
+        const int64_t* dims = mySpace.getDims();
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (int dir = 0; dir < NUM_DIRECTIONS; ++dir)
+            {
+                for (int sign = 1; sign >= -1; sign -= 2)
+                {
+                    int64_t step[3] = { directions[dir][0] * sign, directions[dir][1] * sign, directions[dir][2] * sign };
+                    vector<int64_t> lineStarts;//voxels whose previous voxel along the line is outside the volume
+                    for (int axis = 0; axis < 3; ++axis)
+                    {
+                        if (step[axis] == 0) continue;
+                        int64_t ijk[3], limits[3][2];
+                        for (int other = 0; other < 3; ++other)
+                        {
+                            limits[other][0] = 0;
+                            limits[other][1] = dims[other];
+                            if (other < axis && step[other] != 0)
+                            {//don't repeat the starts already on an earlier face
+                                if (step[other] > 0)
+                                {
+                                    limits[other][0] = 1;
+                                } else {
+                                    limits[other][1] = dims[other] - 1;
+                                }
+                            }
+                        }
+                        limits[axis][0] = (step[axis] > 0 ? 0 : dims[axis] - 1);
+                        limits[axis][1] = limits[axis][0] + 1;
+                        for (ijk[2] = limits[2][0]; ijk[2] < limits[2][1]; ++ijk[2])
+                        {
+                            for (ijk[1] = limits[1][0]; ijk[1] < limits[1][1]; ++ijk[1])
+                            {
+                                for (ijk[0] = limits[0][0]; ijk[0] < limits[0][1]; ++ijk[0])
+                                {
+                                    lineStarts.push_back(ijk[0]);
+                                    lineStarts.push_back(ijk[1]);
+                                    lineStarts.push_back(ijk[2]);
+                                }
+                            }
+                        }
+                    }
+                    int64_t numLines = (int64_t)lineStarts.size();
+#pragma omp CARET_PARFOR schedule(dynamic)
+                    for (int64_t line = 0; line < numLines; line += 3)
+                    {
+                        int64_t ijk[3] = { lineStarts[line], lineStarts[line + 1], lineStarts[line + 2] };
+                        int32_t prevSource = -1;
+                        bool lineChanged = false;
+                        Vector3D coord;
+                        for (; mySpace.indexValid(ijk); ijk[0] += step[0], ijk[1] += step[1], ijk[2] += step[2])
+                        {
+                            int64_t index = mySpace.getIndex(ijk);
+                            int32_t& thisSource = closestSource[index];
+                            if ((volMarked[index] & 1) == 0 && prevSource != -1 && prevSource != thisSource)
+                            {//band voxels already have the true closest point
+                                mySpace.indexToSpace(ijk, coord);
+                                if (thisSource == -1 || (coord - bandPoints[prevSource]).lengthsquared() < (coord - bandPoints[thisSource]).lengthsquared())
+                                {
+                                    thisSource = prevSource;
+                                    lineChanged = true;
+                                }
+                            }
+                            prevSource = thisSource;
+                        }
+                        if (lineChanged)
+                        {
+#pragma omp critical
+                            changed = true;
+                        }
+                    }
+                }
+            }
+        }
+    }
 }
 
 AlgorithmCreateSignedDistanceVolume::AlgorithmCreateSignedDistanceVolume(ProgressObject* myProgObj, const SurfaceFile* mySurf, VolumeFile* myVolOut, VolumeFile* myRoiOut, const float& fillValue,
-                                                                         const float& exactLim, const float& approxLim, const int& approxNeighborhood, const SignedDistanceHelper::WindingLogic& myWinding) : AbstractAlgorithm(myProgObj)
+                                                                         const float& exactLim, const float& approxLim, const int& approxNeighborhood, const SignedDistanceHelper::WindingLogic& myWinding,
+                                                                         const bool& useTransform) : AbstractAlgorithm(myProgObj)
 {
     if (exactLim <= 0.0f)
     {
@@ -177,6 +278,23 @@ AlgorithmCreateSignedDistanceVolume::AlgorithmCreateSignedDistanceVolume(Progres
     Vector3D kOrthHat = ivec.cross(jvec);
     kOrthHat = kOrthHat.normal();
     if (kOrthHat.dot(kvec) < 0) kOrthHat = -kOrthHat;
+    float bandLim = exactLim;//distance to the nearest vertex for a voxel to be computed exactly
+    if (useTransform)
+    {//the sign of each region comes from the band around it, so every voxel within a voxel of the surface must be in the band
+        //every point of a triangle is within (longest edge) / sqrt(3) of a vertex, equality for equilateral
+        float maxEdge = 0.0f;
+        int numTriangles = mySurf->getNumberOfTriangles();
+        for (int i = 0; i < numTriangles; ++i)
+        {
+            const int32_t* thisTri = mySurf->getTriangle(i);
+            for (int j = 0; j < 3; ++j)
+            {
+                Vector3D edge = Vector3D(mySurf->getCoordinate(thisTri[j])) - Vector3D(mySurf->getCoordinate(thisTri[(j + 1) % 3]));
+                maxEdge = max(maxEdge, edge.length());
+            }
+        }
+        bandLim = max(bandLim, max(max(ivec.length(), jvec.length()), kvec.length()) + maxEdge / sqrt(3.0f));
+    }
     vector<int64_t> myDims;
     myVolOut->getDimensions(myDims);
     myVolOut->setValueAllVoxels(fillValue);
@@ -185,7 +303,7 @@ AlgorithmCreateSignedDistanceVolume::AlgorithmCreateSignedDistanceVolume(Progres
     CaretArray<int> volMarked(frameSize, 0);
     myProgress.setTask("marking voxel to be calculated exactly");
     //compare expected runtimes of kernel based and locator based marking methods
-    if (2.9 * myDims[0] * myDims[1] * myDims[2] < (numNodes * exactLim * exactLim * exactLim / iOrthHat.dot(ivec) / jOrthHat.dot(jvec) / kOrthHat.dot(kvec)))
+    if (2.9 * myDims[0] * myDims[1] * myDims[2] < (numNodes * bandLim * bandLim * bandLim / iOrthHat.dot(ivec) / jOrthHat.dot(jvec) / kOrthHat.dot(kvec)))
     {
 #pragma omp CARET_PARFOR schedule(dynamic)
         for (int64_t k = 0; k < myDims[2]; ++k)
@@ -196,7 +314,7 @@ AlgorithmCreateSignedDistanceVolume::AlgorithmCreateSignedDistanceVolume(Progres
                 {
                     Vector3D voxCoord;
                     myVolOut->indexToSpace(i, j, k, voxCoord);
-                    int32_t ret = mySurf->closestNode(voxCoord, exactLim);
+                    int32_t ret = mySurf->closestNode(voxCoord, bandLim);
                     if (ret != -1)
                     {
                         volMarked[myVolOut->getIndex(i, j, k)] = 1;
@@ -211,27 +329,27 @@ AlgorithmCreateSignedDistanceVolume::AlgorithmCreateSignedDistanceVolume(Progres
             int64_t ijk[3];
             Vector3D nodeCoord = mySurf->getCoordinate(node), tempvec;
             float tempf, tempf2, tempf3;
-            tempvec = nodeCoord - iOrthHat * exactLim;
+            tempvec = nodeCoord - iOrthHat * bandLim;
             myVolOut->spaceToIndex(tempvec, tempf, tempf2, tempf3);//compute bounding box once rather than doing a convoluted sphere loop construct
             int64_t imin = (int64_t)ceil(tempf);
             if (imin < 0) imin = 0;
-            tempvec = nodeCoord + iOrthHat * exactLim;
+            tempvec = nodeCoord + iOrthHat * bandLim;
             myVolOut->spaceToIndex(tempvec, tempf, tempf2, tempf3);
             int64_t imax = (int64_t)floor(tempf) + 1;
             if (imax > myDims[0]) imax = myDims[0];
-            tempvec = nodeCoord - jOrthHat * exactLim;
+            tempvec = nodeCoord - jOrthHat * bandLim;
             myVolOut->spaceToIndex(tempvec, tempf, tempf2, tempf3);
             int64_t jmin = (int64_t)ceil(tempf2);
             if (jmin < 0) jmin = 0;
-            tempvec = nodeCoord + jOrthHat * exactLim;
+            tempvec = nodeCoord + jOrthHat * bandLim;
             myVolOut->spaceToIndex(tempvec, tempf, tempf2, tempf3);
             int64_t jmax = (int64_t)floor(tempf2) + 1;
             if (jmax > myDims[1]) jmax = myDims[1];
-            tempvec = nodeCoord - kOrthHat * exactLim;
+            tempvec = nodeCoord - kOrthHat * bandLim;
             myVolOut->spaceToIndex(tempvec, tempf, tempf2, tempf3);
             int64_t kmin = (int64_t)ceil(tempf3);
             if (kmin < 0) kmin = 0;
-            tempvec = nodeCoord + kOrthHat * exactLim;
+            tempvec = nodeCoord + kOrthHat * bandLim;
             myVolOut->spaceToIndex(tempvec, tempf, tempf2, tempf3);
             int64_t kmax = (int64_t)floor(tempf3) + 1;
             if (kmax > myDims[2]) kmax = myDims[2];
@@ -243,7 +361,7 @@ AlgorithmCreateSignedDistanceVolume::AlgorithmCreateSignedDistanceVolume(Progres
                     {
                         myVolOut->indexToSpace(ijk, tempvec);
                         tempvec -= nodeCoord;
-                        if (tempvec.length() <= exactLim)
+                        if (tempvec.length() <= bandLim)
                         {
                             volMarked[myVolOut->getIndex(ijk)] = 1;
                         }
@@ -271,6 +389,8 @@ AlgorithmCreateSignedDistanceVolume::AlgorithmCreateSignedDistanceVolume(Progres
     }
     myProgress.reportProgress(markweight);
     myProgress.setTask("computing exact distances");
+    vector<Vector3D> bandPoints;//closest surface point of each exact voxel, only needed for the distance transform
+    if (useTransform) bandPoints.resize(exactVoxelList.size() / 3);
 #pragma omp CARET_PAR
     {
         CaretPointer<SignedDistanceHelper> myDist = mySurf->getSignedDistanceHelper();
@@ -280,13 +400,81 @@ AlgorithmCreateSignedDistanceVolume::AlgorithmCreateSignedDistanceVolume(Progres
         for (int i = 0; i < numExact; i += 3)
         {
             myVolOut->indexToSpace(exactVoxelList.data() + i, thisCoord);
-            myVolOut->setValue(myDist->dist(thisCoord, myWinding), exactVoxelList.data() + i);
+            if (useTransform)
+            {
+                myVolOut->setValue(myDist->dist(thisCoord, myWinding, bandPoints[i / 3]), exactVoxelList.data() + i);
+            } else {
+                myVolOut->setValue(myDist->dist(thisCoord, myWinding), exactVoxelList.data() + i);
+            }
             volMarked[myVolOut->getIndex(exactVoxelList.data() + i)] |= 22;//set marked to have valid value (positive and negative), and frozen
         }
     }
     myProgress.reportProgress(markweight + exactweight);
-    if (approxLim > exactLim)
+    if (approxLim > exactLim && useTransform)
     {
+        myProgress.setTask("propagating closest points");
+        const VolumeSpace& mySpace = myVolOut->getVolumeSpace();
+        vector<int32_t> closestSource(frameSize, -1);
+        int numExact = (int)exactVoxelList.size();
+        for (int i = 0; i < numExact; i += 3)
+        {
+            closestSource[myVolOut->getIndex(exactVoxelList.data() + i)] = i / 3;
+        }
+        sweepClosestPoints(mySpace, bandPoints, volMarked, closestSource);
+        //the surface is entirely inside the band, so each connected region outside it has one sign, take it from the band voxels around it
+        vector<char> outsideBand(frameSize);
+        for (int64_t i = 0; i < frameSize; ++i)
+        {
+            outsideBand[i] = ((volMarked[i] & 1) == 0 ? 1 : 0);
+        }
+        vector<int64_t> regionLabels;
+        vector<ConnectedComponentsHelper::Component> regions;
+        ConnectedComponentsHelper::labelVoxels(myDims.data(), outsideBand.data(), 1.0f, regionLabels, regions);
+        vector<int64_t> regionVotes(regions.size(), 0);//positive minus negative bordering band voxels, a tie (or no bordering band voxels) leaves the region at the fill value
+        for (int i = 0; i < numExact; i += 3)
+        {
+            const int64_t* thisVoxel = exactVoxelList.data() + i;
+            int vote = (myVolOut->getValue(thisVoxel) < 0.0f ? -1 : 1);
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                for (int direction = -1; direction <= 1; direction += 2)
+                {
+                    int64_t tempijk[3] = { thisVoxel[0], thisVoxel[1], thisVoxel[2] };
+                    tempijk[axis] += direction;
+                    if (myVolOut->indexValid(tempijk))
+                    {
+                        int64_t region = regionLabels[myVolOut->getIndex(tempijk)];
+                        if (region != -1) regionVotes[region] += vote;
+                    }
+                }
+            }
+        }
+        vector<float> outFrame(myVolOut->getFrame(), myVolOut->getFrame() + frameSize);
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int64_t k = 0; k < myDims[2]; ++k)
+        {
+            int64_t tempijk[3];
+            tempijk[2] = k;
+            Vector3D thisCoord;
+            for (tempijk[1] = 0; tempijk[1] < myDims[1]; ++tempijk[1])
+            {
+                for (tempijk[0] = 0; tempijk[0] < myDims[0]; ++tempijk[0])
+                {
+                    int64_t index = mySpace.getIndex(tempijk);
+                    if (regionLabels[index] == -1 || closestSource[index] == -1) continue;//band voxels are already done, and a region may have no band voxels at all
+                    int64_t thisVote = regionVotes[regionLabels[index]];
+                    if (thisVote == 0) continue;//sign is ambiguous, don't guess
+                    mySpace.indexToSpace(tempijk, thisCoord);
+                    float thisDist = (thisCoord - bandPoints[closestSource[index]]).length();
+                    if (thisDist > approxLim) continue;
+                    if (thisVote < 0) thisDist = -thisDist;
+                    outFrame[index] = thisDist;
+                    volMarked[index] |= 4;//frozen, for the roi
+                }
+            }
+        }
+        myVolOut->setFrame(outFrame.data());
+    } else if (approxLim > exactLim) {
         myProgress.setTask("approximating distances in extended region");
         int faceNeigh[] = { 1, 0, 0, 
                             -1, 0, 0,
@@ -21,7 +21,7 @@
 #include "AlgorithmFiberDotProducts.h"
 #include "AlgorithmException.h"
 #include "CiftiFile.h"
-#include "CaretPointLocator.h"
+#include "CaretKdTree.h"
 #include "MetricFile.h"
 #include "SignedDistanceHelper.h"
 #include "SurfaceFile.h"
@@ -123,7 +123,7 @@ AlgorithmFiberDotProducts::AlgorithmFiberDotProducts(ProgressObject* myProgObj,
         }
     }
     if (coordIndices.size() == 0) throw AlgorithmException("no fiber samples passed the <max-dist> and <direction> tests");
-    CaretPointLocator myLocator(coordsInside.data(), coordIndices.size());//build the locator
+    CaretKdTree myLocator(coordsInside.data(), coordIndices.size());//build the locator
     int numNodes = mySurf->getNumberOfNodes();
     myDotProdOut->setNumberOfNodesAndColumns(numNodes, numFibers);
     myFSampOut->setNumberOfNodesAndColumns(numNodes, numFibers);
@@ -135,9 +135,11 @@ AlgorithmFiberDotProducts::AlgorithmFiberDotProducts(ProgressObject* myProgObj,
         myFSampOut->setColumnName(i, "Fiber " + AString::number(i + 1) + " population mean f");
     }
     const float* coordData = mySurf->getCoordinateData();
+    vector<int64_t> closestSamples(numNodes);
+    myLocator.closestPoints(coordData, numNodes, closestSamples.data());
     for (int i = 0; i < numNodes; ++i)
     {
-        int closest = myLocator.closestPoint(coordData + i * 3);
+        int closest = (int)closestSamples[i];
         if (closest != -1)
         {
             myFibers->getRow(rowScratch.data(), coordIndices[closest]);
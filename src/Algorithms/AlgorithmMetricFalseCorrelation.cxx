@@ -22,11 +22,12 @@
 #include "AlgorithmException.h"
 
 #include "CaretOMP.h"
-#include "CaretPointLocator.h"
+#include "CaretKdTree.h"
 #include "GeodesicHelper.h"
 #include "SurfaceFile.h"
 #include "MetricFile.h"
 
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 
@@ -128,7 +129,7 @@ AlgorithmMetricFalseCorrelation::AlgorithmMetricFalseCorrelation(ProgressObject*
     myMetricOut->setColumnName(4, "non-neighborhood vertex number");
     const AString sep1 = ",", sep2 = ";\n";
     float distRatioCutoff = 3.0f;
-    CaretPointer<const CaretPointLocator> myLocator = mySurf->getPointLocator();
+    CaretPointer<const CaretKdTree> myLocator = mySurf->getPointLocator();
 #pragma omp CARET_PAR
     {
         CaretPointer<GeodesicHelper> myGeo = mySurf->getGeodesicHelper();
@@ -141,31 +142,31 @@ AlgorithmMetricFalseCorrelation::AlgorithmMetricFalseCorrelation(ProgressObject*
             {
                 AString rawDumpString;//build the entire string for a single node, then write it in one call within #pragma omp critical
                 Vector3D myCoord = mySurf->getCoordinate(n);
-                set<LocatorInfo> inRange = myLocator->pointsInRange(myCoord, max3D);
+                vector<int64_t> inRange;
+                myLocator->pointsInRange(myCoord, max3D, inRange);
+                sort(inRange.begin(), inRange.end());//keep the raw dump in vertex order
                 int numInterested = (int)inRange.size();
                 vector<int32_t> interested(numInterested);
-                int counter = 0;
-                for (set<LocatorInfo>::iterator iter = inRange.begin(); iter != inRange.end(); ++iter)
+                for (int counter = 0; counter < numInterested; ++counter)
                 {
-                    interested[counter] = iter->index;
-                    ++counter;
+                    interested[counter] = (int32_t)inRange[counter];
                 }
                 vector<float> geoDists;
                 myGeo->getGeoToTheseNodes(n, interested, geoDists);
-                counter = 0;
-                for (set<LocatorInfo>::iterator iter = inRange.begin(); iter != inRange.end(); ++iter)
+                for (int counter = 0; counter < numInterested; ++counter)
                 {
-                    if (roiCol == NULL || (roiCol[iter->index] > 0.0f))
+                    const int32_t thisIndex = interested[counter];
+                    if (roiCol == NULL || (roiCol[thisIndex] > 0.0f))
                     {
-                        float dist3D = (myCoord - iter->coords).length();
-                        if (iter->index == n || geoDists[counter] / dist3D < distRatioCutoff)
+                        float dist3D = (myCoord - Vector3D(mySurf->getCoordinate(thisIndex))).length();
+                        if (thisIndex == n || geoDists[counter] / dist3D < distRatioCutoff)
                         {
                             if (maxgeo <= max3D)//otherwise, we can't trust the 3D test picking up all the points we want
                             {
                                 if (dumpRaw)
                                 {
-                                    float thiscorr = correlate(n, iter->index);
-                                    rawDumpString += AString::number(n) + sep1 + AString::number(iter->index) + sep1 + AString::number(thiscorr) + sep1 +
+                                    float thiscorr = correlate(n, thisIndex);
+                                    rawDumpString += AString::number(n) + sep1 + AString::number(thisIndex) + sep1 + AString::number(thiscorr) + sep1 +
                                         AString::number(geoDists[counter]) + sep1 + AString::number(dist3D) + sep2;
                                     if (geoDists[counter] <= maxgeo && geoDists[counter] >= mingeo)
                                     {
@@ -175,7 +176,7 @@ AlgorithmMetricFalseCorrelation::AlgorithmMetricFalseCorrelation(ProgressObject*
                                 } else {
                                     if (geoDists[counter] <= maxgeo && geoDists[counter] >= mingeo)
                                     {
-                                        float thiscorr = correlate(n, iter->index);
+                                        float thiscorr = correlate(n, thisIndex);
                                         neighAccum += thiscorr;
                                         ++neighCount;
                                     }
@@ -185,17 +186,16 @@ AlgorithmMetricFalseCorrelation::AlgorithmMetricFalseCorrelation(ProgressObject*
                             if (dist3D < crossingDist || crossingNode == -1)
                             {
                                 crossingDist = dist3D;
-                                crossingNode = iter->index;
+                                crossingNode = thisIndex;
                             }
                             if (dumpRaw)
                             {
-                                float thiscorr = correlate(n, iter->index);
-                                rawDumpString += AString::number(n) + sep1 + AString::number(iter->index) + sep1 + AString::number(thiscorr) + sep1 +
+                                float thiscorr = correlate(n, thisIndex);
+                                rawDumpString += AString::number(n) + sep1 + AString::number(thisIndex) + sep1 + AString::number(thiscorr) + sep1 +
                                     AString::number(geoDists[counter]) + sep1 + AString::number(dist3D) + sep2;
                             }
                         }
                     }
-                    ++counter;
                 }
                 if (maxgeo > max3D)//so, we have to run geodesic separately
                 {
@@ -22,6 +22,7 @@
 #include "AlgorithmException.h"
 
 #include "CaretLogger.h"
+#include "ConnectedComponentsHelper.h"
 #include "GeodesicHelper.h"
 #include "MetricFile.h"
 #include "SurfaceFile.h"
@@ -145,19 +146,17 @@ void AlgorithmMetricFindClusters::useParameters(OperationParameters* myParams, P
 
 namespace
 {
-    struct Cluster
+    void getMemberList(const vector<int64_t>& memberOffsets, const vector<int64_t>& members, const int64_t& component, vector<int32_t>& listOut)
     {
-        Cluster() { area = 0.0; }
-        vector<int32_t> members;
-        double area;
-    };
+        listOut.assign(members.begin() + memberOffsets[component], members.begin() + memberOffsets[component + 1]);
+    }
     
     void processColumn(const float* data, const float* roiData, const float* nodeAreas, TopologyHelper* myTopoHelp, GeodesicHelper* myGeoHelp,
                        const float& threshVal, const float& minArea, const bool& lessThan, const float& areaRatio, const float& distanceCutoff,
                        float* outData, int& markVal)
     {
         int numNodes = myTopoHelp->getNumberOfNodes();
-        vector<int> marked(numNodes, 0);
+        vector<char> marked(numNodes, 0);
         if (lessThan)
         {
             for (int i = 0; i < numNodes; ++i)
@@ -176,41 +175,22 @@ namespace
                 }
             }
         }
-        vector<Cluster> clusters;
+        vector<int64_t> labels;
+        vector<ConnectedComponentsHelper::Component> components;
+        ConnectedComponentsHelper::labelVertices(myTopoHelp, marked.data(), nodeAreas, labels, components);
+        vector<int64_t> clusters;//components that are big enough, in the order a serial scan finds them
         float biggestSize = 0.0f;
         int biggestCluster = -1;
-        for (int i = 0; i < numNodes; ++i)
+        for (int64_t i = 0; i < (int64_t)components.size(); ++i)
         {
-            if (marked[i])
+            if (components[i].size > minArea)
             {
-                Cluster newCluster;
-                newCluster.members.push_back(i);
-                marked[i] = 0;//unmark it when added to list to prevent multiples
-                for (int index = 0; index < (int)newCluster.members.size(); ++index)//NOTE: vector grows inside loop
+                if (components[i].size > biggestSize)
                 {
-                    int node = newCluster.members[index];//keep list around so we can put it into the output immediately if it is large enough
-                    newCluster.area += nodeAreas[node];
-                    const vector<int32_t>& neighbors = myTopoHelp->getNodeNeighbors(node);
-                    int numNeigh = (int)neighbors.size();
-                    for (int n = 0; n < numNeigh; ++n)
-                    {
-                        const int32_t& neighbor = neighbors[n];
-                        if (marked[neighbor])
-                        {
-                            newCluster.members.push_back(neighbor);
-                            marked[neighbor] = 0;
-                        }
-                    }
-                }
-                if (newCluster.area > minArea)
-                {
-                    if (newCluster.area > biggestSize)
-                    {
-                        biggestSize = newCluster.area;
-                        biggestCluster = (int)clusters.size();
-                    }
-                    clusters.push_back(newCluster);
+                    biggestSize = components[i].size;
+                    biggestCluster = (int)clusters.size();
                 }
+                clusters.push_back(i);
             }
         }
         vector<int32_t> pathScratch;
@@ -218,6 +198,13 @@ namespace
         if (!clusters.empty() && biggestCluster == -1) CaretLogWarning("clusters found, but none have positive area, check your vertex areas for negatives");
         if (biggestCluster != -1 && (distanceCutoff > 0.0f || areaRatio > 0.0f))
         {
+            vector<int64_t> memberOffsets, members;
+            vector<int32_t> biggestMembers, thisMembers;
+            if (distanceCutoff > 0.0f)
+            {
+                ConnectedComponentsHelper::getComponentMembers(labels, components, memberOffsets, members);
+                getMemberList(memberOffsets, members, clusters[biggestCluster], biggestMembers);
+            }
             for (size_t i = 0; i < clusters.size(); ++i)
             {
                 if ((int)i != biggestCluster)
@@ -225,7 +212,7 @@ namespace
                     bool erase = false;
                     if (areaRatio > 0.0f)
                     {
-                        if ((clusters[i].area / biggestSize) < areaRatio)
+                        if ((components[clusters[i]].size / biggestSize) < areaRatio)
                         {
                             erase = true;
                         }
@@ -233,7 +220,8 @@ namespace
                     if (!erase && distanceCutoff > 0.0f)
                     {
                         CaretAssert(myGeoHelp != NULL);
-                        myGeoHelp->getPathBetweenNodeLists(clusters[i].members, clusters[biggestCluster].members, distanceCutoff, pathScratch, distScratch, true);
+                        getMemberList(memberOffsets, members, clusters[i], thisMembers);
+                        myGeoHelp->getPathBetweenNodeLists(thisMembers, biggestMembers, distanceCutoff, pathScratch, distScratch, true);
                         if (pathScratch.empty())//empty path means no path found
                         {
                             erase = true;
@@ -248,6 +236,7 @@ namespace
                 }
             }
         }
+        vector<float> componentMarks(components.size(), 0.0f);//components that were too small or got removed stay 0
         for (size_t i = 0; i < clusters.size(); ++i)
         {
             if (markVal == 0)
@@ -257,12 +246,15 @@ namespace
             }
             float tempVal = markVal;
             if ((int)tempVal != markVal) throw AlgorithmException("too many clusters, unable to mark them uniquely");
-            int numMembers = (int)clusters[i].members.size();
-            for (int index = 0; index < numMembers; ++index)
+            componentMarks[clusters[i]] = tempVal;
+            ++markVal;
+        }
+        for (int i = 0; i < numNodes; ++i)
+        {
+            if (labels[i] != -1)
             {
-                outData[clusters[i].members[index]] = tempVal;
+                outData[i] = componentMarks[labels[i]];
             }
-            ++markVal;
         }
     }
 }
@@ -21,11 +21,11 @@
 #include "AlgorithmMetricRemoveIslands.h"
 #include "AlgorithmException.h"
 
+#include "ConnectedComponentsHelper.h"
 #include "MetricFile.h"
 #include "SurfaceFile.h"
 #include "TopologyHelper.h"
 
-#include <utility>
 #include <vector>
 
 using namespace caret;
@@ -92,65 +92,40 @@ AlgorithmMetricRemoveIslands::AlgorithmMetricRemoveIslands(ProgressObject* myPro
     int numCols = myMetric->getNumberOfColumns();
     myMetricOut->setNumberOfNodesAndColumns(numNodes, numCols);
     myMetricOut->setStructure(myMetric->getStructure());
+    CaretPointer<TopologyHelper> myHelp = mySurf->getTopologyHelper();
     for (int col = 0; col < numCols; ++col)
     {
-        vector<pair<float, vector<int> > > areas;
-        vector<int> used(numNodes, 0);
-        CaretPointer<TopologyHelper> myHelp = mySurf->getTopologyHelper();
         const float* roiData = myMetric->getValuePointerForColumn(col);
         myMetricOut->setColumnName(col, myMetric->getColumnName(col));
+        vector<char> marked(numNodes, 0);
         for (int i = 0; i < numNodes; ++i)
         {
-            if (used[i] == 0 && roiData[i] > 0.0f)
-            {
-                areas.push_back(make_pair(0.0f, vector<int>()));
-                vector<int>& thisAreaMembers = areas.back().second;
-                float& thisSurfArea = areas.back().first;
-                thisAreaMembers.push_back(i);
-                thisSurfArea += areaData[i];
-                used[i] = 1;
-                vector<int> mystack;
-                mystack.push_back(i);
-                while (!mystack.empty())
-                {
-                    int curnode = mystack.back();
-                    mystack.pop_back();
-                    const vector<int32_t>& neighbors = myHelp->getNodeNeighbors(curnode);
-                    int numNeigh = (int)neighbors.size();
-                    for (int j = 0; j < numNeigh; ++j)
-                    {
-                        int thisneigh = neighbors[j];
-                        if (used[thisneigh] == 0 && roiData[thisneigh] > 0.0f)
-                        {
-                            used[thisneigh] = 1;
-                            thisAreaMembers.push_back(thisneigh);
-                            thisSurfArea += areaData[thisneigh];
-                            mystack.push_back(thisneigh);
-                        }
-                    }
-                }
-            }
+            if (roiData[i] > 0.0f) marked[i] = 1;
         }
+        vector<int64_t> labels;
+        vector<ConnectedComponentsHelper::Component> areas;
+        ConnectedComponentsHelper::labelVertices(myHelp, marked.data(), areaData, labels, areas);
         vector<float> outscratch(numNodes, 0.0f);
         int numAreas = (int)areas.size();
         if (numAreas > 0)
         {
             int bestIndex = 0;
-            float bestArea = areas[0].first;
+            float bestArea = areas[0].size;
             for (int i = 1; i < numAreas; ++i)
             {
-                float thisArea = (int)areas[i].first;
+                float thisArea = (int)areas[i].size;
                 if (thisArea > bestArea)
                 {
                     bestIndex = i;
                     bestArea = thisArea;
                 }
             }
-            const vector<int>& thisArea = areas[bestIndex].second;
-            int numAreaNodes = (int)thisArea.size();
-            for (int i = 0; i < numAreaNodes; ++i)
+            for (int i = 0; i < numNodes; ++i)
             {
-                outscratch[thisArea[i]] = 1.0f;//make it into a simple 0/1 metric, even if it wasn't before
+                if (labels[i] == bestIndex)
+                {
+                    outscratch[i] = 1.0f;//make it into a simple 0/1 metric, even if it wasn't before
+                }
             }
         }
         myMetricOut->setValuesForColumn(col, outscratch.data());
@@ -159,13 +159,15 @@ AlgorithmMetricTFCE::AlgorithmMetricTFCE(ProgressObject* myProgObj, const Surfac
         int numCols = myMetric->getNumberOfColumns();
         myMetricOut->setNumberOfNodesAndColumns(mySurf->getNumberOfNodes(), numCols);
         myMetricOut->setStructure(mySurf->getStructure());
+        CaretPointer<TopologyHelper> myHelper = mySurf->getTopologyHelper();//one helper for all columns, getNodeNeighbors is const
 #pragma omp CARET_PAR
         {
             vector<float> outcol(mySurf->getNumberOfNodes(), 0.0f);
+            TFCEScratch myScratch;
 #pragma omp CARET_FOR
             for (int col = 0; col < numCols; ++col)
             {
-                processColumn(mySurf, toUse->getValuePointerForColumn(col), outcol.data(), roiData, param_e, param_h, areaData);
+                processColumn(myHelper, toUse->getValuePointerForColumn(col), outcol.data(), roiData, param_e, param_h, areaData, myScratch);
                 myMetricOut->setValuesForColumn(col, outcol.data());
                 myMetricOut->setMapName(col, myMetric->getMapName(col));
             }
@@ -183,24 +185,27 @@ AlgorithmMetricTFCE::AlgorithmMetricTFCE(ProgressObject* myProgObj, const Surfac
         myMetricOut->setNumberOfNodesAndColumns(mySurf->getNumberOfNodes(), 1);
         myMetricOut->setStructure(mySurf->getStructure());
         vector<float> outcol(mySurf->getNumberOfNodes(), 0.0f);
-        processColumn(mySurf, toUse->getValuePointerForColumn(useCol), outcol.data(), roiData, param_e, param_h, areaData);
+        TFCEScratch myScratch;
+        processColumn(mySurf->getTopologyHelper(), toUse->getValuePointerForColumn(useCol), outcol.data(), roiData, param_e, param_h, areaData, myScratch);
         myMetricOut->setValuesForColumn(0, outcol.data());
         myMetricOut->setMapName(0, myMetric->getMapName(columnNum));
     }
 }
 
-void AlgorithmMetricTFCE::processColumn(const SurfaceFile* mySurf, const float* colData, float* outData, const float* roiData, const float& param_e, const float& param_h, const float* areaData)
+void AlgorithmMetricTFCE::processColumn(TopologyHelper* myHelper, const float* colData, float* outData, const float* roiData, const float& param_e, const float& param_h, const float* areaData,
+                                        TFCEScratch& scratch)
 {
-    int numNodes = mySurf->getNumberOfNodes();
-    vector<double> accum(numNodes, 0.0);
-    CaretPointer<TopologyHelper> myHelper = mySurf->getTopologyHelper();
-    tfce_pos(myHelper, colData, accum.data(), roiData, param_e, param_h, areaData);
-    vector<float> negData(numNodes);
+    int numNodes = myHelper->getNumberOfNodes();
+    vector<double>& accum = scratch.accum;
+    accum.assign(numNodes, 0.0);//assign doesn't reallocate after the first column
+    tfce_pos(myHelper, colData, accum.data(), roiData, param_e, param_h, areaData, scratch.membership);
+    vector<float>& negData = scratch.negData;
+    negData.resize(numNodes);
     for (int i = 0; i < numNodes; ++i)
     {
         negData[i] = -colData[i];
     }
-    tfce_pos(myHelper, negData.data(), accum.data(), roiData, param_e, param_h, areaData);//negatives and positives don't overlap, so reuse the accum array
+    tfce_pos(myHelper, negData.data(), accum.data(), roiData, param_e, param_h, areaData, scratch.membership);//negatives and positives don't overlap, so reuse the accum array
     for (int i = 0; i < numNodes; ++i)
     {
         if (roiData == NULL || roiData[i] > 0.0f)
@@ -272,10 +277,11 @@ namespace
     }
 }
 
-void AlgorithmMetricTFCE::tfce_pos(TopologyHelper* myHelper, const float* colData, double* accumData, const float* roiData, const float& param_e, const float& param_h, const float* areaData)
+void AlgorithmMetricTFCE::tfce_pos(TopologyHelper* myHelper, const float* colData, double* accumData, const float* roiData, const float& param_e, const float& param_h, const float* areaData,
+                                   vector<int>& membership)
 {
     int numNodes = myHelper->getNumberOfNodes();
-    vector<int> membership(numNodes, -1);//int is enough as long as numNodes is fine as an int, for obvious reasons
+    membership.assign(numNodes, -1);//int is enough as long as numNodes is fine as an int, for obvious reasons
     vector<Cluster> clusterList;
     set<int> deadClusters;//to allow reallocation without changing indices
     CaretSimpleMaxHeap<int, float> nodeHeap;
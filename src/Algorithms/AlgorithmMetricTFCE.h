@@ -23,15 +23,26 @@
 
 #include "AbstractAlgorithm.h"
 
+#include <vector>
+
 namespace caret {
     
     class TopologyHelper;
     
     class AlgorithmMetricTFCE : public AbstractAlgorithm
     {
+    public:
+        ///per-thread buffers, so that processing many columns on the same surface doesn't reallocate per column
+        struct TFCEScratch
+        {
+            std::vector<int> membership;
+            std::vector<double> accum;
+            std::vector<float> negData;
+        };
+    private:
         AlgorithmMetricTFCE();
-        void processColumn(const SurfaceFile* mySurf, const float* colData, float* outData, const float* roiData, const float& param_e, const float& param_h, const float* areaData);
-        void tfce_pos(TopologyHelper* myHelper, const float* colData, double* accumData, const float* roiData, const float& param_e, const float& param_h, const float* areaData);
+        static void tfce_pos(TopologyHelper* myHelper, const float* colData, double* accumData, const float* roiData, const float& param_e, const float& param_h, const float* areaData,
+                             std::vector<int>& membership);
     protected:
         static float getSubAlgorithmWeight();
         static float getAlgorithmInternalWeight();
@@ -42,6 +53,9 @@ namespace caret {
         static void useParameters(OperationParameters* myParams, ProgressObject* myProgObj);
         static AString getCommandSwitch();
         static AString getShortDescription();
+        ///TFCE of a single column, signed like the input, 0 outside the roi - also used by the permutation algorithm
+        static void processColumn(TopologyHelper* myHelper, const float* colData, float* outData, const float* roiData, const float& param_e, const float& param_h, const float* areaData,
+                                  TFCEScratch& scratch);
     };
 
     typedef TemplateAutoOperation<AlgorithmMetricTFCE> AutoAlgorithmMetricTFCE;
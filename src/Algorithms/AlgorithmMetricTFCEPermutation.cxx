@@ -0,0 +1,473 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AlgorithmMetricTFCEPermutation.h"
+#include "AlgorithmException.h"
+
+#include "AlgorithmMetricTFCE.h"
+#include "CaretOMP.h"
+#include "FileInformation.h"
+#include "MetricFile.h"
+#include "SurfaceFile.h"
+#include "TopologyHelper.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+AString AlgorithmMetricTFCEPermutation::getCommandSwitch()
+{
+    return "-metric-tfce-permutation";
+}
+
+AString AlgorithmMetricTFCEPermutation::getShortDescription()
+{
+    return "PERMUTATION TEST OF TFCE ON A METRIC FILE";
+}
+
+OperationParameters* AlgorithmMetricTFCEPermutation::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+    
+    ret->addSurfaceParameter(1, "surface", "the surface to compute on");
+    
+    ret->addMetricParameter(2, "metric-in", "the metric with one column per subject");
+    
+    ret->addMetricOutputParameter(3, "metric-out", "the output metric");
+    
+    OptionalParameter* groupOpt = ret->createOptionalParameter(4, "-two-sample", "shuffle group labels instead of flipping signs");
+    groupOpt->addStringParameter(1, "group-file", "text file containing a 0 or 1 for each column");
+    
+    OptionalParameter* permOpt = ret->createOptionalParameter(5, "-permutations", "set the number of permutations");
+    permOpt->addIntegerParameter(1, "num", "number of permutations including the unpermuted data (default 1000)");
+    
+    OptionalParameter* seedOpt = ret->createOptionalParameter(6, "-seed", "set the random seed");
+    seedOpt->addIntegerParameter(1, "seed", "the seed for generating permutations (default 0)");
+    
+    OptionalParameter* roiOpt = ret->createOptionalParameter(7, "-roi", "select a region of interest to run TFCE on");
+    roiOpt->addMetricParameter(1, "roi-metric", "the area to run TFCE on, as a metric");
+    
+    OptionalParameter* paramsOpt = ret->createOptionalParameter(8, "-parameters", "set parameters for TFCE integral");
+    paramsOpt->addDoubleParameter(1, "E", "exponent for cluster area (default 1.0)");
+    paramsOpt->addDoubleParameter(2, "H", "exponent for threshold value (default 2.0)");
+    
+    OptionalParameter* corrAreaOpt = ret->createOptionalParameter(9, "-corrected-areas", "vertex areas to use instead of computing them from the surface");
+    corrAreaOpt->addMetricParameter(1, "area-metric", "the corrected vertex areas, as a metric");
+    
+    OptionalParameter* distOpt = ret->createOptionalParameter(10, "-max-distribution", "output the maximum absolute TFCE value of each permutation");
+    distOpt->addStringParameter(1, "text-out", "output - text file to write the distribution to");
+    
+    ret->setHelpText(
+        AString("Computes a t-statistic at each vertex, runs TFCE on it (see -metric-tfce), and builds a null distribution of the maximum absolute TFCE value by permutation.  ") +
+        "By default, the test is a one-sample t-test against zero, and permutations randomly flip the sign of each column.  " +
+        "With -two-sample, the test is a pooled-variance two-sample t-test of group 1 minus group 0, and permutations shuffle the group labels.\n\n" +
+        "The first permutation is always the unpermuted data, and the permutations are determined only by the seed, so results do not depend on the number of threads.  " +
+        "The output metric has 3 columns: the t-statistic, its TFCE, and the familywise error corrected p-value of the TFCE, which is the fraction of permutations whose maximum absolute TFCE value is at least the absolute TFCE value at that vertex."
+    );
+    return ret;
+}
+
+void AlgorithmMetricTFCEPermutation::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    SurfaceFile* mySurf = myParams->getSurface(1);
+    MetricFile* myMetric = myParams->getMetric(2);
+    MetricFile* myMetricOut = myParams->getOutputMetric(3);
+    vector<int>* groups = NULL, realGroups;//NOTE: realGroups is NOT a pointer
+    OptionalParameter* groupOpt = myParams->getOptionalParameter(4);
+    if (groupOpt->m_present)
+    {
+        groups = &realGroups;
+        readGroupFile(groupOpt->getString(1), realGroups);
+    }
+    int numPerms = 1000;
+    OptionalParameter* permOpt = myParams->getOptionalParameter(5);
+    if (permOpt->m_present)
+    {
+        numPerms = (int)permOpt->getInteger(1);
+    }
+    int seed = 0;
+    OptionalParameter* seedOpt = myParams->getOptionalParameter(6);
+    if (seedOpt->m_present)
+    {
+        seed = (int)seedOpt->getInteger(1);
+    }
+    MetricFile* myRoi = NULL;
+    OptionalParameter* roiOpt = myParams->getOptionalParameter(7);
+    if (roiOpt->m_present)
+    {
+        myRoi = roiOpt->getMetric(1);
+    }
+    float param_e = 1.0f, param_h = 2.0f;
+    OptionalParameter* paramsOpt = myParams->getOptionalParameter(8);
+    if (paramsOpt->m_present)
+    {
+        param_e = (float)paramsOpt->getDouble(1);
+        param_h = (float)paramsOpt->getDouble(2);
+    }
+    MetricFile* corrAreaMetric = NULL;
+    OptionalParameter* corrAreaOpt = myParams->getOptionalParameter(9);
+    if (corrAreaOpt->m_present)
+    {
+        corrAreaMetric = corrAreaOpt->getMetric(1);
+    }
+    OptionalParameter* distOpt = myParams->getOptionalParameter(10);
+    vector<float> maxDist;
+    AlgorithmMetricTFCEPermutation(myProgObj, mySurf, myMetric, myMetricOut, numPerms, groups, myRoi, param_e, param_h, corrAreaMetric, seed, &maxDist);
+    if (distOpt->m_present)
+    {
+        writeMaxDistribution(distOpt->getString(1), maxDist);
+    }
+}
+
+void AlgorithmMetricTFCEPermutation::readGroupFile(const AString& fileName, vector<int>& groupsOut)
+{
+    FileInformation textFileInfo(fileName);
+    if (!textFileInfo.exists())
+    {
+        throw AlgorithmException("group file doesn't exist");
+    }
+    fstream groupFile(fileName.toLocal8Bit().constData(), fstream::in);
+    if (!groupFile.good())
+    {
+        throw AlgorithmException("error reading group file");
+    }
+    groupsOut.clear();
+    int label;
+    while (groupFile >> label)
+    {
+        groupsOut.push_back(label);
+    }
+}
+
+void AlgorithmMetricTFCEPermutation::writeMaxDistribution(const AString& fileName, const vector<float>& maxDist)
+{
+    ofstream distOut(fileName.toLocal8Bit().constData());
+    if (!distOut) throw AlgorithmException("failed to open text file for output");
+    for (int i = 0; i < (int)maxDist.size(); ++i)
+    {
+        distOut << maxDist[i] << endl;
+    }
+    if (!distOut) throw AlgorithmException("error writing to text file");
+}
+
+namespace
+{//hidden namespace just to make sure things don't collide
+    //mt19937 and seed_seq are fully specified by the standard, and we don't use std distributions (implementation-defined), so permutations are reproducible everywhere
+    void makeDesign(const int& perm, const int& seed, const vector<int>* groups, vector<int>& design)
+    {
+        int numCols = (int)design.size();
+        if (groups == NULL)
+        {
+            design.assign(numCols, 1);
+        } else {
+            design = *groups;
+        }
+        if (perm == 0) return;//unpermuted
+        seed_seq mySeq = { (uint32_t)seed, (uint32_t)perm };
+        mt19937 myRand(mySeq);
+        if (groups == NULL)
+        {
+            for (int i = 0; i < numCols; ++i)
+            {
+                if ((myRand() >> 31) != 0) design[i] = -1;
+            }
+        } else {
+            for (int i = numCols - 1; i > 0; --i)//fisher-yates
+            {
+                int j = (int)(myRand() % (uint32_t)(i + 1));
+                swap(design[i], design[j]);
+            }
+        }
+    }
+    
+    //sum of squares doesn't change under sign flips, and the total sums don't change under label shuffles, so only the signed/group sums need to be recomputed per permutation
+    void computeStat(const vector<const float*>& columns, const vector<int>& design, const bool& twoSample, const double* totalSum, const double* totalSumSq,
+                     const float* roiData, float* statOut, vector<double>& sumScratch, vector<double>& sumSqScratch, const int64_t& numElements)
+    {
+        int numCols = (int)columns.size();
+        sumScratch.assign(numElements, 0.0);
+        if (twoSample)
+        {
+            sumSqScratch.assign(numElements, 0.0);
+            int count1 = 0;
+            for (int c = 0; c < numCols; ++c)
+            {
+                if (design[c] == 0) continue;
+                ++count1;
+                const float* colData = columns[c];
+                for (int64_t i = 0; i < numElements; ++i)
+                {
+                    sumScratch[i] += colData[i];
+                    sumSqScratch[i] += colData[i] * (double)colData[i];
+                }
+            }
+            int count0 = numCols - count1;
+            double countFactor = 1.0 / count0 + 1.0 / count1;
+            for (int64_t i = 0; i < numElements; ++i)
+            {
+                statOut[i] = 0.0f;
+                if (roiData != NULL && !(roiData[i] > 0.0f)) continue;
+                double sum1 = sumScratch[i], sum0 = totalSum[i] - sum1;
+                double ss1 = sumSqScratch[i] - sum1 * sum1 / count1, ss0 = (totalSumSq[i] - sumSqScratch[i]) - sum0 * sum0 / count0;
+                double pooledVar = (ss0 + ss1) / (numCols - 2);
+                if (pooledVar > 0.0)
+                {
+                    statOut[i] = (float)((sum1 / count1 - sum0 / count0) / sqrt(pooledVar * countFactor));
+                }
+            }
+        } else {
+            for (int c = 0; c < numCols; ++c)
+            {
+                const float* colData = columns[c];
+                if (design[c] < 0)
+                {
+                    for (int64_t i = 0; i < numElements; ++i)
+                    {
+                        sumScratch[i] -= colData[i];
+                    }
+                } else {
+                    for (int64_t i = 0; i < numElements; ++i)
+                    {
+                        sumScratch[i] += colData[i];
+                    }
+                }
+            }
+            for (int64_t i = 0; i < numElements; ++i)
+            {
+                statOut[i] = 0.0f;
+                if (roiData != NULL && !(roiData[i] > 0.0f)) continue;
+                double mean = sumScratch[i] / numCols;
+                double variance = (totalSumSq[i] - numCols * mean * mean) / (numCols - 1);
+                if (variance > 0.0)
+                {
+                    statOut[i] = (float)(mean / sqrt(variance / numCols));
+                }
+            }
+        }
+    }
+}
+
+namespace
+{
+    class MetricTFCEMapper : public AlgorithmMetricTFCEPermutation::TFCEMapper
+    {
+        TopologyHelper* m_helper;//shared, the topology helper is thread safe
+        const float* m_roiData, *m_areaData;
+        float m_param_e, m_param_h;
+        AlgorithmMetricTFCE::TFCEScratch m_scratch;
+    public:
+        MetricTFCEMapper(TopologyHelper* myHelper, const float* roiData, const float* areaData, const float& param_e, const float& param_h)
+        {
+            m_helper = myHelper;
+            m_roiData = roiData;
+            m_areaData = areaData;
+            m_param_e = param_e;
+            m_param_h = param_h;
+        }
+        TFCEMapper* clone() const { return new MetricTFCEMapper(m_helper, m_roiData, m_areaData, m_param_e, m_param_h); }
+        void tfce(const float* statData, float* tfceOut)
+        {
+            AlgorithmMetricTFCE::processColumn(m_helper, statData, tfceOut, m_roiData, m_param_e, m_param_h, m_areaData, m_scratch);
+        }
+    };
+}
+
+AlgorithmMetricTFCEPermutation::AlgorithmMetricTFCEPermutation(ProgressObject* myProgObj, const SurfaceFile* mySurf, const MetricFile* myMetric, MetricFile* myMetricOut, const int& numPerms,
+                                                               const vector<int>* groups, const MetricFile* myRoi, const float& param_e, const float& param_h,
+                                                               const MetricFile* corrAreaMetric, const int& seed, vector<float>* maxDistOut) : AbstractAlgorithm(myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    int numNodes = mySurf->getNumberOfNodes();
+    if (myMetric->getNumberOfNodes() != numNodes) throw AlgorithmException("metric and surface have different number of vertices");
+    if (myRoi != NULL && myRoi->getNumberOfNodes() != numNodes) throw AlgorithmException("roi metric and surface have different number of vertices");
+    if (corrAreaMetric != NULL && corrAreaMetric->getNumberOfNodes() != numNodes) throw AlgorithmException("corrected area metric and surface have different number of vertices");
+    int numCols = myMetric->getNumberOfColumns();
+    const float* roiData = NULL, *areaData = NULL;
+    vector<float> surfAreaData;
+    if (corrAreaMetric == NULL)
+    {
+        mySurf->computeNodeAreas(surfAreaData);
+        areaData = surfAreaData.data();
+    } else {
+        areaData = corrAreaMetric->getValuePointerForColumn(0);
+    }
+    if (myRoi != NULL) roiData = myRoi->getValuePointerForColumn(0);
+    vector<const float*> columns(numCols);
+    for (int c = 0; c < numCols; ++c)
+    {
+        columns[c] = myMetric->getValuePointerForColumn(c);
+    }
+    CaretPointer<TopologyHelper> myHelper = mySurf->getTopologyHelper();//shared by all permutations and threads
+    MetricTFCEMapper myMapper(myHelper, roiData, areaData, param_e, param_h);
+    vector<float> observedStat, observedTFCE, pvals, maxDist;
+    permutationTest(myProgress, columns, numNodes, roiData, myMapper, numPerms, groups, seed, observedStat, observedTFCE, pvals, maxDist);
+    myMetricOut->setNumberOfNodesAndColumns(numNodes, 3);
+    myMetricOut->setStructure(mySurf->getStructure());
+    myMetricOut->setValuesForColumn(0, observedStat.data());
+    myMetricOut->setMapName(0, "t-statistic");
+    myMetricOut->setValuesForColumn(1, observedTFCE.data());
+    myMetricOut->setMapName(1, "TFCE");
+    myMetricOut->setValuesForColumn(2, pvals.data());
+    myMetricOut->setMapName(2, "FWE corrected p");
+    if (maxDistOut != NULL) *maxDistOut = maxDist;
+}
+
+void AlgorithmMetricTFCEPermutation::permutationTest(LevelProgress& myProgress, const vector<const float*>& columns, const int64_t& numElements, const float* roiData, const TFCEMapper& myMapper,
+                                                     const int& numPerms, const vector<int>* groups, const int& seed,
+                                                     vector<float>& statOut, vector<float>& tfceOut, vector<float>& pvalOut, vector<float>& maxDistOut)
+{
+    if (numPerms < 1) throw AlgorithmException("number of permutations must be positive");
+    int numCols = (int)columns.size();
+    bool twoSample = (groups != NULL);
+    if (twoSample)
+    {
+        if ((int)groups->size() != numCols) throw AlgorithmException("number of group labels doesn't match number of columns");
+        int count1 = 0;
+        for (int c = 0; c < numCols; ++c)
+        {
+            if ((*groups)[c] != 0 && (*groups)[c] != 1) throw AlgorithmException("group labels must be 0 or 1");
+            count1 += (*groups)[c];
+        }
+        if (count1 < 1 || count1 == numCols || numCols < 3) throw AlgorithmException("two-sample test needs at least one column in each group, and at least 3 columns");
+    } else {
+        if (numCols < 2) throw AlgorithmException("one-sample test needs at least 2 columns");
+    }
+    vector<double> totalSum(numElements, 0.0), totalSumSq(numElements, 0.0);
+    for (int c = 0; c < numCols; ++c)
+    {
+        for (int64_t i = 0; i < numElements; ++i)
+        {
+            totalSum[i] += columns[c][i];
+            totalSumSq[i] += columns[c][i] * (double)columns[c][i];
+        }
+    }
+    maxDistOut.resize(numPerms);
+    statOut.resize(numElements);
+    tfceOut.resize(numElements);
+    int numDone = 0;
+    bool failed = false;
+    AString errorMessage;
+    myProgress.setTask("Running permutations");
+#pragma omp CARET_PAR
+    {
+        CaretPointer<TFCEMapper> threadMapper;
+        vector<int> design;
+        vector<double> sumScratch, sumSqScratch;
+        vector<float> statCol, tfceCol;
+        bool threadReady = false;
+        try
+        {
+            threadMapper.grabNew(myMapper.clone());
+            design.resize(numCols);
+            statCol.resize(numElements);
+            tfceCol.resize(numElements);
+            threadReady = true;
+        } catch (CaretException& e) {//exceptions can't leave a parallel region, and every thread must still reach the loop
+#pragma omp critical
+            {
+                failed = true;
+                errorMessage = e.whatString();
+            }
+        } catch (std::exception& e) {
+#pragma omp critical
+            {
+                failed = true;
+                errorMessage = AString("exception during permutations: ") + e.what();
+            }
+        } catch (...) {
+#pragma omp critical
+            {
+                failed = true;
+                errorMessage = "unknown exception during permutations";
+            }
+        }
+#pragma omp CARET_FOR schedule(dynamic)
+        for (int perm = 0; perm < numPerms; ++perm)
+        {
+            if (!threadReady) continue;
+            try
+            {
+                makeDesign(perm, seed, groups, design);
+                computeStat(columns, design, twoSample, totalSum.data(), totalSumSq.data(), roiData, statCol.data(), sumScratch, sumSqScratch, numElements);
+                threadMapper->tfce(statCol.data(), tfceCol.data());
+                float maxVal = 0.0f;
+                for (int64_t i = 0; i < numElements; ++i)
+                {
+                    maxVal = max(maxVal, abs(tfceCol[i]));
+                }
+                maxDistOut[perm] = maxVal;
+                if (perm == 0)
+                {
+                    statOut = statCol;
+                    tfceOut = tfceCol;
+                }
+#pragma omp critical
+                {
+                    ++numDone;
+                    myProgress.reportProgress(((float)numDone) / numPerms);
+                }
+            } catch (CaretException& e) {
+#pragma omp critical
+                {
+                    failed = true;
+                    errorMessage = e.whatString();
+                }
+            } catch (std::exception& e) {
+#pragma omp critical
+                {
+                    failed = true;
+                    errorMessage = AString("exception during permutations: ") + e.what();
+                }
+            } catch (...) {
+#pragma omp critical
+                {
+                    failed = true;
+                    errorMessage = "unknown exception during permutations";
+                }
+            }
+        }
+    }
+    if (failed) throw AlgorithmException(errorMessage);
+    vector<float> sortedDist = maxDistOut;
+    sort(sortedDist.begin(), sortedDist.end());
+    pvalOut.assign(numElements, 1.0f);
+    for (int64_t i = 0; i < numElements; ++i)
+    {
+        if (roiData != NULL && !(roiData[i] > 0.0f)) continue;
+        int numAtLeast = (int)(sortedDist.end() - lower_bound(sortedDist.begin(), sortedDist.end(), abs(tfceOut[i])));
+        pvalOut[i] = ((float)numAtLeast) / numPerms;
+    }
+}
+
+float AlgorithmMetricTFCEPermutation::getAlgorithmInternalWeight()
+{
+    return 1.0f;//override this if needed, if the progress bar isn't smooth
+}
+
+float AlgorithmMetricTFCEPermutation::getSubAlgorithmWeight()
+{
+    //return AlgorithmInsertNameHere::getAlgorithmWeight();//if you use a subalgorithm
+    return 0.0f;
+}
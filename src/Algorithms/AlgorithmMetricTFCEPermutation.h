@@ -0,0 +1,67 @@
+#ifndef __ALGORITHM_METRIC_TFCE_PERMUTATION_H__
+#define __ALGORITHM_METRIC_TFCE_PERMUTATION_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AbstractAlgorithm.h"
+
+#include <vector>
+
+namespace caret {
+    
+    class AlgorithmMetricTFCEPermutation : public AbstractAlgorithm
+    {
+        AlgorithmMetricTFCEPermutation();
+    protected:
+        static float getSubAlgorithmWeight();
+        static float getAlgorithmInternalWeight();
+    public:
+        ///runs TFCE on one map of statistics, each thread of the permutation test uses its own clone
+        class TFCEMapper
+        {
+        public:
+            virtual TFCEMapper* clone() const = 0;
+            virtual void tfce(const float* statData, float* tfceOut) = 0;
+            virtual ~TFCEMapper() { }
+        };
+        ///shared by the metric, volume, and cifti permutation algorithms: columns are the subjects, each numElements long, elements outside the roi get 0 statistic and p-value 1
+        static void permutationTest(LevelProgress& myProgress, const std::vector<const float*>& columns, const int64_t& numElements, const float* roiData, const TFCEMapper& myMapper,
+                                    const int& numPerms, const std::vector<int>* groups, const int& seed,
+                                    std::vector<float>& statOut, std::vector<float>& tfceOut, std::vector<float>& pvalOut, std::vector<float>& maxDistOut);
+        ///reads a 0 or 1 per column, for -two-sample
+        static void readGroupFile(const AString& fileName, std::vector<int>& groupsOut);
+        ///writes the result of -max-distribution
+        static void writeMaxDistribution(const AString& fileName, const std::vector<float>& maxDist);
+        ///groups NULL means one-sample sign-flipping, otherwise one 0/1 label per column for a two-sample label shuffle
+        AlgorithmMetricTFCEPermutation(ProgressObject* myProgObj, const SurfaceFile* mySurf, const MetricFile* myMetric, MetricFile* myMetricOut, const int& numPerms = 1000,
+                                       const std::vector<int>* groups = NULL, const MetricFile* myRoi = NULL, const float& param_e = 1.0f, const float& param_h = 2.0f,
+                                       const MetricFile* corrAreaMetric = NULL, const int& seed = 0, std::vector<float>* maxDistOut = NULL);
+        static OperationParameters* getParameters();
+        static void useParameters(OperationParameters* myParams, ProgressObject* myProgObj);
+        static AString getCommandSwitch();
+        static AString getShortDescription();
+    };
+
+    typedef TemplateAutoOperation<AlgorithmMetricTFCEPermutation> AutoAlgorithmMetricTFCEPermutation;
+
+}
+
+#endif //__ALGORITHM_METRIC_TFCE_PERMUTATION_H__
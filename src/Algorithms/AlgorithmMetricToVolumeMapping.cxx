@@ -23,7 +23,7 @@
 
 #include "CaretAssert.h"
 #include "CaretOMP.h"
-#include "CaretPointLocator.h"
+#include "CaretKdTree.h"
 #include "MetricFile.h"
 #include "RibbonMappingHelper.h"
 #include "SurfaceFile.h"
@@ -64,7 +64,7 @@ OperationParameters* AlgorithmMetricToVolumeMapping::getParameters()
     ribbonOpt->addSurfaceParameter(1, "inner-surf", "the inner surface of the ribbon");
     ribbonOpt->addSurfaceParameter(2, "outer-surf", "the outer surface of the ribbon");
     OptionalParameter* ribbonSubdivOpt = ribbonOpt->createOptionalParameter(3, "-voxel-subdiv", "voxel divisions while estimating voxel weights");
-    ribbonSubdivOpt->addIntegerParameter(1, "subdiv-num", "number of subdivisions, default 3");
+    ribbonSubdivOpt->addIntegerParameter(1, "subdiv-num", "number of subdivisions, default 3, 0 for exact overlap");
     ribbonOpt->createOptionalParameter(4, "-greedy", "instead of antialiasing partial-volumed voxels, put full metric values (legacy behavior)");
     ribbonOpt->createOptionalParameter(5, "-thick-columns", "use overlapping columns (legacy method)");
     
@@ -122,7 +122,7 @@ void AlgorithmMetricToVolumeMapping::useParameters(OperationParameters* myParams
         if (ribbonSubdivOpt->m_present)
         {
             subDivs = (int)ribbonSubdivOpt->getInteger(1);
-            if (subDivs < 1)
+            if (subDivs < 0)
             {
                 throw AlgorithmException("invalid number of subdivisions specified");
             }
@@ -166,7 +166,7 @@ AlgorithmMetricToVolumeMapping::AlgorithmMetricToVolumeMapping(ProgressObject* m
     const int64_t* dims = myVolSpace.getDims();
     const int64_t frameSize = dims[0] * dims[1] * dims[2];
     vector<int32_t> voxelToVertex(frameSize);
-    CaretPointer<const CaretPointLocator> myLocator = mySurf->getPointLocator();
+    CaretPointer<const CaretKdTree> myLocator = mySurf->getPointLocator();
 #pragma omp CARET_PARFOR schedule(dynamic)
     for (int64_t k = 0; k < dims[2]; ++k)
     {
@@ -21,7 +21,7 @@
 #include "AlgorithmVolumeErode.h"
 #include "AlgorithmException.h"
 
-#include "CaretPointLocator.h"
+#include "CaretKdTree.h"
 #include "VolumeFile.h"
 
 #include <algorithm>
@@ -140,7 +140,7 @@ namespace
                 }
             }
         }
-        CaretPointLocator myLocator(coordList.data(), coordList.size() / 3);
+        CaretKdTree myLocator(coordList.data(), coordList.size() / 3);
         for (int64_t k = 0; k < myDims[2]; ++k)
         {
             for (int64_t j = 0; j < myDims[1]; ++j)
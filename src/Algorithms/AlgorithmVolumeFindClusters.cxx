@@ -24,7 +24,9 @@
 #include "CaretAssert.h"
 #include "CaretLogger.h"
 #include "CaretPointer.h"
-#include "CaretPointLocator.h"
+#include "CaretKdTree.h"
+#include "CaretOMP.h"
+#include "ConnectedComponentsHelper.h"
 #include "VolumeFile.h"
 #include "VoxelIJK.h"
 
@@ -145,16 +147,10 @@ namespace
         mySpace.getSpacingVectors(ivec, jvec, kvec, origin);
         float voxelVolume = abs(ivec.dot(jvec.cross(kvec)));
         int64_t minVoxels = (int64_t)ceil(minVolume / voxelVolume);
-        vector<VoxelIJK> neighbors;
-        neighbors.push_back(VoxelIJK(1, 0, 0));
-        neighbors.push_back(VoxelIJK(-1, 0, 0));
-        neighbors.push_back(VoxelIJK(0, 1, 0));
-        neighbors.push_back(VoxelIJK(0, -1, 0));
-        neighbors.push_back(VoxelIJK(0, 0, 1));
-        neighbors.push_back(VoxelIJK(0, 0, -1));
         vector<char> marked(frameSize, 0);
         if (lessThan)
         {
+#pragma omp CARET_PARFOR schedule(static)
             for (int64_t i = 0; i < frameSize; ++i)
             {
                 if ((roiFrame == NULL || roiFrame[i] > 0.0f) && inFrame[i] < threshValue)
@@ -163,6 +159,7 @@ namespace
                 }
             }
         } else {
+#pragma omp CARET_PARFOR schedule(static)
             for (int64_t i = 0; i < frameSize; ++i)
             {
                 if ((roiFrame == NULL || roiFrame[i] > 0.0f) && inFrame[i] > threshValue)
@@ -171,87 +168,64 @@ namespace
                 }
             }
         }
-        vector<vector<VoxelIJK> > clusters;
-        size_t biggestCount = 0;
+        vector<int64_t> labels;
+        vector<ConnectedComponentsHelper::Component> components;
+        ConnectedComponentsHelper::labelVoxels(dims.data(), marked.data(), voxelVolume, labels, components);
+        vector<int64_t> clusters;//components that are big enough, in the order a serial scan finds them
+        int64_t biggestCount = 0;
         int64_t biggestCluster = -1;
-        for (int64_t k = 0; k < dims[2]; ++k)
+        for (int64_t i = 0; i < (int64_t)components.size(); ++i)
         {
-            for (int64_t j = 0; j < dims[1]; ++j)
+            if (components[i].count >= minVoxels)
             {
-                for (int64_t i = 0; i < dims[0]; ++i)
+                if (components[i].count > biggestCount)
                 {
-                    int64_t myIndex = mySpace.getIndex(i, j, k);
-                    if (marked[myIndex])
-                    {
-                        vector<VoxelIJK> voxelList;
-                        voxelList.push_back(VoxelIJK(i, j, k));
-                        marked[myIndex] = 0;//don't let voxels get duplicated in the list
-                        for (int64_t index = 0; index < (int64_t)voxelList.size(); ++index)//NOTE: vector grows inside loop
-                        {
-                            const VoxelIJK& thisVoxel = voxelList[index];
-                            for (int n = 0; n < (int)neighbors.size(); ++n)
-                            {
-                                VoxelIJK neighVox(thisVoxel.m_ijk[0] + neighbors[n].m_ijk[0],
-                                                    thisVoxel.m_ijk[1] + neighbors[n].m_ijk[1],
-                                                    thisVoxel.m_ijk[2] + neighbors[n].m_ijk[2]);
-                                if (mySpace.indexValid(neighVox.m_ijk))
-                                {
-                                    int64_t neighIndex = mySpace.getIndex(neighVox.m_ijk);
-                                    if (marked[neighIndex])
-                                    {
-                                        voxelList.push_back(neighVox);
-                                        marked[neighIndex] = 0;
-                                    }
-                                }
-                            }
-                        }
-                        if ((int64_t)voxelList.size() >= minVoxels)
-                        {
-                            if (voxelList.size() > biggestCount)
-                            {
-                                biggestCount = voxelList.size();
-                                biggestCluster = (int64_t)clusters.size();
-                            }
-                            clusters.push_back(voxelList);
-                        }
-                    }
+                    biggestCount = components[i].count;
+                    biggestCluster = (int64_t)clusters.size();
                 }
+                clusters.push_back(i);
             }
         }
         if (!clusters.empty()) CaretAssert(biggestCluster != -1);
         if (biggestCluster != -1 && (distanceCutoff > 0.0f || sizeRatio > 0.0f))
         {
-            CaretPointer<CaretPointLocator> myLocator;
+            CaretPointer<CaretKdTree> myLocator;
+            vector<int64_t> memberOffsets, members;
             if (distanceCutoff > 0.0f)
             {
+                ConnectedComponentsHelper::getComponentMembers(labels, components, memberOffsets, members);
                 vector<float> biggestCoords;//gather coordinates of biggest cluster voxels
                 biggestCoords.reserve(biggestCount * 3);
-                for (size_t i = 0; i < clusters[biggestCluster].size(); ++i)
+                int64_t biggestComponent = clusters[biggestCluster];
+                for (int64_t i = memberOffsets[biggestComponent]; i < memberOffsets[biggestComponent + 1]; ++i)
                 {
                     float thisCoord[3];
-                    mySpace.indexToSpace(clusters[biggestCluster][i].m_ijk, thisCoord);
+                    VoxelIJK thisVoxel(members[i] % dims[0], (members[i] / dims[0]) % dims[1], members[i] / (dims[0] * dims[1]));
+                    mySpace.indexToSpace(thisVoxel.m_ijk, thisCoord);
                     biggestCoords.push_back(thisCoord[0]);
                     biggestCoords.push_back(thisCoord[1]);
                     biggestCoords.push_back(thisCoord[2]);
                 }
-                myLocator.grabNew(new CaretPointLocator(biggestCoords.data(), biggestCoords.size()));
+                myLocator.grabNew(new CaretKdTree(biggestCoords.data(), biggestCoords.size() / 3));
             }
             for (size_t i = 0; i < clusters.size(); ++i)
             {
                 if ((int64_t)i != biggestCluster)
                 {
+                    const ConnectedComponentsHelper::Component& thisComponent = components[clusters[i]];
                     bool erase = false;
-                    if (sizeRatio > 0.0f && ((float)clusters[i].size()) / biggestCount < sizeRatio)
+                    if (sizeRatio > 0.0f && ((float)thisComponent.count) / biggestCount < sizeRatio)
                     {
                         erase = true;
                     }
                     if (!erase && distanceCutoff > 0.0f)
                     {
                         erase = true;//erase unless we find a point close enough to the biggest cluster
-                        for (size_t j = 0; j < clusters[i].size(); ++j)
+                        for (int64_t j = memberOffsets[clusters[i]]; j < memberOffsets[clusters[i] + 1]; ++j)
                         {
                             float thisCoord[3];
-                            mySpace.indexToSpace(clusters[i][j].m_ijk, thisCoord);
+                            VoxelIJK thisVoxel(members[j] % dims[0], (members[j] / dims[0]) % dims[1], members[j] / (dims[0] * dims[1]));
+                            mySpace.indexToSpace(thisVoxel.m_ijk, thisCoord);
                             int32_t ret = myLocator->closestPointLimited(thisCoord, distanceCutoff);
                             if (ret == -1)
                             {
@@ -269,6 +243,7 @@ namespace
                 }
             }
         }
+        vector<float> componentMarks(components.size(), 0.0f);//components that were too small or got removed stay 0
         for (size_t i = 0; i < clusters.size(); ++i)
         {
             if (markVal == 0)
@@ -278,12 +253,19 @@ namespace
             }
             float tempVal = markVal;
             if ((int)tempVal != markVal) throw AlgorithmException("too many clusters, unable to mark them uniquely");
-            for (size_t index = 0; index < clusters[i].size(); ++index)
+            componentMarks[clusters[i]] = tempVal;
+            ++markVal;
+        }
+        vector<float> outFrame(frameSize, 0.0f);
+#pragma omp CARET_PARFOR schedule(static)
+        for (int64_t i = 0; i < frameSize; ++i)
+        {
+            if (labels[i] != -1)
             {
-                volOut->setValue(tempVal, clusters[i][index].m_ijk, outSubvol, outComponent);
+                outFrame[i] = componentMarks[labels[i]];
             }
-            ++markVal;
         }
+        volOut->setFrame(outFrame.data(), outSubvol, outComponent);
     }
 }
 
@@ -58,7 +58,7 @@ OperationParameters* AlgorithmVolumeLabelToSurfaceMapping::getParameters()
     OptionalParameter* roiVol = ribbonOpt->createOptionalParameter(3, "-volume-roi", "use a volume roi");
     roiVol->addVolumeParameter(1, "roi-volume", "the volume file");
     OptionalParameter* ribbonSubdiv = ribbonOpt->createOptionalParameter(4, "-voxel-subdiv", "voxel divisions while estimating voxel weights");
-    ribbonSubdiv->addIntegerParameter(1, "subdiv-num", "number of subdivisions, default 3");
+    ribbonSubdiv->addIntegerParameter(1, "subdiv-num", "number of subdivisions, default 3, 0 for exact overlap");
     ribbonOpt->createOptionalParameter(5, "-thin-columns", "use non-overlapping polyhedra");
     
     OptionalParameter* subvolumeSelect = ret->createOptionalParameter(5, "-subvol-select", "select a single subvolume to map");
@@ -72,7 +72,7 @@ OperationParameters* AlgorithmVolumeLabelToSurfaceMapping::getParameters()
         "This may require increasing -voxel-subdiv to get enough samples in each voxel to reliably land inside these smaller polyhedra.  "
         "The volume ROI is useful to exclude partial volume effects of voxels the surfaces pass through, and will cause the mapping to ignore " +
         "voxels that don't have a positive value in the mask.  The subdivision number specifies how it approximates the amount of the volume the polyhedron " +
-        "intersects, by splitting each voxel into NxNxN pieces, and checking whether the center of each piece is inside the polyhedron.  If you have very large " +
+        "intersects, by splitting each voxel into NxNxN pieces, and checking whether the center of each piece is inside the polyhedron.  A subdivision number of 0 instead computes the exact overlap.  If you have very large " +
         "voxels, consider increasing this if you get unexpected unlabeled vertices in your output."
     );
     return ret;
@@ -109,7 +109,7 @@ void AlgorithmVolumeLabelToSurfaceMapping::useParameters(OperationParameters* my
         if (ribbonSubdiv->m_present)
         {
             subdivisions = ribbonSubdiv->getInteger(1);
-            if (subdivisions < 1)
+            if (subdivisions < 0)
             {
                 throw AlgorithmException("invalid number of subdivisions specified");
             }
@@ -141,7 +141,7 @@ AlgorithmVolumeTFCE::AlgorithmVolumeTFCE(ProgressObject* myProgObj, const Volume
             {
                 for (int64_t c = 0; c < dims[4]; ++c)
                 {
-                    processFrame(toUse, b, c, outframe.data(), roiFrame, param_e, param_h);
+                    processFrame(toUse->getVolumeSpace(), toUse->getFrame(b, c), outframe.data(), roiFrame, param_e, param_h);
                     myVolOut->setFrame(outframe.data(), b, c);
                 }
             }
@@ -162,20 +162,19 @@ AlgorithmVolumeTFCE::AlgorithmVolumeTFCE(ProgressObject* myProgObj, const Volume
         vector<float> outframe(dims[0] * dims[1] * dims[2]);
         for (int64_t c = 0; c < dims[4]; ++c)
         {
-            processFrame(toUse, useFrame, c, outframe.data(), roiFrame, param_e, param_h);
+            processFrame(toUse->getVolumeSpace(), toUse->getFrame(useFrame, c), outframe.data(), roiFrame, param_e, param_h);
             myVolOut->setFrame(outframe.data(), 0, c);
         }
     }
 }
 
-void AlgorithmVolumeTFCE::processFrame(const VolumeFile* inVol, const int64_t& b, const int64_t& c, float* outData, const float* roiData, const float& param_e, const float& param_h)
+void AlgorithmVolumeTFCE::processFrame(const VolumeSpace& mySpace, const float* inData, float* outData, const float* roiData, const float& param_e, const float& param_h)
 {
-    vector<int64_t> dims = inVol->getDimensions();
+    const int64_t* dims = mySpace.getDims();
     int64_t frameSize = dims[0] * dims[1] * dims[2];
     vector<double> accum(frameSize, 0.0);
-    tfce(inVol, b, c, accum.data(), roiData, param_e, param_h, false);//don't negate - positives
-    tfce(inVol, b, c, accum.data(), roiData, param_e, param_h, true);//negate - negatives - NOTE: output is still positive!!!
-    const float* inData = inVol->getFrame(b, c);
+    tfce(mySpace, inData, accum.data(), roiData, param_e, param_h, false);//don't negate - positives
+    tfce(mySpace, inData, accum.data(), roiData, param_e, param_h, true);//negate - negatives - NOTE: output is still positive!!!
     for (int64_t i = 0; i < frameSize; ++i)
     {
         if (inData[i] > 0.0f)//negate the results from negative inputs
@@ -242,14 +241,13 @@ namespace
     }
 }
 
-void AlgorithmVolumeTFCE::tfce(const VolumeFile* inVol, const int64_t& b, const int64_t& c, double* accumData, const float* roiData, const float& param_e, const float& param_h, const bool& negate)
+void AlgorithmVolumeTFCE::tfce(const VolumeSpace& mySpace, const float* frameData, double* accumData, const float* roiData, const float& param_e, const float& param_h, const bool& negate)
 {
-    vector<int64_t> dims = inVol->getDimensions();
+    const int64_t* dims = mySpace.getDims();
     Vector3D ivec, jvec, kvec, origin;//compute the volume of a voxel so different resolutions have comparable values - as if it matters, but hey
-    inVol->getVolumeSpace().getSpacingVectors(ivec, jvec, kvec, origin);//who knows, maybe we'll have distortion correction in volume someday
+    mySpace.getSpacingVectors(ivec, jvec, kvec, origin);//who knows, maybe we'll have distortion correction in volume someday
     float voxelVolume = abs(ivec.dot(jvec.cross(kvec)));
     const int64_t frameSize = dims[0] * dims[1] * dims[2];
-    const float* frameData = inVol->getFrame(b, c);
     vector<int64_t> membership(frameSize, -1);//use int64_t just in case we get an absurd number of clusters
     vector<Cluster> clusterList;
     set<int64_t> deadClusters;//to allow reallocation without changing indices
@@ -260,7 +258,7 @@ void AlgorithmVolumeTFCE::tfce(const VolumeFile* inVol, const int64_t& b, const
         {
             for (int64_t k = 0; k < dims[2]; ++k)
             {
-                int64_t index = inVol->getIndex(i, j, k);
+                int64_t index = mySpace.getIndex(i, j, k);
                 if ((roiData == NULL || roiData[index] > 0.0f))
                 {
                     if (negate)
@@ -290,14 +288,14 @@ void AlgorithmVolumeTFCE::tfce(const VolumeFile* inVol, const int64_t& b, const
     {
         float value;
         VoxelIJK voxel = voxelHeap.pop(&value);
-        int64_t voxelIndex = inVol->getIndex(voxel.m_ijk);
+        int64_t voxelIndex = mySpace.getIndex(voxel.m_ijk);
         set<int64_t> touchingClusters;
         for (int i = 0; i < STENCIL_SIZE; i += 3)
         {
             VoxelIJK neighVoxel(voxel.m_ijk[0] + stencil[i], voxel.m_ijk[1] + stencil[i + 1], voxel.m_ijk[2] + stencil[i + 2]);
-            if (inVol->indexValid(neighVoxel.m_ijk))
+            if (mySpace.indexValid(neighVoxel.m_ijk))
             {
-                int64_t neighIndex = inVol->getIndex(neighVoxel.m_ijk);
+                int64_t neighIndex = mySpace.getIndex(neighVoxel.m_ijk);
                 if (membership[neighIndex] != -1)
                 {
                     touchingClusters.insert(membership[neighIndex]);
@@ -346,7 +344,7 @@ void AlgorithmVolumeTFCE::tfce(const VolumeFile* inVol, const int64_t& b, const
                         double correctionVal = thisCluster.accumVal - mergedCluster.accumVal;//fix the accum values in the side cluster so we can add the merged cluster's accum to everything at the end
                         for (int64_t j = 0; j < numMembers; ++j)//add the correction value to every member so that we have the current integrated values correct
                         {
-                            int64_t memberIndex = inVol->getIndex(thisCluster.members[j].m_ijk);
+                            int64_t memberIndex = mySpace.getIndex(thisCluster.members[j].m_ijk);
                             accumData[memberIndex] += correctionVal;//apply the correction
                             membership[memberIndex] = mergedIndex;//and update membership
                         }
@@ -372,7 +370,7 @@ void AlgorithmVolumeTFCE::tfce(const VolumeFile* inVol, const int64_t& b, const
         int numMembers = (int)thisCluster.members.size();
         for (int j = 0; j < numMembers; ++j)
         {
-            accumData[inVol->getIndex(thisCluster.members[j].m_ijk)] += thisCluster.accumVal;//add the resulting slice to all members - their stored data contains the offset between the cluster peak and their corect value
+            accumData[mySpace.getIndex(thisCluster.members[j].m_ijk)] += thisCluster.accumVal;//add the resulting slice to all members - their stored data contains the offset between the cluster peak and their corect value
         }
     }
 }
@@ -25,11 +25,12 @@
 
 namespace caret {
     
+    class VolumeSpace;
+    
     class AlgorithmVolumeTFCE : public AbstractAlgorithm
     {
         AlgorithmVolumeTFCE();
-        void processFrame(const VolumeFile* inVol, const int64_t& b, const int64_t& c, float* outData, const float* roiData, const float& param_e, const float& param_h);
-        void tfce(const VolumeFile* inVol, const int64_t& b, const int64_t& c, double* accumData, const float* roiData, const float& param_e, const float& param_h, const bool& negate);
+        static void tfce(const VolumeSpace& mySpace, const float* frameData, double* accumData, const float* roiData, const float& param_e, const float& param_h, const bool& negate);
     protected:
         static float getSubAlgorithmWeight();
         static float getAlgorithmInternalWeight();
@@ -40,6 +41,8 @@ namespace caret {
         static void useParameters(OperationParameters* myParams, ProgressObject* myProgObj);
         static AString getCommandSwitch();
         static AString getShortDescription();
+        ///TFCE of a single frame, signed like the input, 0 outside the roi - also used by the permutation algorithms
+        static void processFrame(const VolumeSpace& mySpace, const float* inData, float* outData, const float* roiData, const float& param_e, const float& param_h);
     };
 
     typedef TemplateAutoOperation<AlgorithmVolumeTFCE> AutoAlgorithmVolumeTFCE;
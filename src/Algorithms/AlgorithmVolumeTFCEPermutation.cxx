@@ -0,0 +1,191 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AlgorithmMetricTFCEPermutation.h"
+#include "AlgorithmException.h"
+
+#include "AlgorithmVolumeTFCEPermutation.h"
+#include "AlgorithmException.h"
+
+#include "AlgorithmMetricTFCEPermutation.h"
+#include "AlgorithmVolumeTFCE.h"
+#include "VolumeFile.h"
+
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+AString AlgorithmVolumeTFCEPermutation::getCommandSwitch()
+{
+    return "-volume-tfce-permutation";
+}
+
+AString AlgorithmVolumeTFCEPermutation::getShortDescription()
+{
+    return "PERMUTATION TEST OF TFCE ON A VOLUME FILE";
+}
+
+OperationParameters* AlgorithmVolumeTFCEPermutation::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+    
+    ret->addVolumeParameter(1, "volume-in", "the volume with one subvolume per subject");
+    
+    ret->addVolumeOutputParameter(2, "volume-out", "the output volume");
+    
+    OptionalParameter* groupOpt = ret->createOptionalParameter(3, "-two-sample", "shuffle group labels instead of flipping signs");
+    groupOpt->addStringParameter(1, "group-file", "text file containing a 0 or 1 for each subvolume");
+    
+    OptionalParameter* permOpt = ret->createOptionalParameter(4, "-permutations", "set the number of permutations");
+    permOpt->addIntegerParameter(1, "num", "number of permutations including the unpermuted data (default 1000)");
+    
+    OptionalParameter* seedOpt = ret->createOptionalParameter(5, "-seed", "set the random seed");
+    seedOpt->addIntegerParameter(1, "seed", "the seed for generating permutations (default 0)");
+    
+    OptionalParameter* roiOpt = ret->createOptionalParameter(6, "-roi", "select a region of interest to run TFCE on");
+    roiOpt->addVolumeParameter(1, "roi-volume", "the area to run TFCE on, as a volume");
+    
+    OptionalParameter* paramsOpt = ret->createOptionalParameter(7, "-parameters", "set parameters for TFCE integral");
+    paramsOpt->addDoubleParameter(1, "E", "exponent for cluster volume (default 0.5)");
+    paramsOpt->addDoubleParameter(2, "H", "exponent for threshold value (default 2.0)");
+    
+    OptionalParameter* distOpt = ret->createOptionalParameter(8, "-max-distribution", "output the maximum absolute TFCE value of each permutation");
+    distOpt->addStringParameter(1, "text-out", "output - text file to write the distribution to");
+    
+    ret->setHelpText(
+        AString("Computes a t-statistic at each voxel, runs TFCE on it (see -volume-tfce), and builds a null distribution of the maximum absolute TFCE value by permutation.  ") +
+        "The tests, permutations, and outputs are the same as -metric-tfce-permutation, with subvolumes in place of metric columns.  " +
+        "The output volume has 3 subvolumes: the t-statistic, its TFCE, and the familywise error corrected p-value of the TFCE."
+    );
+    return ret;
+}
+
+void AlgorithmVolumeTFCEPermutation::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    VolumeFile* myVol = myParams->getVolume(1);
+    VolumeFile* myVolOut = myParams->getOutputVolume(2);
+    vector<int>* groups = NULL, realGroups;//NOTE: realGroups is NOT a pointer
+    OptionalParameter* groupOpt = myParams->getOptionalParameter(3);
+    if (groupOpt->m_present)
+    {
+        groups = &realGroups;
+        AlgorithmMetricTFCEPermutation::readGroupFile(groupOpt->getString(1), realGroups);
+    }
+    int numPerms = 1000;
+    OptionalParameter* permOpt = myParams->getOptionalParameter(4);
+    if (permOpt->m_present)
+    {
+        numPerms = (int)permOpt->getInteger(1);
+    }
+    int seed = 0;
+    OptionalParameter* seedOpt = myParams->getOptionalParameter(5);
+    if (seedOpt->m_present)
+    {
+        seed = (int)seedOpt->getInteger(1);
+    }
+    VolumeFile* myRoi = NULL;
+    OptionalParameter* roiOpt = myParams->getOptionalParameter(6);
+    if (roiOpt->m_present)
+    {
+        myRoi = roiOpt->getVolume(1);
+    }
+    float param_e = 0.5f, param_h = 2.0f;
+    OptionalParameter* paramsOpt = myParams->getOptionalParameter(7);
+    if (paramsOpt->m_present)
+    {
+        param_e = (float)paramsOpt->getDouble(1);
+        param_h = (float)paramsOpt->getDouble(2);
+    }
+    OptionalParameter* distOpt = myParams->getOptionalParameter(8);
+    vector<float> maxDist;
+    AlgorithmVolumeTFCEPermutation(myProgObj, myVol, myVolOut, numPerms, groups, myRoi, param_e, param_h, seed, &maxDist);
+    if (distOpt->m_present)
+    {
+        AlgorithmMetricTFCEPermutation::writeMaxDistribution(distOpt->getString(1), maxDist);
+    }
+}
+
+namespace
+{
+    class VolumeTFCEMapper : public AlgorithmMetricTFCEPermutation::TFCEMapper
+    {
+        VolumeSpace m_space;
+        const float* m_roiData;
+        float m_param_e, m_param_h;
+    public:
+        VolumeTFCEMapper(const VolumeSpace& mySpace, const float* roiData, const float& param_e, const float& param_h) : m_space(mySpace)
+        {
+            m_roiData = roiData;
+            m_param_e = param_e;
+            m_param_h = param_h;
+        }
+        TFCEMapper* clone() const { return new VolumeTFCEMapper(m_space, m_roiData, m_param_e, m_param_h); }
+        void tfce(const float* statData, float* tfceOut)
+        {
+            AlgorithmVolumeTFCE::processFrame(m_space, statData, tfceOut, m_roiData, m_param_e, m_param_h);
+        }
+    };
+}
+
+AlgorithmVolumeTFCEPermutation::AlgorithmVolumeTFCEPermutation(ProgressObject* myProgObj, const VolumeFile* myVol, VolumeFile* myVolOut, const int& numPerms,
+                                                               const vector<int>* groups, const VolumeFile* myRoi, const float& param_e, const float& param_h,
+                                                               const int& seed, vector<float>* maxDistOut) : AbstractAlgorithm(myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    const VolumeSpace& mySpace = myVol->getVolumeSpace();
+    if (myRoi != NULL && !mySpace.matches(myRoi->getVolumeSpace())) throw AlgorithmException("roi volume has different volume space than input");
+    vector<int64_t> dims = myVol->getDimensions();
+    if (dims[4] != 1) throw AlgorithmException("multi-component volumes are not supported");
+    int64_t frameSize = dims[0] * dims[1] * dims[2];
+    int numCols = (int)dims[3];
+    const float* roiData = NULL;
+    if (myRoi != NULL) roiData = myRoi->getFrame();
+    vector<const float*> columns(numCols);
+    for (int c = 0; c < numCols; ++c)
+    {
+        columns[c] = myVol->getFrame(c);
+    }
+    VolumeTFCEMapper myMapper(mySpace, roiData, param_e, param_h);
+    vector<float> observedStat, observedTFCE, pvals, maxDist;
+    AlgorithmMetricTFCEPermutation::permutationTest(myProgress, columns, frameSize, roiData, myMapper, numPerms, groups, seed, observedStat, observedTFCE, pvals, maxDist);
+    vector<int64_t> outDims = dims;
+    outDims.resize(4);
+    outDims[3] = 3;
+    myVolOut->reinitialize(outDims, myVol->getSform());
+    myVolOut->setFrame(observedStat.data(), 0);
+    myVolOut->setMapName(0, "t-statistic");
+    myVolOut->setFrame(observedTFCE.data(), 1);
+    myVolOut->setMapName(1, "TFCE");
+    myVolOut->setFrame(pvals.data(), 2);
+    myVolOut->setMapName(2, "FWE corrected p");
+    if (maxDistOut != NULL) *maxDistOut = maxDist;
+}
+
+float AlgorithmVolumeTFCEPermutation::getAlgorithmInternalWeight()
+{
+    return 1.0f;//override this if needed, if the progress bar isn't smooth
+}
+
+float AlgorithmVolumeTFCEPermutation::getSubAlgorithmWeight()
+{
+    //return AlgorithmInsertNameHere::getAlgorithmWeight();//if you use a subalgorithm
+    return 0.0f;
+}
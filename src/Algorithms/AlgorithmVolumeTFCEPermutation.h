@@ -0,0 +1,53 @@
+#ifndef __ALGORITHM_VOLUME_TFCE_PERMUTATION_H__
+#define __ALGORITHM_VOLUME_TFCE_PERMUTATION_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "AlgorithmMetricTFCEPermutation.h"
+#include "AlgorithmException.h"
+#include "AbstractAlgorithm.h"
+
+#include <vector>
+
+namespace caret {
+    
+    class AlgorithmVolumeTFCEPermutation : public AbstractAlgorithm
+    {
+        AlgorithmVolumeTFCEPermutation();
+    protected:
+        static float getSubAlgorithmWeight();
+        static float getAlgorithmInternalWeight();
+    public:
+        ///groups NULL means one-sample sign-flipping, otherwise one 0/1 label per subvolume for a two-sample label shuffle
+        AlgorithmVolumeTFCEPermutation(ProgressObject* myProgObj, const VolumeFile* myVol, VolumeFile* myVolOut, const int& numPerms = 1000,
+                                       const std::vector<int>* groups = NULL, const VolumeFile* myRoi = NULL, const float& param_e = 0.5f, const float& param_h = 2.0f,
+                                       const int& seed = 0, std::vector<float>* maxDistOut = NULL);
+        static OperationParameters* getParameters();
+        static void useParameters(OperationParameters* myParams, ProgressObject* myProgObj);
+        static AString getCommandSwitch();
+        static AString getShortDescription();
+    };
+
+    typedef TemplateAutoOperation<AlgorithmVolumeTFCEPermutation> AutoAlgorithmVolumeTFCEPermutation;
+
+}
+
+#endif //__ALGORITHM_VOLUME_TFCE_PERMUTATION_H__
@@ -67,7 +67,7 @@ OperationParameters* AlgorithmVolumeToSurfaceMapping::getParameters()
     OptionalParameter* roiVol = ribbonOpt->createOptionalParameter(3, "-volume-roi", "use a volume roi");
     roiVol->addVolumeParameter(1, "roi-volume", "the volume file");
     OptionalParameter* ribbonSubdiv = ribbonOpt->createOptionalParameter(4, "-voxel-subdiv", "voxel divisions while estimating voxel weights");
-    ribbonSubdiv->addIntegerParameter(1, "subdiv-num", "number of subdivisions, default 3");
+    ribbonSubdiv->addIntegerParameter(1, "subdiv-num", "number of subdivisions, default 3, 0 for exact overlap");
     ribbonOpt->createOptionalParameter(7, "-thin-columns", "use non-overlapping polyhedra");
     OptionalParameter* ribbonWeights = ribbonOpt->createOptionalParameter(5, "-output-weights", "write the voxel weights for a vertex to a volume file");
     ribbonWeights->addIntegerParameter(1, "vertex", "the vertex number to get the voxel weights for, 0-based");
@@ -92,7 +92,7 @@ OperationParameters* AlgorithmVolumeToSurfaceMapping::getParameters()
         "This may require increasing -voxel-subdiv to get enough samples in each voxel to reliably land inside these smaller polyhedra.  "
         "The volume ROI is useful to exclude partial volume effects of voxels the surfaces pass through, and will cause the mapping to ignore " +
         "voxels that don't have a positive value in the mask.  The subdivision number specifies how it approximates the amount of the volume the polyhedron " +
-        "intersects, by splitting each voxel into NxNxN pieces, and checking whether the center of each piece is inside the polyhedron.  If you have very large " +
+        "intersects, by splitting each voxel into NxNxN pieces, and checking whether the center of each piece is inside the polyhedron.  A subdivision number of 0 instead computes the exact overlap.  If you have very large " +
         "voxels, consider increasing this if you get zeros in your output.\n\n" +
         "The myelin style method uses part of the caret5 myelin mapping command to do the mapping: for each surface vertex, take all voxels closer than the thickness at the vertex " +
         "that are within the ribbon ROI, and less than half the thickness value away from the vertex along the direction of the surface normal, and apply a gaussian kernel " +
@@ -194,7 +194,7 @@ void AlgorithmVolumeToSurfaceMapping::useParameters(OperationParameters* myParam
             if (ribbonSubdiv->m_present)
             {
                 subdivisions = ribbonSubdiv->getInteger(1);
-                if (subdivisions < 1)
+                if (subdivisions < 0)
                 {
                     throw AlgorithmException("invalid number of subdivisions specified");
                 }
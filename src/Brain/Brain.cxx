@@ -35,6 +35,7 @@
 #include "BrainStructure.h"
 #include "BrowserTabContent.h"
 #include "CaretDataFileHelper.h"
+#include "CaretDataFileParallelReader.h"
 #include "CaretLogger.h"
 #include "CaretPreferences.h"
 #include "ChartingDataManager.h"
@@ -1466,6 +1467,7 @@ Brain::addReadOrReloadVolumeFile(const FileModeAddReadReload fileMode,
     if (readFlag) {
         try {
             try {
+                vf->setPreferOnDiskReading(true);//large 4D volumes only read the frames that get displayed
                 vf->readFile(filename);
             }
             catch (const std::bad_alloc&) {
@@ -5283,6 +5285,200 @@ Brain::readDataFile(const DataFileTypeEnum::Enum dataFileType,
     return caretDataFileRead;
 }
 
+/**
+ * Read the content of data files concurrently.  Files that can be read
+ * concurrently are created here (on this thread) and their content is read
+ * by the parallel reader's threads.  Files that are not read here (palette,
+ * scene, on the network, do not exist, etc.) must be read with readDataFile().
+ *
+ * Progress events are sent from this thread while waiting for
+ * the reading to complete.
+ *
+ * @param specFileDataFiles
+ *    Spec file entries of files that are to be read.
+ * @param parallelReader
+ *    Reader that reads the files.  It owns the files until they are
+ *    added with addDataFileReadInParallel().
+ * @param specFileDataFileToReaderIndexOut
+ *    Output mapping spec file entries of files that were read to their index
+ *    in the parallel reader.
+ * @param progressUpdate
+ *    Progress event sent while files are read.
+ * @return
+ *    True if reading completed, false if the user cancelled.
+ */
+bool
+Brain::readDataFilesInParallel(const std::vector<const SpecFileDataFile*>& specFileDataFiles,
+                               CaretDataFileParallelReader& parallelReader,
+                               std::map<const SpecFileDataFile*, int32_t>& specFileDataFileToReaderIndexOut,
+                               EventProgressUpdate* progressUpdate)
+{
+    CaretAssert(progressUpdate);
+    specFileDataFileToReaderIndexOut.clear();
+    
+    for (std::vector<const SpecFileDataFile*>::const_iterator iter = specFileDataFiles.begin();
+         iter != specFileDataFiles.end();
+         iter++) {
+        const SpecFileDataFile* specFileDataFile = *iter;
+        CaretAssert(specFileDataFile);
+        
+        const DataFileTypeEnum::Enum dataFileType = specFileDataFile->getDataFileType();
+        switch (dataFileType) {
+            case DataFileTypeEnum::CONNECTIVITY_DENSE_DYNAMIC:
+            case DataFileTypeEnum::PALETTE:
+            case DataFileTypeEnum::SCENE:
+            case DataFileTypeEnum::SPECIFICATION:
+            case DataFileTypeEnum::UNKNOWN:
+                continue;
+            default:
+                break;
+        }
+        
+        /*
+         * Missing files and files on the network are left for
+         * readDataFile() so that errors and authentication are
+         * handled exactly as before.
+         */
+        const AString dataFileName = convertFilePathNameToAbsolutePathName(specFileDataFile->getFileName());
+        if (DataFile::isFileOnNetwork(dataFileName)) {
+            continue;
+        }
+        FileInformation fileInfo(dataFileName);
+        if ( ! fileInfo.exists()) {
+            continue;
+        }
+        
+        /*
+         * Files are created here since some file constructors
+         * register for events.  Surfaces must be a Brain Surface.
+         */
+        CaretDataFile* caretDataFile = NULL;
+        if (dataFileType == DataFileTypeEnum::SURFACE) {
+            caretDataFile = new Surface();
+        }
+        else {
+            caretDataFile = CaretDataFileHelper::createCaretDataFileForFileType(dataFileType);
+        }
+        if (caretDataFile == NULL) {
+            continue;
+        }
+        
+        VolumeFile* volumeFile = dynamic_cast<VolumeFile*>(caretDataFile);
+        if (volumeFile != NULL) {
+            volumeFile->setPreferOnDiskReading(true);//large 4D volumes only read the frames that get displayed
+        }
+        
+        const int32_t readerIndex = parallelReader.addFile(caretDataFile,
+                                                           dataFileName);
+        specFileDataFileToReaderIndexOut.insert(std::make_pair(specFileDataFile,
+                                                               readerIndex));
+    }
+    
+    const int32_t numberOfFiles = parallelReader.getNumberOfFiles();
+    if (numberOfFiles <= 0) {
+        return true;
+    }
+    
+    parallelReader.start();
+    
+    bool doneFlag = false;
+    while ( ! doneFlag) {
+        int32_t numberOfFilesRead = 0;
+        doneFlag = parallelReader.waitForFilesRead(100,
+                                                   numberOfFilesRead);
+        progressUpdate->setProgressMessage("Reading files ("
+                                           + AString::number(numberOfFilesRead)
+                                           + " of "
+                                           + AString::number(numberOfFiles)
+                                           + ")");
+        EventManager::get()->sendEvent(progressUpdate->getPointer());
+        
+        if (progressUpdate->isCancelled()) {
+            parallelReader.cancel();
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+/**
+ * Add a data file that was read by readDataFilesInParallel().  Performs the
+ * same validation that is performed when the file is read by readDataFile().
+ *
+ * @param parallelReader
+ *    Reader that read the file.
+ * @param readerFileIndex
+ *    Index of the file in the parallel reader.
+ * @param dataFileType
+ *    Type of data file.
+ * @param structure
+ *    Struture of file (used if not invalid)
+ * @param dataFileName
+ *    Name of data file.
+ * @throws DataFileException
+ *    If there was an error reading or adding the file.
+ * @return
+ *    Pointer to file that was added.
+ */
+CaretDataFile*
+Brain::addDataFileReadInParallel(CaretDataFileParallelReader& parallelReader,
+                                 const int32_t readerFileIndex,
+                                 const DataFileTypeEnum::Enum dataFileType,
+                                 const StructureEnum::Enum structure,
+                                 const AString& dataFileName)
+{
+    CaretDataFile* caretDataFile = parallelReader.takeFile(readerFileIndex);
+    CaretAssert(caretDataFile);
+    
+    try {
+        BorderFile* borderFile = dynamic_cast<BorderFile*>(caretDataFile);
+        if (borderFile != NULL) {
+            /*
+             * Create a map of structure to number of nodes
+             */
+            std::map<StructureEnum::Enum, int32_t> structureToNodeCountMap;
+            for (std::vector<BrainStructure*>::iterator bsIter = m_brainStructures.begin();
+                 bsIter != m_brainStructures.end();
+                 bsIter++) {
+                const BrainStructure* bs = *bsIter;
+                CaretAssert(bs);
+                structureToNodeCountMap.insert(std::make_pair(bs->getStructure(),
+                                                              bs->getNumberOfNodes()));
+            }
+            
+            borderFile->updateNumberOfNodesIfSingleStructure(structureToNodeCountMap);
+        }
+        
+        if (dynamic_cast<CiftiConnectivityMatrixDenseFile*>(caretDataFile) != NULL) {
+            caretDataFile->clearModified();
+        }
+        
+        const CiftiMappableDataFile* ciftiMapFile = dynamic_cast<const CiftiMappableDataFile*>(caretDataFile);
+        if (ciftiMapFile != NULL) {
+            validateCiftiMappableDataFile(ciftiMapFile);
+        }
+        
+        return addReadOrReloadDataFile(FILE_MODE_ADD,
+                                       caretDataFile,
+                                       dataFileType,
+                                       structure,
+                                       dataFileName,
+                                       false);
+    }
+    catch (const DataFileException& dfe) {
+        /*
+         * In add mode, a file that fails is not deleted
+         */
+        if ( ! isFileValid(caretDataFile)) {
+            delete caretDataFile;
+        }
+        throw dfe;
+    }
+    
+    return NULL;
+}
+
 /**
  * Processing performed after adding or removing a data file.
  */
@@ -5345,11 +5541,36 @@ Brain::loadFilesSelectedInSpecFile(EventSpecFileReadDataFiles* readSpecFileDataF
                                        "Starting to read selected files");
     EventManager::get()->sendEvent(progressUpdate.getPointer());
 
+    /*
+     * Read the content of the files concurrently.  The files are
+     * added to the brain, in order, by the loop below.
+     */
+    const int32_t numFileGroups = sf->getNumberOfDataFileTypeGroups();
+    std::vector<const SpecFileDataFile*> specFileDataFilesToRead;
+    for (int32_t ig = 0; ig < numFileGroups; ig++) {
+        const SpecFileDataFileTypeGroup* group = sf->getDataFileTypeGroupByIndex(ig);
+        const int32_t numFiles = group->getNumberOfFiles();
+        for (int32_t iFile = 0; iFile < numFiles; iFile++) {
+            const SpecFileDataFile* dataFileInfo = group->getFileInformation(iFile);
+            if (dataFileInfo->isLoadingSelected()) {
+                specFileDataFilesToRead.push_back(dataFileInfo);
+            }
+        }
+    }
+    CaretDataFileParallelReader parallelReader;
+    std::map<const SpecFileDataFile*, int32_t> specFileDataFileToReaderIndex;
+    if ( ! readDataFilesInParallel(specFileDataFilesToRead,
+                                   parallelReader,
+                                   specFileDataFileToReaderIndex,
+                                   &progressUpdate)) {
+        resetBrain();
+        return;
+    }
+    
     /*
      * Note: Need to read palette first since some of the individual file
      * reading routines update palette coloring when file is read
      */
-    const int32_t numFileGroups = sf->getNumberOfDataFileTypeGroups();
     for (int32_t ig = -1; ig < numFileGroups; ig++) {
         const SpecFileDataFileTypeGroup* group = ((ig == -1)
                                                ? sf->getDataFileTypeGroupByType(DataFileTypeEnum::PALETTE)
@@ -5385,10 +5606,20 @@ Brain::loadFilesSelectedInSpecFile(EventSpecFileReadDataFiles* readSpecFileDataF
                 }
                 
                 try {
-                    readDataFile(dataFileType,
-                                 structure,
-                                 filename,
-                                 false);
+                    std::map<const SpecFileDataFile*, int32_t>::iterator readerIndexIter = specFileDataFileToReaderIndex.find(dataFileInfo);
+                    if (readerIndexIter != specFileDataFileToReaderIndex.end()) {
+                        addDataFileReadInParallel(parallelReader,
+                                                  readerIndexIter->second,
+                                                  dataFileType,
+                                                  structure,
+                                                  filename);
+                    }
+                    else {
+                        readDataFile(dataFileType,
+                                     structure,
+                                     filename,
+                                     false);
+                    }
                 }
                 catch (const DataFileException& e) {
                     if (errorMessage.isEmpty() == false) {
@@ -5619,9 +5850,48 @@ Brain::loadSpecFileFromScene(const SceneAttributes* sceneAttributes,
     
     
     /*
-     * Load new files and add existing files that were previously loaded.
+     * Read the content of new files concurrently.  When the scene file is
+     * on the network, the files are on the network and are read below.
      */
     const int32_t numFileGroups = specFileToLoad->getNumberOfDataFileTypeGroups();
+    std::vector<const SpecFileDataFile*> specFileDataFilesToRead;
+    if ( ! sceneFileOnNetwork) {
+        for (int32_t ig = 0; ig < numFileGroups; ig++) {
+            const SpecFileDataFileTypeGroup* group = specFileToLoad->getDataFileTypeGroupByIndex(ig);
+            const int32_t numFiles = group->getNumberOfFiles();
+            for (int32_t iFile = 0; iFile < numFiles; iFile++) {
+                const SpecFileDataFile* fileInfo = group->getFileInformation(iFile);
+                if (fileInfo->isLoadingSelected()) {
+                    if (specFilesEntryToNonModifiedFile.find(fileInfo) == specFilesEntryToNonModifiedFile.end()) {
+                        specFileDataFilesToRead.push_back(fileInfo);
+                    }
+                }
+            }
+        }
+    }
+    CaretDataFileParallelReader parallelReader;
+    std::map<const SpecFileDataFile*, int32_t> specFileDataFileToReaderIndex;
+    if ( ! readDataFilesInParallel(specFileDataFilesToRead,
+                                   parallelReader,
+                                   specFileDataFileToReaderIndex,
+                                   &progressEvent)) {
+        /*
+         * Files that were in memory prior to loading the scene
+         * and have not been added to the brain
+         */
+        for (std::map<const SpecFileDataFile*, CaretDataFile*>::iterator iter = specFilesEntryToNonModifiedFile.begin();
+             iter != specFilesEntryToNonModifiedFile.end();
+             iter++) {
+            delete iter->second;
+        }
+        resetBrain(keepSceneFiles,
+                   keepSpecFile);
+        return;
+    }
+    
+    /*
+     * Load new files and add existing files that were previously loaded.
+     */
     for (int32_t ig = 0; ig < numFileGroups; ig++) {
         const SpecFileDataFileTypeGroup* group = specFileToLoad->getDataFileTypeGroupByIndex(ig);
         const DataFileTypeEnum::Enum dataFileType = group->getDataFileType();
@@ -5677,10 +5947,20 @@ Brain::loadSpecFileFromScene(const SceneAttributes* sceneAttributes,
                                 }
                             }
                         }
-                        readDataFile(dataFileType,
-                                     structure,
-                                     filename,
-                                     false);
+                        std::map<const SpecFileDataFile*, int32_t>::iterator readerIndexIter = specFileDataFileToReaderIndex.find(fileInfo);
+                        if (readerIndexIter != specFileDataFileToReaderIndex.end()) {
+                            addDataFileReadInParallel(parallelReader,
+                                                      readerIndexIter->second,
+                                                      dataFileType,
+                                                      structure,
+                                                      filename);
+                        }
+                        else {
+                            readDataFile(dataFileType,
+                                         structure,
+                                         filename,
+                                         false);
+                        }
                     }
                 }
                 catch (const DataFileException& e) {
@@ -46,6 +46,7 @@ namespace caret {
     class FociFile;
     class BrainStructure;
     class CaretDataFile;
+    class CaretDataFileParallelReader;
     class CaretMappableDataFile;
     class ChartingDataManager;
     class ChartableLineSeriesBrainordinateInterface;
@@ -77,6 +78,7 @@ namespace caret {
     class DisplayPropertiesVolume;
     class EventDataFileRead;
     class EventDataFileReload;
+    class EventProgressUpdate;
     class EventSpecFileReadDataFiles;
     class GapsAndMargins;
     class IdentificationManager;
@@ -94,6 +96,7 @@ namespace caret {
     class SceneFile;
     class SelectionManager;
     class SpecFile;
+    class SpecFileDataFile;
     class Surface;
     class SurfaceFile;
     class SurfaceProjectedItem;
@@ -485,6 +488,17 @@ namespace caret {
                           const AString& dataFileName,
                           const bool markDataFileAsModified);
         
+        bool readDataFilesInParallel(const std::vector<const SpecFileDataFile*>& specFileDataFiles,
+                                     CaretDataFileParallelReader& parallelReader,
+                                     std::map<const SpecFileDataFile*, int32_t>& specFileDataFileToReaderIndexOut,
+                                     EventProgressUpdate* progressUpdate);
+        
+        CaretDataFile* addDataFileReadInParallel(CaretDataFileParallelReader& parallelReader,
+                                                 const int32_t readerFileIndex,
+                                                 const DataFileTypeEnum::Enum dataFileType,
+                                                 const StructureEnum::Enum structure,
+                                                 const AString& dataFileName);
+        
         /**
          * Is the data file with the given name already loaded?
          *
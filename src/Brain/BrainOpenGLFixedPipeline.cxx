@@ -47,6 +47,7 @@
 #include "BrainOpenGLPrimitiveDrawing.h"
 #include "BrainOpenGLVolumeObliqueSliceDrawing.h"
 #include "BrainOpenGLVolumeSliceDrawing.h"
+#include "BrainOpenGLVolumeSliceTextureCache.h"
 #include "BrainOpenGLShapeCone.h"
 #include "BrainOpenGLShapeCube.h"
 #include "BrainOpenGLShapeCylinder.h"
@@ -63,6 +64,7 @@
 #include "CaretMappableDataFile.h"
 #include "CaretMappableDataFileAndMapSelectionModel.h"
 #include "CaretPreferences.h"
+#include "CaretTriangleLocator.h"
 #include "ChartableMatrixInterface.h"
 #include "ChartableMatrixSeriesInterface.h"
 #include "ChartModelDataSeries.h"
@@ -100,6 +102,7 @@
 #include "Focus.h"
 #include "GapsAndMargins.h"
 #include "GiftiLabel.h"
+#include "GraphicsEngineDataOpenGLSurface.h"
 #include "GiftiLabelTable.h"
 #include "GroupAndNameHierarchyModel.h"
 #include "IdentifiedItemNode.h"
@@ -166,6 +169,7 @@ BrainOpenGLFixedPipeline::BrainOpenGLFixedPipeline(BrainOpenGLTextRenderInterfac
     this->initializeMembersBrainOpenGL();
     this->colorIdentification   = new IdentificationWithColor();
     m_annotationDrawing.grabNew(new BrainOpenGLAnnotationDrawingFixedPipeline(this));
+    m_volumeSliceTextureCache.grabNew(new BrainOpenGLVolumeSliceTextureCache());
     
     m_shapeSphere = NULL;
     m_shapeCone   = NULL;
@@ -1944,52 +1948,68 @@ BrainOpenGLFixedPipeline::drawSurfaceTriangles(Surface* surface,
             break;
     }
     
+    /*
+     * Find the triangle under the mouse by casting a ray into the
+     * surface's triangle locator.  This avoids drawing the surface
+     * and reading back the selection buffer.
+     */
+    int32_t triangleIndex = -1;
+    float depth = -1.0;
+    bool isRayCastSelect = false;
     if (isSelect) {
+        isRayCastSelect = getSurfaceTriangleUnderMouseWithRayCast(surface,
+                                                                  triangleIndex,
+                                                                  depth);
+    }
+    
+    if (isSelect
+        && ( ! isRayCastSelect)) {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     }
     
     uint8_t rgba[4];
     
-    glBegin(GL_TRIANGLES);
-    for (int32_t i = 0; i < numTriangles; i++) {
-        const int32_t i3 = i * 3;
-        const int32_t n1 = triangles[i3];
-        const int32_t n2 = triangles[i3+1];
-        const int32_t n3 = triangles[i3+2];
+    if ( ! isRayCastSelect) {
+        glBegin(GL_TRIANGLES);
+        for (int32_t i = 0; i < numTriangles; i++) {
+            const int32_t i3 = i * 3;
+            const int32_t n1 = triangles[i3];
+            const int32_t n2 = triangles[i3+1];
+            const int32_t n3 = triangles[i3+2];
         
-        if (isSelect) {
-            this->colorIdentification->addItem(rgba, SelectionItemDataTypeEnum::SURFACE_TRIANGLE, i);
-            glColor3ubv(rgba);
-            glNormal3fv(&normals[n1*3]);
-            glVertex3fv(&coordinates[n1*3]);
-            glNormal3fv(&normals[n2*3]);
-            glVertex3fv(&coordinates[n2*3]);
-            glNormal3fv(&normals[n3*3]);
-            glVertex3fv(&coordinates[n3*3]);
-        }
-        else {
-            glColor4fv(&nodeColoringRGBA[n1*4]);
-            glNormal3fv(&normals[n1*3]);
-            glVertex3fv(&coordinates[n1*3]);
-            glColor4fv(&nodeColoringRGBA[n2*4]);
-            glNormal3fv(&normals[n2*3]);
-            glVertex3fv(&coordinates[n2*3]);
-            glColor4fv(&nodeColoringRGBA[n3*4]);
-            glNormal3fv(&normals[n3*3]);
-            glVertex3fv(&coordinates[n3*3]);
+            if (isSelect) {
+                this->colorIdentification->addItem(rgba, SelectionItemDataTypeEnum::SURFACE_TRIANGLE, i);
+                glColor3ubv(rgba);
+                glNormal3fv(&normals[n1*3]);
+                glVertex3fv(&coordinates[n1*3]);
+                glNormal3fv(&normals[n2*3]);
+                glVertex3fv(&coordinates[n2*3]);
+                glNormal3fv(&normals[n3*3]);
+                glVertex3fv(&coordinates[n3*3]);
+            }
+            else {
+                glColor4fv(&nodeColoringRGBA[n1*4]);
+                glNormal3fv(&normals[n1*3]);
+                glVertex3fv(&coordinates[n1*3]);
+                glColor4fv(&nodeColoringRGBA[n2*4]);
+                glNormal3fv(&normals[n2*3]);
+                glVertex3fv(&coordinates[n2*3]);
+                glColor4fv(&nodeColoringRGBA[n3*4]);
+                glNormal3fv(&normals[n3*3]);
+                glVertex3fv(&coordinates[n3*3]);
+            }
         }
+        glEnd();
     }
-    glEnd();
     
     if (isSelect) {
-        int32_t triangleIndex = -1;
-        float depth = -1.0;
-        this->getIndexFromColorSelection(SelectionItemDataTypeEnum::SURFACE_TRIANGLE, 
-                                         this->mouseX, 
-                                         this->mouseY,
-                                         triangleIndex,
-                                         depth);
-        
+        if ( ! isRayCastSelect) {
+            this->getIndexFromColorSelection(SelectionItemDataTypeEnum::SURFACE_TRIANGLE,
+                                             this->mouseX,
+                                             this->mouseY,
+                                             triangleIndex,
+                                             depth);
+        }
         
         if (triangleIndex >= 0) {
             bool isTriangleIdAccepted = false;
@@ -2201,6 +2221,82 @@ BrainOpenGLFixedPipeline::drawSurfaceTriangles(Surface* surface,
     }
 }
 
+/**
+ * Find the surface triangle under the mouse by casting a ray, from
+ * the mouse position into the screen, against the surface's triangle
+ * locator.  The ray is found with the current modelview and projection
+ * matrices so it is in the surface's coordinate space.
+ *
+ * The ray cast does not know about clipping planes, so when any
+ * clipping plane is enabled it is not used and the caller must use
+ * the selection buffer instead.
+ *
+ * @param surface
+ *    Surface that is searched.
+ * @param triangleIndexOut
+ *    Output with the triangle under the mouse, -1 if none.
+ * @param depthOut
+ *    Output with the screen depth of the point hit on the triangle,
+ *    comparable to the depth read from the selection buffer.
+ * @return
+ *    True if the ray cast was performed (even if no triangle was hit),
+ *    false if the selection buffer must be used.
+ */
+bool
+BrainOpenGLFixedPipeline::getSurfaceTriangleUnderMouseWithRayCast(const Surface* surface,
+                                                                  int32_t& triangleIndexOut,
+                                                                  float& depthOut)
+{
+    triangleIndexOut = -1;
+    depthOut = -1.0;
+    
+    if (surface->getNumberOfTriangles() <= 0) {
+        return false;
+    }
+    for (int32_t i = 0; i < 6; i++) {
+        if (glIsEnabled(GL_CLIP_PLANE0 + i)) {
+            return false;
+        }
+    }
+    
+    GLdouble modelviewMatrix[16];
+    glGetDoublev(GL_MODELVIEW_MATRIX, modelviewMatrix);
+    GLdouble projectionMatrix[16];
+    glGetDoublev(GL_PROJECTION_MATRIX, projectionMatrix);
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    
+    /*
+     * Ray from the near clipping plane to the far clipping plane
+     */
+    double nearXYZ[3], farXYZ[3];
+    if ( ! gluUnProject(this->mouseX, this->mouseY, 0.0,
+                        modelviewMatrix, projectionMatrix, viewport,
+                        &nearXYZ[0], &nearXYZ[1], &nearXYZ[2])) {
+        return false;
+    }
+    if ( ! gluUnProject(this->mouseX, this->mouseY, 1.0,
+                        modelviewMatrix, projectionMatrix, viewport,
+                        &farXYZ[0], &farXYZ[1], &farXYZ[2])) {
+        return false;
+    }
+    const float startXYZ[3] = { (float)nearXYZ[0], (float)nearXYZ[1], (float)nearXYZ[2] };
+    const float endXYZ[3]   = { (float)farXYZ[0],  (float)farXYZ[1],  (float)farXYZ[2]  };
+    
+    TriangleRayHit hit;
+    if (surface->getTriangleLocator()->lineSegmentIntersects(startXYZ, endXYZ, &hit)) {
+        double windowXYZ[3];
+        if (gluProject(hit.xyz[0], hit.xyz[1], hit.xyz[2],
+                       modelviewMatrix, projectionMatrix, viewport,
+                       &windowXYZ[0], &windowXYZ[1], &windowXYZ[2])) {
+            triangleIndexOut = hit.triangle;
+            depthOut = windowXYZ[2];
+        }
+    }
+    
+    return true;
+}
+
 /**
  * During projection mode, set the projected data.  If the 
  * projection data is already set, it will be overridden
@@ -2340,16 +2436,59 @@ BrainOpenGLFixedPipeline::drawSurfaceNodes(Surface* surface,
 
 
 /**
- * Draw a surface triangles with vertex arrays.
+ * Draw a surface triangles with vertex arrays.  When vertex buffers are
+ * supported, the geometry and coloring stay in buffers owned by the surface
+ * and are only sent again when they change.
  * @param surface
  *    Surface that is drawn.
  * @param nodeColoringRGBA
- *    RGBA coloring for the nodes.
+ *    RGBA coloring for the nodes (the surface's coloring for a tab).
  */
 void 
-BrainOpenGLFixedPipeline::drawSurfaceTrianglesWithVertexArrays(const Surface* surface,
+BrainOpenGLFixedPipeline::drawSurfaceTrianglesWithVertexArrays(Surface* surface,
                                                                const float* nodeColoringRGBA)
 {
+    const int numTriangles = surface->getNumberOfTriangles();
+    int32_t coloringKey = -1;
+    int64_t coloringStamp = -1;
+    const bool coloringFoundFlag = ((nodeColoringRGBA == NULL)
+                                    || surface->getNodeColoringKeyAndStamp(nodeColoringRGBA,
+                                                                           coloringKey,
+                                                                           coloringStamp));
+    if (BrainOpenGL::isVertexBuffersSupported()
+        && (numTriangles > 0)
+        && coloringFoundFlag) {
+        GraphicsEngineDataOpenGLSurface* openglData = surface->getGraphicsEngineDataForOpenGL();
+        if ((openglData != NULL)
+            && (openglData->getOpenGLContextPointer() != getContextSharingGroupPointer())) {
+            /*
+             * Buffers belong to a different context, replacing deletes them
+             */
+            openglData = NULL;
+        }
+        if (openglData == NULL) {
+            openglData = new GraphicsEngineDataOpenGLSurface(getContextSharingGroupPointer());
+            surface->setGraphicsEngineDataForOpenGL(openglData);
+        }
+        openglData->loadGeometry(surface->getGeometryModificationCount(),
+                                 surface->getCoordinateData(),
+                                 surface->getNormalData(),
+                                 surface->getNumberOfNodes(),
+                                 surface->getTriangle(0),
+                                 numTriangles);
+        openglData->deleteColorsOlderThan(surface->getNodeColoringInvalidationStamp());
+        if (nodeColoringRGBA != NULL) {
+            openglData->loadColors(coloringKey,
+                                   nodeColoringRGBA,
+                                   coloringStamp);
+        }
+        else {
+            glColor3fv(m_backgroundColorFloat);
+        }
+        openglData->draw(coloringKey);
+        return;
+    }
+    
     glEnableClientState(GL_VERTEX_ARRAY);
     if (nodeColoringRGBA != NULL) {
         glEnableClientState(GL_COLOR_ARRAY);
@@ -2372,7 +2511,6 @@ BrainOpenGLFixedPipeline::drawSurfaceTrianglesWithVertexArrays(const Surface* su
                     0, 
                     reinterpret_cast<const GLvoid*>(surface->getNormalVector(0)));
     
-    const int numTriangles = surface->getNumberOfTriangles();
     glDrawElements(GL_TRIANGLES, 
                    (3 * numTriangles), 
                    GL_UNSIGNED_INT,
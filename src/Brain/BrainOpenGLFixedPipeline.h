@@ -54,6 +54,7 @@ namespace caret {
     class BrainOpenGLShapeRingOutline;
     class BrainOpenGLShapeSphere;
     class BrainOpenGLViewportContent;
+    class BrainOpenGLVolumeSliceTextureCache;
     class BrowserTabContent;
     class CaretMappableDataFile;
     class ClippingPlaneGroup;
@@ -201,12 +202,16 @@ namespace caret {
         void drawSurfaceNodes(Surface* surface,
                               const float* nodeColoringRGBA);
         
-        void drawSurfaceTrianglesWithVertexArrays(const Surface* surface,
+        void drawSurfaceTrianglesWithVertexArrays(Surface* surface,
                                                   const float* nodeColoringRGBA);
         
         void drawSurfaceTriangles(Surface* surface,
                                   const float* nodeColoringRGBA);
         
+        bool getSurfaceTriangleUnderMouseWithRayCast(const Surface* surface,
+                                                     int32_t& triangleIndexOut,
+                                                     float& depthOut);
+        
         void drawSurfaceNodeAttributes(Surface* surface);
         
         void drawSurfaceBorderBeingDrawn(const Surface* surface);
@@ -616,6 +621,9 @@ namespace caret {
         
         CaretPointer<BrainOpenGLAnnotationDrawingFixedPipeline> m_annotationDrawing;
         
+        /** Volume slice textures kept between draws since the slice drawing objects are created for each draw */
+        CaretPointer<BrainOpenGLVolumeSliceTextureCache> m_volumeSliceTextureCache;
+        
         std::vector<AnnotationColorBar*> m_annotationColorBarsForDrawing;
         
         /** Some graphics using annotations for some elements so user can select and edit them */
@@ -32,6 +32,7 @@
 #include "BrainOpenGLAnnotationDrawingFixedPipeline.h"
 #include "BrainOpenGLPrimitiveDrawing.h"
 #include "BrainOpenGLViewportContent.h"
+#include "BrainOpenGLVolumeSliceTextureCache.h"
 #include "BrowserTabContent.h"
 #include "CaretAssert.h"
 #include "CaretLogger.h"
@@ -1215,6 +1216,18 @@ BrainOpenGLVolumeObliqueSliceDrawing::drawObliqueSlice(const VolumeSliceViewPlan
      */
     std::vector<VoxelToDraw*> voxelsToDraw;
     
+    /*
+     * The voxels form a grid of rows and columns that covers the
+     * screen.  When each row has the same number of voxels, the
+     * slice can be drawn with one textured quad whose corners are
+     * the corners of the grid.
+     */
+    int64_t gridNumberOfRows = 0;
+    int64_t gridNumberOfColumns = -1;
+    bool gridRegularFlag = true;
+    float gridTopLeft[3] = { topLeft[0], topLeft[1], topLeft[2] };
+    float gridTopRight[3] = { topRight[0], topRight[1], topRight[2] };
+    
     if ((bottomLeftToTopLeftDistance > 0)
         && (bottomRightToTopRightDistance > 0)) {
         
@@ -1274,6 +1287,18 @@ BrainOpenGLVolumeObliqueSliceDrawing::drawObliqueSlice(const VolumeSliceViewPlan
             MathFunctions::createUnitVector(leftEdgeBottomCoord, rightEdgeBottomCoord, bottomEdgeUnitVector);
             const double numVoxelsInRowFloat = bottomVoxelEdgeDistance / voxelSize;
             const int64_t numVoxelsInRow = MathFunctions::round(numVoxelsInRowFloat);
+            if (gridNumberOfColumns < 0) {
+                gridNumberOfColumns = numVoxelsInRow;
+            }
+            else if (numVoxelsInRow != gridNumberOfColumns) {
+                gridRegularFlag = false;
+            }
+            for (int32_t iXYZ = 0; iXYZ < 3; iXYZ++) {
+                gridTopLeft[iXYZ]  = leftEdgeTopCoord[iXYZ];
+                gridTopRight[iXYZ] = rightEdgeTopCoord[iXYZ];
+            }
+            const int64_t rowIndex = gridNumberOfRows;
+            gridNumberOfRows++;
             const double bottomEdgeVoxelSize = bottomVoxelEdgeDistance / numVoxelsInRow;
             const double bottomVoxelEdgeDX = bottomEdgeVoxelSize * bottomEdgeUnitVector[0];
             const double bottomVoxelEdgeDY = bottomEdgeVoxelSize * bottomEdgeUnitVector[1];
@@ -1525,6 +1550,8 @@ BrainOpenGLVolumeObliqueSliceDrawing::drawObliqueSlice(const VolumeSliceViewPlan
                                                                bottomRightVoxelCoord,
                                                                topRightVoxelCoord,
                                                                topLeftVoxelCoord);
+                            voxelDrawingInfo->m_rowIndex    = rowIndex;
+                            voxelDrawingInfo->m_columnIndex = i;
                             voxelsToDraw.push_back(voxelDrawingInfo);
                         }
                         
@@ -1629,6 +1656,33 @@ BrainOpenGLVolumeObliqueSliceDrawing::drawObliqueSlice(const VolumeSliceViewPlan
     
     const int64_t numVoxelsToDraw = static_cast<int64_t>(voxelsToDraw.size());
     
+    /*
+     * Unless identifying (which needs the voxel quads), the slice
+     * is drawn with a texture that has one texel per voxel in the grid.
+     */
+    bool drawWithTextureFlag = false;
+    int64_t textureWidth = 1;
+    int64_t textureHeight = 1;
+    std::vector<uint8_t> textureRGBA;
+    if (( ! m_identificationModeFlag)
+        && gridRegularFlag
+        && (gridNumberOfRows > 0)
+        && (gridNumberOfColumns > 0)) {
+        while (textureWidth < gridNumberOfColumns) {
+            textureWidth *= 2;
+        }
+        while (textureHeight < gridNumberOfRows) {
+            textureHeight *= 2;
+        }
+        GLint maximumTextureSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maximumTextureSize);
+        if ((textureWidth <= maximumTextureSize)
+            && (textureHeight <= maximumTextureSize)) {
+            textureRGBA.assign(textureWidth * textureHeight * 4, 0);
+            drawWithTextureFlag = true;
+        }
+    }
+    
     /*
      * quadCoords is the coordinates for all four corners of a 'quad'
      * that is used to draw a voxel.  quadRGBA is the colors for each
@@ -1644,11 +1698,14 @@ BrainOpenGLVolumeObliqueSliceDrawing::drawObliqueSlice(const VolumeSliceViewPlan
     const int64_t coordinatesPerQuad = 4;
     const int64_t componentsPerCoordinate = 3;
     const int64_t colorComponentsPerCoordinate = 4;
-    quadCoordsVector.resize(numVoxelsToDraw
+    const int64_t numQuadsToDraw = (drawWithTextureFlag
+                                    ? 0
+                                    : numVoxelsToDraw);
+    quadCoordsVector.resize(numQuadsToDraw
                             * coordinatesPerQuad
                             * componentsPerCoordinate);
     quadNormalsVector.resize(quadCoordsVector.size());
-    quadRGBAsVector.resize(numVoxelsToDraw *
+    quadRGBAsVector.resize(numQuadsToDraw *
                            coordinatesPerQuad *
                            colorComponentsPerCoordinate);
     
@@ -1656,9 +1713,9 @@ BrainOpenGLVolumeObliqueSliceDrawing::drawObliqueSlice(const VolumeSliceViewPlan
     int64_t normalOffset = 0;
     int64_t rgbaOffset = 0;
     
-    float*   quadCoords  = &quadCoordsVector[0];
-    float*   quadNormals = &quadNormalsVector[0];
-    uint8_t* quadRGBAs   = &quadRGBAsVector[0];
+    float*   quadCoords  = quadCoordsVector.data();
+    float*   quadNormals = quadNormalsVector.data();
+    uint8_t* quadRGBAs   = quadRGBAsVector.data();
     
     for (int64_t iVox = 0; iVox < numVoxelsToDraw; iVox++) {
         CaretAssertVectorIndex(voxelsToDraw, iVox);
@@ -1702,6 +1759,18 @@ BrainOpenGLVolumeObliqueSliceDrawing::drawObliqueSlice(const VolumeSliceViewPlan
             }
         }
         
+        if (drawWithTextureFlag) {
+            if (voxelRGBA[3] > 0) {
+                const int64_t texelOffset = ((vtd->m_rowIndex * textureWidth) + vtd->m_columnIndex) * 4;
+                CaretAssertVectorIndex(textureRGBA, texelOffset + 3);
+                textureRGBA[texelOffset]   = voxelRGBA[0];
+                textureRGBA[texelOffset+1] = voxelRGBA[1];
+                textureRGBA[texelOffset+2] = voxelRGBA[2];
+                textureRGBA[texelOffset+3] = voxelRGBA[3];
+            }
+            continue;
+        }
+        
         if (voxelRGBA[3] > 0) {
             float sliceNormalVector[3];
             plane.getNormalVector(sliceNormalVector);
@@ -1778,7 +1847,22 @@ BrainOpenGLVolumeObliqueSliceDrawing::drawObliqueSlice(const VolumeSliceViewPlan
     }
     voxelsToDraw.clear();
     
-    if ( ! quadCoordsVector.empty()) {
+    if (drawWithTextureFlag) {
+        float sliceNormalVector[3];
+        plane.getNormalVector(sliceNormalVector);
+        drawObliqueSliceTexture(sliceViewPlane,
+                                sliceNormalVector,
+                                bottomLeft,
+                                bottomRight,
+                                gridTopRight,
+                                gridTopLeft,
+                                gridNumberOfColumns,
+                                gridNumberOfRows,
+                                textureRGBA,
+                                textureWidth,
+                                textureHeight);
+    }
+    else if ( ! quadCoordsVector.empty()) {
         glPushMatrix();
         BrainOpenGLPrimitiveDrawing::drawQuads(quadCoordsVector,
                                                quadNormalsVector,
@@ -1787,6 +1871,97 @@ BrainOpenGLVolumeObliqueSliceDrawing::drawObliqueSlice(const VolumeSliceViewPlan
     }
 }
 
+/**
+ * Draw the voxels of an oblique slice as one textured quad.
+ *
+ * The texture has one texel per voxel in the slice's grid (padded to a
+ * power of two in each dimension).  Texels for voxels that are not drawn
+ * have a zero alpha and are discarded by the alpha test.  The texture is
+ * kept by the fixed pipeline drawing's slice texture cache and only loaded
+ * into OpenGL when its texels change, such as when the slice is rotated or
+ * panned.
+ *
+ * @param sliceViewPlane
+ *    The plane for slice drawing.
+ * @param sliceNormalVector
+ *    Normal vector of the slice plane.
+ * @param bottomLeft
+ *    Bottom left corner of the grid.
+ * @param bottomRight
+ *    Bottom right corner of the grid.
+ * @param topRight
+ *    Top right corner of the grid.
+ * @param topLeft
+ *    Top left corner of the grid.
+ * @param numberOfColumns
+ *    Number of columns in the grid.
+ * @param numberOfRows
+ *    Number of rows in the grid.
+ * @param texelsRGBA
+ *    The texels.
+ * @param textureWidth
+ *    Width of the texture.
+ * @param textureHeight
+ *    Height of the texture.
+ */
+void
+BrainOpenGLVolumeObliqueSliceDrawing::drawObliqueSliceTexture(const VolumeSliceViewPlaneEnum::Enum sliceViewPlane,
+                                                              const float sliceNormalVector[3],
+                                                              const float bottomLeft[3],
+                                                              const float bottomRight[3],
+                                                              const float topRight[3],
+                                                              const float topLeft[3],
+                                                              const int64_t numberOfColumns,
+                                                              const int64_t numberOfRows,
+                                                              const std::vector<uint8_t>& texelsRGBA,
+                                                              const int64_t textureWidth,
+                                                              const int64_t textureHeight)
+{
+    glPushAttrib(GL_ENABLE_BIT
+                 | GL_TEXTURE_BIT
+                 | GL_COLOR_BUFFER_BIT);
+    
+    /*
+     * An oblique slice is not one of the volume's slices so there
+     * is one texture for each view plane.
+     */
+    const GLuint textureName = m_fixedPipelineDrawing->m_volumeSliceTextureCache->bindTexture(m_fixedPipelineDrawing->getContextSharingGroupPointer(),
+                                                                                            NULL,
+                                                                                            -1,
+                                                                                            static_cast<int32_t>(sliceViewPlane),
+                                                                                            -1,
+                                                                                            texelsRGBA,
+                                                                                            textureWidth,
+                                                                                            textureHeight);
+    if (textureName == 0) {
+        glPopAttrib();
+        return;
+    }
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    
+    glEnable(GL_TEXTURE_2D);
+    glEnable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GREATER, 0.0);
+    
+    const float maxS = static_cast<float>(numberOfColumns) / textureWidth;
+    const float maxT = static_cast<float>(numberOfRows) / textureHeight;
+    
+    glBegin(GL_QUADS);
+    glNormal3fv(sliceNormalVector);
+    glTexCoord2f(0.0, 0.0);
+    glVertex3fv(bottomLeft);
+    glTexCoord2f(maxS, 0.0);
+    glVertex3fv(bottomRight);
+    glTexCoord2f(maxS, maxT);
+    glVertex3fv(topRight);
+    glTexCoord2f(0.0, maxT);
+    glVertex3fv(topLeft);
+    glEnd();
+    
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPopAttrib();
+}
+
 /**
  * Draw an orthogonal slice.
  *
@@ -5311,6 +5486,9 @@ BrainOpenGLVolumeObliqueSliceDrawing::VoxelToDraw::VoxelToDraw(const float cente
     const int64_t numSlices = 5;
     m_sliceIndices.reserve(numSlices);
     m_sliceOffsets.reserve(numSlices);
+    
+    m_rowIndex    = -1;
+    m_columnIndex = -1;
 }
 
 /**
@@ -186,6 +186,16 @@ namespace caret {
              * Offset in values in VoxelsInSliceForVolume
              */
             std::vector<int64_t> m_sliceOffsets;
+            
+            /**
+             * Row of voxel in the oblique slice's grid
+             */
+            int64_t m_rowIndex;
+            
+            /**
+             * Column of voxel in the oblique slice's grid
+             */
+            int64_t m_columnIndex;
         };
         
         BrainOpenGLVolumeObliqueSliceDrawing(const BrainOpenGLVolumeObliqueSliceDrawing&);
@@ -221,6 +231,18 @@ namespace caret {
                               Matrix4x4& transformationMatrix,
                               const Plane& plane);
         
+        void drawObliqueSliceTexture(const VolumeSliceViewPlaneEnum::Enum sliceViewPlane,
+                                     const float sliceNormalVector[3],
+                                     const float bottomLeft[3],
+                                     const float bottomRight[3],
+                                     const float topRight[3],
+                                     const float topLeft[3],
+                                     const int64_t numberOfColumns,
+                                     const int64_t numberOfRows,
+                                     const std::vector<uint8_t>& texelsRGBA,
+                                     const int64_t textureWidth,
+                                     const int64_t textureHeight);
+        
         void drawOrthogonalSlice(const VolumeSliceViewPlaneEnum::Enum sliceViewPlane,
                                  const float sliceCoordinates[3],
                                  const Plane& plane);
@@ -32,6 +32,7 @@
 #include "BrainOpenGLAnnotationDrawingFixedPipeline.h"
 #include "BrainOpenGLPrimitiveDrawing.h"
 #include "BrainOpenGLViewportContent.h"
+#include "BrainOpenGLVolumeSliceTextureCache.h"
 #include "BrainordinateRegionOfInterest.h"
 #include "BrowserTabContent.h"
 #include "CaretAssert.h"
@@ -1231,6 +1232,18 @@ BrainOpenGLVolumeSliceDrawing::drawObliqueSlice(const VolumeSliceViewPlaneEnum::
      */
     std::vector<VoxelToDraw*> voxelsToDraw;
     
+    /*
+     * The voxels form a grid of rows and columns that covers the
+     * screen.  When each row has the same number of voxels, the
+     * slice can be drawn with one textured quad whose corners are
+     * the corners of the grid.
+     */
+    int64_t gridNumberOfRows = 0;
+    int64_t gridNumberOfColumns = -1;
+    bool gridRegularFlag = true;
+    float gridTopLeft[3] = { topLeft[0], topLeft[1], topLeft[2] };
+    float gridTopRight[3] = { topRight[0], topRight[1], topRight[2] };
+    
     if ((bottomLeftToTopLeftDistance > 0)
         && (bottomRightToTopRightDistance > 0)) {
         
@@ -1290,6 +1303,18 @@ BrainOpenGLVolumeSliceDrawing::drawObliqueSlice(const VolumeSliceViewPlaneEnum::
             MathFunctions::createUnitVector(leftEdgeBottomCoord, rightEdgeBottomCoord, bottomEdgeUnitVector);
             const double numVoxelsInRowFloat = bottomVoxelEdgeDistance / voxelSize;
             const int64_t numVoxelsInRow = MathFunctions::round(numVoxelsInRowFloat);
+            if (gridNumberOfColumns < 0) {
+                gridNumberOfColumns = numVoxelsInRow;
+            }
+            else if (numVoxelsInRow != gridNumberOfColumns) {
+                gridRegularFlag = false;
+            }
+            for (int32_t iXYZ = 0; iXYZ < 3; iXYZ++) {
+                gridTopLeft[iXYZ]  = leftEdgeTopCoord[iXYZ];
+                gridTopRight[iXYZ] = rightEdgeTopCoord[iXYZ];
+            }
+            const int64_t rowIndex = gridNumberOfRows;
+            gridNumberOfRows++;
             const double bottomEdgeVoxelSize = bottomVoxelEdgeDistance / numVoxelsInRow;
             const double bottomVoxelEdgeDX = bottomEdgeVoxelSize * bottomEdgeUnitVector[0];
             const double bottomVoxelEdgeDY = bottomEdgeVoxelSize * bottomEdgeUnitVector[1];
@@ -1507,6 +1532,8 @@ BrainOpenGLVolumeSliceDrawing::drawObliqueSlice(const VolumeSliceViewPlaneEnum::
                                                                bottomRightVoxelCoord,
                                                                topRightVoxelCoord,
                                                                topLeftVoxelCoord);
+                            voxelDrawingInfo->m_rowIndex    = rowIndex;
+                            voxelDrawingInfo->m_columnIndex = i;
                             voxelsToDraw.push_back(voxelDrawingInfo);
                         }
                         
@@ -1595,6 +1622,33 @@ BrainOpenGLVolumeSliceDrawing::drawObliqueSlice(const VolumeSliceViewPlaneEnum::
     
     const int64_t numVoxelsToDraw = static_cast<int64_t>(voxelsToDraw.size());
     
+    /*
+     * Unless identifying (which needs the voxel quads), the slice
+     * is drawn with a texture that has one texel per voxel in the grid.
+     */
+    bool drawWithTextureFlag = false;
+    int64_t textureWidth = 1;
+    int64_t textureHeight = 1;
+    std::vector<uint8_t> textureRGBA;
+    if (( ! m_identificationModeFlag)
+        && gridRegularFlag
+        && (gridNumberOfRows > 0)
+        && (gridNumberOfColumns > 0)) {
+        while (textureWidth < gridNumberOfColumns) {
+            textureWidth *= 2;
+        }
+        while (textureHeight < gridNumberOfRows) {
+            textureHeight *= 2;
+        }
+        GLint maximumTextureSize = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maximumTextureSize);
+        if ((textureWidth <= maximumTextureSize)
+            && (textureHeight <= maximumTextureSize)) {
+            textureRGBA.assign(textureWidth * textureHeight * 4, 0);
+            drawWithTextureFlag = true;
+        }
+    }
+    
     /*
      * quadCoords is the coordinates for all four corners of a 'quad'
      * that is used to draw a voxel.  quadRGBA is the colors for each
@@ -1610,11 +1664,14 @@ BrainOpenGLVolumeSliceDrawing::drawObliqueSlice(const VolumeSliceViewPlaneEnum::
     const int64_t coordinatesPerQuad = 4;
     const int64_t componentsPerCoordinate = 3;
     const int64_t colorComponentsPerCoordinate = 4;
-    quadCoordsVector.resize(numVoxelsToDraw
+    const int64_t numQuadsToDraw = (drawWithTextureFlag
+                                    ? 0
+                                    : numVoxelsToDraw);
+    quadCoordsVector.resize(numQuadsToDraw
                             * coordinatesPerQuad
                             * componentsPerCoordinate);
     quadNormalsVector.resize(quadCoordsVector.size());
-    quadRGBAsVector.resize(numVoxelsToDraw *
+    quadRGBAsVector.resize(numQuadsToDraw *
                            coordinatesPerQuad *
                            colorComponentsPerCoordinate);
     
@@ -1622,9 +1679,9 @@ BrainOpenGLVolumeSliceDrawing::drawObliqueSlice(const VolumeSliceViewPlaneEnum::
     int64_t normalOffset = 0;
     int64_t rgbaOffset = 0;
     
-    float*   quadCoords  = &quadCoordsVector[0];
-    float*   quadNormals = &quadNormalsVector[0];
-    uint8_t* quadRGBAs   = &quadRGBAsVector[0];
+    float*   quadCoords  = quadCoordsVector.data();
+    float*   quadNormals = quadNormalsVector.data();
+    uint8_t* quadRGBAs   = quadRGBAsVector.data();
     
     for (int64_t iVox = 0; iVox < numVoxelsToDraw; iVox++) {
         CaretAssertVectorIndex(voxelsToDraw, iVox);
@@ -1668,6 +1725,18 @@ BrainOpenGLVolumeSliceDrawing::drawObliqueSlice(const VolumeSliceViewPlaneEnum::
             }
         }
         
+        if (drawWithTextureFlag) {
+            if (voxelRGBA[3] > 0) {
+                const int64_t texelOffset = ((vtd->m_rowIndex * textureWidth) + vtd->m_columnIndex) * 4;
+                CaretAssertVectorIndex(textureRGBA, texelOffset + 3);
+                textureRGBA[texelOffset]   = voxelRGBA[0];
+                textureRGBA[texelOffset+1] = voxelRGBA[1];
+                textureRGBA[texelOffset+2] = voxelRGBA[2];
+                textureRGBA[texelOffset+3] = voxelRGBA[3];
+            }
+            continue;
+        }
+        
         if (voxelRGBA[3] > 0) {
             float sliceNormalVector[3];
             plane.getNormalVector(sliceNormalVector);
@@ -1744,7 +1813,22 @@ BrainOpenGLVolumeSliceDrawing::drawObliqueSlice(const VolumeSliceViewPlaneEnum::
     }
     voxelsToDraw.clear();
     
-    if ( ! quadCoordsVector.empty()) {
+    if (drawWithTextureFlag) {
+        float sliceNormalVector[3];
+        plane.getNormalVector(sliceNormalVector);
+        drawObliqueSliceTexture(sliceViewPlane,
+                                sliceNormalVector,
+                                bottomLeft,
+                                bottomRight,
+                                gridTopRight,
+                                gridTopLeft,
+                                gridNumberOfColumns,
+                                gridNumberOfRows,
+                                textureRGBA,
+                                textureWidth,
+                                textureHeight);
+    }
+    else if ( ! quadCoordsVector.empty()) {
         glPushMatrix();
         BrainOpenGLPrimitiveDrawing::drawQuads(quadCoordsVector,
                                                quadNormalsVector,
@@ -1753,6 +1837,97 @@ BrainOpenGLVolumeSliceDrawing::drawObliqueSlice(const VolumeSliceViewPlaneEnum::
     }
 }
 
+/**
+ * Draw the voxels of an oblique slice as one textured quad.
+ *
+ * The texture has one texel per voxel in the slice's grid (padded to a
+ * power of two in each dimension).  Texels for voxels that are not drawn
+ * have a zero alpha and are discarded by the alpha test.  The texture is
+ * kept by the fixed pipeline drawing's slice texture cache and only loaded
+ * into OpenGL when its texels change, such as when the slice is rotated or
+ * panned.
+ *
+ * @param sliceViewPlane
+ *    The plane for slice drawing.
+ * @param sliceNormalVector
+ *    Normal vector of the slice plane.
+ * @param bottomLeft
+ *    Bottom left corner of the grid.
+ * @param bottomRight
+ *    Bottom right corner of the grid.
+ * @param topRight
+ *    Top right corner of the grid.
+ * @param topLeft
+ *    Top left corner of the grid.
+ * @param numberOfColumns
+ *    Number of columns in the grid.
+ * @param numberOfRows
+ *    Number of rows in the grid.
+ * @param texelsRGBA
+ *    The texels.
+ * @param textureWidth
+ *    Width of the texture.
+ * @param textureHeight
+ *    Height of the texture.
+ */
+void
+BrainOpenGLVolumeSliceDrawing::drawObliqueSliceTexture(const VolumeSliceViewPlaneEnum::Enum sliceViewPlane,
+                                                       const float sliceNormalVector[3],
+                                                       const float bottomLeft[3],
+                                                       const float bottomRight[3],
+                                                       const float topRight[3],
+                                                       const float topLeft[3],
+                                                       const int64_t numberOfColumns,
+                                                       const int64_t numberOfRows,
+                                                       const std::vector<uint8_t>& texelsRGBA,
+                                                       const int64_t textureWidth,
+                                                       const int64_t textureHeight)
+{
+    glPushAttrib(GL_ENABLE_BIT
+                 | GL_TEXTURE_BIT
+                 | GL_COLOR_BUFFER_BIT);
+    
+    /*
+     * An oblique slice is not one of the volume's slices so there
+     * is one texture for each view plane.
+     */
+    const GLuint textureName = m_fixedPipelineDrawing->m_volumeSliceTextureCache->bindTexture(m_fixedPipelineDrawing->getContextSharingGroupPointer(),
+                                                                                            NULL,
+                                                                                            -1,
+                                                                                            static_cast<int32_t>(sliceViewPlane),
+                                                                                            -1,
+                                                                                            texelsRGBA,
+                                                                                            textureWidth,
+                                                                                            textureHeight);
+    if (textureName == 0) {
+        glPopAttrib();
+        return;
+    }
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    
+    glEnable(GL_TEXTURE_2D);
+    glEnable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GREATER, 0.0);
+    
+    const float maxS = static_cast<float>(numberOfColumns) / textureWidth;
+    const float maxT = static_cast<float>(numberOfRows) / textureHeight;
+    
+    glBegin(GL_QUADS);
+    glNormal3fv(sliceNormalVector);
+    glTexCoord2f(0.0, 0.0);
+    glVertex3fv(bottomLeft);
+    glTexCoord2f(maxS, 0.0);
+    glVertex3fv(bottomRight);
+    glTexCoord2f(maxS, maxT);
+    glVertex3fv(topRight);
+    glTexCoord2f(0.0, maxT);
+    glVertex3fv(topLeft);
+    glEnd();
+    
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPopAttrib();
+}
+
 /**
  * Draw an orthogonal slice.
  *
@@ -2077,6 +2252,8 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSlice_LPI_ONLY(const VolumeSliceVie
                                   volumeFile,
                                   iVol,
                                   mapIndex,
+                                  sliceViewPlane,
+                                  sliceIndexForDrawing,
                                   volumeDrawingOpacity);
         glDisable(GL_POLYGON_OFFSET_FILL);
     }
@@ -2586,6 +2763,8 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSlice(const VolumeSliceViewPlaneEnu
                                   volumeFile,
                                   iVol,
                                   volInfo.mapIndex,
+                                  sliceViewingPlane,
+                                  sliceIndexForDrawing,
                                   volumeDrawingOpacity);
         glDisable(GL_POLYGON_OFFSET_FILL);
         
@@ -3207,6 +3386,8 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceWithCulling(const VolumeSliceV
                                   volumeFile,
                                   iVol,
                                   mapIndex,
+                                  sliceViewPlane,
+                                  sliceIndexForDrawing,
                                   volumeDrawingOpacity);
         
         glDisable(GL_POLYGON_OFFSET_FILL);
@@ -4719,6 +4900,10 @@ BrainOpenGLVolumeSliceDrawing::setOrthographicProjection(const VolumeSliceViewPl
  *    Selected map in the volume being drawn.
  * @param mapIndex
  *    Selected map in the volume being drawn.
+ * @param sliceViewPlane
+ *    Plane of the slice.
+ * @param sliceIndex
+ *    Index of the slice in the volume.
  * @param sliceOpacity
  *    Opacity from the overlay.
  */
@@ -4734,12 +4919,37 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceVoxels(const float sliceNormal
                                                          const VolumeMappableInterface* volumeInterface,
                                                          const int32_t volumeIndex,
                                                          const int32_t mapIndex,
+                                                         const VolumeSliceViewPlaneEnum::Enum sliceViewPlane,
+                                                         const int64_t sliceIndex,
                                                          const uint8_t sliceOpacity)
 {
     if (validVoxelCount <= 0) {
         return;
     }
     
+    /*
+     * Unless identifying, the slice is uploaded as a texture and
+     * drawn with one quad.  Identification needs each voxel drawn
+     * as a quad so that the voxels can be found in the selection
+     * buffer.
+     */
+    if ( ! m_identificationModeFlag) {
+        if (drawOrthogonalSliceVoxelsTexture(sliceNormalVector,
+                                             coordinate,
+                                             rowStep,
+                                             columnStep,
+                                             numberOfColumns,
+                                             numberOfRows,
+                                             sliceRGBA,
+                                             volumeInterface,
+                                             mapIndex,
+                                             sliceViewPlane,
+                                             sliceIndex,
+                                             sliceOpacity)) {
+            return;
+        }
+    }
+    
     /*
      * There are two ways to draw the voxels.
      *
@@ -4815,6 +5025,151 @@ BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceVoxels(const float sliceNormal
     
 }
 
+/**
+ * Draw the voxels in an orthogonal slice as one textured quad.
+ *
+ * The slice coloring is copied into a texture (padded to a power of
+ * two in each dimension) with one texel per voxel.  Voxels that are not
+ * displayed get a zero alpha and are discarded by the alpha test so
+ * that they do not update the depth buffer.  The textures are kept by
+ * the fixed pipeline drawing's slice texture cache and the texels are only
+ * loaded into OpenGL when they differ from those loaded in a previous draw.
+ *
+ * @param sliceNormalVector
+ *    Normal vector of the slice plane.
+ * @param coordinate
+ *    Coordinate of first voxel in the slice (bottom left as begin viewed)
+ * @param rowStep
+ *    Three-dimensional step to next row.
+ * @param columnStep
+ *    Three-dimensional step to next column.
+ * @param numberOfColumns
+ *    Number of columns in the slice.
+ * @param numberOfRows
+ *    Number of rows in the slice.
+ * @param sliceRGBA
+ *    RGBA coloring for voxels in the slice.
+ * @param volumeInterface
+ *    Volume being drawn.
+ * @param mapIndex
+ *    Selected map in the volume being drawn.
+ * @param sliceViewPlane
+ *    Plane of the slice.
+ * @param sliceIndex
+ *    Index of the slice in the volume.
+ * @param sliceOpacity
+ *    Opacity from the overlay.
+ * @return
+ *    True if the slice was drawn, false if a texture could not be used
+ *    and the slice needs to be drawn with quads.
+ */
+bool
+BrainOpenGLVolumeSliceDrawing::drawOrthogonalSliceVoxelsTexture(const float sliceNormalVector[3],
+                                                                const float coordinate[3],
+                                                                const float rowStep[3],
+                                                                const float columnStep[3],
+                                                                const int64_t numberOfColumns,
+                                                                const int64_t numberOfRows,
+                                                                const std::vector<uint8_t>& sliceRGBA,
+                                                                const VolumeMappableInterface* volumeInterface,
+                                                                const int32_t mapIndex,
+                                                                const VolumeSliceViewPlaneEnum::Enum sliceViewPlane,
+                                                                const int64_t sliceIndex,
+                                                                const uint8_t sliceOpacity)
+{
+    if ((numberOfColumns <= 0)
+        || (numberOfRows <= 0)) {
+        return false;
+    }
+    
+    GLint maximumTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maximumTextureSize);
+    int64_t textureWidth = 1;
+    while (textureWidth < numberOfColumns) {
+        textureWidth *= 2;
+    }
+    int64_t textureHeight = 1;
+    while (textureHeight < numberOfRows) {
+        textureHeight *= 2;
+    }
+    if ((textureWidth > maximumTextureSize)
+        || (textureHeight > maximumTextureSize)) {
+        return false;
+    }
+    
+    /*
+     * Same opacity rules as the quad drawing: voxels with a zero
+     * alpha are not displayed, all others use the overlay's opacity.
+     * Texels outside of the slice (padding) are transparent.
+     */
+    m_sliceTextureRGBA.assign(textureWidth * textureHeight * 4, 0);
+    uint8_t* texels = &m_sliceTextureRGBA[0];
+    CaretAssert(static_cast<int64_t>(sliceRGBA.size()) >= (numberOfColumns * numberOfRows * 4));
+    for (int64_t jRow = 0; jRow < numberOfRows; jRow++) {
+        const uint8_t* sliceRow = &sliceRGBA[jRow * numberOfColumns * 4];
+        uint8_t* textureRow = texels + (jRow * textureWidth * 4);
+        for (int64_t iCol = 0; iCol < numberOfColumns; iCol++) {
+            const int64_t offset = iCol * 4;
+            if (sliceRow[offset + 3] > 0) {
+                textureRow[offset]     = sliceRow[offset];
+                textureRow[offset + 1] = sliceRow[offset + 1];
+                textureRow[offset + 2] = sliceRow[offset + 2];
+                textureRow[offset + 3] = sliceOpacity;
+            }
+        }
+    }
+    
+    glPushAttrib(GL_ENABLE_BIT
+                 | GL_TEXTURE_BIT
+                 | GL_COLOR_BUFFER_BIT);
+    
+    const GLuint textureName = m_fixedPipelineDrawing->m_volumeSliceTextureCache->bindTexture(m_fixedPipelineDrawing->getContextSharingGroupPointer(),
+                                                                                            volumeInterface,
+                                                                                            mapIndex,
+                                                                                            static_cast<int32_t>(sliceViewPlane),
+                                                                                            sliceIndex,
+                                                                                            m_sliceTextureRGBA,
+                                                                                            textureWidth,
+                                                                                            textureHeight);
+    if (textureName == 0) {
+        glPopAttrib();
+        return false;
+    }
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    
+    glEnable(GL_TEXTURE_2D);
+    glEnable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GREATER, 0.0);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    
+    const float maxS = static_cast<float>(numberOfColumns) / textureWidth;
+    const float maxT = static_cast<float>(numberOfRows) / textureHeight;
+    float bottomRight[3], topRight[3], topLeft[3];
+    for (int32_t i = 0; i < 3; i++) {
+        bottomRight[i] = coordinate[i] + (numberOfColumns * columnStep[i]);
+        topLeft[i]     = coordinate[i] + (numberOfRows * rowStep[i]);
+        topRight[i]    = topLeft[i] + (numberOfColumns * columnStep[i]);
+    }
+    
+    glBegin(GL_QUADS);
+    glNormal3fv(sliceNormalVector);
+    glTexCoord2f(0.0, 0.0);
+    glVertex3fv(coordinate);
+    glTexCoord2f(maxS, 0.0);
+    glVertex3fv(bottomRight);
+    glTexCoord2f(maxS, maxT);
+    glVertex3fv(topRight);
+    glTexCoord2f(0.0, maxT);
+    glVertex3fv(topLeft);
+    glEnd();
+    
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPopAttrib();
+    
+    return true;
+}
+
 /**
  * Draw the voxels in an orthogonal slice with single quads.
  *
@@ -6159,6 +6514,9 @@ BrainOpenGLVolumeSliceDrawing::VoxelToDraw::VoxelToDraw(const float center[3],
     const int64_t numSlices = 5;
     m_sliceIndices.reserve(numSlices);
     m_sliceOffsets.reserve(numSlices);
+    
+    m_rowIndex    = -1;
+    m_columnIndex = -1;
 }
 
 /**
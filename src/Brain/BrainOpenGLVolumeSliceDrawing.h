@@ -167,6 +167,16 @@ namespace caret {
              * Offset in values in VoxelsInSliceForVolume
              */
             std::vector<int64_t> m_sliceOffsets;
+            
+            /**
+             * Row of voxel in the oblique slice's grid
+             */
+            int64_t m_rowIndex;
+            
+            /**
+             * Column of voxel in the oblique slice's grid
+             */
+            int64_t m_columnIndex;
         };
         
         BrainOpenGLVolumeSliceDrawing(const BrainOpenGLVolumeSliceDrawing&);
@@ -202,6 +212,18 @@ namespace caret {
                               Matrix4x4& transformationMatrix,
                               const Plane& plane);
         
+        void drawObliqueSliceTexture(const VolumeSliceViewPlaneEnum::Enum sliceViewPlane,
+                                     const float sliceNormalVector[3],
+                                     const float bottomLeft[3],
+                                     const float bottomRight[3],
+                                     const float topRight[3],
+                                     const float topLeft[3],
+                                     const int64_t numberOfColumns,
+                                     const int64_t numberOfRows,
+                                     const std::vector<uint8_t>& texelsRGBA,
+                                     const int64_t textureWidth,
+                                     const int64_t textureHeight);
+        
         void drawOrthogonalSlice_LPI_ONLY(const VolumeSliceViewPlaneEnum::Enum sliceViewPlane,
                                  const float sliceCoordinates[3],
                                  const Plane& plane);
@@ -269,6 +291,8 @@ namespace caret {
                                        const VolumeMappableInterface* volumeInterface,
                                        const int32_t volumeIndex,
                                        const int32_t mapIndex,
+                                       const VolumeSliceViewPlaneEnum::Enum sliceViewPlane,
+                                       const int64_t sliceIndex,
                                        const uint8_t sliceOpacity);
         
         void drawOrthogonalSliceVoxelsSingleQuads(const float sliceNormalVector[3],
@@ -283,6 +307,19 @@ namespace caret {
                                        const int32_t mapIndex,
                                        const uint8_t sliceOpacity);
         
+        bool drawOrthogonalSliceVoxelsTexture(const float sliceNormalVector[3],
+                                              const float coordinate[3],
+                                              const float rowStep[3],
+                                              const float columnStep[3],
+                                              const int64_t numberOfColumns,
+                                              const int64_t numberOfRows,
+                                              const std::vector<uint8_t>& sliceRGBA,
+                                              const VolumeMappableInterface* volumeInterface,
+                                              const int32_t mapIndex,
+                                              const VolumeSliceViewPlaneEnum::Enum sliceViewPlane,
+                                              const int64_t sliceIndex,
+                                              const uint8_t sliceOpacity);
+        
         void drawOrthogonalSliceVoxelsQuadIndicesAndStrips(const float sliceNormalVector[3],
                                                            const float coordinate[3],
                                                            const float rowStep[3],
@@ -358,6 +395,9 @@ namespace caret {
         
         bool m_identificationModeFlag;
         
+        /** Texels for the slice texture, reused to avoid reallocations */
+        std::vector<uint8_t> m_sliceTextureRGBA;
+        
         static const int32_t IDENTIFICATION_INDICES_PER_VOXEL;
         
         // ADD_NEW_MEMBERS_HERE
@@ -0,0 +1,219 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017 Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#define __BRAIN_OPEN_G_L_VOLUME_SLICE_TEXTURE_CACHE_DECLARE__
+#include "BrainOpenGLVolumeSliceTextureCache.h"
+#undef __BRAIN_OPEN_G_L_VOLUME_SLICE_TEXTURE_CACHE_DECLARE__
+
+#include "CaretAssert.h"
+#include "EventGraphicsOpenGLCreateTextureName.h"
+#include "EventManager.h"
+#include "GraphicsOpenGLTextureName.h"
+
+using namespace caret;
+
+
+
+/**
+ * \class caret::BrainOpenGLVolumeSliceTextureCache
+ * \brief Textures for volume slices that persist from one draw to the next.
+ * \ingroup Brain
+ *
+ * The volume slice drawing objects are created for each draw so the slice
+ * textures are kept here, owned by the fixed pipeline drawing.  A texture
+ * is identified by the volume, map, slice view plane, and slice index.  The
+ * texels last loaded into each texture are kept so that the texture is only
+ * reloaded when the slice's coloring (palette, threshold, opacity, layer
+ * order, etc.) or its extent has changed.  Since the texels are compared,
+ * a texture is never drawn with stale coloring even if a volume is
+ * destroyed and another is created at the same address.
+ */
+
+/**
+ * Constructor.
+ */
+BrainOpenGLVolumeSliceTextureCache::BrainOpenGLVolumeSliceTextureCache()
+: CaretObject()
+{
+
+}
+
+/**
+ * Destructor.
+ */
+BrainOpenGLVolumeSliceTextureCache::~BrainOpenGLVolumeSliceTextureCache()
+{
+    clear();
+}
+
+/**
+ * Delete all of the textures.
+ */
+void
+BrainOpenGLVolumeSliceTextureCache::clear()
+{
+    for (auto& sliceIter : m_sliceTextures) {
+        delete sliceIter.second.m_textureName;
+    }
+    m_sliceTextures.clear();
+}
+
+/**
+ * Bind the texture for a slice, creating the texture or loading the texels
+ * into it only when the texels differ from those last loaded.
+ *
+ * @param openglContextPointer
+ *     The current OpenGL context (sharing group).  Textures created in
+ *     a different context are recreated.
+ * @param volumeIdentifier
+ *     Identifies the volume (its address).
+ * @param mapIndex
+ *     Index of the map.
+ * @param sliceViewPlane
+ *     The slice view plane.
+ * @param sliceIndex
+ *     Index of the slice (use -1 for a slice that is not one of the
+ *     volume's slices such as an oblique slice).
+ * @param texelsRGBA
+ *     The texels, four bytes per texel.
+ * @param textureWidth
+ *     Width of the texture.
+ * @param textureHeight
+ *     Height of the texture.
+ * @return
+ *     The OpenGL texture name that is now bound to GL_TEXTURE_2D or zero
+ *     if a texture could not be created.
+ */
+GLuint
+BrainOpenGLVolumeSliceTextureCache::bindTexture(void* openglContextPointer,
+                                                const void* volumeIdentifier,
+                                                const int32_t mapIndex,
+                                                const int32_t sliceViewPlane,
+                                                const int64_t sliceIndex,
+                                                const std::vector<uint8_t>& texelsRGBA,
+                                                const int64_t textureWidth,
+                                                const int64_t textureHeight)
+{
+    CaretAssert(static_cast<int64_t>(texelsRGBA.size()) == (textureWidth * textureHeight * 4));
+
+    const SliceKey key(volumeIdentifier,
+                       mapIndex,
+                       sliceViewPlane,
+                       sliceIndex);
+    auto sliceIter = m_sliceTextures.find(key);
+    if (sliceIter == m_sliceTextures.end()) {
+        removeLeastRecentlyUsed();
+        sliceIter = m_sliceTextures.insert(std::make_pair(key,
+                                                          SliceTexture())).first;
+    }
+    SliceTexture& sliceTexture = sliceIter->second;
+    sliceTexture.m_lastUsed = ++m_useCounter;
+
+    if (sliceTexture.m_textureName != NULL) {
+        if (sliceTexture.m_textureName->getOpenGLContextPointer() != openglContextPointer) {
+            delete sliceTexture.m_textureName;
+            sliceTexture.m_textureName = NULL;
+        }
+    }
+
+    bool loadTexelsFlag = false;
+    if (sliceTexture.m_textureName == NULL) {
+        EventGraphicsOpenGLCreateTextureName createEvent;
+        EventManager::get()->sendEvent(createEvent.getPointer());
+        sliceTexture.m_textureName = createEvent.getOpenGLTextureName();
+        if (sliceTexture.m_textureName == NULL) {
+            m_sliceTextures.erase(sliceIter);
+            return 0;
+        }
+
+        glBindTexture(GL_TEXTURE_2D, sliceTexture.m_textureName->getTextureName());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        loadTexelsFlag = true;
+    }
+    else {
+        glBindTexture(GL_TEXTURE_2D, sliceTexture.m_textureName->getTextureName());
+        if ((sliceTexture.m_textureWidth != textureWidth)
+            || (sliceTexture.m_textureHeight != textureHeight)
+            || (sliceTexture.m_texelsRGBA != texelsRGBA)) {
+            loadTexelsFlag = true;
+        }
+    }
+
+    if (loadTexelsFlag) {
+        glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D,
+                     0,
+                     GL_RGBA,
+                     textureWidth,
+                     textureHeight,
+                     0,
+                     GL_RGBA,
+                     GL_UNSIGNED_BYTE,
+                     &texelsRGBA[0]);
+        glPopClientAttrib();
+
+        sliceTexture.m_texelsRGBA    = texelsRGBA;
+        sliceTexture.m_textureWidth  = textureWidth;
+        sliceTexture.m_textureHeight = textureHeight;
+    }
+
+    return sliceTexture.m_textureName->getTextureName();
+}
+
+/**
+ * If the cache is full, delete the texture that was used least recently.
+ */
+void
+BrainOpenGLVolumeSliceTextureCache::removeLeastRecentlyUsed()
+{
+    if (static_cast<int32_t>(m_sliceTextures.size()) < s_maximumNumberOfTextures) {
+        return;
+    }
+
+    auto oldestIter = m_sliceTextures.begin();
+    for (auto sliceIter = m_sliceTextures.begin();
+         sliceIter != m_sliceTextures.end();
+         sliceIter++) {
+        if (sliceIter->second.m_lastUsed < oldestIter->second.m_lastUsed) {
+            oldestIter = sliceIter;
+        }
+    }
+    if (oldestIter != m_sliceTextures.end()) {
+        delete oldestIter->second.m_textureName;
+        m_sliceTextures.erase(oldestIter);
+    }
+}
+
+/**
+ * Get a description of this object's content.
+ * @return String describing this object's content.
+ */
+AString
+BrainOpenGLVolumeSliceTextureCache::toString() const
+{
+    return ("BrainOpenGLVolumeSliceTextureCache: "
+            + AString::number(m_sliceTextures.size())
+            + " textures");
+}
+
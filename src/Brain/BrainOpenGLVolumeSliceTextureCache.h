@@ -0,0 +1,97 @@
+#ifndef __BRAIN_OPEN_G_L_VOLUME_SLICE_TEXTURE_CACHE_H__
+#define __BRAIN_OPEN_G_L_VOLUME_SLICE_TEXTURE_CACHE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017 Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <map>
+#include <stdint.h>
+#include <tuple>
+#include <vector>
+
+#include "CaretObject.h"
+#include "CaretOpenGLInclude.h"
+
+namespace caret {
+
+    class GraphicsOpenGLTextureName;
+
+    class BrainOpenGLVolumeSliceTextureCache : public CaretObject {
+
+    public:
+        BrainOpenGLVolumeSliceTextureCache();
+
+        virtual ~BrainOpenGLVolumeSliceTextureCache();
+
+        GLuint bindTexture(void* openglContextPointer,
+                           const void* volumeIdentifier,
+                           const int32_t mapIndex,
+                           const int32_t sliceViewPlane,
+                           const int64_t sliceIndex,
+                           const std::vector<uint8_t>& texelsRGBA,
+                           const int64_t textureWidth,
+                           const int64_t textureHeight);
+
+        void clear();
+
+        // ADD_NEW_METHODS_HERE
+
+        virtual AString toString() const;
+
+    private:
+        /** Volume, map, slice view plane, slice index */
+        typedef std::tuple<const void*, int32_t, int32_t, int64_t> SliceKey;
+
+        /** A texture and a copy of the texels last loaded into it */
+        struct SliceTexture {
+            GraphicsOpenGLTextureName* m_textureName = NULL;
+
+            std::vector<uint8_t> m_texelsRGBA;
+
+            int64_t m_textureWidth = 0;
+
+            int64_t m_textureHeight = 0;
+
+            int64_t m_lastUsed = 0;
+        };
+
+        BrainOpenGLVolumeSliceTextureCache(const BrainOpenGLVolumeSliceTextureCache&);
+
+        BrainOpenGLVolumeSliceTextureCache& operator=(const BrainOpenGLVolumeSliceTextureCache&);
+
+        void removeLeastRecentlyUsed();
+
+        std::map<SliceKey, SliceTexture> m_sliceTextures;
+
+        int64_t m_useCounter = 0;
+
+        /** Slices kept at one time (three planes and a few layers or montage slices) */
+        static const int32_t s_maximumNumberOfTextures;
+
+        // ADD_NEW_MEMBERS_HERE
+
+    };
+
+#ifdef __BRAIN_OPEN_G_L_VOLUME_SLICE_TEXTURE_CACHE_DECLARE__
+    const int32_t BrainOpenGLVolumeSliceTextureCache::s_maximumNumberOfTextures = 48;
+#endif // __BRAIN_OPEN_G_L_VOLUME_SLICE_TEXTURE_CACHE_DECLARE__
+
+} // namespace
+#endif  //__BRAIN_OPEN_G_L_VOLUME_SLICE_TEXTURE_CACHE_H__
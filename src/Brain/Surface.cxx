@@ -20,6 +20,7 @@
 
 #include "BoundingBox.h"
 #include "BrainStructure.h"
+#include "GraphicsEngineDataOpenGLSurface.h"
 #include "Surface.h"
 
 using namespace caret;
@@ -114,6 +115,7 @@ void
 Surface::copyHelperSurface(const Surface& /*s*/)
 {
     this->initializeMemberSurface();
+    m_graphicsEngineDataForOpenGL.reset();
     this->computeNormals();
 }
 
@@ -146,6 +148,24 @@ Surface::setBrainStructure(BrainStructure* brainStructure)
     this->brainStructure = brainStructure;
 }
 
+/**
+ * @return The OpenGL buffers for drawing this surface (NULL if not yet created).
+ */
+GraphicsEngineDataOpenGLSurface*
+Surface::getGraphicsEngineDataForOpenGL()
+{
+    return m_graphicsEngineDataForOpenGL.get();
+}
 
-
-
+/**
+ * Set the OpenGL buffers for drawing this surface.  This surface
+ * takes ownership and will delete them.
+ *
+ * @param graphicsEngineDataForOpenGL
+ *     The OpenGL buffers.
+ */
+void
+Surface::setGraphicsEngineDataForOpenGL(GraphicsEngineDataOpenGLSurface* graphicsEngineDataForOpenGL)
+{
+    m_graphicsEngineDataForOpenGL.reset(graphicsEngineDataForOpenGL);
+}
@@ -22,6 +22,7 @@
  */
 /*LICENSE_END*/
 
+#include <memory>
 #include <vector>
 
 #include "SurfaceFile.h"
@@ -30,6 +31,7 @@ namespace caret {
     
     class BoundingBox;
     class BrainStructure;
+    class GraphicsEngineDataOpenGLSurface;
     
     /**
      * Maintains view of some type of object.
@@ -55,12 +57,19 @@ namespace caret {
         
         void setBrainStructure(BrainStructure* brainStructure);
         
+        GraphicsEngineDataOpenGLSurface* getGraphicsEngineDataForOpenGL();
+        
+        void setGraphicsEngineDataForOpenGL(GraphicsEngineDataOpenGLSurface* graphicsEngineDataForOpenGL);
+        
     private:
         void initializeMemberSurface();
         
         void copyHelperSurface(const Surface& s);
 
         BrainStructure* brainStructure;
+        
+        /** OpenGL buffers with the geometry and coloring, never copied */
+        std::unique_ptr<GraphicsEngineDataOpenGLSurface> m_graphicsEngineDataForOpenGL;
     };
 
 } // namespace
@@ -24,12 +24,15 @@
 #include "CaretAssert.h"
 #include "CaretHttpManager.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "DataFileException.h"
 #include "FileInformation.h"
 #include "MultiDimArray.h"
 #include "MultiDimIterator.h"
 #include "NiftiIO.h"
 
+#include <algorithm>
+
 using namespace std;
 using namespace caret;
 
@@ -41,11 +44,14 @@ namespace
         mutable NiftiIO m_nifti;//because file objects aren't stateless (current position), so reading "changes" them
         CiftiXML m_xml;//because we need to parse it to set up the dimensions anyway
     public:
-        CiftiOnDiskImpl(const QString& filename);//read-only
+        CiftiOnDiskImpl(const QString& filename, const bool& memoryMap = false);//read-only
         CiftiOnDiskImpl(const QString& filename, const CiftiXML& xml, const CiftiVersion& version, const bool& swapEndian,
                         const int16_t& datatype, const bool& rescale, const double& minval, const double& maxval);//make new empty file with read/write
         void getRow(float* dataOut, const std::vector<int64_t>& indexSelect, const bool& tolerateShortRead) const;
         void getColumn(float* dataOut, const int64_t& index) const;
+        void getRows(float* dataOut, const std::vector<int64_t>& indices, const int64_t& rowSize) const;
+        const float* getRowPointer(const std::vector<int64_t>& indexSelect) const;
+        void setAccessHint(const CaretBinaryFile::AccessHint& hint) { m_nifti.setAccessHint(hint); }
         const CiftiXML& getCiftiXML() const { return m_xml; }
         QString getFilename() const { return m_nifti.getFilename(); }
         bool isSwapped() const { return m_nifti.getHeader().isSwapped(); }
@@ -62,6 +68,7 @@ namespace
         void getRow(float* dataOut, const std::vector<int64_t>& indexSelect, const bool& tolerateShortRead) const;
         void getColumn(float* dataOut, const int64_t& index) const;
         bool isInMemory() const { return true; }
+        const float* getRowPointer(const std::vector<int64_t>& indexSelect) const { return m_array.get(1, indexSelect); }
         void setRow(const float* dataIn, const std::vector<int64_t>& indexSelect);
         void setColumn(const float* dataIn, const int64_t& index);
     };
@@ -107,6 +114,16 @@ CiftiFile::WriteImplInterface::~WriteImplInterface()
 {
 }
 
+void CiftiFile::ReadImplInterface::getRows(float* dataOut, const vector<int64_t>& indices, const int64_t& rowSize) const
+{
+    vector<int64_t> indexSelect(1);
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        indexSelect[0] = indices[i];
+        getRow(dataOut + i * rowSize, indexSelect, false);
+    }
+}
+
 CiftiFile::CiftiFile(const QString& fileName)
 {
     m_endianPref = NATIVE;
@@ -125,6 +142,18 @@ void CiftiFile::openFile(const QString& fileName)
     m_fileName = fileName;
 }
 
+void CiftiFile::openFileMapped(const QString& fileName, const CaretBinaryFile::AccessHint& hint)
+{
+    close();
+    CaretPointer<CiftiOnDiskImpl> newRead(new CiftiOnDiskImpl(FileInformation(fileName).getAbsoluteFilePath(), true));//falls back to normal reading for compressed files
+    newRead->setAccessHint(hint);
+    m_readingImpl = newRead;
+    m_xml = newRead->getCiftiXML();
+    m_dims = m_xml.getDimensions();
+    m_onDiskVersion = m_xml.getParsedVersion();
+    m_fileName = fileName;
+}
+
 void CiftiFile::openURL(const QString& url, const QString& user, const QString& pass)
 {
     close();//to make sure it closes everything first, even if the open throws
@@ -249,6 +278,40 @@ void CiftiFile::getRow(float* dataOut, const vector<int64_t>& indexSelect, const
     m_readingImpl->getRow(dataOut, indexSelect, tolerateShortRead);
 }
 
+const float* CiftiFile::getRowPointer(const vector<int64_t>& indexSelect) const
+{
+    if (m_dims.empty()) throw DataFileException("getRowPointer called on uninitialized CiftiFile");
+    if (m_readingImpl == NULL) return NULL;
+    return m_readingImpl->getRowPointer(indexSelect);
+}
+
+const float* CiftiFile::getRowPointer(const int64_t& index) const
+{
+    if (m_dims.empty()) throw DataFileException("getRowPointer called on uninitialized CiftiFile");
+    if (m_dims.size() != 2) throw DataFileException("getRowPointer with single index called on non-2D CiftiFile");
+    if (m_readingImpl == NULL) return NULL;
+    vector<int64_t> tempvec(1, index);
+    return m_readingImpl->getRowPointer(tempvec);
+}
+
+void CiftiFile::getRows(float* dataOut, const vector<int64_t>& indices) const
+{
+    if (m_dims.empty()) throw DataFileException("getRows called on uninitialized CiftiFile");
+    if (m_dims.size() != 2) throw DataFileException("getRows called on non-2D CiftiFile");
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        if (indices[i] < 0 || indices[i] >= m_dims[1]) throw DataFileException("getRows called with invalid row index " + AString::number(indices[i]));
+    }
+    if (m_readingImpl == NULL) return;//NOT an error because we are pretending to have a matrix already, while we are waiting for setRow to actually start writing the file
+    m_readingImpl->getRows(dataOut, indices, m_dims[0]);
+}
+
+void CiftiFile::setAccessHint(const CaretBinaryFile::AccessHint& hint)
+{
+    if (m_readingImpl == NULL) return;
+    m_readingImpl->setAccessHint(hint);
+}
+
 void CiftiFile::getColumn(float* dataOut, const int64_t& index) const
 {
     if (m_dims.empty()) throw DataFileException("getColumn called on uninitialized CiftiFile");
@@ -458,9 +521,9 @@ void CiftiMemoryImpl::setColumn(const float* dataIn, const int64_t& index)
     }
 }
 
-CiftiOnDiskImpl::CiftiOnDiskImpl(const QString& filename)
+CiftiOnDiskImpl::CiftiOnDiskImpl(const QString& filename, const bool& memoryMap)
 {//opens existing file for reading
-    m_nifti.openRead(filename);//read-only, so we don't need write permission to read a cifti file
+    m_nifti.openRead(filename, memoryMap);//read-only, so we don't need write permission to read a cifti file
     if (m_nifti.getNumComponents() != 1) throw DataFileException("complex or rgb datatype found in file '" + filename + "', these are not supported in cifti");
     const NiftiHeader& myHeader = m_nifti.getHeader();
     int numExts = (int)myHeader.m_extensions.size(), whichExt = -1;
@@ -660,9 +723,112 @@ void CiftiOnDiskImpl::close()
 
 void CiftiOnDiskImpl::getRow(float* dataOut, const vector<int64_t>& indexSelect, const bool& tolerateShortRead) const
 {
+    const float* mapped = getRowPointer(indexSelect);
+    if (mapped != NULL)
+    {//skip the scratch buffer and conversion
+        int64_t rowSize = m_xml.getDimensionLength(CiftiXML::ALONG_ROW);
+        for (int64_t i = 0; i < rowSize; ++i)
+        {
+            dataOut[i] = mapped[i];
+        }
+        return;
+    }
     m_nifti.readData(dataOut, 5, indexSelect, tolerateShortRead);//5 means 4 reserved (space and time) plus the first cifti dimension
 }
 
+namespace
+{
+    const int64_t ROW_RUN_MAX_BYTES = 1 << 24;//cap on a single coalesced read, so scratch memory stays reasonable for huge requests
+}
+
+void CiftiOnDiskImpl::getRows(float* dataOut, const vector<int64_t>& indices, const int64_t& rowSize) const
+{
+    const int64_t numIndices = (int64_t)indices.size();
+    if (numIndices == 0) return;
+    vector<pair<int64_t, int64_t> > sorted(numIndices);//row in file, row in output
+    for (int64_t i = 0; i < numIndices; ++i)
+    {
+        sorted[i] = make_pair(indices[i], i);
+    }
+    sort(sorted.begin(), sorted.end());
+    const int64_t maxRunRows = max((int64_t)1, ROW_RUN_MAX_BYTES / (rowSize * (int64_t)sizeof(float)));
+    vector<int64_t> runStarts(1, 0);//split the sorted list wherever the file rows aren't adjacent (duplicates don't break a run)
+    for (int64_t i = 1; i < numIndices; ++i)
+    {
+        if (sorted[i].first - sorted[i - 1].first > 1 || sorted[i].first - sorted[runStarts.back()].first >= maxRunRows)
+        {
+            runStarts.push_back(i);
+        }
+    }
+    runStarts.push_back(numIndices);
+    const int64_t numRuns = (int64_t)runStarts.size() - 1;
+    const bool useThreads = numRuns > 1 && m_nifti.canReadConcurrently();//otherwise, the reads would just take turns on the NiftiIO mutex
+    bool failed = false;
+    AString errorMessage;
+#pragma omp CARET_PARFOR schedule(dynamic) if(useThreads)
+    for (int64_t run = 0; run < numRuns; ++run)
+    {
+        try
+        {
+            const int64_t runBegin = runStarts[run], runEnd = runStarts[run + 1];
+            const int64_t firstRow = sorted[runBegin].first;
+            const int64_t runRows = sorted[runEnd - 1].first - firstRow + 1;
+            vector<int64_t> indexSelect(1, firstRow);
+            const float* source = m_nifti.getMappedFloatData(5, indexSelect);//mapped rows are contiguous, so the first row pointer covers the run
+            vector<float> scratch;
+            if (source == NULL)
+            {
+                bool direct = (runEnd - runBegin == runRows);//no duplicates, now check whether the output rows are in the same order
+                for (int64_t i = runBegin + 1; direct && i < runEnd; ++i)
+                {
+                    direct = (sorted[i].second == sorted[i - 1].second + 1);
+                }
+                if (direct)
+                {//caller asked for these rows in file order, read straight into the output
+                    m_nifti.readDataRange(dataOut + sorted[runBegin].second * rowSize, 5, indexSelect, runRows);
+                    continue;
+                }
+                scratch.resize(runRows * rowSize);
+                m_nifti.readDataRange(scratch.data(), 5, indexSelect, runRows);
+                source = scratch.data();
+            }
+            for (int64_t i = runBegin; i < runEnd; ++i)
+            {
+                const float* rowIn = source + (sorted[i].first - firstRow) * rowSize;
+                float* rowOut = dataOut + sorted[i].second * rowSize;
+                for (int64_t j = 0; j < rowSize; ++j)
+                {
+                    rowOut[j] = rowIn[j];
+                }
+            }
+        } catch (CaretException& e) {//exceptions can't leave a parallel region
+#pragma omp critical
+            {
+                failed = true;
+                errorMessage = e.whatString();
+            }
+        } catch (std::exception& e) {
+#pragma omp critical
+            {
+                failed = true;
+                errorMessage = AString("exception while reading cifti rows: ") + e.what();
+            }
+        } catch (...) {
+#pragma omp critical
+            {
+                failed = true;
+                errorMessage = "unknown exception while reading cifti rows";
+            }
+        }
+    }
+    if (failed) throw DataFileException(errorMessage);
+}
+
+const float* CiftiOnDiskImpl::getRowPointer(const vector<int64_t>& indexSelect) const
+{
+    return m_nifti.getMappedFloatData(5, indexSelect);
+}
+
 void CiftiOnDiskImpl::getColumn(float* dataOut, const int64_t& index) const
 {
     CaretAssert(m_xml.getNumberOfDimensions() == 2);//otherwise this shouldn't be called
@@ -21,6 +21,7 @@
  */
 /*LICENSE_END*/
 
+#include "CaretBinaryFile.h"
 #include "CaretPointer.h"
 #include "CiftiInterface.h"
 #include "CiftiXML.h"
@@ -53,6 +54,7 @@ namespace caret
         }
         explicit CiftiFile(const QString &fileName);//calls openFile
         void openFile(const QString& fileName);//starts on-disk reading
+        void openFileMapped(const QString& fileName, const CaretBinaryFile::AccessHint& hint = CaretBinaryFile::ACCESS_NORMAL);//on-disk reading through a memory mapping, see getRowPointer()
         void openURL(const QString& url, const QString& user, const QString& pass);//open from XNAT
         void openURL(const QString& url);//same, without user/pass (or curently, reusing existing auth if the server matches
         void setWritingFile(const QString& fileName, const CiftiVersion& writingVersion = CiftiVersion(), const ENDIAN& endian = NATIVE);//starts on-disk writing
@@ -69,6 +71,14 @@ namespace caret
             return MultiDimIterator<int64_t>(std::vector<int64_t>(m_dims.begin() + 1, m_dims.end()));
         }
         void getColumn(float* dataOut, const int64_t& index) const;//for 2D only, will be slow if on disk!
+        ///for 2D only, fetch many rows at once, dataOut must hold indices.size() rows - output is in the order of indices, duplicates are allowed
+        ///on disk, the indices are sorted and adjacent rows are read in single contiguous reads, so pass all the rows you need rather than calling getRow in a loop
+        void getRows(float* dataOut, const std::vector<int64_t>& indices) const;
+        ///pointer to the row without copying, for in-memory files and for mapped files that need no conversion (native-endian float32, no scaling)
+        ///returns NULL when that isn't possible, use getRow() instead - the pointer is invalidated by anything that replaces the data (close, open, setCiftiXML, writeFile over itself)
+        const float* getRowPointer(const std::vector<int64_t>& indexSelect) const;
+        const float* getRowPointer(const int64_t& index) const;
+        void setAccessHint(const CaretBinaryFile::AccessHint& hint);//only affects memory-mapped reading
         
         void setCiftiXML(const CiftiXML& xml, const bool useOldMetadata = true);
         void setCiftiXML(const CiftiXMLOld &xml, const bool useOldMetadata = true);//set xml from old implementation
@@ -91,7 +101,10 @@ namespace caret
         public:
             virtual void getRow(float* dataOut, const std::vector<int64_t>& indexSelect, const bool& tolerateShortRead) const = 0;
             virtual void getColumn(float* dataOut, const int64_t& index) const = 0;
+            virtual void getRows(float* dataOut, const std::vector<int64_t>& indices, const int64_t& rowSize) const;//default calls getRow for each index
             virtual bool isInMemory() const { return false; }
+            virtual const float* getRowPointer(const std::vector<int64_t>&) const { return NULL; }
+            virtual void setAccessHint(const CaretBinaryFile::AccessHint&) { }
             virtual ~ReadImplInterface();
         };
         //assume if you can write to it, you can also read from it
@@ -185,6 +185,40 @@ static const unsigned char Base64DecodeTable[256] =
   0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF
 };
 
+//----------------------------------------------------------------------------
+// Decode tables with each character's 6-bit value already shifted to its
+// place in the 24-bit group, so four characters decode with four lookups
+// and three ORs.  Invalid characters, and '=', set bit 24.
+static const uint32_t Base64ShiftedInvalidBit = 0x01000000;
+
+namespace {
+    struct Base64ShiftedDecodeTables
+    {
+        uint32_t m_table[4][256];
+        
+        Base64ShiftedDecodeTables()
+        {
+            for (int32_t c = 0; c < 256; c++)
+            {
+                const unsigned char d = Base64DecodeTable[c];
+                for (int32_t i = 0; i < 4; i++)
+                {
+                    if ((d == 0xFF) || (c == '='))
+                    {
+                        m_table[i][c] = Base64ShiftedInvalidBit;
+                    }
+                    else
+                    {
+                        m_table[i][c] = (static_cast<uint32_t>(d) << (18 - 6 * i));
+                    }
+                }
+            }
+        }
+    };
+    
+    const Base64ShiftedDecodeTables Base64ShiftedTables;
+}
+
 //----------------------------------------------------------------------------
 inline static unsigned char Base64DecodeChar(unsigned char c)
 {
@@ -298,3 +332,129 @@ uint64_t Base64::decode(const unsigned char *input,
 
   return optr - output;
 }
+
+//----------------------------------------------------------------------------
+inline static bool Base64IsWhitespace(unsigned char c)
+{
+  return ((c == ' ') || (c == '\t') || (c == '\n') || (c == '\r'));
+}
+
+//----------------------------------------------------------------------------
+uint64_t Base64::decodeText(const char* input,
+                            uint64_t inputLength,
+                            unsigned char* output,
+                            uint64_t outputLength)
+{
+  const uint32_t (*table)[256] = Base64ShiftedTables.m_table;
+  const unsigned char *ptr = reinterpret_cast<const unsigned char*>(input);
+  const unsigned char *end = ptr + inputLength;
+  unsigned char *optr = output;
+  unsigned char *oend = output + outputLength;
+
+  while (ptr < end)
+    {
+    // Decode two complete groups (8 characters into 6 bytes) per step,
+    // leaving whitespace, padding and invalid characters to the code below
+    while (((end - ptr) >= 8) && ((oend - optr) >= 6))
+      {
+      const uint32_t a = (table[0][ptr[0]] | table[1][ptr[1]]
+                          | table[2][ptr[2]] | table[3][ptr[3]]);
+      const uint32_t b = (table[0][ptr[4]] | table[1][ptr[5]]
+                          | table[2][ptr[6]] | table[3][ptr[7]]);
+      if ((a | b) & Base64ShiftedInvalidBit)
+        {
+        break;
+        }
+      optr[0] = static_cast<unsigned char>(a >> 16);
+      optr[1] = static_cast<unsigned char>(a >> 8);
+      optr[2] = static_cast<unsigned char>(a);
+      optr[3] = static_cast<unsigned char>(b >> 16);
+      optr[4] = static_cast<unsigned char>(b >> 8);
+      optr[5] = static_cast<unsigned char>(b);
+      ptr += 8;
+      optr += 6;
+      }
+
+    // Decode one group, skipping whitespace, the group may be padded
+    unsigned char group[4] = { '=', '=', '=', '=' };
+    int numChars = 0;
+    while ((numChars < 4) && (ptr < end))
+      {
+      if ( ! Base64IsWhitespace(*ptr))
+        {
+        group[numChars] = *ptr;
+        numChars++;
+        }
+      ptr++;
+      }
+    if (numChars == 0)
+      {
+      // only whitespace remained
+      break;
+      }
+    if (group[0] == '=')
+      {
+      // end of data mark
+      break;
+      }
+    if (group[1] == '=')
+      {
+      return 0;
+      }
+
+    int numBytes = 3;
+    if (group[2] == '=')
+      {
+      if (group[3] != '=')
+        {
+        return 0;
+        }
+      numBytes = 1;
+      }
+    else if (group[3] == '=')
+      {
+      numBytes = 2;
+      }
+    if (numBytes < 3)
+      {
+      // padding is only allowed at the end
+      while ((ptr < end) && Base64IsWhitespace(*ptr))
+        {
+        ptr++;
+        }
+      if ((ptr < end) && (*ptr != '='))
+        {
+        return 0;
+        }
+      }
+
+    const unsigned char d0 = Base64DecodeChar(group[0]);
+    const unsigned char d1 = Base64DecodeChar(group[1]);
+    const unsigned char d2 = Base64DecodeChar(group[2]);
+    const unsigned char d3 = Base64DecodeChar(group[3]);
+    if ((d0 == 0xFF) || (d1 == 0xFF) || (d2 == 0xFF) || (d3 == 0xFF))
+      {
+      return 0;
+      }
+    if ((oend - optr) < numBytes)
+      {
+      return 0;
+      }
+    optr[0] = ((d0 << 2) & 0xFC) | ((d1 >> 4) & 0x03);
+    if (numBytes > 1)
+      {
+      optr[1] = ((d1 << 4) & 0xF0) | ((d2 >> 2) & 0x0F);
+      }
+    if (numBytes > 2)
+      {
+      optr[2] = ((d2 << 6) & 0xC0) | (d3 & 0x3F);
+      }
+    optr += numBytes;
+    if (numBytes < 3)
+      {
+      break;
+      }
+    }
+
+  return optr - output;
+}
@@ -89,6 +89,19 @@ public:
                               unsigned char *output,
                               uint64_t max_input_length = 0);
     
+  // Description:
+  // Decode 'inputLength' characters of Base64 text into the output
+  // buffer, which holds 'outputLength' bytes.  Whitespace (spaces, tabs
+  // and line breaks) is skipped.  Groups of characters are decoded with
+  // shifted lookup tables, eight characters per step, instead of one
+  // triplet at a time.  Returns the number of bytes decoded, which is 0
+  // if the text contains an invalid character or decodes to more than
+  // 'outputLength' bytes.  A group of four '=' marks the end of the data.
+  static uint64_t decodeText(const char* input,
+                             uint64_t inputLength,
+                             unsigned char* output,
+                             uint64_t outputLength);
+    
 private:
     // Description:  
     // Decode 4 bytes into 3 bytes.
@@ -29,12 +29,22 @@
 #include "CaretBinaryFile.h"
 #include "CaretLogger.h"
 #include "DataFileException.h"
+#include "GzipBlockWriter.h"
+#include "GzipIndexedReader.h"
 
 #include <QFile>
 #include "zlib.h"
 
 #include <algorithm>
 
+#ifndef CARET_OS_WINDOWS
+#include <cerrno>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+
 using namespace caret;
 using namespace std;
 
@@ -64,8 +74,10 @@ namespace caret
     class QFileImpl : public CaretBinaryFile::ImplInterface
     {
         QFile m_file;
+        bool m_readOnly;//positional reads bypass QFile's buffering, so don't allow them if there might be unflushed writes
         const static int64_t CHUNK_SIZE;
     public:
+        QFileImpl() { m_readOnly = false; }
         void open(const QString& filename, const CaretBinaryFile::OpenMode& opmode);
         void close();
         void seek(const int64_t& position);
@@ -73,15 +85,60 @@ namespace caret
         int64_t size() { return m_file.size(); }
         void read(void* dataOut, const int64_t& count, int64_t* numRead);
         void write(const void* dataIn, const int64_t& count);
+        bool canReadAt();
+        void readAt(const int64_t& position, void* dataOut, const int64_t& count, int64_t* numRead);
     };
     
     const int64_t QFileImpl::CHUNK_SIZE = 1<<30;//1GiB, QT4 apparently chokes at more than 2GiB via buffer.read using int32
+    
+    //read-only access through QFile::map, reads are a memcpy out of the page cache, and callers can use the mapping directly
+    class MmapFileImpl : public CaretBinaryFile::ImplInterface
+    {
+        QFile m_file;
+        uchar* m_map;
+        int64_t m_size, m_pos;
+    public:
+        MmapFileImpl() { m_map = NULL; m_size = 0; m_pos = 0; }
+        void open(const QString& filename, const CaretBinaryFile::OpenMode& opmode);
+        void close();
+        void seek(const int64_t& position);
+        int64_t pos() { return m_pos; }
+        int64_t size() { return m_size; }
+        void read(void* dataOut, const int64_t& count, int64_t* numRead);
+        void write(const void* dataIn, const int64_t& count);
+        bool canReadAt() { return m_map != NULL; }
+        void readAt(const int64_t& position, void* dataOut, const int64_t& count, int64_t* numRead);
+        const char* getMappedData() { return (const char*)m_map; }
+        void setAccessHint(const CaretBinaryFile::AccessHint& hint);
+        ~MmapFileImpl();
+    };
+}
+
+namespace
+{
+    bool s_gzipIndexCaching = false;
+}
+
+void CaretBinaryFile::setGzipIndexCaching(const bool& enable)
+{
+    s_gzipIndexCaching = enable;
+}
+
+bool CaretBinaryFile::getGzipIndexCaching()
+{
+    return s_gzipIndexCaching;
 }
 
 CaretBinaryFile::ImplInterface::~ImplInterface()
 {
 }
 
+void CaretBinaryFile::ImplInterface::readAt(const int64_t&, void*, const int64_t&, int64_t*)
+{
+    CaretAssert(0);
+    throw DataFileException("positional read is not supported for file '" + m_fileName + "'");
+}
+
 CaretBinaryFile::CaretBinaryFile(const QString& filename, const OpenMode& fileMode)
 {
     open(filename, fileMode);
@@ -118,7 +175,14 @@ void CaretBinaryFile::open(const QString& filename, const OpenMode& opmode)
     if (filename.endsWith(".gz"))
     {
 #ifdef ZLIB_VERSION
-        m_impl.grabNew(new ZFileImpl());
+        if (opmode == READ && GzipIndexedReader::isGzipFile(filename))
+        {//gzread can only seek backwards by starting over, the indexed reader records checkpoints as it goes
+            m_impl.grabNew(new GzipIndexedReader());
+        } else if (opmode == WRITE_TRUNCATE) {//gzwrite uses only one core
+            m_impl.grabNew(new GzipBlockWriter());
+        } else {
+            m_impl.grabNew(new ZFileImpl());
+        }
 #else //ZLIB_VERSION
         throw DataFileException("can't open .gz file '" + filename + "', compiled without zlib support");
 #endif //ZLIB_VERSION
@@ -129,6 +193,40 @@ void CaretBinaryFile::open(const QString& filename, const OpenMode& opmode)
     m_curMode = opmode;
 }
 
+void CaretBinaryFile::openMapped(const QString& filename, const AccessHint& hint)
+{
+    close();
+    if (filename.endsWith(".gz"))
+    {
+        open(filename, READ);//compressed data can't be mapped, this is not an error
+        return;
+    }
+    CaretPointer<ImplInterface> mapped(new MmapFileImpl());
+    try
+    {
+        mapped->open(filename, READ);
+    } catch (DataFileException& e) {//empty file, out of address space, etc
+        CaretLogFine("falling back to normal reading: " + e.whatString());
+        open(filename, READ);//and if the file doesn't exist, this will throw the usual error
+        return;
+    }
+    m_impl = mapped;
+    m_curMode = READ;
+    m_impl->setAccessHint(hint);
+}
+
+const char* CaretBinaryFile::getMappedData()
+{
+    if (m_curMode == NONE) return NULL;
+    return m_impl->getMappedData();
+}
+
+void CaretBinaryFile::setAccessHint(const AccessHint& hint)
+{
+    if (m_curMode == NONE) return;
+    m_impl->setAccessHint(hint);
+}
+
 void CaretBinaryFile::read(void* dataOut, const int64_t& count, int64_t* numRead)
 {
     CaretAssert(count >= 0);//not sure about allowing 0
@@ -155,6 +253,20 @@ int64_t CaretBinaryFile::size()
     return m_impl->size();
 }
 
+bool CaretBinaryFile::canReadAt()
+{
+    if (m_curMode == NONE) return false;
+    return m_impl->canReadAt();
+}
+
+void CaretBinaryFile::readAt(const int64_t& position, void* dataOut, const int64_t& count, int64_t* numRead)
+{
+    CaretAssert(position >= 0);
+    CaretAssert(count >= 0);
+    if (!canReadAt()) throw DataFileException("file does not support positional reads");
+    m_impl->readAt(position, dataOut, count, numRead);
+}
+
 void CaretBinaryFile::write(const void* dataIn, const int64_t& count)
 {
     CaretAssert(count >= 0);//not sure about allowing 0
@@ -290,6 +402,7 @@ void QFileImpl::open(const QString& filename, const CaretBinaryFile::OpenMode& o
     if (opmode & CaretBinaryFile::WRITE) mode |= QIODevice::WriteOnly;
     if (opmode & CaretBinaryFile::TRUNCATE) mode |= QIODevice::Truncate;//expect QFile to recognize silliness like TRUNCATE by itself
     m_file.setFileName(filename);
+    m_readOnly = !(opmode & CaretBinaryFile::WRITE);
     if (!m_file.open(mode))
     {
         if (!m_file.exists())
@@ -319,6 +432,7 @@ void QFileImpl::open(const QString& filename, const CaretBinaryFile::OpenMode& o
 void QFileImpl::close()
 {
     m_file.close();
+    m_readOnly = false;
 }
 
 void QFileImpl::read(void* dataOut, const int64_t& count, int64_t* numRead)
@@ -344,6 +458,45 @@ void QFileImpl::read(void* dataOut, const int64_t& count, int64_t* numRead)
     }
 }
 
+bool QFileImpl::canReadAt()
+{
+#ifdef CARET_OS_WINDOWS
+    return false;//ReadFile with an OVERLAPPED offset still moves the file pointer on synchronous handles, so windows uses the locked seek + read path
+#else
+    return m_readOnly && m_file.isOpen() && m_file.handle() != -1;
+#endif
+}
+
+void QFileImpl::readAt(const int64_t& position, void* dataOut, const int64_t& count, int64_t* numRead)
+{
+#ifdef CARET_OS_WINDOWS
+    CaretAssert(0);
+    throw DataFileException("positional read is not supported on windows, file '" + m_fileName + "'");
+#else
+    int fd = m_file.handle();//pread doesn't use or change the file offset, so no locking is needed
+    int64_t total = 0;
+    int64_t readret = -1;
+    while (total < count)
+    {
+        int64_t maxToRead = min(count - total, CHUNK_SIZE);
+        readret = pread(fd, ((char*)dataOut) + total, maxToRead, position + total);
+        if (readret < 0 && errno == EINTR) continue;
+        if (readret < 1) break;//0 or -1 means error or eof
+        total += readret;
+    }
+    if (numRead == NULL)
+    {
+        if (total != count)
+        {
+            if (readret < 0) throw DataFileException("error while reading file '" + m_fileName + "'");
+            throw DataFileException("premature end of file in '" + m_fileName + "'");
+        }
+    } else {
+        *numRead = total;
+    }
+#endif
+}
+
 void QFileImpl::seek(const int64_t& position)
 {
     if (!m_file.seek(position)) throw DataFileException("seek failed in file '" + m_fileName + "'");
@@ -374,3 +527,98 @@ void QFileImpl::write(const void* dataIn, const int64_t& count)
                          + " bytes.");
     if (total != count) throw DataFileException(msg);
 }
+
+void MmapFileImpl::open(const QString& filename, const CaretBinaryFile::OpenMode& opmode)
+{
+    close();
+    m_fileName = filename;
+    if (opmode != CaretBinaryFile::READ) throw DataFileException("memory-mapped file only supports READ mode");
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::ReadOnly)) throw DataFileException("failed to open file '" + filename + "'");
+    m_size = m_file.size();
+    if (m_size <= 0) throw DataFileException("can't memory-map empty file '" + filename + "'");
+    m_map = m_file.map(0, m_size);
+    if (m_map == NULL) throw DataFileException("failed to memory-map file '" + filename + "'");
+    m_pos = 0;
+}
+
+void MmapFileImpl::close()
+{
+    if (m_map != NULL)
+    {
+        m_file.unmap(m_map);
+        m_map = NULL;
+    }
+    m_file.close();
+    m_size = 0;
+    m_pos = 0;
+}
+
+void MmapFileImpl::seek(const int64_t& position)
+{
+    if (position > m_size) throw DataFileException("seek failed in file '" + m_fileName + "'");
+    m_pos = position;
+}
+
+void MmapFileImpl::read(void* dataOut, const int64_t& count, int64_t* numRead)
+{
+    int64_t tempRead = 0;
+    readAt(m_pos, dataOut, count, &tempRead);
+    m_pos += tempRead;
+    if (numRead == NULL)
+    {
+        if (tempRead != count) throw DataFileException("premature end of file in '" + m_fileName + "'");
+    } else {
+        *numRead = tempRead;
+    }
+}
+
+void MmapFileImpl::readAt(const int64_t& position, void* dataOut, const int64_t& count, int64_t* numRead)
+{
+    if (m_map == NULL) throw DataFileException("read called on unopened MmapFileImpl");//shouldn't happen
+    int64_t toRead = 0;
+    if (position < m_size) toRead = min(count, m_size - position);
+    if (toRead > 0) memcpy(dataOut, m_map + position, toRead);
+    if (numRead == NULL)
+    {
+        if (toRead != count) throw DataFileException("premature end of file in '" + m_fileName + "'");
+    } else {
+        *numRead = toRead;
+    }
+}
+
+void MmapFileImpl::write(const void*, const int64_t&)
+{
+    throw DataFileException("memory-mapped file '" + m_fileName + "' is read-only");
+}
+
+void MmapFileImpl::setAccessHint(const CaretBinaryFile::AccessHint& hint)
+{
+    if (m_map == NULL) return;
+#ifndef CARET_OS_WINDOWS
+    int advice = MADV_NORMAL;
+    switch (hint)
+    {
+        case CaretBinaryFile::ACCESS_NORMAL:
+            advice = MADV_NORMAL;
+            break;
+        case CaretBinaryFile::ACCESS_SEQUENTIAL:
+            advice = MADV_SEQUENTIAL;
+            break;
+        case CaretBinaryFile::ACCESS_RANDOM:
+            advice = MADV_RANDOM;
+            break;
+    }
+    if (madvise(m_map, m_size, advice) != 0)//only a hint, so don't throw
+    {
+        CaretLogFine("madvise failed on file '" + m_fileName + "'");
+    }
+#else
+    (void)hint;
+#endif
+}
+
+MmapFileImpl::~MmapFileImpl()
+{
+    close();//doesn't throw
+}
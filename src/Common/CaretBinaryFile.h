@@ -43,10 +43,22 @@ namespace caret {
             WRITE_TRUNCATE = 6,//ditto
             READ_WRITE_TRUNCATE = 7//ditto
         };
+        enum AccessHint
+        {
+            ACCESS_NORMAL,
+            ACCESS_SEQUENTIAL,
+            ACCESS_RANDOM
+        };
         CaretBinaryFile() { }
         ///constructor that opens file
         CaretBinaryFile(const QString& filename, const OpenMode& fileMode = READ);
         void open(const QString& filename, const OpenMode& opmode = READ);
+        ///open read-only through a memory mapping, falls back to normal reading for compressed files or if the mapping fails
+        void openMapped(const QString& filename, const AccessHint& hint = ACCESS_NORMAL);
+        ///pointer to the contents of the whole file if it is memory-mapped, else NULL
+        const char* getMappedData();
+        ///tell the OS how a memory-mapped file will be accessed, does nothing otherwise
+        void setAccessHint(const AccessHint& hint);
         void close();
         QString getFilename() const;//not a reference because when no file is open, m_impl is NULL
         bool getOpenForRead();
@@ -55,7 +67,14 @@ namespace caret {
         int64_t pos();
         void read(void* dataOut, const int64_t& count, int64_t* numRead = NULL);//throw if numRead is NULL and (error or end of file reached early)
         void write(const void* dataIn, const int64_t& count);//failure to complete write is always an exception
+        ///save the seek index of gzip files read to the end in a sidecar file (<name>.gzidx), and use such files when they are newer than the data
+        static void setGzipIndexCaching(const bool& enable);
+        static bool getGzipIndexCaching();
         int64_t size();//may return -1 if size cannot be determined efficiently
+        ///whether readAt() is available, for files opened for reading only (gzip files are decompressed from the nearest recorded checkpoint), false for uncompressed files on windows
+        bool canReadAt();
+        ///read from an absolute position without using or changing the current position, may be called from multiple threads at once
+        void readAt(const int64_t& position, void* dataOut, const int64_t& count, int64_t* numRead = NULL);//same error behavior as read()
         class ImplInterface
         {
         protected:
@@ -69,6 +88,10 @@ namespace caret {
             virtual int64_t size() = 0;
             virtual void read(void* dataOut, const int64_t& count, int64_t* numRead) = 0;
             virtual void write(const void* dataIn, const int64_t& count) = 0;
+            virtual bool canReadAt() { return false; }
+            virtual void readAt(const int64_t& position, void* dataOut, const int64_t& count, int64_t* numRead);//default throws, only called when canReadAt() returns true
+            virtual const char* getMappedData() { return NULL; }
+            virtual void setAccessHint(const AccessHint&) { }
             virtual ~ImplInterface();
         };
     private:
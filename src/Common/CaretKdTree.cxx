@@ -0,0 +1,278 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretKdTree.h"
+#include "CaretOMP.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    struct AxisCompare
+    {
+        const float* m_coords;
+        int m_axis;
+        AxisCompare(const float* coords, const int axis) : m_coords(coords), m_axis(axis) { }
+        bool operator()(const int64_t& left, const int64_t& right) const
+        {
+            return m_coords[left * 3 + m_axis] < m_coords[right * 3 + m_axis];
+        }
+    };
+}
+
+CaretKdTree::CaretKdTree(const float* coordsIn, const int64_t numCoords)
+{
+    m_numPoints = max(numCoords, (int64_t)0);
+    for (int i = 0; i < 3; ++i)
+    {
+        m_min[i] = 0.0f;
+        m_max[i] = 0.0f;
+    }
+    if (m_numPoints == 0) return;
+    for (int i = 0; i < 3; ++i)
+    {
+        m_min[i] = coordsIn[i];
+        m_max[i] = coordsIn[i];
+    }
+    vector<int64_t> order(m_numPoints);
+    for (int64_t i = 0; i < m_numPoints; ++i)
+    {
+        order[i] = i;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            m_min[axis] = min(m_min[axis], coordsIn[i * 3 + axis]);
+            m_max[axis] = max(m_max[axis], coordsIn[i * 3 + axis]);
+        }
+    }
+    m_axes.resize(m_numPoints, 0);
+    buildRange(order, coordsIn, 0, m_numPoints);
+    m_coords.resize(m_numPoints * 3);
+    float* xOut = m_coords.data(), *yOut = xOut + m_numPoints, *zOut = yOut + m_numPoints;
+    for (int64_t i = 0; i < m_numPoints; ++i)
+    {
+        const float* point = coordsIn + order[i] * 3;
+        xOut[i] = point[0];
+        yOut[i] = point[1];
+        zOut[i] = point[2];
+    }
+    m_indices.swap(order);
+}
+
+void CaretKdTree::buildRange(vector<int64_t>& order, const float* coordsIn, const int64_t start, const int64_t end)
+{
+    if (end - start <= LEAF_SIZE) return;
+    float rangeMin[3], rangeMax[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        rangeMin[axis] = coordsIn[order[start] * 3 + axis];
+        rangeMax[axis] = rangeMin[axis];
+    }
+    for (int64_t i = start + 1; i < end; ++i)
+    {
+        const float* point = coordsIn + order[i] * 3;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            rangeMin[axis] = min(rangeMin[axis], point[axis]);
+            rangeMax[axis] = max(rangeMax[axis], point[axis]);
+        }
+    }
+    int splitAxis = 0;
+    for (int axis = 1; axis < 3; ++axis)
+    {
+        if (rangeMax[axis] - rangeMin[axis] > rangeMax[splitAxis] - rangeMin[splitAxis]) splitAxis = axis;
+    }
+    int64_t mid = start + (end - start) / 2;
+    nth_element(order.begin() + start, order.begin() + mid, order.begin() + end, AxisCompare(coordsIn, splitAxis));
+    m_axes[mid] = (int8_t)splitAxis;
+    buildRange(order, coordsIn, start, mid);
+    buildRange(order, coordsIn, mid + 1, end);
+}
+
+float CaretKdTree::boxDistSquared(const float target[3]) const
+{
+    float ret = 0.0f;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float diff = 0.0f;
+        if (target[axis] < m_min[axis]) diff = m_min[axis] - target[axis];
+        if (target[axis] > m_max[axis]) diff = target[axis] - m_max[axis];
+        ret += diff * diff;
+    }
+    return ret;
+}
+
+void CaretKdTree::closestInRange(const int64_t start, const int64_t end, const float target[3], float& bestDist2, int64_t& bestPos, bool& found) const
+{
+    const float* xCoords = m_coords.data(), *yCoords = xCoords + m_numPoints, *zCoords = yCoords + m_numPoints;
+    if (end - start <= LEAF_SIZE)
+    {
+        for (int64_t i = start; i < end; ++i)
+        {
+            float dx = xCoords[i] - target[0], dy = yCoords[i] - target[1], dz = zCoords[i] - target[2];
+            float dist2 = dx * dx + dy * dy + dz * dz;
+            if (dist2 < bestDist2 || (!found && dist2 <= bestDist2))//allow a point exactly at the limit when nothing has been found yet
+            {
+                bestDist2 = dist2;
+                bestPos = i;
+                found = true;
+            }
+        }
+        return;
+    }
+    int64_t mid = start + (end - start) / 2;
+    int axis = m_axes[mid];
+    float diff = target[axis] - m_coords[axis * m_numPoints + mid];
+    {
+        float dx = xCoords[mid] - target[0], dy = yCoords[mid] - target[1], dz = zCoords[mid] - target[2];
+        float dist2 = dx * dx + dy * dy + dz * dz;
+        if (dist2 < bestDist2 || (!found && dist2 <= bestDist2))
+        {
+            bestDist2 = dist2;
+            bestPos = mid;
+            found = true;
+        }
+    }
+    if (diff <= 0.0f)
+    {
+        closestInRange(start, mid, target, bestDist2, bestPos, found);
+        if (diff * diff <= bestDist2) closestInRange(mid + 1, end, target, bestDist2, bestPos, found);
+    } else {
+        closestInRange(mid + 1, end, target, bestDist2, bestPos, found);
+        if (diff * diff <= bestDist2) closestInRange(start, mid, target, bestDist2, bestPos, found);
+    }
+}
+
+int64_t CaretKdTree::closestPoint(const float target[3]) const
+{
+    if (m_numPoints == 0) return -1;
+    float bestDist2 = numeric_limits<float>::infinity();
+    int64_t bestPos = -1;
+    bool found = false;
+    closestInRange(0, m_numPoints, target, bestDist2, bestPos, found);
+    if (!found) return -1;//only if the target has NaNs
+    return m_indices[bestPos];
+}
+
+int64_t CaretKdTree::closestPointLimited(const float target[3], const float& maxDist) const
+{
+    if (m_numPoints == 0) return -1;
+    float bestDist2 = maxDist * maxDist;
+    if (boxDistSquared(target) > bestDist2) return -1;
+    int64_t bestPos = -1;
+    bool found = false;
+    closestInRange(0, m_numPoints, target, bestDist2, bestPos, found);
+    if (!found) return -1;
+    return m_indices[bestPos];
+}
+
+void CaretKdTree::closestPoints(const float* targets, const int64_t numTargets, int64_t* indicesOut, const float& maxDist) const
+{
+    const bool limited = (maxDist > 0.0f);
+#pragma omp CARET_PARFOR schedule(dynamic, 256)
+    for (int64_t i = 0; i < numTargets; ++i)
+    {
+        if (limited)
+        {
+            indicesOut[i] = closestPointLimited(targets + i * 3, maxDist);
+        } else {
+            indicesOut[i] = closestPoint(targets + i * 3);
+        }
+    }
+}
+
+void CaretKdTree::collectInRange(const int64_t start, const int64_t end, const float target[3], const float& maxDist2, vector<int64_t>& indicesOut, vector<float>* dist2Out) const
+{
+    const float* xCoords = m_coords.data(), *yCoords = xCoords + m_numPoints, *zCoords = yCoords + m_numPoints;
+    if (end - start <= LEAF_SIZE)
+    {
+        for (int64_t i = start; i < end; ++i)
+        {
+            float dx = xCoords[i] - target[0], dy = yCoords[i] - target[1], dz = zCoords[i] - target[2];
+            float dist2 = dx * dx + dy * dy + dz * dz;
+            if (dist2 <= maxDist2)
+            {
+                indicesOut.push_back(m_indices[i]);
+                if (dist2Out != NULL) dist2Out->push_back(dist2);
+            }
+        }
+        return;
+    }
+    int64_t mid = start + (end - start) / 2;
+    int axis = m_axes[mid];
+    float diff = target[axis] - m_coords[axis * m_numPoints + mid];
+    float dx = xCoords[mid] - target[0], dy = yCoords[mid] - target[1], dz = zCoords[mid] - target[2];
+    float dist2 = dx * dx + dy * dy + dz * dz;
+    if (dist2 <= maxDist2)
+    {
+        indicesOut.push_back(m_indices[mid]);
+        if (dist2Out != NULL) dist2Out->push_back(dist2);
+    }
+    if (diff <= 0.0f || diff * diff <= maxDist2) collectInRange(start, mid, target, maxDist2, indicesOut, dist2Out);
+    if (diff >= 0.0f || diff * diff <= maxDist2) collectInRange(mid + 1, end, target, maxDist2, indicesOut, dist2Out);
+}
+
+void CaretKdTree::pointsInRange(const float target[3], const float& maxDist, vector<int64_t>& indicesOut, vector<float>* dist2Out) const
+{
+    indicesOut.clear();
+    if (dist2Out != NULL) dist2Out->clear();
+    if (m_numPoints == 0) return;
+    float maxDist2 = maxDist * maxDist;
+    if (boxDistSquared(target) > maxDist2) return;
+    collectInRange(0, m_numPoints, target, maxDist2, indicesOut, dist2Out);
+}
+
+bool CaretKdTree::anyInRange(const int64_t start, const int64_t end, const float target[3], const float& maxDist2) const
+{
+    const float* xCoords = m_coords.data(), *yCoords = xCoords + m_numPoints, *zCoords = yCoords + m_numPoints;
+    if (end - start <= LEAF_SIZE)
+    {
+        for (int64_t i = start; i < end; ++i)
+        {
+            float dx = xCoords[i] - target[0], dy = yCoords[i] - target[1], dz = zCoords[i] - target[2];
+            if (dx * dx + dy * dy + dz * dz < maxDist2) return true;
+        }
+        return false;
+    }
+    int64_t mid = start + (end - start) / 2;
+    int axis = m_axes[mid];
+    float diff = target[axis] - m_coords[axis * m_numPoints + mid];
+    float dx = xCoords[mid] - target[0], dy = yCoords[mid] - target[1], dz = zCoords[mid] - target[2];
+    if (dx * dx + dy * dy + dz * dz < maxDist2) return true;
+    if (diff <= 0.0f)//near side first, it is more likely to have a close enough point
+    {
+        if (anyInRange(start, mid, target, maxDist2)) return true;
+        return (diff * diff < maxDist2) && anyInRange(mid + 1, end, target, maxDist2);
+    } else {
+        if (anyInRange(mid + 1, end, target, maxDist2)) return true;
+        return (diff * diff < maxDist2) && anyInRange(start, mid, target, maxDist2);
+    }
+}
+
+bool CaretKdTree::anyInRange(const float target[3], const float& maxDist) const
+{
+    if (m_numPoints == 0) return false;
+    float maxDist2 = maxDist * maxDist;
+    if (boxDistSquared(target) >= maxDist2) return false;
+    return anyInRange(0, m_numPoints, target, maxDist2);
+}
@@ -0,0 +1,63 @@
+#ifndef __CARET_KD_TREE_H__
+#define __CARET_KD_TREE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace caret {
+    
+    ///static k-d tree over a point set, stored implicitly in a few flat arrays: the point at the middle of any range is the split point for that range
+    ///all queries are const and thread-safe, so use one tree from many threads instead of building more
+    class CaretKdTree
+    {
+        std::vector<float> m_coords;//x, then y, then z for all points, in tree order
+        std::vector<int64_t> m_indices;//original index of the point at each tree position
+        std::vector<int8_t> m_axes;//split axis of the range centered at each position, unused for positions inside leaves
+        int64_t m_numPoints;
+        float m_min[3], m_max[3];
+        static const int64_t LEAF_SIZE = 16;
+        void buildRange(std::vector<int64_t>& order, const float* coordsIn, const int64_t start, const int64_t end);
+        void closestInRange(const int64_t start, const int64_t end, const float target[3], float& bestDist2, int64_t& bestPos, bool& found) const;
+        void collectInRange(const int64_t start, const int64_t end, const float target[3], const float& maxDist2, std::vector<int64_t>& indicesOut, std::vector<float>* dist2Out) const;
+        bool anyInRange(const int64_t start, const int64_t end, const float target[3], const float& maxDist2) const;
+        float boxDistSquared(const float target[3]) const;
+        CaretKdTree();
+    public:
+        ///make a tree from xyz triples, indices returned are the triple number
+        CaretKdTree(const float* coordsIn, const int64_t numCoords);
+        int64_t getNumberOfPoints() const { return m_numPoints; }
+        ///index of the closest point, -1 if there are no points
+        int64_t closestPoint(const float target[3]) const;
+        ///index of the closest point within maxDist, -1 if there is none
+        int64_t closestPointLimited(const float target[3], const float& maxDist) const;
+        ///closest point to each of many targets, in parallel - maxDist <= 0 means unlimited
+        void closestPoints(const float* targets, const int64_t numTargets, int64_t* indicesOut, const float& maxDist = -1.0f) const;
+        ///indices of all points within maxDist, in no particular order - optionally also their squared distances, in the same order
+        void pointsInRange(const float target[3], const float& maxDist, std::vector<int64_t>& indicesOut, std::vector<float>* dist2Out = NULL) const;
+        ///whether any point is closer than maxDist
+        bool anyInRange(const float target[3], const float& maxDist) const;
+    };
+}
+
+#endif //__CARET_KD_TREE_H__
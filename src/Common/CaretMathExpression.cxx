@@ -23,11 +23,61 @@
 #include "CaretLogger.h"
 #include "CaretMathExpression.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 using namespace caret;
 using namespace std;
 
+const int CaretMathExpression::BLOCK_SIZE = 256;//doubles per register, small enough that a few dozen registers stay in cache
+
+namespace
+{//functions shared by tree evaluation and compiled evaluation, so they can't disagree
+    inline double mathAsinh(const double& arg)
+    {
+        //return asinh(arg);//will work, and be preferred, when we use c++11, but doesn't work on windows with previous standard
+        if (arg > 0)
+        {
+            return log(arg + sqrt(arg * arg + 1));
+        } else {
+            return -log(-arg + sqrt(arg * arg + 1));//special case negative for stability in large negatives
+        }
+    }
+    
+    inline double mathAcosh(const double& arg)
+    {
+        return log(arg + sqrt(arg * arg - 1));
+    }
+    
+    inline double mathAtanh(const double& arg)
+    {
+        return 0.5 * log((1 + arg) / (1 - arg));
+    }
+    
+    inline double mathRound(const double& arg)
+    {//windows doesn't use c99 when compiling c++ earlier than c++11, so implement manually
+        if (arg > 0.0)
+        {
+            return floor(arg + 0.5);
+        } else {
+            return ceil(arg - 0.5);
+        }
+    }
+    
+    inline double mathMod(const double& first, const double& second)
+    {
+        if (second == 0.0) return 0.0;
+        return first - second * floor(first / second);
+    }
+    
+    inline bool mathApproxEqual(const double& left, const double& right)
+    {
+        float adjust = min(abs(left), abs(right)) / 1000000;//because == doesn't always work as expected, include a fudge factor based on the approximate precision of float
+        return (left >= right - adjust) && (left <= right + adjust);
+    }
+}
+
 CaretMathExpression::CaretMathExpression(const AString& expression)
 {
     m_input = expression;
@@ -39,6 +89,7 @@ CaretMathExpression::CaretMathExpression(const AString& expression)
         throw CaretException("extra characters on end of expression input: '" + m_input.mid(m_position) + "'");
     }
     CaretLogFiner("parsed '" + expression + "' as '" + toString() + "'");
+    compile();
 }
 
 double CaretMathExpression::evaluate(const vector<float>& variableValues) const
@@ -47,6 +98,380 @@ double CaretMathExpression::evaluate(const vector<float>& variableValues) const
     return m_root->eval(variableValues);
 }
 
+void CaretMathExpression::evaluateMany(const vector<const float*>& variableArrays, float* dataOut, const int64_t& count, const vector<int64_t>* strides) const
+{
+    int numVars = (int)m_varNames.size();
+    CaretAssert((int)variableArrays.size() == numVars);
+    CaretAssert(strides == NULL || (int)strides->size() == numVars);
+    vector<double> registers((int64_t)m_numRegisters * BLOCK_SIZE);//per call, so that threads can share the expression
+    for (int i = 0; i < (int)m_constants.size(); ++i)
+    {
+        double* reg = registers.data() + (int64_t)m_constants[i].first * BLOCK_SIZE;
+        for (int j = 0; j < BLOCK_SIZE; ++j)
+        {
+            reg[j] = m_constants[i].second;
+        }
+    }
+    const double* result = registers.data() + (int64_t)m_resultRegister * BLOCK_SIZE;
+    for (int64_t base = 0; base < count; base += BLOCK_SIZE)
+    {
+        int blockCount = (int)min((int64_t)BLOCK_SIZE, count - base);
+        for (int v = 0; v < numVars; ++v)
+        {
+            double* reg = registers.data() + (int64_t)v * BLOCK_SIZE;
+            int64_t stride = (strides == NULL ? 1 : (*strides)[v]);
+            if (stride == 1)
+            {
+                const float* source = variableArrays[v] + base;
+                for (int i = 0; i < blockCount; ++i)
+                {
+                    reg[i] = source[i];
+                }
+            } else if (stride == 0) {
+                if (base == 0)//same value every time, so only fill it once
+                {
+                    for (int i = 0; i < BLOCK_SIZE; ++i)
+                    {
+                        reg[i] = variableArrays[v][0];
+                    }
+                }
+            } else {
+                const float* source = variableArrays[v] + base * stride;
+                for (int i = 0; i < blockCount; ++i)
+                {
+                    reg[i] = source[i * stride];
+                }
+            }
+        }
+        for (int j = 0; j < (int)m_program.size(); ++j)
+        {
+            execute(m_program[j], registers.data(), blockCount);
+        }
+        for (int i = 0; i < blockCount; ++i)
+        {
+            dataOut[base + i] = (float)result[i];
+        }
+    }
+}
+
+void CaretMathExpression::compile()
+{
+    m_program.clear();
+    m_constants.clear();
+    m_numRegisters = (int)m_varNames.size();
+    map<uint64_t, int> constRegisters;
+    map<vector<int>, int> cseRegisters;
+    m_resultRegister = compileNode(m_root, constRegisters, cseRegisters);
+    CaretLogFiner("compiled expression to " + AString::number(m_program.size()) + " instructions, " + AString::number(m_constants.size()) + " constants");
+}
+
+bool CaretMathExpression::isConstantTree(const MathNode* node)
+{
+    if (node->m_type == MathNode::VAR) return false;
+    for (int i = 0; i < (int)node->m_arguments.size(); ++i)
+    {
+        if (!isConstantTree(node->m_arguments[i])) return false;
+    }
+    return true;
+}
+
+int CaretMathExpression::compileNode(const MathNode* node, map<uint64_t, int>& constRegisters, map<vector<int>, int>& cseRegisters)
+{
+    if (node->m_type == MathNode::VAR)
+    {
+        return node->m_varIndex;
+    }
+    if (isConstantTree(node))//constant folding, done by the tree evaluator so the folded value is exactly what evaluate() gives
+    {
+        double value = node->eval(vector<float>());
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(double));//NaN doesn't compare equal to itself, so key on the bit pattern
+        map<uint64_t, int>::iterator iter = constRegisters.find(bits);
+        if (iter != constRegisters.end()) return iter->second;
+        int reg = m_numRegisters;
+        ++m_numRegisters;
+        m_constants.push_back(make_pair(reg, value));
+        constRegisters[bits] = reg;
+        return reg;
+    }
+    vector<int> args(node->m_arguments.size());
+    for (int i = 0; i < (int)node->m_arguments.size(); ++i)
+    {
+        args[i] = compileNode(node->m_arguments[i], constRegisters, cseRegisters);
+    }
+    int ret = -1;
+    switch (node->m_type)
+    {
+        case MathNode::OR:
+        case MathNode::AND:
+        {
+            CaretAssert(args.size() > 1);
+            Instruction::OpCode op = (node->m_type == MathNode::OR ? Instruction::OR : Instruction::AND);
+            ret = args[0];
+            for (int i = 1; i < (int)args.size(); ++i)
+            {
+                ret = addInstruction(op, MathFunctionEnum::INVALID, ret, args[i], -1, cseRegisters);
+            }
+            break;
+        }
+        case MathNode::EQUAL:
+            CaretAssert(args.size() > 1);
+            CaretAssert(node->m_invert.size() == args.size());
+            ret = args[0];
+            for (int i = 1; i < (int)args.size(); ++i)
+            {
+                ret = addInstruction(node->m_invert[i] ? Instruction::NOTEQUAL : Instruction::EQUAL, MathFunctionEnum::INVALID, ret, args[i], -1, cseRegisters);
+            }
+            break;
+        case MathNode::GREATERLESS:
+            CaretAssert(args.size() > 1);
+            CaretAssert(node->m_invert.size() == args.size());
+            CaretAssert(node->m_inclusive.size() == args.size());
+            ret = args[0];
+            for (int i = 1; i < (int)args.size(); ++i)
+            {
+                Instruction::OpCode op;
+                if (node->m_inclusive[i])
+                {
+                    op = (node->m_invert[i] ? Instruction::LESSEQUAL : Instruction::GREATEREQUAL);
+                } else {
+                    op = (node->m_invert[i] ? Instruction::LESS : Instruction::GREATER);
+                }
+                ret = addInstruction(op, MathFunctionEnum::INVALID, ret, args[i], -1, cseRegisters);
+            }
+            break;
+        case MathNode::ADDSUB:
+            CaretAssert(args.size() > 1);
+            CaretAssert(node->m_invert.size() == args.size());
+            ret = args[0];
+            for (int i = 1; i < (int)args.size(); ++i)
+            {
+                ret = addInstruction(node->m_invert[i] ? Instruction::SUB : Instruction::ADD, MathFunctionEnum::INVALID, ret, args[i], -1, cseRegisters);
+            }
+            break;
+        case MathNode::MULTDIV:
+            CaretAssert(args.size() > 1);
+            CaretAssert(node->m_invert.size() == args.size());
+            ret = args[0];
+            for (int i = 1; i < (int)args.size(); ++i)
+            {
+                ret = addInstruction(node->m_invert[i] ? Instruction::DIV : Instruction::MULT, MathFunctionEnum::INVALID, ret, args[i], -1, cseRegisters);
+            }
+            break;
+        case MathNode::NOT:
+            CaretAssert(args.size() == 1);
+            ret = addInstruction(Instruction::NOT, MathFunctionEnum::INVALID, args[0], -1, -1, cseRegisters);
+            break;
+        case MathNode::NEGATE:
+            CaretAssert(args.size() == 1);
+            ret = addInstruction(Instruction::NEGATE, MathFunctionEnum::INVALID, args[0], -1, -1, cseRegisters);
+            break;
+        case MathNode::POW:
+            CaretAssert(args.size() == 2);
+            ret = addInstruction(Instruction::POW, MathFunctionEnum::INVALID, args[0], args[1], -1, cseRegisters);
+            break;
+        case MathNode::FUNC:
+            CaretAssert(args.size() > 0 && args.size() <= 3);
+            args.resize(3, -1);
+            ret = addInstruction(Instruction::FUNC, node->m_function, args[0], args[1], args[2], cseRegisters);
+            break;
+        case MathNode::VAR:
+        case MathNode::CONST://handled above
+        case MathNode::INVALID:
+            CaretAssertMessage(0, "parsing left INVALID MathNode");
+            throw CaretException("parsing problem in CaretMathExpression");
+    }
+    return ret;
+}
+
+int CaretMathExpression::addInstruction(const Instruction::OpCode& op, const MathFunctionEnum::Enum& function, const int& arg1, const int& arg2, const int& arg3,
+                                        map<vector<int>, int>& cseRegisters)
+{
+    Instruction instr;
+    instr.m_op = op;
+    instr.m_function = function;
+    instr.m_args[0] = arg1;
+    instr.m_args[1] = arg2;
+    instr.m_args[2] = arg3;
+    switch (op)//exactly commutative operations, so that "a + b" and "b + a" share a register
+    {
+        case Instruction::ADD:
+        case Instruction::MULT:
+        case Instruction::AND:
+        case Instruction::OR:
+            if (instr.m_args[0] > instr.m_args[1]) swap(instr.m_args[0], instr.m_args[1]);
+            break;
+        default:
+            break;
+    }
+    vector<int> key(5);//common subexpression elimination: registers are never overwritten, so identical instructions give identical results
+    key[0] = op;
+    key[1] = function;
+    key[2] = instr.m_args[0];
+    key[3] = instr.m_args[1];
+    key[4] = instr.m_args[2];
+    map<vector<int>, int>::iterator iter = cseRegisters.find(key);
+    if (iter != cseRegisters.end()) return iter->second;
+    instr.m_out = m_numRegisters;
+    ++m_numRegisters;
+    m_program.push_back(instr);
+    cseRegisters[key] = instr.m_out;
+    return instr.m_out;
+}
+
+void CaretMathExpression::execute(const Instruction& instr, double* registers, const int& count)
+{//simple loops over one block, so the compiler can vectorize the arithmetic and comparisons
+    double* out = registers + (int64_t)instr.m_out * BLOCK_SIZE;
+    const double* a = registers + (int64_t)instr.m_args[0] * BLOCK_SIZE;
+    const double* b = (instr.m_args[1] < 0 ? NULL : registers + (int64_t)instr.m_args[1] * BLOCK_SIZE);
+    const double* c = (instr.m_args[2] < 0 ? NULL : registers + (int64_t)instr.m_args[2] * BLOCK_SIZE);
+    switch (instr.m_op)
+    {
+        case Instruction::ADD:
+            for (int i = 0; i < count; ++i) out[i] = a[i] + b[i];
+            break;
+        case Instruction::SUB:
+            for (int i = 0; i < count; ++i) out[i] = a[i] - b[i];
+            break;
+        case Instruction::MULT:
+            for (int i = 0; i < count; ++i) out[i] = a[i] * b[i];
+            break;
+        case Instruction::DIV:
+            for (int i = 0; i < count; ++i) out[i] = a[i] / b[i];
+            break;
+        case Instruction::POW:
+            for (int i = 0; i < count; ++i) out[i] = pow(a[i], b[i]);
+            break;
+        case Instruction::NEGATE:
+            for (int i = 0; i < count; ++i) out[i] = -a[i];
+            break;
+        case Instruction::NOT:
+            for (int i = 0; i < count; ++i) out[i] = (a[i] > 0.0 ? 0.0 : 1.0);
+            break;
+        case Instruction::AND:
+            for (int i = 0; i < count; ++i) out[i] = ((a[i] > 0.0 && b[i] > 0.0) ? 1.0 : 0.0);
+            break;
+        case Instruction::OR:
+            for (int i = 0; i < count; ++i) out[i] = ((a[i] > 0.0 || b[i] > 0.0) ? 1.0 : 0.0);
+            break;
+        case Instruction::EQUAL:
+            for (int i = 0; i < count; ++i) out[i] = (mathApproxEqual(a[i], b[i]) ? 1.0 : 0.0);
+            break;
+        case Instruction::NOTEQUAL:
+            for (int i = 0; i < count; ++i) out[i] = (mathApproxEqual(a[i], b[i]) ? 0.0 : 1.0);
+            break;
+        case Instruction::GREATER:
+            for (int i = 0; i < count; ++i) out[i] = (a[i] > b[i] ? 1.0 : 0.0);
+            break;
+        case Instruction::LESS:
+            for (int i = 0; i < count; ++i) out[i] = (a[i] < b[i] ? 1.0 : 0.0);
+            break;
+        case Instruction::GREATEREQUAL:
+            for (int i = 0; i < count; ++i)
+            {
+                float adjust = min(abs(a[i]), abs(b[i])) / 1000000;//same fudge factor as mathApproxEqual
+                out[i] = (a[i] >= b[i] - adjust ? 1.0 : 0.0);
+            }
+            break;
+        case Instruction::LESSEQUAL:
+            for (int i = 0; i < count; ++i)
+            {
+                float adjust = min(abs(a[i]), abs(b[i])) / 1000000;
+                out[i] = (a[i] <= b[i] + adjust ? 1.0 : 0.0);
+            }
+            break;
+        case Instruction::FUNC:
+            switch (instr.m_function)
+            {
+                case MathFunctionEnum::SIN:
+                    for (int i = 0; i < count; ++i) out[i] = sin(a[i]);
+                    break;
+                case MathFunctionEnum::COS:
+                    for (int i = 0; i < count; ++i) out[i] = cos(a[i]);
+                    break;
+                case MathFunctionEnum::TAN:
+                    for (int i = 0; i < count; ++i) out[i] = tan(a[i]);
+                    break;
+                case MathFunctionEnum::ASIN:
+                    for (int i = 0; i < count; ++i) out[i] = asin(a[i]);
+                    break;
+                case MathFunctionEnum::ACOS:
+                    for (int i = 0; i < count; ++i) out[i] = acos(a[i]);
+                    break;
+                case MathFunctionEnum::ATAN:
+                    for (int i = 0; i < count; ++i) out[i] = atan(a[i]);
+                    break;
+                case MathFunctionEnum::SINH:
+                    for (int i = 0; i < count; ++i) out[i] = sinh(a[i]);
+                    break;
+                case MathFunctionEnum::COSH:
+                    for (int i = 0; i < count; ++i) out[i] = cosh(a[i]);
+                    break;
+                case MathFunctionEnum::TANH:
+                    for (int i = 0; i < count; ++i) out[i] = tanh(a[i]);
+                    break;
+                case MathFunctionEnum::ASINH:
+                    for (int i = 0; i < count; ++i) out[i] = mathAsinh(a[i]);
+                    break;
+                case MathFunctionEnum::ACOSH:
+                    for (int i = 0; i < count; ++i) out[i] = mathAcosh(a[i]);
+                    break;
+                case MathFunctionEnum::ATANH:
+                    for (int i = 0; i < count; ++i) out[i] = mathAtanh(a[i]);
+                    break;
+                case MathFunctionEnum::LN:
+                    for (int i = 0; i < count; ++i) out[i] = log(a[i]);
+                    break;
+                case MathFunctionEnum::EXP:
+                    for (int i = 0; i < count; ++i) out[i] = exp(a[i]);
+                    break;
+                case MathFunctionEnum::LOG:
+                    for (int i = 0; i < count; ++i) out[i] = log10(a[i]);
+                    break;
+                case MathFunctionEnum::SQRT:
+                    for (int i = 0; i < count; ++i) out[i] = sqrt(a[i]);
+                    break;
+                case MathFunctionEnum::ABS:
+                    for (int i = 0; i < count; ++i) out[i] = abs(a[i]);
+                    break;
+                case MathFunctionEnum::FLOOR:
+                    for (int i = 0; i < count; ++i) out[i] = floor(a[i]);
+                    break;
+                case MathFunctionEnum::ROUND:
+                    for (int i = 0; i < count; ++i) out[i] = mathRound(a[i]);
+                    break;
+                case MathFunctionEnum::CEIL:
+                    for (int i = 0; i < count; ++i) out[i] = ceil(a[i]);
+                    break;
+                case MathFunctionEnum::ATAN2:
+                    for (int i = 0; i < count; ++i) out[i] = atan2(a[i], b[i]);
+                    break;
+                case MathFunctionEnum::MIN:
+                    for (int i = 0; i < count; ++i) out[i] = (a[i] > b[i] ? b[i] : a[i]);
+                    break;
+                case MathFunctionEnum::MAX:
+                    for (int i = 0; i < count; ++i) out[i] = (a[i] < b[i] ? b[i] : a[i]);
+                    break;
+                case MathFunctionEnum::MOD:
+                    for (int i = 0; i < count; ++i) out[i] = mathMod(a[i], b[i]);
+                    break;
+                case MathFunctionEnum::CLAMP:
+                    for (int i = 0; i < count; ++i)
+                    {
+                        double temp = a[i];
+                        if (temp < b[i]) temp = b[i];
+                        if (temp > c[i]) temp = c[i];
+                        out[i] = temp;
+                    }
+                    break;
+                case MathFunctionEnum::INVALID:
+                    CaretAssertMessage(0, "compiled FUNC instruction with INVALID function");
+                    break;
+            }
+            break;
+    }
+}
+
 vector<AString> CaretMathExpression::getVarNames() const
 {
     vector<AString> ret(m_varNames.size());
@@ -124,9 +549,7 @@ double CaretMathExpression::MathNode::eval(const vector<float>& values) const
             ret = m_arguments[0]->eval(values);
             for (int i = 1; i < end; ++i)
             {
-                double temp = m_arguments[i]->eval(values);
-                float adjust = min(abs(ret), abs(temp)) / 1000000;//because == doesn't always work as expected, include a fudge factor based on the approximate precision of float
-                bool equal = (ret >= m_arguments[i]->eval(values) - adjust) && (ret <= m_arguments[i]->eval(values) + adjust);
+                bool equal = mathApproxEqual(ret, m_arguments[i]->eval(values));
                 if (m_invert[i])
                 {
                     ret = equal ? 0.0 : 1.0;
@@ -148,7 +571,7 @@ double CaretMathExpression::MathNode::eval(const vector<float>& values) const
                 double temp = m_arguments[i]->eval(values);
                 if (m_inclusive[i])
                 {
-                    float adjust = min(abs(ret), abs(temp)) / 1000000;//because == doesn't always work as expected, include a fudge factor based on the approximate precision of float
+                    float adjust = min(abs(ret), abs(temp)) / 1000000;//same fudge factor as mathApproxEqual
                     if (m_invert[i])
                     {
                         ret = (ret <= temp + adjust ? 1.0 : 0.0);//don't trust booleans to cast to 0 and 1, just because
@@ -255,34 +678,17 @@ double CaretMathExpression::MathNode::eval(const vector<float>& values) const
                     ret = tanh(m_arguments[0]->eval(values));
                     break;
                 case MathFunctionEnum::ASINH:
-                {
                     CaretAssert(m_arguments.size() == 1);
-                    //ret = asinh(m_arguments[0].eval(values));//will work, and be preferred, when we use c++11, but doesn't work on windows with previous standard
-                    double arg = m_arguments[0]->eval(values);
-                    if (arg > 0)
-                    {
-                        ret = log(arg + sqrt(arg * arg + 1));
-                    } else {
-                        ret = -log(-arg + sqrt(arg * arg + 1));//special case negative for stability in large negatives
-                    }
+                    ret = mathAsinh(m_arguments[0]->eval(values));
                     break;
-                }
                 case MathFunctionEnum::ACOSH:
-                {
                     CaretAssert(m_arguments.size() == 1);
-                    //ret = acosh(m_arguments[0].eval(values));
-                    double arg = m_arguments[0]->eval(values);
-                    ret = log(arg + sqrt(arg * arg - 1));
+                    ret = mathAcosh(m_arguments[0]->eval(values));
                     break;
-                }
                 case MathFunctionEnum::ATANH:
-                {
                     CaretAssert(m_arguments.size() == 1);
-                    //ret = atanh(m_arguments[0].eval(values));
-                    double arg = m_arguments[0]->eval(values);
-                    ret = 0.5 * log((1 + arg) / (1 - arg));
+                    ret = mathAtanh(m_arguments[0]->eval(values));
                     break;
-                }
                 case MathFunctionEnum::LN:
                     CaretAssert(m_arguments.size() == 1);
                     ret = log(m_arguments[0]->eval(values));
@@ -308,17 +714,9 @@ double CaretMathExpression::MathNode::eval(const vector<float>& values) const
                     ret = floor(m_arguments[0]->eval(values));
                     break;
                 case MathFunctionEnum::ROUND:
-                {
                     CaretAssert(m_arguments.size() == 1);
-                    double temp = m_arguments[0]->eval(values);//windows doesn't use c99 when compiling c++ earlier than c++11, so implement manually
-                    if (temp > 0.0)
-                    {
-                        ret = floor(temp + 0.5);
-                    } else {
-                        ret = ceil(temp - 0.5);
-                    }
+                    ret = mathRound(m_arguments[0]->eval(values));
                     break;
-                }
                 case MathFunctionEnum::CEIL:
                     CaretAssert(m_arguments.size() == 1);
                     ret = ceil(m_arguments[0]->eval(values));
@@ -344,18 +742,9 @@ double CaretMathExpression::MathNode::eval(const vector<float>& values) const
                     break;
                 }
                 case MathFunctionEnum::MOD:
-                {
                     CaretAssert(m_arguments.size() == 2);
-                    double second = m_arguments[1]->eval(values);
-                    if (second == 0.0)
-                    {
-                        ret = 0.0;
-                    } else {
-                        double first = m_arguments[0]->eval(values);
-                        ret = first - second * floor(first / second);
-                    }
+                    ret = mathMod(m_arguments[0]->eval(values), m_arguments[1]->eval(values));
                     break;
-                }
                 case MathFunctionEnum::CLAMP:
                 {
                     CaretAssert(m_arguments.size() == 3);
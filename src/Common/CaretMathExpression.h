@@ -63,6 +63,45 @@ class CaretMathExpression
         double eval(const std::vector<float>& values) const;
         AString toString(const std::vector<AString>& varNames) const;
     };
+    //flat register program compiled from the tree, evaluated a block of elements at a time
+    //registers: variables first, then constants, then one register per instruction
+    struct Instruction
+    {
+        enum OpCode
+        {
+            ADD,
+            SUB,
+            MULT,
+            DIV,
+            POW,
+            NEGATE,
+            NOT,
+            AND,
+            OR,
+            EQUAL,
+            NOTEQUAL,
+            GREATER,
+            LESS,
+            GREATEREQUAL,
+            LESSEQUAL,
+            FUNC
+        };
+        OpCode m_op;
+        MathFunctionEnum::Enum m_function;
+        int m_args[3];
+        int m_out;
+    };
+    static const int BLOCK_SIZE;
+    std::vector<Instruction> m_program;
+    std::vector<std::pair<int, double> > m_constants;//register, value
+    int m_numRegisters, m_resultRegister;
+    void compile();
+    int compileNode(const MathNode* node, std::map<uint64_t, int>& constRegisters, std::map<std::vector<int>, int>& cseRegisters);
+    int addInstruction(const Instruction::OpCode& op, const MathFunctionEnum::Enum& function, const int& arg1, const int& arg2, const int& arg3,
+                       std::map<std::vector<int>, int>& cseRegisters);
+    static void execute(const Instruction& instr, double* registers, const int& count);
+    static bool isConstantTree(const MathNode* node);
+    
     std::map<AString, int> m_varNames;
     AString m_input;
     int m_position, m_end;
@@ -86,6 +125,9 @@ public:
     static bool getNamedConstant(const AString& name, double& valueOut);
     CaretMathExpression(const AString& expression);
     double evaluate(const std::vector<float>& variableValues) const;
+    ///evaluate count elements using the compiled program, variableArrays in the order of getVarNames(), thread-safe
+    ///strides defaults to all 1s, use a stride of 0 to use a single value for every element
+    void evaluateMany(const std::vector<const float*>& variableArrays, float* dataOut, const int64_t& count, const std::vector<int64_t>* strides = NULL) const;
     std::vector<AString> getVarNames() const;
     AString toString() const;//the expression, with a lot of parentheses added
 };
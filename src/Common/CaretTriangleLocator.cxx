@@ -0,0 +1,258 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretTriangleLocator.h"
+#include "CaretAssert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    struct CenterCompare
+    {
+        const float* m_centers;
+        int m_axis;
+        CenterCompare(const float* centers, const int axis) : m_centers(centers), m_axis(axis) { }
+        bool operator()(const int32_t& left, const int32_t& right) const
+        {
+            return m_centers[left * 3 + m_axis] < m_centers[right * 3 + m_axis];
+        }
+    };
+}
+
+CaretTriangleLocator::CaretTriangleLocator(const float* coordsIn, const int64_t numCoords, const int32_t* trianglesIn, const int64_t numTriangles)
+{
+    CaretAssert(numTriangles < numeric_limits<int32_t>::max());
+    m_coords.assign(coordsIn, coordsIn + numCoords * 3);
+    m_triangles.assign(trianglesIn, trianglesIn + numTriangles * 3);
+    if (numTriangles == 0) return;
+    vector<float> centers(numTriangles * 3);
+    m_triangleOrder.resize(numTriangles);
+    for (int64_t i = 0; i < numTriangles; ++i)
+    {
+        m_triangleOrder[i] = (int32_t)i;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float sum = 0.0f;
+            for (int v = 0; v < 3; ++v)
+            {
+                CaretAssert(m_triangles[i * 3 + v] >= 0 && m_triangles[i * 3 + v] < numCoords);
+                sum += m_coords[m_triangles[i * 3 + v] * 3 + axis];
+            }
+            centers[i * 3 + axis] = sum / 3.0f;
+        }
+    }
+    m_nodes.reserve(2 * (numTriangles / NUM_TRIANGLES_LEAF + 1));
+    buildNode(centers, 0, (int32_t)numTriangles);
+}
+
+void CaretTriangleLocator::buildNode(vector<float>& centers, const int32_t start, const int32_t count)
+{
+    int32_t myIndex = (int32_t)m_nodes.size();
+    m_nodes.push_back(Node());
+    Node myNode;
+    float centerMin[3], centerMax[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        myNode.m_min[axis] = numeric_limits<float>::max();
+        myNode.m_max[axis] = -numeric_limits<float>::max();
+        centerMin[axis] = numeric_limits<float>::max();
+        centerMax[axis] = -numeric_limits<float>::max();
+    }
+    for (int32_t i = start; i < start + count; ++i)
+    {
+        const int32_t* tri = m_triangles.data() + m_triangleOrder[i] * 3;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            for (int v = 0; v < 3; ++v)
+            {
+                float coord = m_coords[tri[v] * 3 + axis];
+                myNode.m_min[axis] = min(myNode.m_min[axis], coord);
+                myNode.m_max[axis] = max(myNode.m_max[axis], coord);
+            }
+            float center = centers[m_triangleOrder[i] * 3 + axis];
+            centerMin[axis] = min(centerMin[axis], center);
+            centerMax[axis] = max(centerMax[axis], center);
+        }
+    }
+    int splitAxis = 0;
+    for (int axis = 1; axis < 3; ++axis)
+    {
+        if (centerMax[axis] - centerMin[axis] > centerMax[splitAxis] - centerMin[splitAxis]) splitAxis = axis;
+    }
+    if (count <= NUM_TRIANGLES_LEAF || centerMax[splitAxis] <= centerMin[splitAxis])//also stop if all centers are the same, splitting wouldn't help
+    {
+        myNode.m_start = start;
+        myNode.m_count = count;
+        m_nodes[myIndex] = myNode;
+        return;
+    }
+    int32_t half = count / 2;//median split keeps the depth logarithmic
+    int32_t* orderStart = m_triangleOrder.data() + start;
+    nth_element(orderStart, orderStart + half, orderStart + count, CenterCompare(centers.data(), splitAxis));
+    buildNode(centers, start, half);
+    myNode.m_start = (int32_t)m_nodes.size();
+    myNode.m_count = 0;
+    buildNode(centers, start + half, count - half);
+    m_nodes[myIndex] = myNode;//m_nodes may have reallocated during recursion
+}
+
+bool CaretTriangleLocator::intersectTriangle(const int32_t triangle, const float start[3], const float direction[3], float& tOut, float& uOut, float& vOut) const
+{//Moller-Trumbore, in double to avoid missing hits on shared edges of large surfaces
+    const int32_t* tri = m_triangles.data() + triangle * 3;
+    const float* c0 = m_coords.data() + tri[0] * 3;
+    const float* c1 = m_coords.data() + tri[1] * 3;
+    const float* c2 = m_coords.data() + tri[2] * 3;
+    double edge1[3], edge2[3], pvec[3], tvec[3], qvec[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        edge1[i] = c1[i] - c0[i];
+        edge2[i] = c2[i] - c0[i];
+        tvec[i] = start[i] - c0[i];
+    }
+    pvec[0] = direction[1] * edge2[2] - direction[2] * edge2[1];
+    pvec[1] = direction[2] * edge2[0] - direction[0] * edge2[2];
+    pvec[2] = direction[0] * edge2[1] - direction[1] * edge2[0];
+    double det = edge1[0] * pvec[0] + edge1[1] * pvec[1] + edge1[2] * pvec[2];
+    if (det == 0.0) return false;//parallel to the triangle, or degenerate triangle
+    double invDet = 1.0 / det;
+    double u = (tvec[0] * pvec[0] + tvec[1] * pvec[1] + tvec[2] * pvec[2]) * invDet;
+    if (u < 0.0 || u > 1.0) return false;
+    qvec[0] = tvec[1] * edge1[2] - tvec[2] * edge1[1];
+    qvec[1] = tvec[2] * edge1[0] - tvec[0] * edge1[2];
+    qvec[2] = tvec[0] * edge1[1] - tvec[1] * edge1[0];
+    double v = (direction[0] * qvec[0] + direction[1] * qvec[1] + direction[2] * qvec[2]) * invDet;
+    if (v < 0.0 || u + v > 1.0) return false;
+    double t = (edge2[0] * qvec[0] + edge2[1] * qvec[1] + edge2[2] * qvec[2]) * invDet;
+    if (t < 0.0) return false;
+    tOut = (float)t;
+    uOut = (float)u;
+    vOut = (float)v;
+    return true;
+}
+
+bool CaretTriangleLocator::findFirstHit(const float start[3], const float direction[3], const float& maxT, TriangleRayHit& hitOut) const
+{
+    hitOut = TriangleRayHit();
+    if (m_nodes.empty()) return false;
+    float invDir[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        invDir[i] = 1.0f / direction[i];//infinity for zero components, which the slab test handles
+    }
+    float bestT = maxT, bestU = 0.0f, bestV = 0.0f;
+    int32_t bestTriangle = -1;
+    vector<int32_t> stack;
+    stack.reserve(64);
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+        const Node& thisNode = m_nodes[stack.back()];
+        int32_t thisIndex = stack.back();
+        stack.pop_back();
+        float tNear = 0.0f, tFar = bestT;
+        bool missed = false;
+        for (int i = 0; i < 3; ++i)
+        {
+            float t1 = (thisNode.m_min[i] - start[i]) * invDir[i];
+            float t2 = (thisNode.m_max[i] - start[i]) * invDir[i];
+            if (t1 != t1 || t2 != t2)//zero direction component with the start on the slab boundary, 0 * inf
+            {
+                if (start[i] < thisNode.m_min[i] || start[i] > thisNode.m_max[i]) missed = true;
+                continue;
+            }
+            if (t1 > t2) swap(t1, t2);
+            tNear = max(tNear, t1);
+            tFar = min(tFar, t2);
+            if (tNear > tFar) missed = true;
+        }
+        if (missed) continue;
+        if (thisNode.m_count > 0)
+        {
+            for (int32_t i = thisNode.m_start; i < thisNode.m_start + thisNode.m_count; ++i)
+            {
+                float t, u, v;
+                if (intersectTriangle(m_triangleOrder[i], start, direction, t, u, v) && t <= bestT)
+                {
+                    bestT = t;
+                    bestU = u;
+                    bestV = v;
+                    bestTriangle = m_triangleOrder[i];
+                }
+            }
+        } else {
+            stack.push_back(thisNode.m_start);
+            stack.push_back(thisIndex + 1);//no ordering by distance, the box test against bestT prunes well enough for picking
+        }
+    }
+    if (bestTriangle < 0) return false;
+    hitOut.triangle = bestTriangle;
+    hitOut.barycentric[0] = 1.0f - bestU - bestV;
+    hitOut.barycentric[1] = bestU;
+    hitOut.barycentric[2] = bestV;
+    float length2 = 0.0f;
+    for (int i = 0; i < 3; ++i)
+    {
+        hitOut.xyz[i] = start[i] + bestT * direction[i];
+        length2 += direction[i] * direction[i];
+    }
+    hitOut.distance = bestT * sqrt(length2);
+    int best = 0;
+    float bestDist2 = 0.0f;
+    for (int v = 0; v < 3; ++v)
+    {//the largest barycentric weight isn't always the closest vertex on an obtuse triangle, so compare distances
+        const float* vertCoord = m_coords.data() + m_triangles[bestTriangle * 3 + v] * 3;
+        float dist2 = 0.0f;
+        for (int i = 0; i < 3; ++i)
+        {
+            float diff = vertCoord[i] - hitOut.xyz[i];
+            dist2 += diff * diff;
+        }
+        if (v == 0 || dist2 < bestDist2)
+        {
+            best = v;
+            bestDist2 = dist2;
+        }
+    }
+    hitOut.nearestVertex = m_triangles[bestTriangle * 3 + best];
+    return true;
+}
+
+bool CaretTriangleLocator::rayIntersects(const float start[3], const float direction[3], TriangleRayHit* hitOut) const
+{
+    TriangleRayHit tempHit;
+    bool ret = findFirstHit(start, direction, numeric_limits<float>::max(), tempHit);
+    if (hitOut != NULL) *hitOut = tempHit;
+    return ret;
+}
+
+bool CaretTriangleLocator::lineSegmentIntersects(const float start[3], const float end[3], TriangleRayHit* hitOut) const
+{
+    float direction[3] = { end[0] - start[0], end[1] - start[1], end[2] - start[2] };
+    TriangleRayHit tempHit;
+    bool ret = findFirstHit(start, direction, 1.0f, tempHit);
+    if (hitOut != NULL) *hitOut = tempHit;
+    return ret;
+}
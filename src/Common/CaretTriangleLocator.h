@@ -0,0 +1,68 @@
+#ifndef __CARET_TRIANGLE_LOCATOR_H__
+#define __CARET_TRIANGLE_LOCATOR_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+namespace caret {
+    
+    struct TriangleRayHit
+    {
+        int32_t triangle;//-1 if nothing was hit
+        float distance;//euclidean distance from the start of the ray
+        float xyz[3];
+        float barycentric[3];//weights of the triangle's three vertices
+        int32_t nearestVertex;//vertex of the triangle closest to the hit
+        TriangleRayHit() { triangle = -1; distance = -1.0f; nearestVertex = -1; }
+    };
+    
+    ///bounding volume hierarchy over the triangles of a mesh, for finding what a ray or line segment hits first
+    class CaretTriangleLocator
+    {
+        struct Node
+        {
+            float m_min[3], m_max[3];
+            int32_t m_start;//first entry in m_triangleOrder if leaf, otherwise index of the second child (first child follows the node)
+            int32_t m_count;//0 for internal nodes
+        };
+        std::vector<float> m_coords;
+        std::vector<int32_t> m_triangles;
+        std::vector<int32_t> m_triangleOrder;//triangle indices, leaves reference consecutive ranges
+        std::vector<Node> m_nodes;
+        static const int32_t NUM_TRIANGLES_LEAF = 4;
+        void buildNode(std::vector<float>& centers, const int32_t start, const int32_t count);
+        bool intersectTriangle(const int32_t triangle, const float start[3], const float direction[3], float& tOut, float& uOut, float& vOut) const;
+        bool findFirstHit(const float start[3], const float direction[3], const float& maxT, TriangleRayHit& hitOut) const;
+        CaretTriangleLocator();
+    public:
+        ///copies the coordinates and triangles, triangles are vertex index triples
+        CaretTriangleLocator(const float* coordsIn, const int64_t numCoords, const int32_t* trianglesIn, const int64_t numTriangles);
+        ///first triangle hit by the ray, direction does not need to be normalized, both sides of triangles are hit
+        bool rayIntersects(const float start[3], const float direction[3], TriangleRayHit* hitOut = NULL) const;
+        ///first triangle hit between start and end
+        bool lineSegmentIntersects(const float start[3], const float end[3], TriangleRayHit* hitOut = NULL) const;
+    };
+}
+
+#endif //__CARET_TRIANGLE_LOCATOR_H__
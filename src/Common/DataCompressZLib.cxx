@@ -31,6 +31,11 @@
      PURPOSE.  See the above copyright notice for more information.
 
 =========================================================================*/
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "Base64.h"
 #include "DataCompressZLib.h"
 #include "MathFunctions.h"
 #include "zlib.h"
@@ -110,6 +115,94 @@ DataCompressZLib::uncompressData(const unsigned char* compressedData,
   return decSize;
 }
 
+//----------------------------------------------------------------------------
+uint64_t
+DataCompressZLib::uncompressBase64Data(const char* base64Text,
+                                       uint64_t base64TextLength,
+                                       unsigned char* uncompressedData,
+                                       uint64_t uncompressedSize)
+{
+  const uint64_t TEXT_BLOCK_LENGTH = 1 << 16;//characters other than whitespace per block, must be a multiple of 4 so that blocks decode independently
+  std::vector<unsigned char> compressedBlock(TEXT_BLOCK_LENGTH / 4 * 3);
+  
+  z_stream stream;
+  stream.zalloc = Z_NULL;
+  stream.zfree = Z_NULL;
+  stream.opaque = Z_NULL;
+  stream.next_in = Z_NULL;
+  stream.avail_in = 0;
+  if (inflateInit(&stream) != Z_OK)
+    {
+    return 0;
+    }
+  
+  const uint64_t maxAvailOut = std::numeric_limits<uInt>::max();
+  uint64_t textOffset = 0;
+  uint64_t outOffset = 0;
+  int status = Z_OK;
+  while ((status == Z_OK) && (textOffset < base64TextLength))
+    {
+    // end the block after TEXT_BLOCK_LENGTH characters that are not
+    // whitespace, so that it ends on a group boundary
+    uint64_t textLength = 0;
+    uint64_t numChars = 0;
+    while ((numChars < TEXT_BLOCK_LENGTH) && (textOffset + textLength < base64TextLength))
+      {
+      const char c = base64Text[textOffset + textLength];
+      if ((c != ' ') && (c != '\t') && (c != '\n') && (c != '\r'))
+        {
+        numChars++;
+        }
+      textLength++;
+      }
+    const uint64_t blockSize = Base64::decodeText(base64Text + textOffset,
+                                                  textLength,
+                                                  &compressedBlock[0],
+                                                  compressedBlock.size());
+    textOffset += textLength;
+    if (blockSize == 0)
+      {
+      if (textOffset < base64TextLength)
+        {
+        status = Z_DATA_ERROR;
+        }
+      break;
+      }
+
+    stream.next_in = &compressedBlock[0];
+    stream.avail_in = blockSize;
+    while ((status == Z_OK) && (stream.avail_in > 0))
+      {
+      if (outOffset >= uncompressedSize)
+        {
+        // output is full, only the end of the stream may remain
+        unsigned char overflow;
+        stream.next_out = &overflow;
+        stream.avail_out = 1;
+        status = inflate(&stream, Z_NO_FLUSH);
+        if (stream.avail_out == 0)
+          {
+          status = Z_BUF_ERROR;
+          }
+        continue;
+        }
+      const uint64_t availOut = std::min(maxAvailOut, uncompressedSize - outOffset);
+      stream.next_out = reinterpret_cast<Bytef*>(uncompressedData + outOffset);
+      stream.avail_out = availOut;
+      status = inflate(&stream, Z_NO_FLUSH);
+      outOffset += availOut - stream.avail_out;
+      }
+    }
+
+  inflateEnd(&stream);
+  if ((status != Z_STREAM_END)
+      || (outOffset != uncompressedSize))
+    {
+    return 0;
+    }
+  return outOffset;
+}
+
 //----------------------------------------------------------------------------
 unsigned long
 DataCompressZLib::getMaximumCompressionSpace(unsigned long size)
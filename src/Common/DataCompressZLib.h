@@ -79,6 +79,14 @@ public:
                                  uint64_t compressedSize,
                                  unsigned char* uncompressedData,
                                  uint64_t uncompressedSiz);
+  // Decode Base64 text (whitespace is skipped) in small blocks and
+  // inflate each block directly into the output, so that the compressed
+  // data is never held in memory in full.  Returns the uncompressed size,
+  // or 0 if decoding or decompression fails or the size does not match.
+    uint64_t uncompressBase64Data(const char* base64Text,
+                                  uint64_t base64TextLength,
+                                  unsigned char* uncompressedData,
+                                  uint64_t uncompressedSize);
 protected:    
     int compressionLevel;
     
@@ -20,7 +20,8 @@
 /*LICENSE_END*/
 
 #include "FastStatistics.h"
-#include "CaretPointer.h"
+#include "CaretAssert.h"
+#include "CaretOMP.h"
 
 #include <algorithm>
 #include <cmath>
@@ -63,88 +64,108 @@ void FastStatistics::reset()
     m_max = 0.0f;
 }
 
-void FastStatistics::update(const float* data, const int64_t& dataCount)
+namespace
 {
-    reset();
-    CaretArray<float> positives(dataCount), negatives(dataCount), absolutes(dataCount);
-    double sum = 0.0;//for numerical stability
-    bool first = true;//so min can be positive and max can be negative
-    for (int64_t i = 0; i < dataCount; ++i)
+    const int64_t PARALLEL_MIN_COUNT = 1 << 16;//thread startup and merging cost more than they save on small maps
+    
+    //results of the first pass over one thread's share of the data, merged afterwards
+    struct FirstPassPartial
     {
-        if (data[i] != data[i])
+        int64_t posCount, zeroCount, negCount, infCount, negInfCount, nanCount;
+        float min, max, mostPos, leastPos, leastNeg, mostNeg;
+        double sum;
+        FirstPassPartial()
         {
-            ++m_nanCount;
-            continue;//skip NaNs
+            posCount = 0; zeroCount = 0; negCount = 0; infCount = 0; negInfCount = 0; nanCount = 0;
+            min = numeric_limits<float>::max();
+            max = -numeric_limits<float>::max();
+            mostPos = 0.0f;
+            leastPos = numeric_limits<float>::max();
+            leastNeg = -numeric_limits<float>::max();
+            mostNeg = 0.0f;
+            sum = 0.0;
         }
-        if (data[i] == 0.0f)//test exactly zero (negative zero also tests equal), in case someone wants stats on something with miniscule values (percent of surface area per node?)
+        void merge(const FirstPassPartial& rhs)
         {
-            ++m_zeroCount;
-        } else {
-            if (data[i] < 0.0f)
+            posCount += rhs.posCount; zeroCount += rhs.zeroCount; negCount += rhs.negCount;
+            infCount += rhs.infCount; negInfCount += rhs.negInfCount; nanCount += rhs.nanCount;
+            if (rhs.min < min) min = rhs.min;
+            if (rhs.max > max) max = rhs.max;
+            if (rhs.mostPos > mostPos) mostPos = rhs.mostPos;
+            if (rhs.leastPos < leastPos) leastPos = rhs.leastPos;
+            if (rhs.leastNeg > leastNeg) leastNeg = rhs.leastNeg;
+            if (rhs.mostNeg < mostNeg) mostNeg = rhs.mostNeg;
+            sum += rhs.sum;
+        }
+    };
+}
+
+void FastStatistics::update(const float* data, const int64_t& dataCount)
+{
+    update(data, dataCount, -numeric_limits<float>::max(), numeric_limits<float>::max());//every finite value is in this range
+}
+
+void FastStatistics::update(const float* data, const int64_t& dataCount, const float& minThreshInclusive, const float& maxThreshInclusive)
+{//fused version: one pass for counts, extremes and sum, one pass for deviation and all three percentile histograms, no copies of the data
+    reset();
+    FirstPassPartial total;
+#pragma omp CARET_PAR if (dataCount > PARALLEL_MIN_COUNT)
+    {
+        FirstPassPartial mine;
+#pragma omp CARET_FOR
+        for (int64_t i = 0; i < dataCount; ++i)
+        {
+            const float value = data[i];
+            if (value != value)
             {
-                if (data[i] * 2.0f == data[i])
+                ++mine.nanCount;
+                continue;//skip NaNs
+            }
+            if (value != 0.0f && value * 2.0f == value)
+            {//skip and count all infs, ignoring the range
+                if (value < 0.0f)
                 {
-                    ++m_negInfCount;
-                    continue;//skip neg infs
+                    ++mine.negInfCount;
                 } else {
-                    negatives[m_negCount] = data[i];
-                    ++m_negCount;
-                    if (data[i] > m_leastNeg) m_leastNeg = data[i];
-                    if (data[i] < m_mostNeg) m_mostNeg = data[i];
-                    
-                    absolutes[m_absCount] = -data[i];
-                    if (absolutes[m_absCount] > m_mostAbs)  m_mostAbs  = absolutes[m_absCount];
-                    if (absolutes[m_absCount] < m_leastAbs) m_leastAbs = absolutes[m_absCount];
-                    ++m_absCount;
+                    ++mine.infCount;
                 }
+                continue;
+            }
+            if (value < minThreshInclusive || value > maxThreshInclusive) continue;//we now have only numerical values, skip them if they are outside the range
+            if (value == 0.0f)//test exactly zero (negative zero also tests equal), in case someone wants stats on something with miniscule values (percent of surface area per node?)
+            {
+                ++mine.zeroCount;
+            } else if (value < 0.0f) {
+                ++mine.negCount;
+                if (value > mine.leastNeg) mine.leastNeg = value;
+                if (value < mine.mostNeg) mine.mostNeg = value;
             } else {
-                if (data[i] * 2.0f == data[i])
-                {
-                    ++m_infCount;
-                    continue;//skip infs
-                } else {
-                    positives[m_posCount] = data[i];
-                    ++m_posCount;
-                    if (data[i] > m_mostPos) m_mostPos = data[i];
-                    if (data[i] < m_leastPos) m_leastPos = data[i];
-                    
-                    absolutes[m_absCount] = data[i];
-                    if (absolutes[m_absCount] > m_mostAbs)  m_mostAbs  = absolutes[m_absCount];
-                    if (absolutes[m_absCount] < m_leastAbs) m_leastAbs = absolutes[m_absCount];
-                    ++m_absCount;
-                }
+                ++mine.posCount;
+                if (value > mine.mostPos) mine.mostPos = value;
+                if (value < mine.leastPos) mine.leastPos = value;
             }
+            if (value > mine.max) mine.max = value;
+            if (value < mine.min) mine.min = value;
+            mine.sum += value;//use a two-pass method for stability, only do mean this pass
         }
-        if (data[i] > m_max || first) m_max = data[i];
-        if (data[i] < m_min || first) m_min = data[i];
-        sum += data[i];//use a two-pass method for stability, only do mean this pass
-        first = false;
-    }
-    int64_t totalGood = (m_negCount + m_zeroCount + m_posCount);
-    m_mean = sum / totalGood;
-    float tempf;
-    double sum2 = 0.0;
-    for (int64_t i = 0; i < dataCount; ++i)
-    {
-        if (data[i] != data[i]) continue;//skip NaNs
-        if (data[i] < -1.0f && (data[i] * 2.0f == data[i])) continue;//exclude -inf
-        if (data[i] > 1.0f && (data[i] * 2.0f == data[i])) continue;//exclude inf
-        tempf = data[i] - m_mean;
-        sum2 += tempf * tempf;
-    }
-    if (totalGood > 0)
-    {
-        m_stdDevPop = sqrt(sum2 / totalGood);
-        if (totalGood > 1)
+#pragma omp critical
         {
-            m_stdDevSample = sqrt(sum2 / (totalGood - 1));
+            total.merge(mine);
         }
     }
-    int usebuckets = min(NUM_BUCKETS_PERCENTILE_HIST, dataCount);
-    m_negPercentHist.update(usebuckets, negatives, m_negCount);
-    m_posPercentHist.update(usebuckets, positives, m_posCount);
-    m_absPercentHist.update(usebuckets, absolutes, m_absCount);
-    
+    m_posCount = total.posCount;
+    m_zeroCount = total.zeroCount;
+    m_negCount = total.negCount;
+    m_infCount = total.infCount;
+    m_negInfCount = total.negInfCount;
+    m_nanCount = total.nanCount;
+    m_absCount = m_posCount + m_negCount;//absolutes are the nonzero values
+    m_mostPos = total.mostPos;
+    m_leastPos = total.leastPos;
+    m_leastNeg = total.leastNeg;
+    m_mostNeg = total.mostNeg;
+    m_mostAbs = max(m_mostPos, -m_mostNeg);
+    m_leastAbs = min(m_leastPos, -m_leastNeg);
     if (m_negCount <= 0)
     {
         m_leastNeg = 0.0;
@@ -160,74 +181,64 @@ void FastStatistics::update(const float* data, const int64_t& dataCount)
         m_leastAbs = 0.0;
         m_mostAbs  = 0.0;
     }
-}
-
-void FastStatistics::update(const float* data, const int64_t& dataCount, const float& minThreshInclusive, const float& maxThreshInclusive)
-{
-    reset();
-    CaretArray<float> positives(dataCount), negatives(dataCount), absolutes(dataCount);
-    double sum = 0.0;//for numerical stability
-    bool first = true;//so min can be positive and max can be negative
-    for (int64_t i = 0; i < dataCount; ++i)
+    int64_t totalGood = (m_negCount + m_zeroCount + m_posCount);
+    if (totalGood > 0)
     {
-        if (data[i] != data[i])
-        {
-            ++m_nanCount;
-            continue;//skip NaNs
-        }
-        if (data[i] < -1.0f && (data[i] * 2.0f == data[i]))
-        {
-            ++m_negInfCount;
-            continue;//skip and count all infs, ignoring the range for now
-        }
-        if (data[i] > 1.0f && (data[i] * 2.0f == data[i]))
-        {
-            ++m_infCount;
-            continue;//ditto
-        }
-        if (data[i] < minThreshInclusive || data[i] > maxThreshInclusive)
-        {//we now have only numerical values
-            continue;//skip them if they are outside the range
-        }
-        if (data[i] == 0.0f)//test exactly zero (negative zero also tests equal), in case someone wants stats on something with miniscule values (percent of surface area per node?)
+        m_min = total.min;
+        m_max = total.max;
+    }
+    m_mean = total.sum / totalGood;
+    const float mean = m_mean;
+    const int usebuckets = (int)min(NUM_BUCKETS_PERCENTILE_HIST, dataCount);//10,000 will probably allow us to approximate the percentiles pretty closely, and eats only 80K of memory each
+    const float negMin = m_mostNeg, negMax = m_leastNeg, posMin = m_leastPos, posMax = m_mostPos, absMin = m_leastAbs, absMax = m_mostAbs;
+    if (usebuckets > 0)
+    {
+        m_negPercentHist.beginAccumulation(usebuckets, negMin, negMax);//the ranges of the histograms are exactly the extremes we just found
+        m_posPercentHist.beginAccumulation(usebuckets, posMin, posMax);
+        m_absPercentHist.beginAccumulation(usebuckets, absMin, absMax);
+    }
+    double sum2 = 0.0;
+    if (totalGood > 0)
+    {
+#pragma omp CARET_PAR if (dataCount > PARALLEL_MIN_COUNT)
         {
-            ++m_zeroCount;
-        } else {
-            if (data[i] < 0.0f)
+            Histogram myNeg(usebuckets), myPos(usebuckets), myAbs(usebuckets);
+            myNeg.beginAccumulation(usebuckets, negMin, negMax);
+            myPos.beginAccumulation(usebuckets, posMin, posMax);
+            myAbs.beginAccumulation(usebuckets, absMin, absMax);
+            double mySum2 = 0.0;
+#pragma omp CARET_FOR
+            for (int64_t i = 0; i < dataCount; ++i)
             {
-                negatives[m_negCount] = data[i];
-                ++m_negCount;
-                if (data[i] > m_leastNeg) m_leastNeg = data[i];
-                if (data[i] < m_mostNeg) m_mostNeg = data[i];
-                
-                absolutes[m_absCount] = -data[i];
-                ++m_absCount;
-            } else {
-                positives[m_posCount] = data[i];
-                ++m_posCount;
-                if (data[i] > m_mostPos) m_mostPos = data[i];
-                if (data[i] < m_leastPos) m_leastPos = data[i];
-                
-                absolutes[m_absCount] = data[i];
-                ++m_absCount;
+                const float value = data[i];
+                if (value != value) continue;//skip NaNs
+                if (value != 0.0f && value * 2.0f == value) continue;//exclude infs
+                if (value < minThreshInclusive || value > maxThreshInclusive) continue;
+                const float tempf = value - mean;
+                mySum2 += tempf * tempf;
+                if (value < 0.0f)
+                {
+                    myNeg.addValue(value);
+                    myAbs.addValue(-value);
+                } else if (value > 0.0f) {
+                    myPos.addValue(value);
+                    myAbs.addValue(value);
+                }
+            }
+#pragma omp critical
+            {
+                m_negPercentHist.mergeAccumulation(myNeg);
+                m_posPercentHist.mergeAccumulation(myPos);
+                m_absPercentHist.mergeAccumulation(myAbs);
+                sum2 += mySum2;
             }
         }
-        if (data[i] > m_max || first) m_max = data[i];
-        if (data[i] < m_min || first) m_min = data[i];
-        sum += data[i];//use a two-pass method for stability, only do mean this pass
-        first = false;
     }
-    int64_t totalGood = (m_negCount + m_zeroCount + m_posCount);
-    m_mean = sum / totalGood;
-    float tempf;
-    double sum2 = 0.0;
-    for (int64_t i = 0; i < dataCount; ++i)
+    if (usebuckets > 0)
     {
-        if (data[i] != data[i]) continue;//skip NaNs
-        if (data[i] < -1.0f && (data[i] * 2.0f == data[i])) continue;//exclude -inf
-        if (data[i] > 1.0f && (data[i] * 2.0f == data[i])) continue;//exclude inf
-        tempf = data[i] - m_mean;
-        sum2 += tempf * tempf;
+        m_negPercentHist.finishAccumulation();
+        m_posPercentHist.finishAccumulation();
+        m_absPercentHist.finishAccumulation();
     }
     if (totalGood > 0)
     {
@@ -237,26 +248,6 @@ void FastStatistics::update(const float* data, const int64_t& dataCount, const f
             m_stdDevSample = sqrt(sum2 / (totalGood - 1));
         }
     }
-    int usebuckets = min(NUM_BUCKETS_PERCENTILE_HIST, dataCount);
-    m_negPercentHist.update(usebuckets, negatives, m_negCount);//10,000 will probably allow us to approximate the percentiles pretty closely, and eats only 80K of memory each
-    m_posPercentHist.update(usebuckets, positives, m_posCount);
-    m_absPercentHist.update(usebuckets, absolutes, m_absCount);
-    
-    if (m_negCount <= 0)
-    {
-        m_leastNeg = 0.0;
-        m_mostNeg  = 0.0;
-    }
-    if (m_posCount <= 0)
-    {
-        m_leastPos = 0.0;
-        m_mostPos  = 0.0;
-    }
-    if (m_absCount <= 0)
-    {
-        m_leastAbs = 0.0;
-        m_mostAbs  = 0.0;
-    }
 }
 
 float FastStatistics::getApproxNegativePercentile(const float& percent) const
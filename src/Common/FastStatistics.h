@@ -47,6 +47,8 @@ namespace caret
         void update(const float* data, const int64_t& dataCount);
         
         ///statistics and display are really not that related, so for now, only include a continuous clipping range, excluding the middle from data will do weird things to standard deviation
+        ///NOTE: mean, standard deviation, extremes and percentiles use only the values inside the range, infs and NaNs are counted regardless of the range
+        ///(previously, the thresholded standard deviation summed squared deviations over all finite values but divided by the in-range count)
         void update(const float* data, const int64_t& dataCount, const float& minThreshInclusive, const float& maxThreshInclusive);
         
         float getApproxPositivePercentile(const float& percent) const;
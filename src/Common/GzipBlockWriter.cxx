@@ -0,0 +1,209 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "GzipBlockWriter.h"
+
+#include "CaretAssert.h"
+#include "CaretLogger.h"
+#include "CaretOMP.h"
+#include "DataFileException.h"
+#include "GzipIndexedReader.h"
+
+#include "zlib.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int64_t BLOCK_SIZE = 1<<20;//uncompressed bytes per member, large enough that restarting the dictionary costs very little compression
+    const int64_t RAW_CHUNK = 1<<26;//QFile chokes on large writes
+    
+    bool compressBlock(const vector<char>& dataIn, vector<char>& dataOut)
+    {
+        z_stream strm;
+        memset(&strm, 0, sizeof(strm));//zalloc, zfree, opaque = Z_NULL
+        if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 31, 8, Z_DEFAULT_STRATEGY) != Z_OK) return false;//31 means gzip wrapper, same defaults as gzopen with "wb"
+        dataOut.resize(deflateBound(&strm, dataIn.size()) + 32);//older zlib doesn't count the gzip header and trailer in the bound
+        strm.next_in = (Bytef*)dataIn.data();
+        strm.avail_in = dataIn.size();
+        strm.next_out = (Bytef*)dataOut.data();
+        strm.avail_out = dataOut.size();
+        int ret = deflate(&strm, Z_FINISH);
+        dataOut.resize(dataOut.size() - strm.avail_out);
+        deflateEnd(&strm);
+        return (ret == Z_STREAM_END);
+    }
+}
+
+GzipBlockWriter::GzipBlockWriter()
+{
+    m_pos = 0;
+    m_rawPos = 0;
+    m_batchSize = 1;
+}
+
+void GzipBlockWriter::open(const QString& filename, const CaretBinaryFile::OpenMode& opmode)
+{
+    close();
+    m_fileName = filename;
+    if (opmode != CaretBinaryFile::WRITE_TRUNCATE) throw DataFileException("compressed file only supports READ and WRITE_TRUNCATE modes");
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        throw DataFileException("failed to open compressed file '" + filename + "', unable to create file");
+    }
+    m_pending.clear();
+    m_pending.push_back(vector<char>());
+    m_pending.back().reserve(BLOCK_SIZE);
+    m_pos = 0;
+    m_rawPos = 0;
+    m_memberOutPos.clear();
+    m_memberInPos.clear();
+    m_batchSize = 1;
+#ifdef CARET_OMP
+    m_batchSize = max(1, 2 * omp_get_max_threads());//enough blocks to keep every thread busy, without buffering much
+#endif
+}
+
+void GzipBlockWriter::close()
+{
+    if (!m_file.isOpen()) return;//happens when closed and then destroyed, error opening
+    try
+    {
+        compressPending(true);
+    } catch (...) {
+        m_pending.clear();
+        m_file.close();
+        throw;
+    }
+    bool flushed = m_file.flush();
+    m_file.close();
+    if (!flushed) throw DataFileException("error closing compressed file '" + m_fileName + "'");
+    if (CaretBinaryFile::getGzipIndexCaching())
+    {//we know where every member starts, so the index is free
+        vector<GzipIndexedReader::Checkpoint> index(m_memberOutPos.size());
+        for (size_t i = 0; i < m_memberOutPos.size(); ++i)
+        {
+            index[i].m_outPos = m_memberOutPos[i];
+            index[i].m_inPos = m_memberInPos[i];
+        }
+        GzipIndexedReader::saveIndex(m_fileName, m_rawPos, m_pos, index);
+    }
+}
+
+GzipBlockWriter::~GzipBlockWriter()
+{
+    try//throwing from a destructor is a bad idea
+    {
+        close();
+    } catch (CaretException& e) {//handles DataFileException, should be the only culprit
+        CaretLogSevere(e.whatString());
+    } catch (exception& e) {
+        CaretLogSevere(e.what());
+    } catch (...) {
+        CaretLogSevere("caught unknown exception type while closing a compressed file");
+    }
+}
+
+void GzipBlockWriter::seek(const int64_t& position)
+{
+    if (!m_file.isOpen()) throw DataFileException("seek called on unopened GzipBlockWriter");//shouldn't happen
+    if (position < m_pos) throw DataFileException("can't seek backwards while writing compressed file '" + m_fileName + "'");
+    if (position == m_pos) return;
+    vector<char> zeros(min(position - m_pos, BLOCK_SIZE), 0);
+    while (m_pos < position)
+    {
+        write(zeros.data(), min(position - m_pos, (int64_t)zeros.size()));
+    }
+}
+
+void GzipBlockWriter::read(void*, const int64_t&, int64_t*)
+{
+    throw DataFileException("read called on write-only compressed file '" + m_fileName + "'");
+}
+
+void GzipBlockWriter::write(const void* dataIn, const int64_t& count)
+{
+    if (!m_file.isOpen()) throw DataFileException("write called on unopened GzipBlockWriter");//shouldn't happen
+    const char* charIn = (const char*)dataIn;
+    int64_t done = 0;
+    while (done < count)
+    {
+        vector<char>& current = m_pending.back();
+        int64_t toCopy = min(count - done, BLOCK_SIZE - (int64_t)current.size());
+        current.insert(current.end(), charIn + done, charIn + done + toCopy);
+        done += toCopy;
+        m_pos += toCopy;
+        if ((int64_t)current.size() == BLOCK_SIZE)
+        {
+            if ((int)m_pending.size() >= m_batchSize) compressPending(false);
+            m_pending.push_back(vector<char>());
+            m_pending.back().reserve(BLOCK_SIZE);
+        }
+    }
+}
+
+void GzipBlockWriter::compressPending(const bool& final)
+{
+    const int64_t numBlocks = (int64_t)m_pending.size();
+    int64_t blockStart = m_pos;//uncompressed position of the first pending block
+    for (int64_t i = 0; i < numBlocks; ++i)
+    {
+        CaretAssert(final || (int64_t)m_pending[i].size() == BLOCK_SIZE);
+        blockStart -= m_pending[i].size();
+    }
+    vector<vector<char> > compressed(numBlocks);
+    bool failed = false;
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int64_t i = 0; i < numBlocks; ++i)
+    {
+        if (!compressBlock(m_pending[i], compressed[i]))
+        {
+#pragma omp critical
+            failed = true;
+        }
+    }
+    if (failed) throw DataFileException("error compressing data for file '" + m_fileName + "'");
+    for (int64_t i = 0; i < numBlocks; ++i)
+    {
+        if (m_pending[i].empty() && !(m_rawPos == 0 && i == numBlocks - 1)) continue;//only write an empty member if the whole file is empty
+        m_memberOutPos.push_back(blockStart);
+        m_memberInPos.push_back(m_rawPos);
+        writeRaw(compressed[i].data(), compressed[i].size());
+        blockStart += m_pending[i].size();
+    }
+    m_pending.clear();
+}
+
+void GzipBlockWriter::writeRaw(const char* data, const int64_t& count)
+{
+    int64_t total = 0;
+    while (total < count)
+    {
+        int64_t writeret = m_file.write(data + total, min(count - total, RAW_CHUNK));
+        if (writeret < 1) throw DataFileException("failed to write to compressed file '" + m_fileName + "'");
+        total += writeret;
+    }
+    m_rawPos += count;
+}
@@ -0,0 +1,63 @@
+#ifndef __GZIP_BLOCK_WRITER_H__
+#define __GZIP_BLOCK_WRITER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretBinaryFile.h"
+
+#include <QFile>
+
+#include <vector>
+
+namespace caret {
+
+    ///write-only gzip file that compresses fixed-size blocks on multiple threads, each block is a complete gzip member
+    ///concatenated members are standard gzip (gunzip and gzread handle them), and each member start is a free seek point for GzipIndexedReader
+    class GzipBlockWriter : public CaretBinaryFile::ImplInterface
+    {
+    public:
+        GzipBlockWriter();
+        void open(const QString& filename, const CaretBinaryFile::OpenMode& opmode);
+        void close();
+        void seek(const int64_t& position);//only forward, fills with zeros like gzseek
+        int64_t pos() { return m_pos; }
+        int64_t size() { return -1; }
+        void read(void* dataOut, const int64_t& count, int64_t* numRead);//throws, write-only
+        void write(const void* dataIn, const int64_t& count);
+        ~GzipBlockWriter();
+    private:
+        GzipBlockWriter(const GzipBlockWriter&);
+        GzipBlockWriter& operator=(const GzipBlockWriter&);
+
+        QFile m_file;
+        std::vector<std::vector<char> > m_pending;//full blocks waiting to be compressed, the last one is being filled
+        int64_t m_pos;//uncompressed bytes written
+        int64_t m_rawPos;//compressed bytes written
+        std::vector<int64_t> m_memberOutPos, m_memberInPos;//for the sidecar index
+        int m_batchSize;
+
+        void compressPending(const bool& final);
+        void writeRaw(const char* data, const int64_t& count);
+    };
+
+} //namespace caret
+
+#endif //__GZIP_BLOCK_WRITER_H__
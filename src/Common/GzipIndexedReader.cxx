@@ -0,0 +1,667 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+//same large file settings as CaretBinaryFile.cxx
+#ifndef CARET_OS_MACOSX
+#define _LARGEFILE64_SOURCE
+#define _LFS64_LARGEFILE 1
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include "GzipIndexedReader.h"
+
+#include "CaretAssert.h"
+#include "CaretLogger.h"
+#include "CaretOMP.h"
+#include "DataFileException.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include "zlib.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#ifndef CARET_OS_WINDOWS
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int64_t WINDOW_SIZE = 32768;//maximum deflate back-reference distance
+    const int64_t INPUT_CHUNK = 1<<17;
+    const int64_t CHECKPOINT_SPAN = 1<<22;//4MiB of output between windowed checkpoints, so the windows cost under 1% of the uncompressed size
+    const int64_t MEMBER_SPAN = 1<<15;//member starts need no window, so they can be recorded much more densely (blocked gzip output)
+    const int64_t PARALLEL_MIN_SPANS = 3;//don't bother with threads for reads that only touch a couple of spans
+    const char SIDECAR_MAGIC[8] = { 'W', 'B', 'G', 'Z', 'I', 'D', 'X', '1' };
+    
+    bool outPosLess(const int64_t& position, const GzipIndexedReader::Checkpoint& point)
+    {
+        return position < point.m_outPos;
+    }
+}
+
+namespace caret
+{
+    class GzipIndexedReader::Decoder
+    {
+        GzipIndexedReader* m_owner;
+        z_stream m_strm;
+        bool m_init, m_raw, m_eof, m_record;
+        vector<unsigned char> m_inBuf, m_window;//window is circular, and is also where inflate writes its output
+        int64_t m_inNext;//compressed position of the next byte to load into m_inBuf
+        int64_t m_winPos;
+        int64_t m_outPos;
+        int64_t m_lastRecorded;
+
+        void end();
+        int64_t fillInput();
+        bool startNextMember();
+        void throwZlibError(const int& ret);
+    public:
+        Decoder(GzipIndexedReader* owner, const bool& record);
+        ~Decoder() { end(); }
+        void start(const Checkpoint& point);
+        bool isStarted() const { return m_init; }
+        int64_t getPos() const { return m_outPos; }
+        int64_t getInPos() const { return m_inNext - m_strm.avail_in; }
+        int64_t decode(char* dataOut, const int64_t& count);//dataOut can be NULL to skip, returns less than count only at the end of the data
+    };
+}
+
+GzipIndexedReader::Decoder::Decoder(GzipIndexedReader* owner, const bool& record)
+{
+    m_owner = owner;
+    m_record = record;
+    m_init = false;
+    m_raw = false;
+    m_eof = false;
+    m_inNext = 0;
+    m_winPos = 0;
+    m_outPos = 0;
+    m_lastRecorded = 0;
+    m_inBuf.resize(INPUT_CHUNK);
+    m_window.resize(WINDOW_SIZE, 0);
+}
+
+void GzipIndexedReader::Decoder::end()
+{
+    if (m_init) inflateEnd(&m_strm);
+    m_init = false;
+}
+
+void GzipIndexedReader::Decoder::throwZlibError(const int& ret)
+{
+    AString message = "error decompressing file '" + m_owner->m_fileName + "'";
+    if (ret == Z_MEM_ERROR)
+    {
+        message += ", out of memory";
+    } else if (m_strm.msg != NULL) {
+        message += ": " + AString(m_strm.msg);
+    }
+    throw DataFileException(message);
+}
+
+void GzipIndexedReader::Decoder::start(const Checkpoint& point)
+{
+    end();
+    memset(&m_strm, 0, sizeof(m_strm));//zalloc, zfree, opaque = Z_NULL
+    m_raw = !point.m_memberStart;
+    int ret = inflateInit2(&m_strm, m_raw ? -15 : 31);//raw deflate in the middle of a member, otherwise gzip header
+    if (ret != Z_OK) throwZlibError(ret);
+    m_init = true;
+    m_strm.next_in = m_inBuf.data();
+    m_strm.avail_in = 0;
+    m_inNext = point.m_inPos;
+    m_outPos = point.m_outPos;
+    m_lastRecorded = point.m_outPos;
+    m_eof = false;
+    m_winPos = 0;
+    if (m_raw)
+    {
+        if (point.m_bits != 0)
+        {
+            unsigned char partial;
+            if (m_owner->readRaw(point.m_inPos - 1, &partial, 1) != 1) throw DataFileException("error reading compressed file '" + m_owner->m_fileName + "'");
+            ret = inflatePrime(&m_strm, point.m_bits, partial >> (8 - point.m_bits));
+            if (ret != Z_OK) throwZlibError(ret);
+        }
+        CaretAssert((int64_t)point.m_window.size() == WINDOW_SIZE);
+        ret = inflateSetDictionary(&m_strm, point.m_window.data(), point.m_window.size());
+        if (ret != Z_OK) throwZlibError(ret);
+        m_window = point.m_window;//stored oldest first, so m_winPos = 0 overwrites the oldest byte next
+    }
+}
+
+int64_t GzipIndexedReader::Decoder::fillInput()
+{
+    int64_t keep = m_strm.avail_in;
+    if (keep > 0 && m_strm.next_in != m_inBuf.data())
+    {
+        memmove(m_inBuf.data(), m_strm.next_in, keep);
+    }
+    int64_t numRead = m_owner->readRaw(m_inNext, m_inBuf.data() + keep, INPUT_CHUNK - keep);
+    m_inNext += numRead;
+    m_strm.next_in = m_inBuf.data();
+    m_strm.avail_in = keep + numRead;
+    return numRead;
+}
+
+bool GzipIndexedReader::Decoder::startNextMember()
+{//zlib stops at the end of each gzip member, but concatenated members are a valid gzip file, and gzread continues through them
+    if (m_raw)
+    {//we started in the middle of a member, so the 8 byte trailer hasn't been consumed
+        while (m_strm.avail_in < 8)
+        {
+            if (fillInput() == 0) return false;
+        }
+        m_strm.next_in += 8;
+        m_strm.avail_in -= 8;
+    }
+    while (m_strm.avail_in < 2)
+    {
+        if (fillInput() == 0) return false;
+    }
+    if (m_strm.next_in[0] != 0x1f || m_strm.next_in[1] != 0x8b) return false;//like gzread, ignore trailing garbage
+    if (m_raw)
+    {
+        inflateEnd(&m_strm);
+        Bytef* nextIn = m_strm.next_in;
+        uInt availIn = m_strm.avail_in;
+        memset(&m_strm, 0, sizeof(m_strm));
+        int ret = inflateInit2(&m_strm, 31);
+        if (ret != Z_OK)
+        {
+            m_init = false;
+            throwZlibError(ret);
+        }
+        m_strm.next_in = nextIn;
+        m_strm.avail_in = availIn;
+        m_raw = false;
+    } else {
+        int ret = inflateReset(&m_strm);
+        if (ret != Z_OK) throwZlibError(ret);
+    }
+    if (m_record && m_outPos - m_lastRecorded >= MEMBER_SPAN)
+    {
+        Checkpoint point;
+        point.m_outPos = m_outPos;
+        point.m_inPos = m_inNext - m_strm.avail_in;
+        m_owner->recordCheckpoint(point);
+        m_lastRecorded = m_outPos;
+    }
+    return true;
+}
+
+int64_t GzipIndexedReader::Decoder::decode(char* dataOut, const int64_t& count)
+{
+    CaretAssert(m_init);
+    int64_t total = 0;
+    while (total < count && !m_eof)
+    {
+        if (m_strm.avail_in == 0) fillInput();//inflate may still have pending output when there is no more input, so don't stop yet
+        if (m_winPos == WINDOW_SIZE) m_winPos = 0;
+        uInt availOut = (uInt)min(WINDOW_SIZE - m_winPos, count - total);
+        m_strm.next_out = m_window.data() + m_winPos;
+        m_strm.avail_out = availOut;
+        int ret = inflate(&m_strm, m_record ? Z_BLOCK : Z_NO_FLUSH);//Z_BLOCK stops at deflate block boundaries, where checkpoints are possible
+        int64_t produced = availOut - m_strm.avail_out;
+        if (dataOut != NULL && produced > 0)
+        {
+            memcpy(dataOut + total, m_window.data() + m_winPos, produced);
+        }
+        m_winPos += produced;
+        m_outPos += produced;
+        total += produced;
+        switch (ret)
+        {
+            case Z_OK:
+                break;
+            case Z_BUF_ERROR://no progress possible
+                if (m_strm.avail_in != 0) throwZlibError(ret);
+                m_eof = true;//we just tried to refill, so the file is truncated, let the caller report the short read
+                break;
+            case Z_STREAM_END:
+                if (!startNextMember()) m_eof = true;
+                break;
+            default:
+                throwZlibError(ret);
+        }
+        if (m_record)
+        {
+            if (ret != Z_STREAM_END && (m_strm.data_type & 128) && !(m_strm.data_type & 64) && m_outPos - m_lastRecorded >= CHECKPOINT_SPAN)
+            {//at a block boundary that isn't the end of the member
+                Checkpoint point;
+                point.m_outPos = m_outPos;
+                point.m_inPos = m_inNext - m_strm.avail_in;
+                point.m_bits = m_strm.data_type & 7;
+                point.m_memberStart = false;
+                point.m_window.resize(WINDOW_SIZE);
+                int64_t wrapped = (m_winPos == WINDOW_SIZE ? 0 : m_winPos);//unwrap the circular buffer
+                memcpy(point.m_window.data(), m_window.data() + wrapped, WINDOW_SIZE - wrapped);
+                memcpy(point.m_window.data() + WINDOW_SIZE - wrapped, m_window.data(), wrapped);
+                m_owner->recordCheckpoint(point);
+                m_lastRecorded = m_outPos;
+            }
+            m_owner->recordProgress(m_outPos, m_eof);
+        }
+    }
+    return total;
+}
+
+bool GzipIndexedReader::isGzipFile(const QString& filename)
+{
+    QFile testFile(filename);
+    if (!testFile.open(QIODevice::ReadOnly)) return false;
+    char magic[2];
+    if (testFile.read(magic, 2) != 2) return false;
+    return ((unsigned char)magic[0] == 0x1f && (unsigned char)magic[1] == 0x8b);
+}
+
+GzipIndexedReader::GzipIndexedReader()
+{
+    m_rawSize = 0;
+    m_indexedTo = 0;
+    m_indexComplete = false;
+    m_loadedFromSidecar = false;
+    m_pos = 0;
+}
+
+void GzipIndexedReader::open(const QString& filename, const CaretBinaryFile::OpenMode& opmode)
+{
+    close();
+    m_fileName = filename;
+    if (opmode != CaretBinaryFile::READ) throw DataFileException("indexed gzip reading does not support writing, file '" + filename + "'");
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        if (!m_file.exists()) throw DataFileException("failed to open file '" + filename + "', file does not exist, or folder permissions prevent seeing it");
+        throw DataFileException("failed to open file '" + filename + "'");
+    }
+    m_rawSize = m_file.size();
+    m_index.clear();
+    m_index.push_back(Checkpoint());//start of the file is a member start
+    m_indexedTo = 0;
+    m_indexComplete = false;
+    m_loadedFromSidecar = false;
+    if (CaretBinaryFile::getGzipIndexCaching())
+    {
+        m_loadedFromSidecar = loadSidecar();
+    }
+    m_frontier.grabNew(new Decoder(this, true));
+    if (!m_indexComplete)
+    {
+        m_frontier->start(m_index[0]);
+    }
+    m_cursor.grabNew(new Decoder(this, false));
+    m_pos = 0;
+}
+
+void GzipIndexedReader::close()
+{
+    if (!m_file.isOpen()) return;
+    if (CaretBinaryFile::getGzipIndexCaching() && !m_loadedFromSidecar)
+    {
+        if (!m_indexComplete && m_frontier->isStarted() && m_rawSize - m_frontier->getInPos() <= INPUT_CHUNK)
+        {//reading exactly to the end of the data doesn't hit the end of the stream, so finish it if that is cheap
+            m_frontier->decode(NULL, numeric_limits<int64_t>::max());
+        }
+        if (m_indexComplete) saveSidecar();
+    }
+    m_frontier.grabNew(NULL);
+    m_cursor.grabNew(NULL);
+    m_file.close();
+    m_index.clear();
+    m_indexedTo = 0;
+    m_indexComplete = false;
+}
+
+GzipIndexedReader::~GzipIndexedReader()
+{
+    try//throwing from a destructor is a bad idea
+    {
+        close();
+    } catch (CaretException& e) {
+        CaretLogSevere(e.whatString());
+    } catch (exception& e) {
+        CaretLogSevere(e.what());
+    } catch (...) {
+        CaretLogSevere("caught unknown exception type while closing a compressed file");
+    }
+}
+
+void GzipIndexedReader::seek(const int64_t& position)
+{//lazy, the next read picks the best place to start decompressing from
+    m_pos = position;
+}
+
+int64_t GzipIndexedReader::size()
+{
+    CaretMutexLocker locked(&m_indexMutex);
+    if (m_indexComplete) return m_indexedTo;
+    return -1;
+}
+
+void GzipIndexedReader::read(void* dataOut, const int64_t& count, int64_t* numRead)
+{
+    if (!m_file.isOpen()) throw DataFileException("read called on unopened GzipIndexedReader");//shouldn't happen
+    int64_t total = readRange(m_pos, (char*)dataOut, count, true);
+    m_pos += total;
+    if (numRead == NULL)
+    {
+        if (total != count) throw DataFileException("premature end of file in '" + m_fileName + "'");
+    } else {
+        *numRead = total;
+    }
+}
+
+void GzipIndexedReader::readAt(const int64_t& position, void* dataOut, const int64_t& count, int64_t* numRead)
+{
+    if (!m_file.isOpen()) throw DataFileException("readAt called on unopened GzipIndexedReader");//shouldn't happen
+    int64_t total = readRange(position, (char*)dataOut, count, false);
+    if (numRead == NULL)
+    {
+        if (total != count) throw DataFileException("premature end of file in '" + m_fileName + "'");
+    } else {
+        *numRead = total;
+    }
+}
+
+void GzipIndexedReader::write(const void*, const int64_t&)
+{
+    throw DataFileException("write called on read-only compressed file '" + m_fileName + "'");
+}
+
+int64_t GzipIndexedReader::readRaw(const int64_t& position, unsigned char* dataOut, const int64_t& count)
+{
+    int64_t total = 0;
+#ifdef CARET_OS_WINDOWS
+    CaretMutexLocker locked(&m_rawMutex);
+    if (!m_file.seek(position)) return 0;
+    while (total < count)
+    {
+        int64_t readret = m_file.read((char*)dataOut + total, count - total);
+        if (readret < 1) break;
+        total += readret;
+    }
+#else
+    int fd = m_file.handle();
+    while (total < count)
+    {
+        int64_t readret = pread(fd, dataOut + total, count - total, position + total);
+        if (readret < 0 && errno == EINTR) continue;
+        if (readret < 0) throw DataFileException("error while reading file '" + m_fileName + "'");
+        if (readret == 0) break;
+        total += readret;
+    }
+#endif
+    return total;
+}
+
+void GzipIndexedReader::recordCheckpoint(const Checkpoint& point)
+{
+    CaretMutexLocker locked(&m_indexMutex);
+    CaretAssert(point.m_outPos > m_index.back().m_outPos);
+    m_index.push_back(point);
+}
+
+void GzipIndexedReader::recordProgress(const int64_t& decodedTo, const bool& atEnd)
+{
+    CaretMutexLocker locked(&m_indexMutex);
+    m_indexedTo = decodedTo;
+    if (atEnd) m_indexComplete = true;
+}
+
+void GzipIndexedReader::getCheckpointBefore(const int64_t& position, Checkpoint& pointOut)
+{
+    CaretMutexLocker locked(&m_indexMutex);
+    int64_t low = 0, high = (int64_t)m_index.size();//find the last checkpoint at or before position
+    while (high - low > 1)
+    {
+        int64_t guess = (low + high) / 2;
+        if (m_index[guess].m_outPos <= position)
+        {
+            low = guess;
+        } else {
+            high = guess;
+        }
+    }
+    pointOut = m_index[low];
+}
+
+void GzipIndexedReader::decodeIndexed(const int64_t& start, const int64_t& end, char* dataOut, const bool& useCursor)
+{
+    vector<int64_t> bounds(1, start);//split the range at every checkpoint it contains
+    {
+        CaretMutexLocker locked(&m_indexMutex);
+        CaretAssert(end <= m_indexedTo);
+        for (vector<Checkpoint>::const_iterator iter = upper_bound(m_index.begin(), m_index.end(), start, outPosLess); iter != m_index.end() && iter->m_outPos < end; ++iter)
+        {
+            bounds.push_back(iter->m_outPos);
+        }
+    }
+    bounds.push_back(end);
+    const int64_t numSpans = (int64_t)bounds.size() - 1;
+    if (numSpans < PARALLEL_MIN_SPANS)
+    {
+        Checkpoint point;
+        getCheckpointBefore(start, point);
+        Decoder localDecoder(this, false);
+        Decoder* decoder = &localDecoder;
+        if (useCursor)
+        {
+            decoder = m_cursor;
+            if (!decoder->isStarted() || decoder->getPos() > start || decoder->getPos() < point.m_outPos)
+            {//the checkpoint is closer than the cursor, or the cursor is past where we need to be
+                decoder->start(point);
+            }
+        } else {
+            decoder->start(point);
+        }
+        decoder->decode(NULL, start - decoder->getPos());
+        if (decoder->decode(dataOut, end - start) != end - start)
+        {
+            throw DataFileException("compressed file '" + m_fileName + "' changed while reading");
+        }
+        return;
+    }
+    bool failed = false;
+    AString errorMessage;
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int64_t i = 0; i < numSpans; ++i)
+    {
+        try
+        {
+            Checkpoint point;
+            getCheckpointBefore(bounds[i], point);
+            Decoder spanDecoder(this, false);
+            spanDecoder.start(point);
+            spanDecoder.decode(NULL, bounds[i] - point.m_outPos);
+            if (spanDecoder.decode(dataOut + (bounds[i] - start), bounds[i + 1] - bounds[i]) != bounds[i + 1] - bounds[i])
+            {
+                throw DataFileException("compressed file '" + m_fileName + "' changed while reading");
+            }
+        } catch (CaretException& e) {//exceptions can't leave a parallel region
+#pragma omp critical
+            {
+                failed = true;
+                errorMessage = e.whatString();
+            }
+        }
+    }
+    if (failed) throw DataFileException(errorMessage);
+}
+
+int64_t GzipIndexedReader::readRange(const int64_t& position, char* dataOut, const int64_t& count, const bool& useCursor)
+{
+    int64_t total = 0;
+    while (total < count)
+    {
+        const int64_t current = position + total;
+        int64_t indexedTo;
+        bool complete;
+        {
+            CaretMutexLocker locked(&m_indexMutex);
+            indexedTo = m_indexedTo;
+            complete = m_indexComplete;
+        }
+        if (current < indexedTo)
+        {//already seen, decompress from checkpoints
+            int64_t end = min(position + count, indexedTo);
+            decodeIndexed(current, end, dataOut + total, useCursor);
+            total += end - current;
+            continue;
+        }
+        if (complete) break;//past the end of the data
+        CaretMutexLocker locked(&m_frontierMutex);
+        int64_t frontierPos = m_frontier->getPos();
+        if (frontierPos > current) continue;//another thread moved the frontier past us while we waited, so this is indexed now
+        if (frontierPos < current)
+        {//seek forward, which also indexes what we skip over
+            m_frontier->decode(NULL, current - frontierPos);
+            if (m_frontier->getPos() < current) break;//seek past the end
+        }
+        int64_t wanted = count - total;
+        int64_t got = m_frontier->decode(dataOut + total, wanted);
+        total += got;
+        if (got < wanted) break;
+    }
+    return total;
+}
+
+QString GzipIndexedReader::getSidecarName() const
+{
+    return m_fileName + ".gzidx";//saveIndex() has to match
+}
+
+bool GzipIndexedReader::loadSidecar()
+{
+    QFile sidecar(getSidecarName());
+    if (!sidecar.exists()) return false;
+    if (QFileInfo(sidecar.fileName()).lastModified() < QFileInfo(m_fileName).lastModified())
+    {
+        CaretLogFine("ignoring stale gzip index '" + sidecar.fileName() + "'");
+        return false;
+    }
+    if (!sidecar.open(QIODevice::ReadOnly)) return false;
+    QByteArray contents = sidecar.readAll();
+    const char* data = contents.constData();
+    const int64_t length = contents.size();
+    int64_t offset = 0;
+    bool ok = true;
+    vector<Checkpoint> index;
+    int64_t totalSize = 0;
+    char magic[8];
+    int32_t endianCheck = 0;
+    int64_t rawSize = 0, numPoints = 0;
+    if (length < 36) ok = false;
+    if (ok)
+    {
+        memcpy(magic, data, 8);
+        memcpy(&endianCheck, data + 8, 4);
+        memcpy(&rawSize, data + 12, 8);
+        memcpy(&totalSize, data + 20, 8);
+        memcpy(&numPoints, data + 28, 8);
+        offset = 36;
+        ok = (memcmp(magic, SIDECAR_MAGIC, 8) == 0 && endianCheck == 1 && rawSize == m_rawSize && numPoints > 0 && totalSize >= 0);
+    }
+    for (int64_t i = 0; ok && i < numPoints; ++i)
+    {
+        Checkpoint point;
+        int32_t memberStart = 0, windowSize = 0;
+        if (offset + 28 > length)
+        {
+            ok = false;
+            break;
+        }
+        memcpy(&point.m_outPos, data + offset, 8);
+        memcpy(&point.m_inPos, data + offset + 8, 8);
+        memcpy(&point.m_bits, data + offset + 16, 4);
+        memcpy(&memberStart, data + offset + 20, 4);
+        memcpy(&windowSize, data + offset + 24, 4);
+        offset += 28;
+        point.m_memberStart = (memberStart != 0);
+        if ((point.m_memberStart ? windowSize != 0 : windowSize != WINDOW_SIZE) || offset + windowSize > length ||
+            point.m_bits < 0 || point.m_bits > 7 || point.m_inPos > m_rawSize || point.m_outPos > totalSize ||
+            (i == 0 ? point.m_outPos != 0 : point.m_outPos <= index.back().m_outPos))
+        {
+            ok = false;
+            break;
+        }
+        point.m_window.assign(data + offset, data + offset + windowSize);
+        offset += windowSize;
+        index.push_back(point);
+    }
+    if (!ok || offset != length)
+    {
+        CaretLogFine("ignoring invalid gzip index '" + sidecar.fileName() + "'");
+        return false;
+    }
+    CaretMutexLocker locked(&m_indexMutex);
+    m_index = index;
+    m_indexedTo = totalSize;
+    m_indexComplete = true;
+    return true;
+}
+
+void GzipIndexedReader::saveSidecar()
+{
+    CaretMutexLocker locked(&m_indexMutex);
+    saveIndex(m_fileName, m_rawSize, m_indexedTo, m_index);
+}
+
+void GzipIndexedReader::saveIndex(const QString& gzFileName, const int64_t& rawSize, const int64_t& totalSize, const vector<Checkpoint>& index)
+{//caching is an optimization, so failures are only logged
+    QFile sidecar(gzFileName + ".gzidx");
+    if (!sidecar.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        CaretLogFine("unable to write gzip index '" + sidecar.fileName() + "'");
+        return;
+    }
+    QByteArray contents;
+    int32_t endianCheck = 1;
+    int64_t numPoints = (int64_t)index.size();
+    contents.append(SIDECAR_MAGIC, 8);
+    contents.append((const char*)&endianCheck, 4);
+    contents.append((const char*)&rawSize, 8);
+    contents.append((const char*)&totalSize, 8);
+    contents.append((const char*)&numPoints, 8);
+    for (vector<Checkpoint>::const_iterator iter = index.begin(); iter != index.end(); ++iter)
+    {
+        int32_t memberStart = (iter->m_memberStart ? 1 : 0), windowSize = (int32_t)iter->m_window.size();
+        contents.append((const char*)&(iter->m_outPos), 8);
+        contents.append((const char*)&(iter->m_inPos), 8);
+        contents.append((const char*)&(iter->m_bits), 4);
+        contents.append((const char*)&memberStart, 4);
+        contents.append((const char*)&windowSize, 4);
+        if (windowSize > 0) contents.append((const char*)iter->m_window.data(), windowSize);
+    }
+    if (sidecar.write(contents) != contents.size())
+    {
+        CaretLogFine("error writing gzip index '" + sidecar.fileName() + "'");
+        sidecar.close();
+        sidecar.remove();
+    }
+}
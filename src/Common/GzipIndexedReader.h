@@ -0,0 +1,97 @@
+#ifndef __GZIP_INDEXED_READER_H__
+#define __GZIP_INDEXED_READER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "CaretBinaryFile.h"
+#include "CaretMutex.h"
+#include "CaretPointer.h"
+
+#include <QFile>
+
+#include <vector>
+
+namespace caret {
+
+    ///read-only gzip file with random access: while decompressing, it records checkpoints (inflate state plus the preceding 32KiB of output)
+    ///so that a seek only needs to decompress from the nearest checkpoint instead of from the start of the file
+    ///readAt() is thread-safe, and decompresses spans between checkpoints in parallel once they are indexed
+    class GzipIndexedReader : public CaretBinaryFile::ImplInterface
+    {
+    public:
+        struct Checkpoint
+        {
+            int64_t m_outPos;//uncompressed position
+            int64_t m_inPos;//compressed position of the first byte not yet fully consumed
+            int32_t m_bits;//number of bits of the byte before m_inPos that are not yet consumed
+            bool m_memberStart;//start of a gzip member, needs no window or bits
+            std::vector<unsigned char> m_window;//last 32KiB of output before this point, empty for member starts
+            Checkpoint() { m_outPos = 0; m_inPos = 0; m_bits = 0; m_memberStart = true; }
+        };
+        ///check whether the file starts with the gzip magic number, otherwise it should be read with gzread, which passes through uncompressed data
+        static bool isGzipFile(const QString& filename);
+        ///write a sidecar index for a gzip file, for writers that know where their members start - index must start with the start of the file
+        static void saveIndex(const QString& gzFileName, const int64_t& rawSize, const int64_t& totalSize, const std::vector<Checkpoint>& index);
+        GzipIndexedReader();
+        void open(const QString& filename, const CaretBinaryFile::OpenMode& opmode);
+        void close();
+        void seek(const int64_t& position);
+        int64_t pos() { return m_pos; }
+        int64_t size();//-1 until the end of the file has been reached once
+        void read(void* dataOut, const int64_t& count, int64_t* numRead);
+        void write(const void* dataIn, const int64_t& count);//throws, read-only
+        bool canReadAt() { return true; }
+        void readAt(const int64_t& position, void* dataOut, const int64_t& count, int64_t* numRead);
+        ~GzipIndexedReader();
+
+        class Decoder;//defined in the .cxx so that zlib.h stays private
+    private:
+        GzipIndexedReader(const GzipIndexedReader&);
+        GzipIndexedReader& operator=(const GzipIndexedReader&);
+
+        QFile m_file;//the compressed file
+        int64_t m_rawSize;
+        CaretMutex m_rawMutex;//for platforms without pread
+        std::vector<Checkpoint> m_index;//sorted by m_outPos, first entry is always the start of the file
+        int64_t m_indexedTo;//uncompressed position up to which checkpoints have been recorded
+        bool m_indexComplete, m_loadedFromSidecar;
+        CaretMutex m_indexMutex;//protects m_index, m_indexedTo, m_indexComplete
+        CaretPointer<Decoder> m_frontier;//the only decoder that records checkpoints, always positioned at m_indexedTo
+        CaretMutex m_frontierMutex;
+        CaretPointer<Decoder> m_cursor;//reused by sequential read() calls behind the frontier
+        int64_t m_pos;
+
+        int64_t readRaw(const int64_t& position, unsigned char* dataOut, const int64_t& count);//thread-safe
+        void recordCheckpoint(const Checkpoint& point);//called by the frontier decoder
+        void recordProgress(const int64_t& decodedTo, const bool& atEnd);
+        void getCheckpointBefore(const int64_t& position, Checkpoint& pointOut);
+        void decodeIndexed(const int64_t& start, const int64_t& end, char* dataOut, const bool& useCursor);//[start, end) must be below m_indexedTo
+        int64_t readRange(const int64_t& position, char* dataOut, const int64_t& count, const bool& useCursor);
+        QString getSidecarName() const;
+        bool loadSidecar();
+        void saveSidecar();
+
+        friend class Decoder;
+    };
+
+} //namespace caret
+
+#endif //__GZIP_INDEXED_READER_H__
@@ -21,11 +21,19 @@
 
 #include "Histogram.h"
 #include "CaretAssert.h"
+#include "CaretOMP.h"
+
 #include <cmath>
+#include <limits>
 
 using namespace caret;
 using namespace std;
 
+namespace
+{
+    const int64_t PARALLEL_MIN_COUNT = 1 << 16;//thread startup and merging cost more than they save on small maps
+}
+
 Histogram::Histogram(const int& numBuckets)
 {
     resize(numBuckets);
@@ -76,6 +84,7 @@ void Histogram::reset()
     m_displayHeightMax = 0.0;
     m_bucketMin = 0.0;
     m_bucketMax = 0.0;
+    m_bucketSize = 0.0;
 }
 
 void Histogram::update(const int& numBuckets, const float* data, const int64_t& dataCount)
@@ -87,100 +96,68 @@ void Histogram::update(const int& numBuckets, const float* data, const int64_t&
 void Histogram::update(const float* data, const int64_t& dataCount)
 {
     int numBuckets = (int)m_buckets.size();
-    reset();
-    bool first = true;
-    for (int64_t i = 0; i < dataCount; ++i)
-    {//count value classes
-        if (data[i] != data[i])
-        {
-            ++m_nanCount;
-            continue;//skip NaNs
-        }
-        if (data[i] == 0.0f)//test exactly zero (negative zero also tests equal), in case someone wants stats on something with miniscule values (percent of surface area per node?)
+    float dataMin = numeric_limits<float>::max(), dataMax = -numeric_limits<float>::max();
+    int64_t infCount = 0, negInfCount = 0, nanCount = 0;
+#pragma omp CARET_PAR if (dataCount > PARALLEL_MIN_COUNT)
+    {//first pass finds the range of numeric values
+        float myMin = numeric_limits<float>::max(), myMax = -numeric_limits<float>::max();
+        int64_t myInf = 0, myNegInf = 0, myNan = 0;
+#pragma omp CARET_FOR
+        for (int64_t i = 0; i < dataCount; ++i)
         {
-            ++m_zeroCount;
-        } else {
-            if (data[i] < 0.0f)
+            const float value = data[i];
+            if (value != value)
             {
-                if (data[i] * 2.0f == data[i])
-                {
-                    ++m_negInfCount;
-                    continue;//skip neg infs
-                } else {
-                    ++m_negCount;
-                }
-            } else {
-                if (data[i] * 2.0f == data[i])
+                ++myNan;
+                continue;//skip NaNs
+            }
+            if (value != 0.0f && value * 2.0f == value)
+            {
+                if (value < 0.0f)
                 {
-                    ++m_infCount;
-                    continue;//skip infs
+                    ++myNegInf;
                 } else {
-                    ++m_posCount;
+                    ++myInf;
                 }
+                continue;//skip infs
             }
+            if (value < myMin) myMin = value;
+            if (value > myMax) myMax = value;
         }
-        if (first)
+#pragma omp critical
         {
-            first = false;
-            m_bucketMin = data[i];
-            m_bucketMax = data[i];
-        } else {
-            if (data[i] > m_bucketMax)
-            {
-                m_bucketMax = data[i];
-            } else if (data[i] < m_bucketMin) {//skip testing for new minimum if we found a new maximum
-                m_bucketMin = data[i];
-            }
+            if (myMin < dataMin) dataMin = myMin;
+            if (myMax > dataMax) dataMax = myMax;
+            infCount += myInf;
+            negInfCount += myNegInf;
+            nanCount += myNan;
         }
     }
-    if (first)
-    {
-        m_bucketMin = m_bucketMax = 0.0f;
-        return;//our arrays are already zeroed, so just return if no valid data
+    if (dataMin > dataMax)
+    {//no valid data, our arrays are zeroed by beginAccumulation
+        beginAccumulation(numBuckets, 0.0f, 0.0f);
+        finishAccumulation(infCount, negInfCount, nanCount);
+        return;
     }
-    if (m_bucketMin == m_bucketMax)
-    {
-        int64_t totalValid = m_negCount + m_posCount + m_zeroCount;
-        for (int i = 0; i < numBuckets - 1; ++i)
-        {
-            m_cumulative[i] = (i + 1) * totalValid / numBuckets;//so, its not particularly useful if our range is zero, but split them evenly among buckets just for kicks
-            if (i == 0)
-            {
-                m_buckets[i] = m_cumulative[i];
-            } else {
-                m_buckets[i] = m_cumulative[i] - m_cumulative[i - 1];
-            }
-        }//display is already zeroed, so just return
-        m_cumulative[numBuckets - 1] = totalValid;//make sure the last one has all of them
-        if (numBuckets > 1)
+    beginAccumulation(numBuckets, dataMin, dataMax);
+#pragma omp CARET_PAR if (dataCount > PARALLEL_MIN_COUNT)
+    {//second pass fills per-thread partial histograms, then merges them
+        Histogram myHist(numBuckets);
+        myHist.beginAccumulation(numBuckets, dataMin, dataMax);
+#pragma omp CARET_FOR
+        for (int64_t i = 0; i < dataCount; ++i)
         {
-            m_buckets[numBuckets - 1] = m_cumulative[numBuckets - 1] - m_cumulative[numBuckets - 2];
-        } else {
-            m_buckets[numBuckets - 1] = m_cumulative[numBuckets - 1];
+            const float value = data[i];
+            if (value != value) continue;//exclude NaN
+            if (value != 0.0f && value * 2.0f == value) continue;//exclude infs
+            myHist.addValue(value);
         }
-        return;
-    }
-    float bucketsize = (m_bucketMax - m_bucketMin) / numBuckets;
-    for (int64_t i = 0; i < dataCount; ++i)
-    {//determine histogram
-        if (data[i] != data[i]) continue;//exclude NaN
-        if (data[i] < -1.0f && (data[i] * 2.0f == data[i])) continue;//exclude -inf
-        if (data[i] > 1.0f && (data[i] * 2.0f == data[i])) continue;//exclude inf
-        int bucket = (int)((data[i] - m_bucketMin) / bucketsize);//doesn't really matter whether small negative floats truncate to a 0 integer
-        if (bucket < 0) bucket = 0;//because of this
-        if (bucket >= numBuckets) bucket = numBuckets - 1;
-        CaretAssertVectorIndex(m_buckets, bucket);
-        ++m_buckets[bucket];
-    }
-    computeCumulative();
-    m_displayHeightMax = 0.0;
-    for (int i = 0; i < numBuckets; ++i)
-    {//compute display values by normalizing by bucket size
-        m_display[i] = m_buckets[i] / bucketsize;
-        if (m_display[i] > m_displayHeightMax) {
-            m_displayHeightMax = m_display[i];
+#pragma omp critical
+        {
+            mergeAccumulation(myHist);
         }
     }
+    finishAccumulation(infCount, negInfCount, nanCount);
 }
 
 void Histogram::update(const int32_t& numBuckets,
@@ -255,77 +232,130 @@ void Histogram::update(const float* data, const int64_t& dataCount, float mostPo
                     m_posCount = equalCount;
                 }
             }
-            for (int i = 0; i < numBuckets - 1; ++i)
-            {
-                m_cumulative[i] = (i + 1) * equalCount / numBuckets;//so, its not particularly useful if our range is zero, but split them evenly among buckets just for kicks
-                if (i == 0)
-                {
-                    m_buckets[i] = m_cumulative[i];
-                } else {
-                    m_buckets[i] = m_cumulative[i] - m_cumulative[i - 1];
-                }
-            }//display is already zeroed, so just return
-            m_cumulative[numBuckets - 1] = equalCount;//make sure the last one has all of them
-            if (numBuckets > 1)
-            {
-                m_buckets[numBuckets - 1] = m_cumulative[numBuckets - 1] - m_cumulative[numBuckets - 2];
-            } else {
-                m_buckets[numBuckets - 1] = m_cumulative[numBuckets - 1];
-            }
+            splitEvenly(equalCount);
         }
         return;
     }
-    float bucketsize = (m_bucketMax - m_bucketMin) / numBuckets;
-    for (int64_t i = 0; i < dataCount; ++i)//do the histogram
-    {//count value classes
-        if (data[i] != data[i])
-        {
-            ++m_nanCount;
-            continue;//skip NaNs
-        }
-        if (data[i] == 0.0f)//test exactly zero (negative zero also tests equal), in case someone wants stats on something with miniscule values (percent of surface area per node?)
-        {
-            if (!includeZeroValues) continue;//don't count what is excluded
-            ++m_zeroCount;
-        } else {
-            if (data[i] < 0.0f)
+    const float bucketMin = m_bucketMin, bucketMax = m_bucketMax;
+    beginAccumulation(numBuckets, bucketMin, bucketMax);
+    int64_t infCount = 0, negInfCount = 0, nanCount = 0;
+#pragma omp CARET_PAR if (dataCount > PARALLEL_MIN_COUNT)
+    {
+        Histogram myHist(numBuckets);
+        myHist.beginAccumulation(numBuckets, bucketMin, bucketMax);
+        int64_t myInf = 0, myNegInf = 0, myNan = 0;
+#pragma omp CARET_FOR
+        for (int64_t i = 0; i < dataCount; ++i)//do the histogram
+        {//count value classes
+            const float value = data[i];
+            if (value != value)
             {
-                if (data[i] * 2.0f == data[i])
-                {
-                    ++m_negInfCount;
-                    continue;//skip neg infs
-                } else {
-                    if (data[i] > leastNegativeValueInclusive || data[i] < mostNegativeValueInclusive) continue;//exclude negatives outside range
-                    ++m_negCount;
-                }
+                ++myNan;
+                continue;//skip NaNs
+            }
+            if (value == 0.0f)//test exactly zero (negative zero also tests equal), in case someone wants stats on something with miniscule values (percent of surface area per node?)
+            {
+                if (!includeZeroValues) continue;//don't count what is excluded
             } else {
-                if (data[i] * 2.0f == data[i])
+                if (value < 0.0f)
                 {
-                    ++m_infCount;
-                    continue;//skip infs
+                    if (value * 2.0f == value)
+                    {
+                        ++myNegInf;
+                        continue;//skip neg infs
+                    }
+                    if (value > leastNegativeValueInclusive || value < mostNegativeValueInclusive) continue;//exclude negatives outside range
                 } else {
-                    if (data[i] > mostPositiveValueInclusive || data[i] < leastPositiveValueInclusive) continue;//exclude negatives outside range
-                    ++m_posCount;
+                    if (value * 2.0f == value)
+                    {
+                        ++myInf;
+                        continue;//skip infs
+                    }
+                    if (value > mostPositiveValueInclusive || value < leastPositiveValueInclusive) continue;//exclude positives outside range
                 }
             }
+            myHist.addValue(value);//counts the value class too
+        }
+#pragma omp critical
+        {
+            mergeAccumulation(myHist);
+            infCount += myInf;
+            negInfCount += myNegInf;
+            nanCount += myNan;
         }
-        int bucket = (int)((data[i] - m_bucketMin) / bucketsize);//doesn't really matter whether small negative floats truncate to a 0 integer
-        if (bucket < 0) bucket = 0;//because of this
-        if (bucket >= numBuckets) bucket = numBuckets - 1;
-        CaretAssertVectorIndex(m_buckets, bucket);
-        ++m_buckets[bucket];
+    }
+    finishAccumulation(infCount, negInfCount, nanCount);
+}
+
+void Histogram::beginAccumulation(const int& numBuckets, const float& bucketMin, const float& bucketMax)
+{
+    resize(numBuckets);
+    reset();
+    m_bucketMin = bucketMin;
+    m_bucketMax = bucketMax;
+    m_bucketSize = (bucketMax - bucketMin) / numBuckets;
+}
+
+void Histogram::mergeAccumulation(const Histogram& other)
+{
+    CaretAssert(other.m_buckets.size() == m_buckets.size() && other.m_bucketMin == m_bucketMin && other.m_bucketMax == m_bucketMax);
+    int numBuckets = (int)m_buckets.size();
+    for (int i = 0; i < numBuckets; ++i)
+    {
+        m_buckets[i] += other.m_buckets[i];
+    }
+    m_posCount += other.m_posCount;
+    m_zeroCount += other.m_zeroCount;
+    m_negCount += other.m_negCount;
+    m_infCount += other.m_infCount;
+    m_negInfCount += other.m_negInfCount;
+    m_nanCount += other.m_nanCount;
+}
+
+void Histogram::finishAccumulation(const int64_t& infCount, const int64_t& negInfCount, const int64_t& nanCount)
+{
+    m_infCount += infCount;
+    m_negInfCount += negInfCount;
+    m_nanCount += nanCount;
+    if (!(m_bucketMax > m_bucketMin))
+    {
+        splitEvenly(m_posCount + m_zeroCount + m_negCount);//display is already zeroed
+        return;
     }
     computeCumulative();
+    int numBuckets = (int)m_buckets.size();
     m_displayHeightMax = 0.0;
     for (int i = 0; i < numBuckets; ++i)
     {//compute display values by normalizing by bucket size
-        m_display[i] = m_buckets[i] / bucketsize;
+        m_display[i] = m_buckets[i] / m_bucketSize;
         if (m_display[i] > m_displayHeightMax) {
             m_displayHeightMax = m_display[i];
         }
     }
 }
 
+void Histogram::splitEvenly(const int64_t& totalCount)
+{
+    int numBuckets = (int)m_buckets.size();
+    for (int i = 0; i < numBuckets - 1; ++i)
+    {
+        m_cumulative[i] = (i + 1) * totalCount / numBuckets;//so, its not particularly useful if our range is zero, but split them evenly among buckets just for kicks
+        if (i == 0)
+        {
+            m_buckets[i] = m_cumulative[i];
+        } else {
+            m_buckets[i] = m_cumulative[i] - m_cumulative[i - 1];
+        }
+    }
+    m_cumulative[numBuckets - 1] = totalCount;//make sure the last one has all of them
+    if (numBuckets > 1)
+    {
+        m_buckets[numBuckets - 1] = m_cumulative[numBuckets - 1] - m_cumulative[numBuckets - 2];
+    } else {
+        m_buckets[numBuckets - 1] = m_cumulative[numBuckets - 1];
+    }
+}
+
 void Histogram::computeCumulative()
 {
     int numBuckets = (int)m_buckets.size();
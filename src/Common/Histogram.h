@@ -31,7 +31,7 @@ namespace caret
     {
         std::vector<int64_t> m_buckets, m_cumulative;
         std::vector<float> m_display;
-        float m_bucketMin, m_bucketMax;
+        float m_bucketMin, m_bucketMax, m_bucketSize;
         float m_displayHeightMax;
         
         ///counts of each class of number
@@ -43,6 +43,8 @@ namespace caret
         
         void computeCumulative();
         
+        void splitEvenly(const int64_t& totalCount);
+        
         void update(const float* data,
                     const int64_t& dataCount,
                     float mostPositiveValueInclusive,
@@ -71,6 +73,33 @@ namespace caret
                     float mostNegativeValueInclusive,
                     const bool& includeZeroValues);
         
+        ///for building a histogram in pieces, such as one per thread: begin with the range, add finite values, merge pieces with identical ranges, then finish
+        void beginAccumulation(const int& numBuckets, const float& bucketMin, const float& bucketMax);
+        
+        void addValue(const float& value)
+        {
+            if (value == 0.0f)
+            {
+                ++m_zeroCount;
+            } else if (value < 0.0f) {
+                ++m_negCount;
+            } else {
+                ++m_posCount;
+            }
+            if (m_bucketMax > m_bucketMin)
+            {
+                int bucket = (int)((value - m_bucketMin) / m_bucketSize);//doesn't really matter whether small negative floats truncate to a 0 integer
+                if (bucket < 0) bucket = 0;//because of this
+                if (bucket >= (int)m_buckets.size()) bucket = (int)m_buckets.size() - 1;
+                ++m_buckets[bucket];
+            }
+        }
+        
+        void mergeAccumulation(const Histogram& other);
+        
+        ///compute cumulative and display values, and set the counts of nonnumeric values that were excluded
+        void finishAccumulation(const int64_t& infCount = 0, const int64_t& negInfCount = 0, const int64_t& nanCount = 0);
+        
         ///get raw counts (useful mathematically)
         const std::vector<int64_t>& getHistogramCounts() const { return m_buckets; }
         
@@ -131,14 +131,14 @@ float ReductionOperation::reduce(const float* data, const int64_t& numElems, con
         }
         case ReductionEnum::MEDIAN:
         {
-            vector<float> dataCopy(numElems);
-            for (int64_t i = 0; i < numElems; ++i) dataCopy[i] = data[i];
-            sort(dataCopy.begin(), dataCopy.end());
+            vector<float> dataCopy(data, data + numElems);
+            const int64_t half = numElems / 2;
+            nth_element(dataCopy.begin(), dataCopy.begin() + half, dataCopy.end());//linear time, we don't need the whole order
             if ((numElems & 1) == 0)//if even, average middle two
             {
-                return (dataCopy[numElems / 2 - 1] + dataCopy[numElems / 2]) / 2.0f;
+                return (*max_element(dataCopy.begin(), dataCopy.begin() + half) + dataCopy[half]) / 2.0f;//nth_element puts everything smaller before the center
             } else {
-                return dataCopy[numElems / 2];//otherwise, take the center
+                return dataCopy[half];//otherwise, take the center
             }
         }
         case ReductionEnum::MODE:
@@ -538,6 +538,101 @@ float ReductionOperation::reduceWeightedExcludeDev(const float* data, const floa
     return reduceWeighted(excluded.data(), exweights.data(), excluded.size(), type);
 }
 
+float ReductionOperation::percentileInPlace(float* data, const int64_t& numElems, const float& percent)
+{
+    CaretAssert(numElems > 0);
+    CaretAssert(percent >= 0.0f && percent <= 100.0f);
+    const double index = percent / 100.0 * (numElems - 1);
+    if (index <= 0.0) return *min_element(data, data + numElems);
+    if (index >= numElems - 1) return *max_element(data, data + numElems);
+    double ipart;
+    const float fpart = (float)modf(index, &ipart);
+    const int64_t lowIndex = (int64_t)ipart;
+    nth_element(data, data + lowIndex, data + numElems);
+    const float lowVal = data[lowIndex], highVal = *min_element(data + lowIndex + 1, data + numElems);//everything after the nth element is not smaller than it
+    return (1.0f - fpart) * lowVal + fpart * highVal;
+}
+
+bool ReductionAccumulator::isSupported(const ReductionEnum::Enum& type)
+{
+    switch (type)
+    {
+        case ReductionEnum::INVALID:
+        case ReductionEnum::MEDIAN:
+        case ReductionEnum::MODE:
+            return false;
+        default:
+            return true;
+    }
+}
+
+ReductionAccumulator::ReductionAccumulator(const ReductionEnum::Enum& type)
+{
+    m_type = type;
+    m_count = 0;
+    m_maxIndex = -1;
+    m_minIndex = -1;
+    m_nonzero = 0;
+    m_sum = 0.0;
+    m_mean = 0.0;
+    m_resid2 = 0.0;
+    m_product = 1.0;
+    m_max = 0.0f;
+    m_min = 0.0f;
+}
+
+float ReductionAccumulator::getResult() const
+{
+    if (m_count == 0) throw CaretException("reduction requested on no data");
+    switch (m_type)
+    {
+        case ReductionEnum::INVALID:
+            throw CaretException("reduction requested with 'INVALID' method");
+        case ReductionEnum::MEDIAN:
+        case ReductionEnum::MODE:
+            throw CaretException("'" + ReductionEnum::toName(m_type) + "' reduction can't be computed in a single pass");
+        case ReductionEnum::SAMPSTDEV:
+        case ReductionEnum::TSNR:
+        case ReductionEnum::COV:
+            if (m_count < 2) throw CaretException("taking the sample standard deviation of 1 element would require dividing by zero");
+            break;
+        default:
+            break;
+    }
+    switch (m_type)
+    {
+        case ReductionEnum::MAX:
+            return m_max;
+        case ReductionEnum::MIN:
+            return m_min;
+        case ReductionEnum::INDEXMAX:
+            return m_maxIndex + 1;//1-based, to match reduce()
+        case ReductionEnum::INDEXMIN:
+            return m_minIndex + 1;
+        case ReductionEnum::SUM:
+            return m_sum;
+        case ReductionEnum::MEAN:
+            return m_mean;
+        case ReductionEnum::STDEV:
+            return sqrt(m_resid2 / m_count);
+        case ReductionEnum::SAMPSTDEV:
+            return sqrt(m_resid2 / (m_count - 1));
+        case ReductionEnum::VARIANCE:
+            return m_resid2 / m_count;
+        case ReductionEnum::TSNR:
+            return m_mean / sqrt(m_resid2 / (m_count - 1));
+        case ReductionEnum::COV:
+            return sqrt(m_resid2 / (m_count - 1)) / m_mean;
+        case ReductionEnum::PRODUCT:
+            return m_product;
+        case ReductionEnum::COUNT_NONZERO:
+            return m_nonzero;
+        default:
+            CaretAssertMessage(0, "unhandled type in ReductionAccumulator");
+            return 0.0f;
+    }
+}
+
 AString ReductionOperation::getHelpInfo()
 {
     AString ret;
@@ -37,9 +37,39 @@ namespace caret {
         static float reduceWeighted(const float* data, const float* weights, const int64_t& numElems, const ReductionEnum::Enum& type);
         static float reduceWeightedExcludeDev(const float* data, const float* weights, const int64_t& numElems, const ReductionEnum::Enum& type, const float& numDevBelow, const float& numDevAbove);
         static float reduceWeightedOnlyNumeric(const float* data, const float* weights, const int64_t& numElems, const ReductionEnum::Enum& type);
+        ///percentile with linear interpolation, reorders the data (uses nth_element rather than sorting)
+        static float percentileInPlace(float* data, const int64_t& numElems, const float& percent);
         static AString getHelpInfo();
     };
     
+    ///single pass accumulator for the reductions that don't need all the values at once, so huge inputs can be streamed
+    class ReductionAccumulator
+    {
+        ReductionEnum::Enum m_type;
+        int64_t m_count, m_maxIndex, m_minIndex, m_nonzero;
+        double m_sum, m_mean, m_resid2, m_product;//running mean and residual sum of squares use welford's method, for stability
+        float m_max, m_min;
+    public:
+        ///MEDIAN and MODE need all values, so they aren't supported
+        static bool isSupported(const ReductionEnum::Enum& type);
+        ReductionAccumulator(const ReductionEnum::Enum& type = ReductionEnum::INVALID);
+        void addValue(const float& value)
+        {
+            if (m_count == 0 || value > m_max) { m_max = value; m_maxIndex = m_count; }
+            if (m_count == 0 || value < m_min) { m_min = value; m_minIndex = m_count; }
+            ++m_count;
+            if (value != 0.0f) ++m_nonzero;
+            m_sum += value;
+            m_product *= value;
+            double delta = value - m_mean;
+            m_mean += delta / m_count;
+            m_resid2 += delta * (value - m_mean);
+        }
+        int64_t getCount() const { return m_count; }
+        ///throws if there is no data, or SAMPSTDEV and similar on 1 element
+        float getResult() const;
+    };
+    
 }
 
 #endif //__REDUCTION_OPERATION_H__
@@ -23,6 +23,20 @@ inline double sddot (const float *a, const float *b, int n)
     sum += a[k] * b[k];
   return sum;
 }  // sddot()
+//same semantics as the register-blocked version in dot.h: res[4 * i + j] = a[i] dot b[j]
+inline void sddot2x4 (const float *const *a, const float *const *b, int n, double *res)
+{
+  for (int i = 0; i < 8; i++)
+    res[i] = 0;
+  for (int k = 0; k < n; k++)
+  {
+    for (int i = 0; i < 2; i++)
+    {
+      for (int j = 0; j < 4; j++)
+        res[4 * i + j] += a[i][k] * b[j][k];
+    }
+  }
+}  // sddot2x4()
 //copy enum from dot.h
 //renamed to dot_flags in both files for less conflict chance
 typedef enum {
@@ -0,0 +1,483 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <algorithm>
+#include <new>
+
+#include <QThread>
+
+#include "CaretDataFileParallelReader.h"
+
+#include "AnnotationAlignmentEnum.h"
+#include "AnnotationAttributesDefaultTypeEnum.h"
+#include "AnnotationColorBarPositionModeEnum.h"
+#include "AnnotationCoordinateSpaceEnum.h"
+#include "AnnotationDistributeEnum.h"
+#include "AnnotationGroupTypeEnum.h"
+#include "AnnotationGroupingModeEnum.h"
+#include "AnnotationRedoUndoCommandModeEnum.h"
+#include "AnnotationSizingHandleTypeEnum.h"
+#include "AnnotationSurfaceOffsetVectorTypeEnum.h"
+#include "AnnotationTextAlignHorizontalEnum.h"
+#include "AnnotationTextAlignVerticalEnum.h"
+#include "AnnotationTextConnectTypeEnum.h"
+#include "AnnotationTextFontNameEnum.h"
+#include "AnnotationTextFontPointSizeEnum.h"
+#include "AnnotationTextFontSizeTypeEnum.h"
+#include "AnnotationTextOrientationEnum.h"
+#include "AnnotationTypeEnum.h"
+#include "ApplicationTypeEnum.h"
+#include "BackgroundAndForegroundColorsModeEnum.h"
+#include "ByteOrderEnum.h"
+#include "CaretAssert.h"
+#include "CaretColorEnum.h"
+#include "CaretDataFile.h"
+#include "CaretDataFileHelper.h"
+#include "CaretUnitsTypeEnum.h"
+#include "ChartAxisLocationEnum.h"
+#include "ChartAxisTypeEnum.h"
+#include "ChartAxisUnitsEnum.h"
+#include "ChartDataSourceModeEnum.h"
+#include "ChartMatrixLoadingDimensionEnum.h"
+#include "ChartMatrixScaleModeEnum.h"
+#include "ChartOneDataTypeEnum.h"
+#include "ChartSelectionModeEnum.h"
+#include "ChartTwoAxisScaleRangeModeEnum.h"
+#include "ChartTwoDataTypeEnum.h"
+#include "ChartTwoHistogramContentTypeEnum.h"
+#include "ChartTwoLineSeriesContentTypeEnum.h"
+#include "ChartTwoMatrixContentTypeEnum.h"
+#include "ChartTwoMatrixLoadingDimensionEnum.h"
+#include "ChartTwoMatrixTriangularViewingModeEnum.h"
+#include "ChartTwoNumericSubdivisionsModeEnum.h"
+#include "ChartingVersionEnum.h"
+#include "CiftiParcelColoringModeEnum.h"
+#include "DataFileException.h"
+#include "DataFileTypeEnum.h"
+#include "DeveloperFlagsEnum.h"
+#include "DisplayGroupEnum.h"
+#include "EventTypeEnum.h"
+#include "FiberOrientationColoringTypeEnum.h"
+#include "FiberTrajectoryDisplayModeEnum.h"
+#include "GiftiArrayIndexingOrderEnum.h"
+#include "GiftiEncodingEnum.h"
+#include "GiftiEndianEnum.h"
+#include "GroupAndNameCheckStateEnum.h"
+#include "ImageCaptureDimensionsModeEnum.h"
+#include "ImageCaptureMethodEnum.h"
+#include "ImageResolutionUnitsEnum.h"
+#include "ImageSpatialUnitsEnum.h"
+#include "LabelDrawingTypeEnum.h"
+#include "LogLevelEnum.h"
+#include "MapYokingGroupEnum.h"
+#include "MathFunctionEnum.h"
+#include "NiftiEnums.h"
+#include "NumericFormatModeEnum.h"
+#include "OpenGLDrawingMethodEnum.h"
+#include "PaletteColorBarValuesModeEnum.h"
+#include "PaletteEnums.h"
+#include "PaletteHistogramRangeModeEnum.h"
+#include "PaletteNormalizationModeEnum.h"
+#include "PaletteThresholdRangeModeEnum.h"
+#include "ReductionEnum.h"
+#include "SceneObjectDataTypeEnum.h"
+#include "SceneTypeEnum.h"
+#include "SpecFileDialogViewFilesTypeEnum.h"
+#include "SpeciesEnum.h"
+#include "StereotaxicSpaceEnum.h"
+#include "StructureEnum.h"
+#include "SurfaceResamplingMethodEnum.h"
+#include "SurfaceTypeEnum.h"
+#include "TriStateSelectionStatusEnum.h"
+#include "VolumeEditingModeEnum.h"
+#include "VolumeSliceProjectionTypeEnum.h"
+#include "VolumeSliceViewPlaneEnum.h"
+#include "WorkbenchSpecialVersionEnum.h"
+#include "YokingGroupEnum.h"
+
+using namespace caret;
+
+namespace {
+    /*
+     * Enumerated types fill their lookup tables on first use, which
+     * is not thread safe, so any enum that readFile() may use has to
+     * be initialized before the reader threads start.
+     */
+    template <class T>
+    void initializeEnum()
+    {
+        bool validFlag = false;
+        T::fromName("", &validFlag);
+    }
+    
+    void initializeEnumsUsedByReaders()
+    {
+        initializeEnum<AnnotationAlignmentEnum>();
+        initializeEnum<AnnotationAttributesDefaultTypeEnum>();
+        initializeEnum<AnnotationColorBarPositionModeEnum>();
+        initializeEnum<AnnotationCoordinateSpaceEnum>();
+        initializeEnum<AnnotationDistributeEnum>();
+        initializeEnum<AnnotationGroupTypeEnum>();
+        initializeEnum<AnnotationGroupingModeEnum>();
+        initializeEnum<AnnotationRedoUndoCommandModeEnum>();
+        initializeEnum<AnnotationSizingHandleTypeEnum>();
+        initializeEnum<AnnotationSurfaceOffsetVectorTypeEnum>();
+        initializeEnum<AnnotationTextAlignHorizontalEnum>();
+        initializeEnum<AnnotationTextAlignVerticalEnum>();
+        initializeEnum<AnnotationTextConnectTypeEnum>();
+        initializeEnum<AnnotationTextFontNameEnum>();
+        initializeEnum<AnnotationTextFontPointSizeEnum>();
+        initializeEnum<AnnotationTextFontSizeTypeEnum>();
+        initializeEnum<AnnotationTextOrientationEnum>();
+        initializeEnum<AnnotationTypeEnum>();
+        initializeEnum<ApplicationTypeEnum>();
+        initializeEnum<BackgroundAndForegroundColorsModeEnum>();
+        initializeEnum<ByteOrderEnum>();
+        initializeEnum<CaretColorEnum>();
+        initializeEnum<CaretUnitsTypeEnum>();
+        initializeEnum<ChartAxisLocationEnum>();
+        initializeEnum<ChartAxisTypeEnum>();
+        initializeEnum<ChartAxisUnitsEnum>();
+        initializeEnum<ChartDataSourceModeEnum>();
+        initializeEnum<ChartMatrixLoadingDimensionEnum>();
+        initializeEnum<ChartMatrixScaleModeEnum>();
+        initializeEnum<ChartOneDataTypeEnum>();
+        initializeEnum<ChartSelectionModeEnum>();
+        initializeEnum<ChartTwoAxisScaleRangeModeEnum>();
+        initializeEnum<ChartTwoDataTypeEnum>();
+        initializeEnum<ChartTwoHistogramContentTypeEnum>();
+        initializeEnum<ChartTwoLineSeriesContentTypeEnum>();
+        initializeEnum<ChartTwoMatrixContentTypeEnum>();
+        initializeEnum<ChartTwoMatrixLoadingDimensionEnum>();
+        initializeEnum<ChartTwoMatrixTriangularViewingModeEnum>();
+        initializeEnum<ChartTwoNumericSubdivisionsModeEnum>();
+        initializeEnum<ChartingVersionEnum>();
+        initializeEnum<CiftiParcelColoringModeEnum>();
+        initializeEnum<DataFileTypeEnum>();
+        initializeEnum<DeveloperFlagsEnum>();
+        initializeEnum<DisplayGroupEnum>();
+        initializeEnum<EventTypeEnum>();
+        initializeEnum<FiberOrientationColoringTypeEnum>();
+        initializeEnum<FiberTrajectoryDisplayModeEnum>();
+        initializeEnum<GiftiArrayIndexingOrderEnum>();
+        initializeEnum<GiftiEncodingEnum>();
+        initializeEnum<GiftiEndianEnum>();
+        initializeEnum<GroupAndNameCheckStateEnum>();
+        initializeEnum<ImageCaptureDimensionsModeEnum>();
+        initializeEnum<ImageCaptureMethodEnum>();
+        initializeEnum<ImageResolutionUnitsEnum>();
+        initializeEnum<ImageSpatialUnitsEnum>();
+        initializeEnum<LabelDrawingTypeEnum>();
+        initializeEnum<LogLevelEnum>();
+        initializeEnum<MapYokingGroupEnum>();
+        initializeEnum<MathFunctionEnum>();
+        initializeEnum<NiftiDataTypeEnum>();
+        initializeEnum<NiftiIntentEnum>();
+        initializeEnum<NiftiSpacingUnitsEnum>();
+        initializeEnum<NiftiTimeUnitsEnum>();
+        initializeEnum<NiftiTransformEnum>();
+        initializeEnum<NiftiVersionEnum>();
+        initializeEnum<NumericFormatModeEnum>();
+        initializeEnum<OpenGLDrawingMethodEnum>();
+        initializeEnum<PaletteColorBarValuesModeEnum>();
+        initializeEnum<PaletteHistogramRangeModeEnum>();
+        initializeEnum<PaletteNormalizationModeEnum>();
+        initializeEnum<PaletteScaleModeEnum>();
+        initializeEnum<PaletteThresholdRangeModeEnum>();
+        initializeEnum<PaletteThresholdTestEnum>();
+        initializeEnum<PaletteThresholdTypeEnum>();
+        initializeEnum<ReductionEnum>();
+        initializeEnum<SceneObjectDataTypeEnum>();
+        initializeEnum<SceneTypeEnum>();
+        initializeEnum<SecondarySurfaceTypeEnum>();
+        initializeEnum<SpecFileDialogViewFilesTypeEnum>();
+        initializeEnum<SpeciesEnum>();
+        initializeEnum<StereotaxicSpaceEnum>();
+        initializeEnum<StructureEnum>();
+        initializeEnum<SurfaceResamplingMethodEnum>();
+        initializeEnum<SurfaceTypeEnum>();
+        initializeEnum<TriStateSelectionStatusEnum>();
+        initializeEnum<VolumeEditingModeEnum>();
+        initializeEnum<VolumeSliceProjectionTypeEnum>();
+        initializeEnum<VolumeSliceViewPlaneEnum>();
+        initializeEnum<WorkbenchSpecialVersionEnum>();
+        initializeEnum<YokingGroupEnum>();
+    }
+}
+
+
+    
+/**
+ * \class caret::CaretDataFileParallelReader 
+ * \brief Reads the content of several data files concurrently.
+ * \ingroup Files
+ *
+ * The caller creates the files on its own thread (some file constructors
+ * register for events) and only readFile() runs in the worker threads.
+ * The caller polls with waitForFilesRead() so that any progress events
+ * are sent from the caller's thread, never from a worker.
+ */
+
+/**
+ * Runs readFile() for files taken from the reader's list until none remain.
+ */
+class CaretDataFileParallelReader::ReaderThread : public QThread
+{
+public:
+    ReaderThread(CaretDataFileParallelReader* reader) {
+        m_reader = reader;
+    }
+    void run() {
+        m_reader->readFilesInThread();
+    }
+    
+    CaretDataFileParallelReader* m_reader;
+};
+
+/**
+ * Constructor.
+ */
+CaretDataFileParallelReader::CaretDataFileParallelReader()
+{
+    m_nextFileIndex     = 0;
+    m_numberOfFilesRead = 0;
+    m_cancelledFlag     = false;
+}
+
+/**
+ * Destructor.  Waits for any reading in progress and deletes
+ * all files that were not taken with takeFile().
+ */
+CaretDataFileParallelReader::~CaretDataFileParallelReader()
+{
+    cancel();
+    for (std::vector<FileEntry>::iterator iter = m_files.begin();
+         iter != m_files.end();
+         iter++) {
+        delete iter->m_caretDataFile;
+    }
+}
+
+/**
+ * Add a file for reading.  Must be called before start().
+ *
+ * @param caretDataFile
+ *    File whose content is read.  This reader takes ownership until
+ *    the file is taken with takeFile().
+ * @param filename
+ *    Name of the file to read.
+ * @return
+ *    Index of the file for use with takeFile().
+ */
+int32_t
+CaretDataFileParallelReader::addFile(CaretDataFile* caretDataFile,
+                                     const AString& filename)
+{
+    CaretAssert(caretDataFile);
+    CaretAssert(m_threads.empty());
+    FileEntry entry;
+    entry.m_caretDataFile = caretDataFile;
+    entry.m_filename      = filename;
+    entry.m_errorFlag     = false;
+    entry.m_readFlag      = false;
+    m_files.push_back(entry);
+    return static_cast<int32_t>(m_files.size() - 1);
+}
+
+/**
+ * @return Number of files added for reading.
+ */
+int32_t
+CaretDataFileParallelReader::getNumberOfFiles() const
+{
+    return static_cast<int32_t>(m_files.size());
+}
+
+/**
+ * Start reading the files with one thread per core, but no more
+ * threads than files.  Enumerated types are initialized here, on
+ * the caller's thread, before any reader thread can use them.
+ */
+void
+CaretDataFileParallelReader::start()
+{
+    CaretAssert(m_threads.empty());
+    initializeEnumsUsedByReaders();
+    const int32_t numThreads = std::min(std::max(QThread::idealThreadCount(), 1),
+                                        getNumberOfFiles());
+    for (int32_t i = 0; i < numThreads; i++) {
+        ReaderThread* thread = new ReaderThread(this);
+        m_threads.push_back(thread);
+        thread->start();
+    }
+}
+
+/**
+ * Wait until at least one more file finishes reading, all files are read,
+ * or the time expires.
+ *
+ * @param milliseconds
+ *    Maximum time to wait.
+ * @param numberOfFilesReadOut
+ *    Output with number of files that have finished reading (successfully or not).
+ * @return
+ *    True if all files have finished reading.
+ */
+bool
+CaretDataFileParallelReader::waitForFilesRead(const unsigned long milliseconds,
+                                              int32_t& numberOfFilesReadOut)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_numberOfFilesRead < getNumberOfFiles()) {
+        m_fileReadCondition.wait(&m_mutex,
+                                 milliseconds);
+    }
+    numberOfFilesReadOut = m_numberOfFilesRead;
+    const bool allReadFlag = (m_numberOfFilesRead >= getNumberOfFiles());
+    locker.unlock();
+    
+    if (allReadFlag) {
+        waitForThreads();
+    }
+    return allReadFlag;
+}
+
+/**
+ * Stop reading files that have not been started and wait for
+ * files that are being read.
+ */
+void
+CaretDataFileParallelReader::cancel()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_cancelledFlag = true;
+    }
+    waitForThreads();
+}
+
+/**
+ * Take a file after it has been read.  Caller takes ownership of the file.
+ *
+ * @param fileIndex
+ *    Index of file returned by addFile().
+ * @return
+ *    The file that was read.
+ * @throws DataFileException
+ *    If the file was not read or there was an error reading the file
+ *    (the file is deleted).
+ */
+CaretDataFile*
+CaretDataFileParallelReader::takeFile(const int32_t fileIndex)
+{
+    CaretAssertVectorIndex(m_files, fileIndex);
+    FileEntry& entry = m_files[fileIndex];
+    CaretDataFile* caretDataFile = entry.m_caretDataFile;
+    entry.m_caretDataFile = NULL;
+    
+    if (( ! entry.m_readFlag)
+        || entry.m_errorFlag) {
+        delete caretDataFile;
+        if (entry.m_errorFlag) {
+            throw entry.m_exception;
+        }
+        throw DataFileException(entry.m_filename,
+                                "File was not read.");
+    }
+    
+    return caretDataFile;
+}
+
+/**
+ * Called by the reader threads.  Reads files until none remain or reading is cancelled.
+ */
+void
+CaretDataFileParallelReader::readFilesInThread()
+{
+    while (true) {
+        int32_t fileIndex = -1;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_cancelledFlag
+                || (m_nextFileIndex >= getNumberOfFiles())) {
+                return;
+            }
+            fileIndex = m_nextFileIndex;
+            m_nextFileIndex++;
+        }
+        
+        /*
+         * Entries are not resized while threads run, and each entry
+         * is only accessed by the thread that took its index.
+         */
+        FileEntry& entry = m_files[fileIndex];
+        DataFileException dataFileException;
+        bool errorFlag = false;
+        try {
+            entry.m_caretDataFile->readFile(entry.m_filename);
+        }
+        catch (const std::bad_alloc&) {
+            dataFileException = DataFileException(entry.m_filename,
+                                                  CaretDataFileHelper::createBadAllocExceptionMessage(entry.m_filename));
+            errorFlag = true;
+        }
+        catch (const DataFileException& dfe) {
+            dataFileException = dfe;
+            errorFlag = true;
+        }
+        catch (const CaretException& ce) {
+            dataFileException = DataFileException(entry.m_filename,
+                                                  ce.whatString());
+            errorFlag = true;
+        }
+        catch (const std::exception& e) {
+            dataFileException = DataFileException(entry.m_filename,
+                                                  AString("Exception while reading file: ") + e.what());
+            errorFlag = true;
+        }
+        catch (...) {
+            dataFileException = DataFileException(entry.m_filename,
+                                                  "Unknown exception while reading file.");
+            errorFlag = true;
+        }
+        
+        QMutexLocker locker(&m_mutex);
+        entry.m_exception = dataFileException;
+        entry.m_errorFlag = errorFlag;
+        entry.m_readFlag = true;
+        m_numberOfFilesRead++;
+        m_fileReadCondition.wakeAll();
+    }
+}
+
+/**
+ * Wait for all reader threads to finish and delete them.
+ */
+void
+CaretDataFileParallelReader::waitForThreads()
+{
+    for (std::vector<ReaderThread*>::iterator iter = m_threads.begin();
+         iter != m_threads.end();
+         iter++) {
+        (*iter)->wait();
+        delete *iter;
+    }
+    m_threads.clear();
+}
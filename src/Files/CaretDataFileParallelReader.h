@@ -0,0 +1,96 @@
+#ifndef __CARET_DATA_FILE_PARALLEL_READER_H__
+#define __CARET_DATA_FILE_PARALLEL_READER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include <vector>
+
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "DataFileException.h"
+
+namespace caret {
+
+    class CaretDataFile;
+    
+    class CaretDataFileParallelReader {
+        
+    public:
+        CaretDataFileParallelReader();
+        
+        ~CaretDataFileParallelReader();
+        
+        int32_t addFile(CaretDataFile* caretDataFile,
+                        const AString& filename);
+        
+        int32_t getNumberOfFiles() const;
+        
+        void start();
+        
+        bool waitForFilesRead(const unsigned long milliseconds,
+                              int32_t& numberOfFilesReadOut);
+        
+        void cancel();
+        
+        CaretDataFile* takeFile(const int32_t fileIndex);
+        
+    private:
+        CaretDataFileParallelReader(const CaretDataFileParallelReader&);
+
+        CaretDataFileParallelReader& operator=(const CaretDataFileParallelReader&);
+        
+        class ReaderThread;
+        
+        struct FileEntry {
+            CaretDataFile* m_caretDataFile;
+            AString m_filename;
+            DataFileException m_exception;
+            bool m_errorFlag;
+            bool m_readFlag;
+        };
+        
+        void readFilesInThread();
+        
+        void waitForThreads();
+        
+        std::vector<FileEntry> m_files;
+        
+        std::vector<ReaderThread*> m_threads;
+        
+        /** protects the members below, which are shared with the reader threads */
+        QMutex m_mutex;
+        
+        /** signaled each time a file finishes reading */
+        QWaitCondition m_fileReadCondition;
+        
+        int32_t m_nextFileIndex;
+        
+        int32_t m_numberOfFilesRead;
+        
+        bool m_cancelledFlag;
+        
+        // ADD_NEW_MEMBERS_HERE
+
+    };
+    
+} // namespace
+#endif  //__CARET_DATA_FILE_PARALLEL_READER_H__
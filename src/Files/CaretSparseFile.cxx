@@ -28,10 +28,83 @@
 
 #include <QByteArray>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
 using namespace caret;
 using namespace std;
 
 const char magic[] = "\0\0\0\0cst\0";
+const char magicV2[] = "\0\0\0\0cst\2";
+
+namespace
+{
+    const int64_t V2_HEADER_BYTES = 8 + 3 * sizeof(int64_t);//magic, dimensions, row index offset
+    const int64_t V2_ROWS_PER_BLOCK = 64;//row offsets are stored relative to the start of their block of rows
+    
+    ///number of bytes needed to store the value, one of 0, 1, 2, 4
+    int planeWidth(const uint32_t& maxValue)
+    {
+        if (maxValue == 0) return 0;
+        if (maxValue < (1u << 8)) return 1;
+        if (maxValue < (1u << 16)) return 2;
+        return 4;
+    }
+    
+    void appendVarint(vector<uint8_t>& bytes, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            bytes.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back((uint8_t)value);
+    }
+    
+    ///returns false if the varint is malformed or runs past the end
+    bool readVarint(const uint8_t*& ptr, const uint8_t* end, uint64_t& valueOut)
+    {
+        valueOut = 0;
+        for (int shift = 0; shift < 64 && ptr < end; shift += 7)
+        {
+            uint8_t byte = *ptr;
+            ++ptr;
+            valueOut |= ((uint64_t)(byte & 0x7F)) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    }
+    
+    void appendPlane(vector<uint8_t>& bytes, const vector<int64_t>& values, const int& width, const int& shift)
+    {
+        if (width == 0) return;
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            uint32_t part = (uint32_t)(((uint64_t)values[i]) >> shift);
+            for (int b = 0; b < width; ++b)
+            {
+                bytes.push_back((uint8_t)(part >> (8 * b)));
+            }
+        }
+    }
+    
+    ///little endian unsigned value of the given width, assembled bytewise so it doesn't depend on system byte order
+    inline uint32_t readPlaneValue(const uint8_t* ptr, const int& width)
+    {
+        switch (width)
+        {
+            case 1:
+                return ptr[0];
+            case 2:
+                return ptr[0] | ((uint32_t)ptr[1] << 8);
+            case 4:
+                return ptr[0] | ((uint32_t)ptr[1] << 8) | ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[3] << 24);
+            default:
+                return 0;
+        }
+    }
+}
 
 CaretSparseFile::CaretSparseFile(const AString& fileName)
 {
@@ -49,9 +122,13 @@ void CaretSparseFile::readFile(const AString& filename)
     FileInformation fileInfo(filename);//useful later for file size, but create it now to reduce the amount of time between file open and size check
     char buf[8];
     m_file.read(buf, 8);
-    for (int i = 0; i < 8; ++i)
+    if (memcmp(buf, magic, 8) == 0)
     {
-        if (buf[i] != magic[i]) throw DataFileException("file has the wrong magic string");
+        m_version = 1;
+    } else if (memcmp(buf, magicV2, 8) == 0) {
+        m_version = 2;
+    } else {
+        throw DataFileException("file has the wrong magic string");
     }
     m_file.read(m_dims, 2 * sizeof(int64_t));
     if (ByteOrderEnum::isSystemBigEndian())
@@ -59,21 +136,50 @@ void CaretSparseFile::readFile(const AString& filename)
         ByteSwapping::swapBytes(m_dims, 2);
     }
     if (m_dims[0] < 1 || m_dims[1] < 1) throw DataFileException("both dimensions must be positive");
-    m_indexArray.resize(m_dims[1] + 1);
-    vector<int64_t> lengthArray(m_dims[1]);
-    m_file.read(lengthArray.data(), m_dims[1] * sizeof(int64_t));
-    if (ByteOrderEnum::isSystemBigEndian())
-    {
-        ByteSwapping::swapBytes(lengthArray.data(), m_dims[1]);
-    }
-    m_indexArray[0] = 0;
-    for (int64_t i = 0; i < m_dims[1]; ++i)
-    {
-        if (lengthArray[i] > m_dims[0] || lengthArray[i] < 0) throw DataFileException("impossible value found in length array");
-        m_indexArray[i + 1] = m_indexArray[i] + lengthArray[i];
+    int64_t xml_offset = -1;
+    if (m_version == 2)
+    {//only the block offsets are read now, the row offsets within a block are read when a row in it is first needed
+        m_file.read(&m_rowIndexOffset, sizeof(int64_t));
+        if (ByteOrderEnum::isSystemBigEndian())
+        {
+            ByteSwapping::swapBytes(&m_rowIndexOffset, 1);
+        }
+        int64_t numBlocks = (m_dims[1] + V2_ROWS_PER_BLOCK - 1) / V2_ROWS_PER_BLOCK;
+        if (m_rowIndexOffset < V2_HEADER_BYTES || m_rowIndexOffset + numBlocks * (int64_t)sizeof(uint64_t) > fileInfo.size()) throw DataFileException("file is truncated");
+        m_blockOffsets.resize(numBlocks + 1);
+        m_file.seek(m_rowIndexOffset);
+        m_file.read(m_blockOffsets.data(), numBlocks * sizeof(uint64_t));
+        if (ByteOrderEnum::isSystemBigEndian())
+        {
+            ByteSwapping::swapBytes(m_blockOffsets.data(), numBlocks);
+        }
+        m_blockOffsets[numBlocks] = m_rowIndexOffset;//end of the last block
+        for (int64_t i = 0; i < numBlocks; ++i)
+        {
+            if (m_blockOffsets[i] < (uint64_t)V2_HEADER_BYTES || m_blockOffsets[i] > m_blockOffsets[i + 1]) throw DataFileException("impossible value found in row index");
+        }
+        m_rowOffsets.clear();
+        m_rowOffsets.resize(m_dims[1]);
+        m_blockLoaded.clear();
+        m_blockLoaded.resize(numBlocks, 0);
+        xml_offset = m_rowIndexOffset + numBlocks * sizeof(uint64_t) + m_dims[1] * sizeof(uint32_t);
+    } else {
+        m_indexArray.resize(m_dims[1] + 1);
+        vector<int64_t> lengthArray(m_dims[1]);
+        m_file.read(lengthArray.data(), m_dims[1] * sizeof(int64_t));
+        if (ByteOrderEnum::isSystemBigEndian())
+        {
+            ByteSwapping::swapBytes(lengthArray.data(), m_dims[1]);
+        }
+        m_indexArray[0] = 0;
+        for (int64_t i = 0; i < m_dims[1]; ++i)
+        {
+            if (lengthArray[i] > m_dims[0] || lengthArray[i] < 0) throw DataFileException("impossible value found in length array");
+            m_indexArray[i + 1] = m_indexArray[i] + lengthArray[i];
+        }
+        m_valuesOffset = 8 + 2 * sizeof(int64_t) + m_dims[1] * sizeof(int64_t);
+        xml_offset = m_valuesOffset + m_indexArray[m_dims[1]] * 2 * sizeof(int64_t);
     }
-    m_valuesOffset = 8 + 2 * sizeof(int64_t) + m_dims[1] * sizeof(int64_t);
-    int64_t xml_offset = m_valuesOffset + m_indexArray[m_dims[1]] * 2 * sizeof(int64_t);
     if (xml_offset >= fileInfo.size()) throw DataFileException("file is truncated");
     int64_t xml_length = fileInfo.size() - xml_offset;
     if (xml_length < 1) throw DataFileException("file is truncated");
@@ -100,9 +206,104 @@ CaretSparseFile::~CaretSparseFile()
 {
 }
 
+void CaretSparseFile::getRowRangeV2(const int64_t& index, int64_t& startOut, int64_t& endOut)
+{
+    int64_t block = index / V2_ROWS_PER_BLOCK, blockStart = block * V2_ROWS_PER_BLOCK;
+    if (!m_blockLoaded[block])
+    {
+        int64_t numRows = min(V2_ROWS_PER_BLOCK, m_dims[1] - blockStart);
+        int64_t numBlocks = m_blockLoaded.size();
+        m_file.seek(m_rowIndexOffset + numBlocks * sizeof(uint64_t) + blockStart * sizeof(uint32_t));
+        m_file.read(m_rowOffsets.data() + blockStart, numRows * sizeof(uint32_t));
+        if (ByteOrderEnum::isSystemBigEndian())
+        {
+            ByteSwapping::swapBytes(m_rowOffsets.data() + blockStart, numRows);
+        }
+        m_blockLoaded[block] = 1;
+    }
+    startOut = m_blockOffsets[block] + m_rowOffsets[index];
+    if (index + 1 < blockStart + V2_ROWS_PER_BLOCK && index + 1 < m_dims[1])
+    {
+        endOut = m_blockOffsets[block] + m_rowOffsets[index + 1];
+    } else {
+        endOut = m_blockOffsets[block + 1];
+    }
+    if (startOut > endOut || endOut > m_rowIndexOffset) throw DataFileException("impossible value found in row index");
+}
+
+void CaretSparseFile::readRowSparseV2(const int64_t& index, vector<int64_t>& indicesOut, vector<int64_t>& valuesOut)
+{
+    int64_t start, end;
+    getRowRangeV2(index, start, end);
+    m_scratchBytes.resize(end - start);
+    m_file.seek(start);
+    m_file.read(m_scratchBytes.data(), end - start);
+    const uint8_t* ptr = m_scratchBytes.data(), *recordEnd = ptr + (end - start);
+    uint64_t numNonzero;
+    if (!readVarint(ptr, recordEnd, numNonzero) || numNonzero > (uint64_t)m_dims[0]) throw DataFileException("impossible row length found in file");
+    indicesOut.resize(numNonzero);
+    valuesOut.resize(numNonzero);
+    if (numNonzero == 0) return;
+    if (ptr >= recordEnd) throw DataFileException("file is truncated");
+    const int lowWidth = *ptr & 0xF, highWidth = *ptr >> 4;
+    ++ptr;
+    if (lowWidth == 3 || lowWidth > 4 || highWidth == 3 || highWidth > 4) throw DataFileException("impossible value encoding found in file");
+    int64_t curIndex = -1, i = 0;
+    const int64_t count = numNonzero;
+    while (i < count)
+    {//indices are stored as the gap from the previous index, in 7 bit groups
+        if (count - i >= 8 && recordEnd - ptr >= 8)
+        {//whole word test for the common case of 8 gaps below 128, one byte each
+            uint64_t word;
+            memcpy(&word, ptr, 8);
+            if ((word & 0x8080808080808080ULL) == 0)
+            {
+                for (int k = 0; k < 8; ++k)
+                {
+                    curIndex += ptr[k] + 1;
+                    indicesOut[i + k] = curIndex;
+                }
+                ptr += 8;
+                i += 8;
+                continue;
+            }
+        }
+        uint64_t gap;
+        if (!readVarint(ptr, recordEnd, gap) || gap >= (uint64_t)m_dims[0]) throw DataFileException("impossible index value found in file");
+        curIndex += gap + 1;
+        indicesOut[i] = curIndex;
+        ++i;
+    }
+    if (curIndex >= m_dims[0]) throw DataFileException("impossible index value found in file");
+    if (recordEnd - ptr != (int64_t)(count * (lowWidth + highWidth))) throw DataFileException("row data has the wrong size");
+    const uint8_t* highPtr = ptr + count * lowWidth;
+    for (int64_t j = 0; j < count; ++j)
+    {
+        uint64_t value = readPlaneValue(ptr + j * lowWidth, lowWidth);
+        if (highWidth != 0)
+        {
+            value |= ((uint64_t)readPlaneValue(highPtr + j * highWidth, highWidth)) << 32;
+        }
+        valuesOut[j] = (int64_t)value;
+    }
+}
+
 void CaretSparseFile::getRow(const int64_t& index, int64_t* rowOut)
 {
     CaretAssert(index >= 0 && index < m_dims[1]);
+    if (m_version == 2)
+    {
+        readRowSparseV2(index, m_scratchIndices, m_scratchArray);
+        for (int64_t i = 0; i < m_dims[0]; ++i)
+        {
+            rowOut[i] = 0;
+        }
+        for (size_t i = 0; i < m_scratchIndices.size(); ++i)
+        {
+            rowOut[m_scratchIndices[i]] = m_scratchArray[i];
+        }
+        return;
+    }
     int64_t start = m_indexArray[index], end = m_indexArray[index + 1];
     int64_t numToRead = (end - start) * 2;
     m_scratchArray.resize(numToRead);
@@ -135,6 +336,11 @@ void CaretSparseFile::getRow(const int64_t& index, int64_t* rowOut)
 void CaretSparseFile::getRowSparse(const int64_t& index, vector<int64_t>& indicesOut, vector<int64_t>& valuesOut)
 {
     CaretAssert(index >= 0 && index < m_dims[1]);
+    if (m_version == 2)
+    {
+        readRowSparseV2(index, indicesOut, valuesOut);
+        return;
+    }
     int64_t start = m_indexArray[index], end = m_indexArray[index + 1];
     int64_t numToRead = (end - start) * 2, numNonzero = end - start;
     m_scratchArray.resize(numToRead);
@@ -206,8 +412,10 @@ void FiberFractions::zero()
     distance = 0.0f;
 }
 
-CaretSparseFileWriter::CaretSparseFileWriter(const AString& fileName, const CiftiXML& xml)
+CaretSparseFileWriter::CaretSparseFileWriter(const AString& fileName, const CiftiXML& xml, const int32_t& version)
 {
+    if (version != 1 && version != 2) throw DataFileException("unsupported wbsparse version: " + AString::number(version));
+    m_version = version;
     if (!fileName.endsWith(".trajTEMP.wbsparse"))
     {//for now (and maybe forever), this format is single-purpose
         CaretLogWarning("sparse trajectory file '" + fileName + "' should be saved ending in .trajTEMP.wbsparse");
@@ -223,47 +431,82 @@ CaretSparseFileWriter::CaretSparseFileWriter(const AString& fileName, const Cift
         throw DataFileException("wbsparse files cannot be written compressed");
     }//because after we finish writing the data, we have to come back and write the lengths array
     m_file.open(fileName, CaretBinaryFile::WRITE_TRUNCATE);
-    m_file.write(magic, 8);
     int64_t tempdims[2] = { m_dims[0], m_dims[1] };
     if (ByteOrderEnum::isSystemBigEndian())
     {
         ByteSwapping::swapBytes(tempdims, 2);
     }
+    m_nextRowIndex = 0;
+    if (m_version == 2)
+    {
+        m_file.write(magicV2, 8);
+        m_file.write(tempdims, 2 * sizeof(int64_t));
+        int64_t placeholder = 0;
+        m_file.write(&placeholder, sizeof(int64_t));//row index offset, written by finish()
+        m_nextOffset = V2_HEADER_BYTES;
+        m_rowOffsets.resize(m_dims[1], 0);
+        m_blockOffsets.clear();
+        return;
+    }
+    m_file.write(magic, 8);
     m_file.write(tempdims, 2 * sizeof(int64_t));
     m_lengthArray.resize(m_dims[1], 0);//initialize the memory so that valgrind won't complain
     m_file.write(m_lengthArray.data(), m_dims[1] * sizeof(uint64_t));//write it to get the file to the correct length
-    m_nextRowIndex = 0;
     m_valuesOffset = 8 + 2 * sizeof(int64_t) + m_dims[1] * sizeof(int64_t);
 }
 
 void CaretSparseFileWriter::writeRow(const int64_t& index, const int64_t* row)
 {
-    CaretAssert(index < m_dims[1]);
-    CaretAssert(index >= m_nextRowIndex);
-    while (m_nextRowIndex < index)
-    {
-        m_lengthArray[m_nextRowIndex] = 0;
-        ++m_nextRowIndex;
-    }
-    m_scratchArray.clear();
-    int64_t count = 0;
+    m_scratchIndices.clear();
+    m_scratchValues.clear();
     for (int64_t i = 0; i < m_dims[0]; ++i)
     {
         if (row[i] != 0)
         {
-            m_scratchArray.push_back(i);
-            m_scratchArray.push_back(row[i]);
-            ++count;
+            m_scratchIndices.push_back(i);
+            m_scratchValues.push_back(row[i]);
         }
     }
-    m_lengthArray[index] = count;
-    if (ByteOrderEnum::isSystemBigEndian())
+    writeRowSparse(index, m_scratchIndices, m_scratchValues);
+}
+
+void CaretSparseFileWriter::writeRowRecordV2(const int64_t& index, const vector<int64_t>& indices, const vector<int64_t>& values)
+{
+    if (index % V2_ROWS_PER_BLOCK == 0)
     {
-        ByteSwapping::swapBytes(m_scratchArray.data(), m_scratchArray.size());
+        m_blockOffsets.push_back(m_nextOffset);
     }
-    m_file.write(m_scratchArray.data(), m_scratchArray.size() * sizeof(int64_t));
-    m_nextRowIndex = index + 1;
-    if (m_nextRowIndex == m_dims[1]) finish();
+    int64_t relative = m_nextOffset - (int64_t)m_blockOffsets.back();
+    if (relative > (int64_t)numeric_limits<uint32_t>::max()) throw DataFileException("rows are too large for wbsparse version 2, use version 1");
+    m_rowOffsets[index] = relative;
+    m_scratchBytes.clear();
+    size_t numNonzero = indices.size();
+    appendVarint(m_scratchBytes, numNonzero);
+    if (numNonzero > 0)
+    {
+        uint32_t maxLow = 0, maxHigh = 0;
+        int64_t lastIndex = -1;
+        for (size_t i = 0; i < numNonzero; ++i)
+        {
+            if (indices[i] <= lastIndex || indices[i] >= m_dims[0]) throw DataFileException("indices must be sorted when writing sparse rows");
+            uint64_t value = values[i];
+            maxLow = max(maxLow, (uint32_t)value);
+            maxHigh = max(maxHigh, (uint32_t)(value >> 32));
+            lastIndex = indices[i];
+        }
+        const int lowWidth = planeWidth(maxLow), highWidth = planeWidth(maxHigh);
+        m_scratchBytes.push_back((uint8_t)(lowWidth | (highWidth << 4)));
+        lastIndex = -1;
+        for (size_t i = 0; i < numNonzero; ++i)
+        {
+            appendVarint(m_scratchBytes, indices[i] - lastIndex - 1);
+            lastIndex = indices[i];
+        }
+        appendPlane(m_scratchBytes, values, lowWidth, 0);
+        appendPlane(m_scratchBytes, values, highWidth, 32);
+    }
+    m_file.write(m_scratchBytes.data(), m_scratchBytes.size());
+    m_nextOffset += m_scratchBytes.size();
 }
 
 void CaretSparseFileWriter::writeRowSparse(const int64_t& index, const vector<int64_t>& indices, const vector<int64_t>& values)
@@ -271,6 +514,19 @@ void CaretSparseFileWriter::writeRowSparse(const int64_t& index, const vector<in
     CaretAssert(index < m_dims[1]);
     CaretAssert(index >= m_nextRowIndex);
     CaretAssert(indices.size() == values.size());
+    if (m_version == 2)
+    {
+        vector<int64_t> empty;
+        while (m_nextRowIndex < index)
+        {
+            writeRowRecordV2(m_nextRowIndex, empty, empty);
+            ++m_nextRowIndex;
+        }
+        writeRowRecordV2(index, indices, values);
+        m_nextRowIndex = index + 1;
+        if (m_nextRowIndex == m_dims[1]) finish();
+        return;
+    }
     while (m_nextRowIndex < index)
     {
         m_lengthArray[m_nextRowIndex] = 0;
@@ -326,6 +582,30 @@ void CaretSparseFileWriter::finish()
 {
     if (m_finished) return;
     m_finished = true;
+    if (m_version == 2)
+    {
+        vector<int64_t> empty;
+        while (m_nextRowIndex < m_dims[1])
+        {
+            writeRowRecordV2(m_nextRowIndex, empty, empty);
+            ++m_nextRowIndex;
+        }
+        int64_t rowIndexOffset = m_nextOffset;
+        if (ByteOrderEnum::isSystemBigEndian())
+        {
+            ByteSwapping::swapBytes(m_blockOffsets.data(), m_blockOffsets.size());
+            ByteSwapping::swapBytes(m_rowOffsets.data(), m_rowOffsets.size());
+            ByteSwapping::swapBytes(&rowIndexOffset, 1);
+        }
+        m_file.write(m_blockOffsets.data(), m_blockOffsets.size() * sizeof(uint64_t));
+        m_file.write(m_rowOffsets.data(), m_rowOffsets.size() * sizeof(uint32_t));
+        QByteArray myXMLBytes = m_xml.writeXMLToQByteArray();
+        m_file.write(myXMLBytes.constData(), myXMLBytes.size());
+        m_file.seek(8 + 2 * sizeof(int64_t));
+        m_file.write(&rowIndexOffset, sizeof(int64_t));
+        m_file.close();
+        return;
+    }
     while (m_nextRowIndex < m_dims[1])
     {
         m_lengthArray[m_nextRowIndex] = 0;
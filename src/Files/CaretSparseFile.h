@@ -40,19 +40,31 @@ namespace caret {
         void zero();
     };
     
+    ///version 1 stores each nonzero as an int64 index and an int64 value, with an int64 length per row read at open
+    ///version 2 stores each row as a record of delta-varint indices and the narrowest little-endian value planes that fit,
+    ///located through a row index that is read a block of rows at a time
     class CaretSparseFile /* : public DataFile */
     {
         static void decodeFibers(const uint64_t& coded, FiberFractions& decoded);//takes a uint because right shift on signed is implementation dependent
+        void readRowSparseV2(const int64_t& index, std::vector<int64_t>& indicesOut, std::vector<int64_t>& valuesOut);
+        void getRowRangeV2(const int64_t& index, int64_t& startOut, int64_t& endOut);
         CaretBinaryFile m_file;
-        int64_t m_dims[2], m_valuesOffset;
-        std::vector<uint64_t> m_indexArray, m_scratchRow;
-        std::vector<int64_t> m_scratchArray, m_scratchSparseRow;
+        int32_t m_version;
+        int64_t m_dims[2], m_valuesOffset, m_rowIndexOffset;
+        std::vector<uint64_t> m_indexArray, m_scratchRow, m_blockOffsets;
+        std::vector<uint32_t> m_rowOffsets;
+        std::vector<char> m_blockLoaded;
+        std::vector<uint8_t> m_scratchBytes;
+        std::vector<int64_t> m_scratchArray, m_scratchSparseRow, m_scratchIndices;
         CaretSparseFile(const CaretSparseFile& rhs);
         CiftiXML m_xml;
     public:
         const int64_t* getDimensions() { return m_dims; }
+        
+        ///format version of the file that was read
+        int32_t getVersion() const { return m_version; }
 
-        CaretSparseFile() {};
+        CaretSparseFile() { m_version = 0; }
         
         virtual void readFile(const AString& filename);
         
@@ -78,15 +90,20 @@ namespace caret {
     {
         static void encodeFibers(const FiberFractions& orig, uint64_t& coded);
         static uint32_t myclamp(const int& x);
+        void writeRowRecordV2(const int64_t& index, const std::vector<int64_t>& indices, const std::vector<int64_t>& values);
         CaretBinaryFile m_file;
-        int64_t m_dims[2], m_valuesOffset, m_nextRowIndex;
+        int32_t m_version;
+        int64_t m_dims[2], m_valuesOffset, m_nextRowIndex, m_nextOffset;
         bool m_finished;
-        std::vector<uint64_t> m_lengthArray, m_scratchRow;
-        std::vector<int64_t> m_scratchArray, m_scratchSparseRow;
+        std::vector<uint64_t> m_lengthArray, m_scratchRow, m_blockOffsets;
+        std::vector<uint32_t> m_rowOffsets;
+        std::vector<uint8_t> m_scratchBytes;
+        std::vector<int64_t> m_scratchArray, m_scratchSparseRow, m_scratchIndices, m_scratchValues;
         CaretSparseFileWriter(const CaretSparseFileWriter& rhs);
         CiftiXML m_xml;
     public:
-        CaretSparseFileWriter(const AString& fileName, const CiftiXML& xml);
+        ///version 1 can be read by older versions of workbench, version 2 is much smaller on disk but must be asked for
+        CaretSparseFileWriter(const AString& fileName, const CiftiXML& xml, const int32_t& version = 1);
         
         ~CaretSparseFileWriter();
         
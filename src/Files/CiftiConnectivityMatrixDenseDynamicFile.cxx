@@ -228,6 +228,22 @@ CiftiConnectivityMatrixDenseDynamicFile::getDataForRow(float* dataOut,
                                         index);
 }
 
+/**
+ * Load data for many rows at once.
+ *
+ * @param dataOut
+ *     Output with data, must hold indices.size() rows, in the order of indices.
+ * @param indices
+ *     Indices of the rows.
+ */
+void
+CiftiConnectivityMatrixDenseDynamicFile::getDataForRows(float* dataOut,
+                                                        const std::vector<int64_t>& indices) const
+{
+    m_parentDataSeriesCiftiFile->getRows(dataOut,
+                                         indices);
+}
+
 /**
  * Load PROCESSED data for the given column.
  *
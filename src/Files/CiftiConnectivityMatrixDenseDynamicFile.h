@@ -58,6 +58,8 @@ namespace caret {
         virtual void getDataForColumn(float* dataOut, const int64_t& index) const;
         
         virtual void getDataForRow(float* dataOut, const int64_t& index) const;
+        
+        virtual void getDataForRows(float* dataOut, const std::vector<int64_t>& indices) const;
                 
         virtual void getProcessedDataForColumn(float* dataOut, const int64_t& index) const;
         
@@ -35,6 +35,8 @@
 #include "SceneClass.h"
 #include "SceneClassAssistant.h"
 
+#include <algorithm>
+
 using namespace caret;
 
 
@@ -371,22 +373,48 @@ CiftiMappableConnectivityMatrixDataFile::getRowColumnAverageForIndices(const std
     const int64_t numIndices = static_cast<int64_t>(indices.size());
     if (numIndices > 0) {
         std::vector<double> sum(dataLength, 0.0);
-        std::vector<float>  data(dataLength);
         
-        for (std::vector<int64_t>::const_iterator iter = indices.begin();
-             iter != indices.end();
-             iter++) {
-            if (doRowsFlag) {
-                getDataForRow(&data[0], *iter);
-            }
-            else {
-                getDataForColumn(&data[0], *iter);
+        if (doRowsFlag) {
+            /*
+             * Fetch rows in batches so that adjacent rows are read
+             * with a single read instead of one read per row
+             */
+            std::sort(indices.begin(),
+                      indices.end());
+            const int64_t maxBatchBytes = 64 * 1024 * 1024;
+            const int64_t batchSize = std::max(static_cast<int64_t>(1),
+                                               std::min(numIndices,
+                                                        maxBatchBytes / static_cast<int64_t>(dataLength * sizeof(float))));
+            std::vector<float> data(batchSize * dataLength);
+            for (int64_t batchStart = 0; batchStart < numIndices; batchStart += batchSize) {
+                const int64_t batchEnd = std::min(batchStart + batchSize,
+                                                  numIndices);
+                const std::vector<int64_t> batchIndices(indices.begin() + batchStart,
+                                                        indices.begin() + batchEnd);
+                getDataForRows(&data[0], batchIndices);
+                
+                for (int64_t j = 0; j < (batchEnd - batchStart); j++) {
+                    const float* rowData = &data[j * dataLength];
+                    for (int64_t i = 0; i < dataLength; i++) {
+                        CaretAssertVectorIndex(sum, i);
+                        sum[i] += rowData[i];
+                    }
+                }
             }
+        }
+        else {
+            std::vector<float>  data(dataLength);
             
-            for (int64_t i = 0; i < dataLength; i++) {
-                CaretAssertVectorIndex(sum, i);
-                CaretAssertVectorIndex(data, i);
-                sum[i] += data[i];
+            for (std::vector<int64_t>::const_iterator iter = indices.begin();
+                 iter != indices.end();
+                 iter++) {
+                getDataForColumn(&data[0], *iter);
+                
+                for (int64_t i = 0; i < dataLength; i++) {
+                    CaretAssertVectorIndex(sum, i);
+                    CaretAssertVectorIndex(data, i);
+                    sum[i] += data[i];
+                }
             }
         }
 
@@ -594,6 +622,21 @@ CiftiMappableConnectivityMatrixDataFile::getDataForRow(float* dataOut, const int
                         index);
 }
 
+/**
+ * Load data for many rows at once.
+ *
+ * @param dataOut
+ *     Output with data, must hold indices.size() rows, in the order of indices.
+ * @param indices
+ *     Indices of the rows.
+ */
+void
+CiftiMappableConnectivityMatrixDataFile::getDataForRows(float* dataOut, const std::vector<int64_t>& indices) const
+{
+    m_ciftiFile->getRows(dataOut,
+                         indices);
+}
+
 /**
  * Load PROCESSED data for the given column.
  *
@@ -680,7 +680,13 @@ CiftiMappableDataFile::readFile(const AString& ciftiMapFileName)
                 case FILE_MAP_DATA_TYPE_INVALID:
                     break;
                 case FILE_MAP_DATA_TYPE_MATRIX:
-                    m_ciftiFile->openFile(ciftiMapFileName);
+                    /*
+                     * Rows are read one at a time as the user selects
+                     * vertices, so map the file to avoid a read call
+                     * and a conversion copy for each row.
+                     */
+                    m_ciftiFile->openFileMapped(ciftiMapFileName,
+                                                CaretBinaryFile::ACCESS_RANDOM);
                     break;
                 case FILE_MAP_DATA_TYPE_MULTI_MAP:
                     m_ciftiFile->openFile(ciftiMapFileName);
@@ -0,0 +1,249 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "ConnectedComponentsHelper.h"
+
+#include "CaretAssert.h"
+#include "CaretOMP.h"
+#include "TopologyHelper.h"
+
+#include <algorithm>
+#include <utility>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int64_t MIN_BLOCK_ELEMENTS = 1 << 14;//don't split small inputs into tiny blocks
+    const int64_t MAX_NUM_BLOCKS = 256;//block layout doesn't depend on the number of threads, so the size sums come out the same everywhere
+    
+    int64_t findRoot(int64_t* parent, int64_t elem)
+    {
+        while (parent[elem] != elem)
+        {
+            parent[elem] = parent[parent[elem]];//path halving
+            elem = parent[elem];
+        }
+        return elem;
+    }
+    
+    void unite(int64_t* parent, const int64_t& elem1, const int64_t& elem2)
+    {
+        int64_t root1 = findRoot(parent, elem1), root2 = findRoot(parent, elem2);
+        if (root1 < root2)//always link to the lower index, so a root is always the lowest element in its set
+        {
+            parent[root2] = root1;
+        } else if (root2 < root1) {
+            parent[root1] = root2;
+        }
+    }
+    
+    struct BlockInfo
+    {
+        vector<int64_t> roots;//block-local roots, in increasing order
+        vector<int64_t> counts;
+        vector<double> sizes;
+        vector<int64_t> components;//global component of each local root, from the merge pass
+        vector<pair<int64_t, int64_t> > crossLinks;//edges to elements in earlier blocks
+    };
+    
+    class VoxelNeighbors
+    {
+        int64_t m_dims[3], m_sliceSize;
+    public:
+        VoxelNeighbors(const int64_t dims[3])
+        {
+            m_dims[0] = dims[0];
+            m_dims[1] = dims[1];
+            m_dims[2] = dims[2];
+            m_sliceSize = dims[0] * dims[1];
+        }
+        void getLowerNeighbors(const int64_t& elem, vector<int64_t>& neighborsOut) const
+        {//face neighbors only, the upper ones get found from the other side
+            neighborsOut.clear();
+            if (elem % m_dims[0] > 0) neighborsOut.push_back(elem - 1);
+            if ((elem / m_dims[0]) % m_dims[1] > 0) neighborsOut.push_back(elem - m_dims[0]);
+            if (elem >= m_sliceSize) neighborsOut.push_back(elem - m_sliceSize);
+        }
+    };
+    
+    class VertexNeighbors
+    {
+        const TopologyHelper* m_topoHelp;
+    public:
+        VertexNeighbors(const TopologyHelper* topoHelp) { m_topoHelp = topoHelp; }
+        void getLowerNeighbors(const int64_t& elem, vector<int64_t>& neighborsOut) const
+        {
+            neighborsOut.clear();
+            const vector<int32_t>& neighbors = m_topoHelp->getNodeNeighbors(elem);
+            int numNeigh = (int)neighbors.size();
+            for (int n = 0; n < numNeigh; ++n)
+            {
+                if (neighbors[n] < elem) neighborsOut.push_back(neighbors[n]);
+            }
+        }
+    };
+    
+    template <typename NeighborFinder>
+    void labelComponents(const int64_t& numElements, const char* marked, const float* elementSizes, const float& uniformSize, const NeighborFinder& myNeighbors,
+                         vector<int64_t>& labelsOut, vector<ConnectedComponentsHelper::Component>& componentsOut)
+    {
+        labelsOut.resize(numElements);
+        componentsOut.clear();
+        if (numElements == 0) return;
+        int64_t blockElements = max(MIN_BLOCK_ELEMENTS, (numElements - 1) / MAX_NUM_BLOCKS + 1);
+        int64_t numBlocks = (numElements - 1) / blockElements + 1;
+        vector<int64_t> parent(numElements);
+        vector<BlockInfo> blocks(numBlocks);
+        int64_t* parentData = parent.data();
+        int64_t* labelData = labelsOut.data();
+        //union-find inside each block, edges that leave the block are saved for the merge pass
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int64_t b = 0; b < numBlocks; ++b)
+        {
+            BlockInfo& thisBlock = blocks[b];
+            int64_t blockStart = b * blockElements, blockEnd = min(blockStart + blockElements, numElements);
+            vector<int64_t> neighbors;
+            for (int64_t elem = blockStart; elem < blockEnd; ++elem)
+            {
+                if (!marked[elem]) continue;
+                parentData[elem] = elem;
+                myNeighbors.getLowerNeighbors(elem, neighbors);
+                for (size_t n = 0; n < neighbors.size(); ++n)
+                {
+                    const int64_t& neighbor = neighbors[n];
+                    if (!marked[neighbor]) continue;
+                    if (neighbor >= blockStart)
+                    {
+                        unite(parentData, elem, neighbor);
+                    } else {
+                        thisBlock.crossLinks.push_back(make_pair(elem, neighbor));
+                    }
+                }
+            }
+            //a root is visited before the rest of its set, so local roots get numbered in order, and counts and sizes are summed in the same sweep
+            for (int64_t elem = blockStart; elem < blockEnd; ++elem)
+            {
+                if (!marked[elem])
+                {
+                    labelData[elem] = -1;
+                    continue;
+                }
+                int64_t root = findRoot(parentData, elem);
+                if (root == elem)
+                {
+                    labelData[elem] = (int64_t)thisBlock.roots.size();
+                    thisBlock.roots.push_back(elem);
+                    thisBlock.counts.push_back(0);
+                    thisBlock.sizes.push_back(0.0);
+                }
+                int64_t localRoot = labelData[root];
+                labelData[elem] = localRoot;
+                ++thisBlock.counts[localRoot];
+                thisBlock.sizes[localRoot] += (elementSizes == NULL ? uniformSize : elementSizes[elem]);
+            }
+        }
+        //merge pass: join sets across block boundaries, then number the global roots in index order and combine the block sums
+        for (int64_t b = 0; b < numBlocks; ++b)
+        {
+            const vector<pair<int64_t, int64_t> >& crossLinks = blocks[b].crossLinks;
+            for (size_t i = 0; i < crossLinks.size(); ++i)
+            {
+                unite(parentData, crossLinks[i].first, crossLinks[i].second);
+            }
+        }
+        for (int64_t b = 0; b < numBlocks; ++b)
+        {
+            BlockInfo& thisBlock = blocks[b];
+            int64_t numRoots = (int64_t)thisBlock.roots.size();
+            thisBlock.components.resize(numRoots);
+            for (int64_t r = 0; r < numRoots; ++r)
+            {
+                int64_t root = findRoot(parentData, thisBlock.roots[r]);
+                int64_t component;
+                if (root == thisBlock.roots[r])
+                {
+                    component = (int64_t)componentsOut.size();
+                    ConnectedComponentsHelper::Component newComponent;
+                    newComponent.firstElement = root;
+                    newComponent.count = 0;
+                    newComponent.size = 0.0;
+                    componentsOut.push_back(newComponent);
+                } else {//the global root is a local root with a lower index, so it has already been numbered
+                    CaretAssert(root < thisBlock.roots[r]);
+                    component = blocks[root / blockElements].components[labelData[root]];
+                }
+                thisBlock.components[r] = component;
+                componentsOut[component].count += thisBlock.counts[r];
+                componentsOut[component].size += thisBlock.sizes[r];
+            }
+        }
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int64_t b = 0; b < numBlocks; ++b)
+        {
+            const vector<int64_t>& components = blocks[b].components;
+            int64_t blockStart = b * blockElements, blockEnd = min(blockStart + blockElements, numElements);
+            for (int64_t elem = blockStart; elem < blockEnd; ++elem)
+            {
+                if (labelData[elem] != -1)
+                {
+                    labelData[elem] = components[labelData[elem]];
+                }
+            }
+        }
+    }
+}
+
+void ConnectedComponentsHelper::labelVoxels(const int64_t dims[3], const char* marked, const float& voxelSize,
+                                            vector<int64_t>& labelsOut, vector<Component>& componentsOut)
+{
+    labelComponents(dims[0] * dims[1] * dims[2], marked, NULL, voxelSize, VoxelNeighbors(dims), labelsOut, componentsOut);
+}
+
+void ConnectedComponentsHelper::labelVertices(const TopologyHelper* topoHelp, const char* marked, const float* vertexAreas,
+                                              vector<int64_t>& labelsOut, vector<Component>& componentsOut)
+{
+    labelComponents(topoHelp->getNumberOfNodes(), marked, vertexAreas, 1.0f, VertexNeighbors(topoHelp), labelsOut, componentsOut);
+}
+
+void ConnectedComponentsHelper::getComponentMembers(const vector<int64_t>& labels, const vector<Component>& components,
+                                                    vector<int64_t>& offsetsOut, vector<int64_t>& membersOut)
+{
+    int64_t numComponents = (int64_t)components.size();
+    offsetsOut.resize(numComponents + 1);
+    offsetsOut[0] = 0;
+    for (int64_t i = 0; i < numComponents; ++i)
+    {
+        offsetsOut[i + 1] = offsetsOut[i] + components[i].count;
+    }
+    membersOut.resize(offsetsOut[numComponents]);
+    vector<int64_t> position(offsetsOut.begin(), offsetsOut.end() - 1);
+    int64_t numElements = (int64_t)labels.size();
+    for (int64_t elem = 0; elem < numElements; ++elem)
+    {
+        if (labels[elem] != -1)
+        {
+            CaretAssertVectorIndex(position, labels[elem]);
+            membersOut[position[labels[elem]]] = elem;
+            ++position[labels[elem]];
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef __CONNECTED_COMPONENTS_HELPER_H__
+#define __CONNECTED_COMPONENTS_HELPER_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "stdint.h"
+#include <vector>
+
+namespace caret {
+    
+    class TopologyHelper;
+    
+    ///connected component labeling of marked voxels or vertices, using union-find on blocks of elements in parallel, followed by a merge pass
+    class ConnectedComponentsHelper
+    {
+    public:
+        struct Component
+        {
+            int64_t firstElement;//lowest element index in the component, components are sorted by this, so they come out in the same order as a serial scan would find them
+            int64_t count;
+            double size;//sum of element sizes (volume or area), or count if no sizes were given
+        };
+        ///label face-connected marked voxels of a frame, labels are the component index, or -1 for unmarked voxels
+        static void labelVoxels(const int64_t dims[3], const char* marked, const float& voxelSize,
+                                std::vector<int64_t>& labelsOut, std::vector<Component>& componentsOut);
+        ///label marked vertices connected by topology edges, vertexAreas may be NULL
+        static void labelVertices(const TopologyHelper* topoHelp, const char* marked, const float* vertexAreas,
+                                  std::vector<int64_t>& labelsOut, std::vector<Component>& componentsOut);
+        ///group element indices by component, members of component i are membersOut[offsetsOut[i]] to membersOut[offsetsOut[i + 1] - 1], in increasing order
+        static void getComponentMembers(const std::vector<int64_t>& labels, const std::vector<Component>& components,
+                                        std::vector<int64_t>& offsetsOut, std::vector<int64_t>& membersOut);
+    };
+    
+}
+
+#endif //__CONNECTED_COMPONENTS_HELPER_H__
@@ -27,6 +27,7 @@
 #include "SurfaceFile.h"
 #include "TopologyHelper.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <stdint.h>
@@ -40,8 +41,9 @@ GeodesicHelperBase::GeodesicHelperBase(const SurfaceFile* surfaceIn, const float
     TopologyHelper topoHelpIn(topoBase);//leave this building one privately, to not introduce even worse dependencies regarding SurfaceFile
     m_corrAreaSmallestFactor = 1.0f;
     numNodes = surfaceIn->getNumberOfNodes();
-    nodeNeighbors.resize(numNodes);
-    distances.resize(numNodes);
+    vector<vector<int32_t> > neighborLists(numNodes), neighborLists2(numNodes);//built per node, then flattened into CSR arrays at the end
+    vector<vector<float> > distanceLists(numNodes), distanceLists2(numNodes);
+    vector<vector<CrawlInfo> > pathInfoLists(numNodes);
     nodeCoords.resize(numNodes);
     vector<float> sqrtCorrAreas;//each edge has 2 vertices that influence it - assume that each influences a piece of the edge with a ratio depending on the square roots of the vertex areas
     vector<float> sqrtVertAreas;//we also assume isometric expansion at each vertex
@@ -62,17 +64,17 @@ GeodesicHelperBase::GeodesicHelperBase(const SurfaceFile* surfaceIn, const float
     bool firstCorrArea = true;//if all corrected vertex areas are significantly larger than 1, we can make A* faster by multiplying all euclidean distances by it, so find the actual smallest
     for (int32_t i = 0; i < numNodes; ++i)
     {//get neighbors
-        vector<int32_t>& neighbors = nodeNeighbors[i];
+        vector<int32_t>& neighbors = neighborLists[i];
         neighbors = topoHelpIn.getNodeNeighbors(i);
         nodeCoords[i] = surfaceIn->getCoordinate(i);
         const Vector3D baseCoord = nodeCoords[i];
         int numNeigh = (int)neighbors.size();
-        distances[i].resize(numNeigh);
+        distanceLists[i].resize(numNeigh);
         for (int32_t j = 0; j < numNeigh; ++j)
         {
             Vector3D neighCoord = surfaceIn->getCoordinate(neighbors[j]);
             tempvec = baseCoord - neighCoord;
-            distances[i][j] = tempvec.length();//precompute for speed in other calls
+            distanceLists[i][j] = tempvec.length();//precompute for speed in other calls
             if (correctedAreas != NULL)
             {
                 float correctionFactor = (sqrtCorrAreas[i] + sqrtCorrAreas[neighbors[j]]) / (sqrtVertAreas[i] + sqrtVertAreas[neighbors[j]]);
@@ -81,11 +83,11 @@ GeodesicHelperBase::GeodesicHelperBase(const SurfaceFile* surfaceIn, const float
                     m_corrAreaSmallestFactor = correctionFactor;//if this is zero anywhere, it just means that the euclidean part of the heuristic must be ignored (worst case, it does dijkstra)
                     firstCorrArea = false;
                 }
-                distances[i][j] *= correctionFactor;
+                distanceLists[i][j] *= correctionFactor;
             }
             if (i < neighbors[j])
             {
-                nodeSpacingAccum += distances[i][j];
+                nodeSpacingAccum += distanceLists[i][j];
                 ++numEdges;
             }
         }//so few floating point operations, this should turn out symmetric
@@ -93,9 +95,6 @@ GeodesicHelperBase::GeodesicHelperBase(const SurfaceFile* surfaceIn, const float
     m_avgNodeSpacing = nodeSpacingAccum / numEdges;
     std::vector<int32_t> tempneigh2;
     std::vector<float> tempdist2;
-    nodeNeighbors2.resize(numNodes);
-    distances2.resize(numNodes);
-    neighbors2PathInfo.resize(numNodes);
     const vector<TopologyEdgeInfo>& myEdgeInfo = topoHelpIn.getEdgeInfo();
     CaretAssert(numEdges == (int32_t)myEdgeInfo.size());//SurfaceFile checks for triangles with duplicated nodes
     for (int i = 0; i < numEdges; ++i)
@@ -117,12 +116,12 @@ GeodesicHelperBase::GeodesicHelperBase(const SurfaceFile* surfaceIn, const float
         tempInfo.edgeNodes[0] = neigh1Node;
         tempInfo.edgeNodes[1] = neigh2Node;
         const int32_t num_reserve = 8;//uses 8 in case it is used on a mesh with haphazard topology
-        nodeNeighbors2[baseNode].reserve(num_reserve);//reserve should be fast if capacity is already num_reserve, and better than reallocating at 2 and 4, if vector allocation is naive doubling
-        nodeNeighbors2[farNode].reserve(num_reserve);//in the extremely rare case of a node with more than num_reserve neighbors, a second allocation plus copy isn't much of a cost
-        distances2[baseNode].reserve(num_reserve);
-        distances2[farNode].reserve(num_reserve);
-        neighbors2PathInfo[baseNode].reserve(num_reserve);
-        neighbors2PathInfo[farNode].reserve(num_reserve);
+        neighborLists2[baseNode].reserve(num_reserve);//reserve should be fast if capacity is already num_reserve, and better than reallocating at 2 and 4, if vector allocation is naive doubling
+        neighborLists2[farNode].reserve(num_reserve);//in the extremely rare case of a node with more than num_reserve neighbors, a second allocation plus copy isn't much of a cost
+        distanceLists2[baseNode].reserve(num_reserve);
+        distanceLists2[farNode].reserve(num_reserve);
+        pathInfoLists[baseNode].reserve(num_reserve);
+        pathInfoLists[farNode].reserve(num_reserve);
         Vector3D abhat = (neigh2Coord - neigh1Coord).normal(&abmag);//a is neigh1, b is neigh2, b - a = (vector)ab
         Vector3D ac = farCoord - neigh1Coord;//c is farnode, c - a = (vector)ac
         Vector3D ad = abhat * abhat.dot(ac);//d is the point on the shared edge that farnode (c) is closest to
@@ -152,16 +151,58 @@ GeodesicHelperBase::GeodesicHelperBase(const SurfaceFile* surfaceIn, const float
             tempInfo.pieceDists[1] *= correctionFactor;
         }//for now, assume it only depends on the expansion of the endpoints, and affects each part equally
         tempInfo.pieceDists[0] = tempf - tempInfo.pieceDists[1];
-        nodeNeighbors2[farNode].push_back(baseNode);//record it at both ends, because we are looping through edges
-        distances2[farNode].push_back(tempf);
-        neighbors2PathInfo[farNode].push_back(tempInfo);
+        neighborLists2[farNode].push_back(baseNode);//record it at both ends, because we are looping through edges
+        distanceLists2[farNode].push_back(tempf);
+        pathInfoLists[farNode].push_back(tempInfo);
         
         float tempf2 = tempInfo.pieceDists[0];//swap the piece distances around for the baseNode info
         tempInfo.pieceDists[0] = tempInfo.pieceDists[1];
         tempInfo.pieceDists[1] = tempf2;
-        nodeNeighbors2[baseNode].push_back(farNode);
-        distances2[baseNode].push_back(tempf);
-        neighbors2PathInfo[baseNode].push_back(tempInfo);
+        neighborLists2[baseNode].push_back(farNode);
+        distanceLists2[baseNode].push_back(tempf);
+        pathInfoLists[baseNode].push_back(tempInfo);
+    }
+    flattenLists(neighborLists, distanceLists, neighborStart, nodeNeighbors, distances);
+    flattenLists(neighborLists2, distanceLists2, neighborStart2, nodeNeighbors2, distances2);
+    neighbors2PathInfo.reserve(nodeNeighbors2.size());
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        neighbors2PathInfo.insert(neighbors2PathInfo.end(), pathInfoLists[i].begin(), pathInfoLists[i].end());
+    }
+    m_minEdgeLength = -1.0f;
+    m_maxEdgeLength = 0.0f;
+    for (size_t i = 0; i < distances.size(); ++i)
+    {
+        if (m_minEdgeLength < 0.0f || distances[i] < m_minEdgeLength) m_minEdgeLength = distances[i];
+        if (distances[i] > m_maxEdgeLength) m_maxEdgeLength = distances[i];
+    }
+    for (size_t i = 0; i < distances2.size(); ++i)
+    {
+        if (m_minEdgeLength < 0.0f || distances2[i] < m_minEdgeLength) m_minEdgeLength = distances2[i];
+        if (distances2[i] > m_maxEdgeLength) m_maxEdgeLength = distances2[i];
+    }
+}
+
+void GeodesicHelperBase::flattenLists(const vector<vector<int32_t> >& neighborLists, const vector<vector<float> >& distanceLists,
+                                      vector<int32_t>& startOut, vector<int32_t>& neighborsOut, vector<float>& distancesOut)
+{
+    int32_t listCount = (int32_t)neighborLists.size();
+    startOut.resize(listCount + 1);
+    startOut[0] = 0;
+    for (int32_t i = 0; i < listCount; ++i)
+    {
+        CaretAssert(neighborLists[i].size() == distanceLists[i].size());
+        startOut[i + 1] = startOut[i] + (int32_t)neighborLists[i].size();
+    }
+    neighborsOut.resize(startOut[listCount]);
+    distancesOut.resize(startOut[listCount]);
+    for (int32_t i = 0; i < listCount; ++i)
+    {
+        for (int32_t j = 0; j < (int32_t)neighborLists[i].size(); ++j)
+        {
+            neighborsOut[startOut[i] + j] = neighborLists[i][j];
+            distancesOut[startOut[i] + j] = distanceLists[i][j];
+        }
     }
 }
 
@@ -176,6 +217,8 @@ GeodesicHelper::GeodesicHelper(const CaretPointer<const GeodesicHelperBase>& bas
     distances2 = m_myBase->distances2.data();
     nodeNeighbors = m_myBase->nodeNeighbors.data();
     nodeNeighbors2 = m_myBase->nodeNeighbors2.data();
+    neighborStart = m_myBase->neighborStart.data();
+    neighborStart2 = m_myBase->neighborStart2.data();
     nodeCoords = m_myBase->nodeCoords.data();
     neighbors2PathInfo = m_myBase->neighbors2PathInfo.data();
     //allocate private scratch space
@@ -187,6 +230,13 @@ GeodesicHelper::GeodesicHelper(const CaretPointer<const GeodesicHelperBase>& bas
     parentStore.resize(numNodes);
     parent = parentStore.data();//ditto for parents
     heurVal.resize(numNodes);
+    m_useBuckets = true;
+    m_bucketWidth = 0.99f * m_myBase->m_minEdgeLength;//narrower than any edge, so nothing in the current bucket can improve anything else in it
+    const float MAX_BUCKETS = 65536.0f;//if edge lengths vary by much more than this, the heap is the better choice
+    if (m_bucketWidth > 0.0f && m_myBase->m_maxEdgeLength / m_bucketWidth < MAX_BUCKETS)
+    {
+        m_buckets.resize((int32_t)(m_myBase->m_maxEdgeLength / m_bucketWidth) + 2);//any tentative distance is within one max edge of the bucket being processed
+    }
 }
 
 void GeodesicHelper::getNodesToGeoDist(const int32_t node, const float maxdist, std::vector<int32_t>& nodesOut, std::vector<float>& distsOut, const bool smoothflag)
@@ -217,6 +267,11 @@ void GeodesicHelper::getNodesToGeoDist(const int32_t node, const float maxdist,
 
 void GeodesicHelper::dijkstra(const int32_t root, const float maxdist, std::vector<int32_t>& nodes, std::vector<float>& dists, bool smooth)
 {
+    if (isUsingBucketQueue())
+    {
+        dijkstraBuckets(root, maxdist, nodes, dists, smooth);
+        return;
+    }
     int32_t i, j, whichnode, whichneigh, numNeigh, numChanged = 0;
     const int32_t* neighbors;
     float tempf;
@@ -233,14 +288,14 @@ void GeodesicHelper::dijkstra(const int32_t root, const float maxdist, std::vect
         nodes.push_back(whichnode);
         dists.push_back(output[whichnode]);
         marked[whichnode] |= 1;//anything pulled from heap will already be marked as having a valid value (flag 4)
-        neighbors = nodeNeighbors[whichnode].data();
-        numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+        neighbors = nodeNeighbors + neighborStart[whichnode];
+        numNeigh = neighborStart[whichnode + 1] - neighborStart[whichnode];
         for (j = 0; j < numNeigh; ++j)
         {
             whichneigh = neighbors[j];
             if (!(marked[whichneigh] & 1))
             {//skip floating point math if frozen
-                tempf = output[whichnode] + distances[whichnode][j];//isn't precomputation wonderful
+                tempf = output[whichnode] + distances[neighborStart[whichnode] + j];//isn't precomputation wonderful
                 if (tempf <= maxdist)
                 {//keep it off the heap if it is too far
                     if (!(marked[whichneigh] & 4))
@@ -260,14 +315,14 @@ void GeodesicHelper::dijkstra(const int32_t root, const float maxdist, std::vect
         }
         if (smooth)//repeat with numNeighbors2, nodeNeighbors2, distance2
         {
-            neighbors = nodeNeighbors2[whichnode].data();
-            numNeigh = (int32_t)nodeNeighbors2[whichnode].size();
+            neighbors = nodeNeighbors2 + neighborStart2[whichnode];
+            numNeigh = neighborStart2[whichnode + 1] - neighborStart2[whichnode];
             for (j = 0; j < numNeigh; ++j)
             {
                 whichneigh = neighbors[j];
                 if (!(marked[whichneigh] & 1))
                 {//skip floating point math if frozen
-                    tempf = output[whichnode] + distances2[whichnode][j];
+                    tempf = output[whichnode] + distances2[neighborStart2[whichnode] + j];
                     if (tempf <= maxdist)
                     {//keep it off the heap if it is too far
                         if (!(marked[whichneigh] & 4))
@@ -293,6 +348,82 @@ void GeodesicHelper::dijkstra(const int32_t root, const float maxdist, std::vect
     }
 }
 
+void GeodesicHelper::dijkstraBuckets(const int32_t root, const float maxdist, std::vector<int32_t>& nodes, std::vector<float>& dists, bool smooth)
+{//dial's algorithm: buckets are narrower than the shortest edge, so every node in the lowest nonempty bucket is final, and buckets need no ordering inside them
+    int32_t i, j, whichnode, whichneigh, numNeigh, numChanged = 0;
+    const int32_t* neighbors;
+    const float* neighDists;
+    float tempf;
+    const int64_t numBuckets = (int64_t)m_buckets.size();
+    int64_t numQueued = 0;
+    output[root] = 0.0f;
+    marked[root] |= 4;
+    parent[root] = -1;//idiom for end of path
+    changed[numChanged++] = root;
+    m_buckets[0].push_back(root);
+    ++numQueued;
+    for (int64_t current = 0; numQueued > 0; ++current)
+    {
+        vector<int32_t>& thisBucket = m_buckets[current % numBuckets];
+        for (size_t b = 0; b < thisBucket.size(); ++b)//don't use iterators, the bucket can't grow in theory, but rounding is rounding
+        {
+            whichnode = thisBucket[b];
+            --numQueued;
+            if (marked[whichnode] & 1) continue;//stale entry from before a decrease
+            nodes.push_back(whichnode);
+            dists.push_back(output[whichnode]);
+            marked[whichnode] |= 1;
+            for (int pass = 0; pass < (smooth ? 2 : 1); ++pass)
+            {
+                if (pass == 0)
+                {
+                    neighbors = nodeNeighbors + neighborStart[whichnode];
+                    neighDists = distances + neighborStart[whichnode];
+                    numNeigh = neighborStart[whichnode + 1] - neighborStart[whichnode];
+                } else {
+                    neighbors = nodeNeighbors2 + neighborStart2[whichnode];
+                    neighDists = distances2 + neighborStart2[whichnode];
+                    numNeigh = neighborStart2[whichnode + 1] - neighborStart2[whichnode];
+                }
+                for (j = 0; j < numNeigh; ++j)
+                {
+                    whichneigh = neighbors[j];
+                    if (!(marked[whichneigh] & 1))
+                    {
+                        tempf = output[whichnode] + neighDists[j];
+                        if (tempf <= maxdist)
+                        {
+                            bool push = false;
+                            if (!(marked[whichneigh] & 4))
+                            {
+                                marked[whichneigh] |= 4;
+                                changed[numChanged++] = whichneigh;
+                                push = true;
+                            } else if (tempf < output[whichneigh]) {
+                                push = true;//lazy decrease, the old entry gets skipped
+                            }
+                            if (push)
+                            {
+                                output[whichneigh] = tempf;
+                                parent[whichneigh] = whichnode;
+                                int64_t bucket = max(current, (int64_t)(tempf / m_bucketWidth));
+                                CaretAssert(bucket - current < numBuckets);
+                                m_buckets[bucket % numBuckets].push_back(whichneigh);
+                                ++numQueued;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        thisBucket.clear();
+    }
+    for (i = 0; i < numChanged; ++i)
+    {
+        marked[changed[i]] = 0;//minimize reinitialization of arrays
+    }
+}
+
 void GeodesicHelper::dijkstra(const int32_t root, bool smooth)
 {//straightforward dijkstra, no cutoffs, full surface
     int32_t i, j, whichnode, whichneigh, numNeigh;
@@ -306,14 +437,14 @@ void GeodesicHelper::dijkstra(const int32_t root, bool smooth)
     {
         whichnode = m_active.pop();
         marked[whichnode] |= 1;
-        neighbors = nodeNeighbors[whichnode].data();
-        numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+        neighbors = nodeNeighbors + neighborStart[whichnode];
+        numNeigh = neighborStart[whichnode + 1] - neighborStart[whichnode];
         for (j = 0; j < numNeigh; ++j)
         {
             whichneigh = neighbors[j];
             if (!(marked[whichneigh] & 1))
             {//skip floating point math if frozen
-                tempf = output[whichnode] + distances[whichnode][j];
+                tempf = output[whichnode] + distances[neighborStart[whichnode] + j];
                 if (!(marked[whichneigh] & 4))
                 {
                     marked[whichneigh] |= 4;
@@ -329,14 +460,14 @@ void GeodesicHelper::dijkstra(const int32_t root, bool smooth)
         }
         if (smooth)
         {
-            neighbors = nodeNeighbors2[whichnode].data();
-            numNeigh = (int32_t)nodeNeighbors2[whichnode].size();
+            neighbors = nodeNeighbors2 + neighborStart2[whichnode];
+            numNeigh = neighborStart2[whichnode + 1] - neighborStart2[whichnode];
             for (j = 0; j < numNeigh; ++j)
             {
                 whichneigh = neighbors[j];
                 if (!(marked[whichneigh] & 1))
                 {//skip floating point math if frozen
-                    tempf = output[whichnode] + distances2[whichnode][j];
+                    tempf = output[whichnode] + distances2[neighborStart2[whichnode] + j];
                     if (!(marked[whichneigh] & 4))
                     {
                         marked[whichneigh] |= 4;
@@ -496,8 +627,8 @@ void GeodesicHelper::alltoall(float** out, int32_t** parents, bool smooth)
             {
                 if (!(marked[whichnode] & 2)) --remain;
                 marked[whichnode] |= 1;
-                neighbors = nodeNeighbors[whichnode].data();
-                numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+                neighbors = nodeNeighbors + neighborStart[whichnode];
+                numNeigh = neighborStart[whichnode + 1] - neighborStart[whichnode];
                 for (j = 0; j < numNeigh; ++j)
                 {
                     whichneigh = neighbors[j];
@@ -511,7 +642,7 @@ void GeodesicHelper::alltoall(float** out, int32_t** parents, bool smooth)
                     } else {
                         if (!(marked[whichneigh] & 1))
                         {//skip floating point math if marked
-                            tempf = out[root][whichnode] + distances[whichnode][j];
+                            tempf = out[root][whichnode] + distances[neighborStart[whichnode] + j];
                             if (!(marked[whichneigh] & 4))
                             {
                                 out[root][whichneigh] = tempf;
@@ -528,8 +659,8 @@ void GeodesicHelper::alltoall(float** out, int32_t** parents, bool smooth)
                 }
                 if (smooth)
                 {
-                    neighbors = nodeNeighbors2[whichnode].data();
-                    numNeigh = (int32_t)nodeNeighbors2[whichnode].size();
+                    neighbors = nodeNeighbors2 + neighborStart2[whichnode];
+                    numNeigh = neighborStart2[whichnode + 1] - neighborStart2[whichnode];
                     for (j = 0; j < numNeigh; ++j)
                     {
                         whichneigh = neighbors[j];
@@ -543,7 +674,7 @@ void GeodesicHelper::alltoall(float** out, int32_t** parents, bool smooth)
                         } else {
                             if (!(marked[whichneigh] & 1))
                             {//skip floating point math if marked
-                                tempf = out[root][whichnode] + distances2[whichnode][j];
+                                tempf = out[root][whichnode] + distances2[neighborStart2[whichnode] + j];
                                 if (!(marked[whichneigh] & 4))
                                 {
                                     out[root][whichneigh] = tempf;
@@ -698,14 +829,14 @@ void GeodesicHelper::dijkstra(const int32_t root, const std::vector<int32_t>& in
             --remain;
         }
         marked[whichnode] |= 1;//anything pulled from heap will already be marked as having a valid value (flag 4), so already in changed list
-        neighbors = nodeNeighbors[whichnode].data();
-        numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+        neighbors = nodeNeighbors + neighborStart[whichnode];
+        numNeigh = neighborStart[whichnode + 1] - neighborStart[whichnode];
         for (j = 0; j < numNeigh; ++j)
         {
             whichneigh = neighbors[j];
             if (!(marked[whichneigh] & 1))
             {//skip floating point math if frozen
-                tempf = output[whichnode] + distances[whichnode][j];//isn't precomputation wonderful
+                tempf = output[whichnode] + distances[neighborStart[whichnode] + j];//isn't precomputation wonderful
                 if (!(marked[whichneigh] & 4))
                 {
                     if (!marked[whichneigh])
@@ -725,14 +856,14 @@ void GeodesicHelper::dijkstra(const int32_t root, const std::vector<int32_t>& in
         }
         if (smooth)//repeat with numNeighbors2, nodeNeighbors2, distance2
         {
-            neighbors = nodeNeighbors2[whichnode].data();
-            numNeigh = (int32_t)nodeNeighbors2[whichnode].size();
+            neighbors = nodeNeighbors2 + neighborStart2[whichnode];
+            numNeigh = neighborStart2[whichnode + 1] - neighborStart2[whichnode];
             for (j = 0; j < numNeigh; ++j)
             {
                 whichneigh = neighbors[j];
                 if (!(marked[whichneigh] & 1))
                 {//skip floating point math if frozen
-                    tempf = output[whichnode] + distances2[whichnode][j];
+                    tempf = output[whichnode] + distances2[neighborStart2[whichnode] + j];
                     if (!(marked[whichneigh] & 4))
                     {
                         if (!marked[whichneigh])
@@ -794,14 +925,14 @@ int32_t GeodesicHelper::dijkstra(const vector<int32_t>& startList, const vector<
             break;
         }
         marked[whichnode] |= 1;//anything pulled from heap will already be marked as having a valid value (flag 4), so already in changed list
-        neighbors = nodeNeighbors[whichnode].data();
-        numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+        neighbors = nodeNeighbors + neighborStart[whichnode];
+        numNeigh = neighborStart[whichnode + 1] - neighborStart[whichnode];
         for (j = 0; j < numNeigh; ++j)
         {
             whichneigh = neighbors[j];
             if (!(marked[whichneigh] & 1))
             {//skip floating point math if frozen
-                tempf = output[whichnode] + distances[whichnode][j];
+                tempf = output[whichnode] + distances[neighborStart[whichnode] + j];
                 if (tempf <= maxDist)
                 {
                     if (!(marked[whichneigh] & 4))
@@ -824,14 +955,14 @@ int32_t GeodesicHelper::dijkstra(const vector<int32_t>& startList, const vector<
         }
         if (smooth)//repeat with numNeighbors2, nodeNeighbors2, distance2
         {
-            neighbors = nodeNeighbors2[whichnode].data();
-            numNeigh = (int32_t)nodeNeighbors2[whichnode].size();
+            neighbors = nodeNeighbors2 + neighborStart2[whichnode];
+            numNeigh = neighborStart2[whichnode + 1] - neighborStart2[whichnode];
             for (j = 0; j < numNeigh; ++j)
             {
                 whichneigh = neighbors[j];
                 if (!(marked[whichneigh] & 1))
                 {//skip floating point math if frozen
-                    tempf = output[whichnode] + distances2[whichnode][j];
+                    tempf = output[whichnode] + distances2[neighborStart2[whichnode] + j];
                     if (tempf <= maxDist)
                     {
                         if (!(marked[whichneigh] & 4))
@@ -882,14 +1013,14 @@ int32_t GeodesicHelper::closest(const int32_t& root, const char* roi, const floa
             break;
         }
         marked[whichnode] |= 1;//anything pulled from heap will already be marked as having a valid value (flag 4), so already in changed list
-        neighbors = nodeNeighbors[whichnode].data();
-        numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+        neighbors = nodeNeighbors + neighborStart[whichnode];
+        numNeigh = neighborStart[whichnode + 1] - neighborStart[whichnode];
         for (j = 0; j < numNeigh; ++j)
         {
             whichneigh = neighbors[j];
             if (!(marked[whichneigh] & 1))
             {//skip floating point math if frozen
-                tempf = output[whichnode] + distances[whichnode][j];//isn't precomputation wonderful
+                tempf = output[whichnode] + distances[neighborStart[whichnode] + j];//isn't precomputation wonderful
                 if (tempf <= maxdist)
                 {
                     if (!(marked[whichneigh] & 4))
@@ -912,14 +1043,14 @@ int32_t GeodesicHelper::closest(const int32_t& root, const char* roi, const floa
         }
         if (smooth)//repeat with numNeighbors2, nodeNeighbors2, distance2
         {
-            neighbors = nodeNeighbors2[whichnode].data();
-            numNeigh = (int32_t)nodeNeighbors2[whichnode].size();
+            neighbors = nodeNeighbors2 + neighborStart2[whichnode];
+            numNeigh = neighborStart2[whichnode + 1] - neighborStart2[whichnode];
             for (j = 0; j < numNeigh; ++j)
             {
                 whichneigh = neighbors[j];
                 if (!(marked[whichneigh] & 1))
                 {//skip floating point math if frozen
-                    tempf = output[whichnode] + distances2[whichnode][j];//isn't precomputation wonderful
+                    tempf = output[whichnode] + distances2[neighborStart2[whichnode] + j];//isn't precomputation wonderful
                     if (tempf <= maxdist)
                     {
                         if (!(marked[whichneigh] & 4))
@@ -969,14 +1100,14 @@ int32_t GeodesicHelper::closest(const int32_t& root, const char* roi, bool smoot
             break;
         }
         marked[whichnode] |= 1;//anything pulled from heap will already be marked as having a valid value (flag 4), so already in changed list
-        neighbors = nodeNeighbors[whichnode].data();
-        numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+        neighbors = nodeNeighbors + neighborStart[whichnode];
+        numNeigh = neighborStart[whichnode + 1] - neighborStart[whichnode];
         for (j = 0; j < numNeigh; ++j)
         {
             whichneigh = neighbors[j];
             if (!(marked[whichneigh] & 1))
             {//skip floating point math if frozen
-                tempf = output[whichnode] + distances[whichnode][j];//isn't precomputation wonderful
+                tempf = output[whichnode] + distances[neighborStart[whichnode] + j];//isn't precomputation wonderful
                 if (!(marked[whichneigh] & 4))
                 {
                     parent[whichneigh] = whichnode;
@@ -996,14 +1127,14 @@ int32_t GeodesicHelper::closest(const int32_t& root, const char* roi, bool smoot
         }
         if (smooth)//repeat with numNeighbors2, nodeNeighbors2, distance2
         {
-            neighbors = nodeNeighbors2[whichnode].data();
-            numNeigh = (int32_t)nodeNeighbors2[whichnode].size();
+            neighbors = nodeNeighbors2 + neighborStart2[whichnode];
+            numNeigh = neighborStart2[whichnode + 1] - neighborStart2[whichnode];
             for (j = 0; j < numNeigh; ++j)
             {
                 whichneigh = neighbors[j];
                 if (!(marked[whichneigh] & 1))
                 {//skip floating point math if frozen
-                    tempf = output[whichnode] + distances2[whichnode][j];//isn't precomputation wonderful
+                    tempf = output[whichnode] + distances2[neighborStart2[whichnode] + j];//isn't precomputation wonderful
                     if (!(marked[whichneigh] & 4))
                     {
                         parent[whichneigh] = whichnode;
@@ -1048,14 +1179,14 @@ void GeodesicHelper::aStar(const int32_t root, const int32_t endpoint, bool smoo
         whichnode = m_active.pop();//we use a modifiable heap, so we don't need to check for duplicates
         marked[whichnode] |= 1;//frozen - will already be in changed list, due to being in heap
         if (whichnode == endpoint) break;
-        neighbors = nodeNeighbors[whichnode].data();
-        numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+        neighbors = nodeNeighbors + neighborStart[whichnode];
+        numNeigh = neighborStart[whichnode + 1] - neighborStart[whichnode];
         for (int32_t j = 0; j < numNeigh; ++j)
         {
             whichneigh = neighbors[j];
             if (!(marked[whichneigh] & 1))
             {//skip floating point math if frozen
-                tempf = output[whichnode] + distances[whichnode][j];
+                tempf = output[whichnode] + distances[neighborStart[whichnode] + j];
                 if (!(marked[whichneigh] & 4))
                 {
                     heurVal[whichneigh] = m_corrAreaSmallestFactor * (nodeCoords[whichneigh] - nodeCoords[endpoint]).length();
@@ -1073,14 +1204,14 @@ void GeodesicHelper::aStar(const int32_t root, const int32_t endpoint, bool smoo
         }
         if (smooth)//repeat with numNeighbors2, nodeNeighbors2, distance2
         {
-            neighbors = nodeNeighbors2[whichnode].data();
-            numNeigh = (int32_t)nodeNeighbors2[whichnode].size();
+            neighbors = nodeNeighbors2 + neighborStart2[whichnode];
+            numNeigh = neighborStart2[whichnode + 1] - neighborStart2[whichnode];
             for (int32_t j = 0; j < numNeigh; ++j)
             {
                 whichneigh = neighbors[j];
                 if (!(marked[whichneigh] & 1))
                 {//skip floating point math if frozen
-                    tempf = output[whichnode] + distances2[whichnode][j];
+                    tempf = output[whichnode] + distances2[neighborStart2[whichnode] + j];
                     if (!(marked[whichneigh] & 4))
                     {
                         heurVal[whichneigh] = m_corrAreaSmallestFactor * (nodeCoords[whichneigh] - nodeCoords[endpoint]).length();
@@ -1150,14 +1281,14 @@ void GeodesicHelper::aStarLine(const int32_t& root, const int32_t& endpoint, con
         whichnode = m_active.pop();//we use a modifiable heap, so we don't need to check for duplicates
         marked[whichnode] |= 1;//frozen - will already be in changed list, due to being in heap
         if (whichnode == endpoint) break;
-        neighbors = nodeNeighbors[whichnode].data();
-        numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+        neighbors = nodeNeighbors + neighborStart[whichnode];
+        numNeigh = neighborStart[whichnode + 1] - neighborStart[whichnode];
         for (int32_t j = 0; j < numNeigh; ++j)
         {
             whichneigh = neighbors[j];
             if (!(marked[whichneigh] & 1))
             {//skip floating point math if frozen
-                tempf = output[whichnode] + distances[whichnode][j] + penaltyScale * distances[whichnode][j] * (linePenalty(nodeCoords[whichnode], linep1, linep2, segment) + linePenalty(nodeCoords[whichneigh], linep1, linep2, segment));
+                tempf = output[whichnode] + distances[neighborStart[whichnode] + j] + penaltyScale * distances[neighborStart[whichnode] + j] * (linePenalty(nodeCoords[whichnode], linep1, linep2, segment) + linePenalty(nodeCoords[whichneigh], linep1, linep2, segment));
                 if (!(marked[whichneigh] & 4))
                 {
                     remainEucl = (nodeCoords[whichneigh] - nodeCoords[endpoint]).length();
@@ -1198,14 +1329,14 @@ void GeodesicHelper::aStarData(const int32_t& root, const int32_t& endpoint, con
         whichnode = m_active.pop();//we use a modifiable heap, so we don't need to check for duplicates
         marked[whichnode] |= 1;//frozen - will already be in changed list, due to being in heap
         if (whichnode == endpoint) break;
-        neighbors = nodeNeighbors[whichnode].data();
-        numNeigh = (int32_t)nodeNeighbors[whichnode].size();
+        neighbors = nodeNeighbors + neighborStart[whichnode];
+        numNeigh = neighborStart[whichnode + 1] - neighborStart[whichnode];
         for (int32_t j = 0; j < numNeigh; ++j)
         {
             whichneigh = neighbors[j];
             if ((roiData == NULL || roiData[whichneigh] > 0.0f) && !(marked[whichneigh] & 1))
             {//skip floating point math if frozen or outside roi
-                tempf = output[whichnode] + distances[whichnode][j] * (1.0f + followStrength * (data[whichnode] + data[whichneigh]));//integrate 1 + strength * value to get distance plus path-integrated data
+                tempf = output[whichnode] + distances[neighborStart[whichnode] + j] * (1.0f + followStrength * (data[whichnode] + data[whichneigh]));//integrate 1 + strength * value to get distance plus path-integrated data
                 if (!(marked[whichneigh] & 4))
                 {
                     heurVal[whichneigh] = m_corrAreaSmallestFactor * (nodeCoords[whichneigh] - nodeCoords[endpoint]).length();
@@ -1223,16 +1354,16 @@ void GeodesicHelper::aStarData(const int32_t& root, const int32_t& endpoint, con
         }
         if (smooth)//repeat with numNeighbors2, nodeNeighbors2, distance2
         {
-            neighbors = nodeNeighbors2[whichnode].data();
-            numNeigh = (int32_t)nodeNeighbors2[whichnode].size();
-            const GeodesicHelperBase::CrawlInfo* pathInfo = neighbors2PathInfo[whichnode].data();
+            neighbors = nodeNeighbors2 + neighborStart2[whichnode];
+            numNeigh = neighborStart2[whichnode + 1] - neighborStart2[whichnode];
+            const GeodesicHelperBase::CrawlInfo* pathInfo = neighbors2PathInfo + neighborStart2[whichnode];
             for (int32_t j = 0; j < numNeigh; ++j)
             {
                 whichneigh = neighbors[j];
                 if ((roiData == NULL || roiData[whichneigh] > 0.0f) && !(marked[whichneigh] & 1))
                 {//skip floating point math if frozen or outside roi
-                    tempf = output[whichnode] + distances2[whichnode][j] + followStrength * (data[whichnode] * pathInfo[j].pieceDists[0] + data[whichneigh] * pathInfo[j].pieceDists[1]
-                                + distances2[whichnode][j] * (data[pathInfo[j].edgeNodes[0]] * pathInfo[j].edgeWeight + data[pathInfo[j].edgeNodes[1]] * (1.0f - pathInfo[j].edgeWeight)));
+                    tempf = output[whichnode] + distances2[neighborStart2[whichnode] + j] + followStrength * (data[whichnode] * pathInfo[j].pieceDists[0] + data[whichneigh] * pathInfo[j].pieceDists[1]
+                                + distances2[neighborStart2[whichnode] + j] * (data[pathInfo[j].edgeNodes[0]] * pathInfo[j].edgeWeight + data[pathInfo[j].edgeNodes[1]] * (1.0f - pathInfo[j].edgeWeight)));
                     if (!(marked[whichneigh] & 4))
                     {
                         heurVal[whichneigh] = m_corrAreaSmallestFactor * (nodeCoords[whichneigh] - nodeCoords[endpoint]).length();
@@ -51,13 +51,17 @@ namespace caret {
         GeodesicHelperBase();//can't construct without arguments
         GeodesicHelperBase& operator=(const GeodesicHelperBase& right);//can't assign
         GeodesicHelperBase(const GeodesicHelperBase& right);//can't use copy constructor
-        std::vector<std::vector<float> > distances, distances2;
-        std::vector<std::vector<int32_t> > nodeNeighbors, nodeNeighbors2;
-        std::vector<std::vector<CrawlInfo> > neighbors2PathInfo;
+        std::vector<int32_t> neighborStart, neighborStart2;//CSR offsets, neighbors of node i are [neighborStart[i], neighborStart[i + 1]) in nodeNeighbors and distances
+        std::vector<int32_t> nodeNeighbors, nodeNeighbors2;
+        std::vector<float> distances, distances2;
+        std::vector<CrawlInfo> neighbors2PathInfo;//indexed like nodeNeighbors2
+        float m_minEdgeLength, m_maxEdgeLength;//over both kinds of neighbors, for sizing bucket queues
         std::vector<Vector3D> nodeCoords;//for line-following and A*
         int32_t numNodes;
         float m_avgNodeSpacing;//to use for balancing line following penalty
         float m_corrAreaSmallestFactor;//so that heuristics can be consistent despite corrected areas
+        static void flattenLists(const std::vector<std::vector<int32_t> >& neighborLists, const std::vector<std::vector<float> >& distanceLists,
+                                 std::vector<int32_t>& startOut, std::vector<int32_t>& neighborsOut, std::vector<float>& distancesOut);
     public:
         explicit GeodesicHelperBase(const SurfaceFile* surfaceIn, const float* correctedAreas = NULL);//NOTE: this is only an APPROXIMATE correction, use the real surface whenever possible
         friend class GeodesicHelper;//let it grab the private variables it needs
@@ -68,9 +72,12 @@ namespace caret {
         CaretPointer<const GeodesicHelperBase> m_myBase;//mostly just for automatic memory management
         CaretMutex inUse;//could add a function and a locker pointer to be able to lock to thread once, then call repeatedly without locking, if mutex overhead is actually a factor
         CaretMinHeap<int32_t, float> m_active;//save and reuse the allocated space
-        const std::vector<float>* distances, *distances2;
-        const std::vector<int32_t>* nodeNeighbors, *nodeNeighbors2;
-        const std::vector<GeodesicHelperBase::CrawlInfo>* neighbors2PathInfo;
+        const float* distances, *distances2;
+        const int32_t* nodeNeighbors, *nodeNeighbors2, *neighborStart, *neighborStart2;
+        const GeodesicHelperBase::CrawlInfo* neighbors2PathInfo;
+        std::vector<std::vector<int32_t> > m_buckets;//circular dial queue for bounded searches, empty if edge lengths vary too much to use it
+        float m_bucketWidth;
+        bool m_useBuckets;
         const Vector3D* nodeCoords;
         float* output;
         int32_t* parent;
@@ -85,6 +92,7 @@ namespace caret {
         GeodesicHelper& operator=(const GeodesicHelper& right);//can't assign
         GeodesicHelper(const GeodesicHelper&);//can't use copy constructor
         void dijkstra(const int32_t root, const float maxdist, std::vector<int32_t>& nodes, std::vector<float>& dists, bool smooth);//geodesic distance restricted
+        void dijkstraBuckets(const int32_t root, const float maxdist, std::vector<int32_t>& nodes, std::vector<float>& dists, bool smooth);//same, with the dial queue
         void dijkstra(const int32_t root, bool smooth);//full surface
         void dijkstra(const int32_t root, const std::vector<int32_t>& interested, bool smooth);//partial surface
         int32_t dijkstra(const std::vector<int32_t>& startList, const std::vector<int32_t>& endList, const float& maxDist, bool smooth);//one path that connects lists
@@ -98,6 +106,9 @@ namespace caret {
         void aStarData(const int32_t& root, const int32_t& endpoint, const float* data, const float& followStrength, const float* roiData, const bool& smooth);//to single endpoint, following data
     public:
         explicit GeodesicHelper(const CaretPointer<const GeodesicHelperBase>& baseIn);
+        ///choose between the bucket queue (default, when the mesh allows it) and the heap for distance-limited searches - distances are the same, order within a bucket may differ
+        void setUseBucketQueue(const bool& useBuckets) { m_useBuckets = useBuckets; }
+        bool isUsingBucketQueue() const { return m_useBuckets && !m_buckets.empty(); }
         /// Get distances from root node, up to a geodesic distance cutoff (stops computing when no more nodes are within that distance)
         void getNodesToGeoDist(const int32_t node, const float maxdist, std::vector<int32_t>& neighborsOut, std::vector<float>& distsOut, const bool smoothflag = true);
 
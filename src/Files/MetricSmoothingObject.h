@@ -52,6 +52,9 @@ namespace caret {
         void smoothColumn(const MetricFile* metricIn, const int& whichColumn, MetricFile* columnOut, const MetricFile* roi = NULL, const bool& fixZeros = false) const;
         void smoothColumn(const MetricFile* metricIn, const int& whichColumn, MetricFile* metricOut, const int& whichOutColumn, const MetricFile* roi = NULL, const int& whichRoiColumn = 0, const bool& fixZeros = false) const;
         void smoothMetric(const MetricFile* metricIn, MetricFile* metricOut, const MetricFile* roi = NULL, const bool& fixZeros = false) const;
+        ///smooth numColumns consecutive columns starting at firstColumn into consecutive columns of metricOut, reading each weight once per block of columns instead of once per column
+        void smoothColumns(const MetricFile* metricIn, const int& firstColumn, const int& numColumns, MetricFile* metricOut, const int& firstOutColumn,
+                           const MetricFile* roi = NULL, const int& whichRoiColumn = 0, const bool& fixZeros = false) const;
     private:
         struct WeightList
         {
@@ -59,16 +62,22 @@ namespace caret {
             std::vector<float> m_weights;
             float m_weightSum;
         };
-        std::vector<WeightList> m_weightLists;
+        static const int COLUMN_BLOCK = 16;//columns smoothed per pass over the weights
+        int32_t m_numNodes;
+        std::vector<int64_t> m_rowStarts;//CSR form of the gathering kernels, weights for node i are [m_rowStarts[i], m_rowStarts[i + 1])
+        std::vector<int32_t> m_neighbors;
+        std::vector<float> m_weights;
+        std::vector<float> m_weightSums;
         void smoothColumnInternal(float* scratch, const MetricFile* metricIn, const int& whichColumn, MetricFile* metricOut, const int& whichOutColumn, const bool& fixZeros) const;
         void smoothColumnInternal(float* scratch, const MetricFile* metricIn, const int& whichColumn, MetricFile* metricOut, const int& whichOutColumn, const MetricFile* roi, const int& whichRoiColumn, const bool& fixZeros) const;
+        void smoothBlockInternal(const float* blockIn, float* blockOut, const int& blockSize, const float* roiColumn, const bool& fixZeros) const;
         void precomputeWeights(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, Method myMethod, const float* nodeAreas);
-        void precomputeWeightsGeoGauss(const SurfaceFile* mySurf, float myKernel);
-        void precomputeWeightsROIGeoGauss(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi);
-        void precomputeWeightsGeoGaussArea(const SurfaceFile* mySurf, float myKernel, const float* nodeAreas);
-        void precomputeWeightsROIGeoGaussArea(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, const float* nodeAreas);
-        void precomputeWeightsGeoGaussEqual(const SurfaceFile* mySurf, float myKernel);
-        void precomputeWeightsROIGeoGaussEqual(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi);
+        void precomputeWeightsGeoGauss(const SurfaceFile* mySurf, float myKernel, std::vector<WeightList>& weightLists);
+        void precomputeWeightsROIGeoGauss(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, std::vector<WeightList>& weightLists);
+        void precomputeWeightsGeoGaussArea(const SurfaceFile* mySurf, float myKernel, const float* nodeAreas, std::vector<WeightList>& weightLists);
+        void precomputeWeightsROIGeoGaussArea(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, const float* nodeAreas, std::vector<WeightList>& weightLists);
+        void precomputeWeightsGeoGaussEqual(const SurfaceFile* mySurf, float myKernel, std::vector<WeightList>& weightLists);
+        void precomputeWeightsROIGeoGaussEqual(const SurfaceFile* mySurf, float myKernel, const MetricFile* theRoi, std::vector<WeightList>& weightLists);
         MetricSmoothingObject();
     };
     
@@ -180,19 +180,42 @@ NodeAndVoxelColoring::colorScalarsWithPalettePrivate(const FastStatistics* stati
                                                           numberOfScalars);
     
     /*
-     * Get color for normalized values of -1.0 and 1.0.
-     * Since there may be a large number of values that are -1.0 or 1.0
-     * we can compute the color only once for these values and save time.
+     * Colors are taken from a lookup table built once per palette
+     * instead of searching the palette for each scalar.
      */
-    float rgbaPositiveOne[4], rgbaNegativeOne[4];
-    palette->getPaletteColor(1.0,
-                             interpolateFlag,
-                             rgbaPositiveOne);
-    const bool rgbaPositiveOneValid = (rgbaPositiveOne[3] > 0.0);
-    palette->getPaletteColor(-1.0,
-                             interpolateFlag,
-                             rgbaNegativeOne);
-    const bool rgbaNegativeOneValid = (rgbaNegativeOne[3] > 0.0);
+    const CaretPointer<const Palette::ColorLookupTable> paletteLookupTable = palette->getPaletteColorLookupTable(interpolateFlag);
+    
+    /*
+     * Find the scalars that are displayed (sign and NaN tests) and those
+     * that pass the threshold test in one branch free pass over the map
+     * so that the compiler can vectorize it.  0 = not displayed,
+     * 1 = displayed and passes threshold, 2 = displayed and fails threshold.
+     */
+    const bool showPositiveValues = ( ! hidePositiveValues);
+    const bool showNegativeValues = ( ! hideNegativeValues);
+    const bool showZeroValues     = ( ! hideZeroValues);
+    std::vector<uint8_t> displayMaskVector(numberOfScalars);
+    uint8_t* displayMask = (numberOfScalars > 0) ? &displayMaskVector[0] : NULL;
+#pragma omp CARET_PARFOR schedule(static)
+    for (int64_t i = 0; i < numberOfScalars; i++) {
+        const float scalar = scalarValues[i];
+        const bool positiveFlag = (scalar > PaletteColorMapping::SMALL_POSITIVE);
+        const bool negativeFlag = (scalar < PaletteColorMapping::SMALL_NEGATIVE);
+        const bool zeroFlag     = (( ! positiveFlag) & ( ! negativeFlag) & (scalar == scalar));//TSC: never color NaN
+        const bool displayedFlag = ((positiveFlag & showPositiveValues)
+                                    | (negativeFlag & showNegativeValues)
+                                    | (zeroFlag & showZeroValues));
+        
+        const float threshold = thresholdValues[i];
+        const bool insideFlag  = ((threshold >= thresholdMinimum) & (threshold <= thresholdMaximum));
+        const bool outsideFlag = ((threshold > thresholdMaximum) | (threshold < thresholdMinimum));
+        const bool thresholdPassedFlag = (skipThresholdTesting
+                                          | (showOutsideFlag ? outsideFlag : insideFlag));
+        
+        displayMask[i] = (displayedFlag
+                          ? (thresholdPassedFlag ? 1 : 2)
+                          : 0);
+    }
     
     /*
      * Color all scalars.
@@ -221,39 +244,15 @@ NodeAndVoxelColoring::colorScalarsWithPalettePrivate(const FastStatistics* stati
                 break;
         }
         
-        float scalar = scalarValues[i];
-        const float threshold = thresholdValues[i];
-        
         /*
          * Positive/Zero/Negative Test
          */
-        if (scalar > PaletteColorMapping::SMALL_POSITIVE) {   // JWH 24 April 2015    NodeAndVoxelColoring::SMALL_POSITIVE) {
-            if (hidePositiveValues) {
-                continue;
-            }
-        }
-        else if (scalar < PaletteColorMapping::SMALL_NEGATIVE) {  // JWH 24 April 2015  NodeAndVoxelColoring::SMALL_NEGATIVE) {
-            if (hideNegativeValues) {
-                continue;
-            }
-        }
-        else if (MathFunctions::isNaN(scalar)) {
-            continue;//TSC: never color NaN
-        } else {
-            /*
-             * May be very near zero so force to zero.
-             * 
-             * TSC: that seems wrong, leave the normalized value alone
-             *  if the data value is near zero, that doesn't mean the palette settings aren't also near zero
-             *  therefore, normalized value may not be near zero, which is important
-             * 
-             */
-            //normalizedValues[i] = 0.0;
-            if (hideZeroValues) {
-                continue;
-            }
+        if (displayMask[i] == 0) {
+            continue;
         }
         
+        const float threshold = thresholdValues[i];
+        
         /*
          * Temporary for rgba coloring now that past possible
          * continue statements
@@ -268,38 +267,17 @@ NodeAndVoxelColoring::colorScalarsWithPalettePrivate(const FastStatistics* stati
         const float normalValue = normalizedValues[i];
         
         /*
-         * RGBA colors have been mapped for extreme values
+         * Color scalar using palette
          */
-        if (normalValue >= 1.0) {
-            if (rgbaPositiveOneValid) {
-                rgbaOut[0] = rgbaPositiveOne[0];
-                rgbaOut[1] = rgbaPositiveOne[1];
-                rgbaOut[2] = rgbaPositiveOne[2];
-                rgbaOut[3] = rgbaPositiveOne[3];
-            }
-        }
-        else if (normalValue <= -1.0) {
-            if (rgbaNegativeOneValid) {
-                rgbaOut[0] = rgbaNegativeOne[0];
-                rgbaOut[1] = rgbaNegativeOne[1];
-                rgbaOut[2] = rgbaNegativeOne[2];
-                rgbaOut[3] = rgbaNegativeOne[3];
-            }
-        }
-        else {
-            /*
-             * Color scalar using palette
-             */
-            float rgba[4];
-            palette->getPaletteColor(normalValue,
-                                     interpolateFlag,
+        float rgba[4];
+        palette->getLookupTableColor(*paletteLookupTable,
+                                     normalValue,
                                      rgba);
-            if (rgba[3] > 0.0f) {
-                rgbaOut[0] = rgba[0];
-                rgbaOut[1] = rgba[1];
-                rgbaOut[2] = rgba[2];
-                rgbaOut[3] = rgba[3];
-            }
+        if (rgba[3] > 0.0f) {
+            rgbaOut[0] = rgba[0];
+            rgbaOut[1] = rgba[1];
+            rgbaOut[2] = rgba[2];
+            rgbaOut[3] = rgba[3];
         }
         
         /*
@@ -307,24 +285,7 @@ NodeAndVoxelColoring::colorScalarsWithPalettePrivate(const FastStatistics* stati
          * Threshold is done last so colors are still set
          * but if threshold test fails, alpha is set invalid.
          */
-        bool thresholdPassedFlag = false;
-        if (skipThresholdTesting) {
-            thresholdPassedFlag = true;
-        }
-        else if (showOutsideFlag) {
-            if (threshold > thresholdMaximum) {
-                thresholdPassedFlag = true;
-            }
-            else if (threshold < thresholdMinimum) {
-                thresholdPassedFlag = true;
-            }
-        }
-        else {
-            if ((threshold >= thresholdMinimum) &&
-                (threshold <= thresholdMaximum)) {
-                thresholdPassedFlag = true;
-            }
-        }
+        const bool thresholdPassedFlag = (displayMask[i] == 1);
         if (thresholdPassedFlag == false) {
             rgbaOut[3] = 0.0;
             if (showMappedThresholdFailuresInGreen) {
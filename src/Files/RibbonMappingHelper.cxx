@@ -54,6 +54,7 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 #include "TopologyHelper.h"
 #include "VolumeSpace.h"
 
+#include <algorithm>
 #include <cmath>
 
 using namespace caret;
@@ -63,15 +64,34 @@ using namespace std;
 namespace
 {
     
+    struct SampleScratch
+    {//per-thread arrays for testing all sample points of a voxel at once
+        std::vector<float> m_x, m_y, m_z;
+        std::vector<char> m_toggle, m_half, m_hit[4];
+        void resize(const int numPoints)
+        {
+            m_x.resize(numPoints); m_y.resize(numPoints); m_z.resize(numPoints);
+            m_toggle.resize(numPoints); m_half.resize(numPoints);
+            for (int i = 0; i < 4; ++i) m_hit[i].resize(numPoints);
+        }
+    };
+    
     struct TriInfo
     {
         Vector3D m_xyz[3];
         float m_planeEq[3];//x coef, y coef, const : z = [0] * x + [1] * y + [2]
         bool vertRayHit(const float* xyz);//true if a +z ray from point hits this triangle
+        void vertRayHitBatch(const float* x, const float* y, const float* z, const int numPoints, char* hitOut) const;//same test on many points, without branches in the point loop
         TriInfo(const float* xyz1, const float* xyz2, const float* xyz3);
         TriInfo() {};
     };
     
+    struct IndexTri
+    {//triangle in voxel index space for the exact overlap computation
+        Vector3D m_ijk[3];
+        float m_weight;//1 for the real triangles, 0.5 for each triangle of both triangulations of a quad
+    };
+    
     struct QuadInfo
     {
         TriInfo m_tris[2][2];
@@ -87,7 +107,12 @@ namespace
         PolyInfo(const SurfaceFile* innerSurf, const SurfaceFile* outerSurf, const int32_t node, const bool& thinColumn = false);//surfaces MUST be in node correspondence, otherwise SEVERE strangeness, possible crashes
         PolyInfo() {};
         int isInside(const float* xyz);//0 for no, 2 for yes, 1 for if only half the triangulations (between the two triangulations of one of the quad faces)
+        int countInside(SampleScratch& scratch, const int numPoints);//sum of isInside over the points in the scratch arrays
+        void prepareOverlap(const VolumeSpace& myVolSpace);//converts the faces to index space, must be called before overlapFraction
+        float overlapFraction(const int64_t* ijk) const;//exact fraction of the voxel inside the polyhedron, counting between the quad triangulations as half, like isInside
     private:
+        std::vector<IndexTri> m_indexTris;
+        float m_orientation;//1 if the faces point outward in index space, -1 if inward
         void addTri(const SurfaceFile* innerSurf, const SurfaceFile* outerSurf, const int32_t* myTri, const int rootIndex, const bool& thinColumn);//adds the tri for each surface, plus the quad
     };
     
@@ -141,6 +166,166 @@ namespace
         if (toggle) return 2;
         return 0;
     }
+    
+    int PolyInfo::countInside(SampleScratch& scratch, const int numPoints)
+    {
+        const float* x = scratch.m_x.data(), *y = scratch.m_y.data(), *z = scratch.m_z.data();
+        char* toggle = scratch.m_toggle.data(), *half = scratch.m_half.data();
+        for (int p = 0; p < numPoints; ++p)
+        {
+            toggle[p] = 0;
+            half[p] = 0;
+        }
+        int numQuads = (int)m_quads.size();
+        for (int i = 0; i < numQuads; ++i)
+        {
+            const QuadInfo& thisQuad = m_quads[i];
+            thisQuad.m_tris[0][0].vertRayHitBatch(x, y, z, numPoints, scratch.m_hit[0].data());
+            thisQuad.m_tris[0][1].vertRayHitBatch(x, y, z, numPoints, scratch.m_hit[1].data());
+            thisQuad.m_tris[1][0].vertRayHitBatch(x, y, z, numPoints, scratch.m_hit[2].data());
+            thisQuad.m_tris[1][1].vertRayHitBatch(x, y, z, numPoints, scratch.m_hit[3].data());
+            const char* hit0 = scratch.m_hit[0].data(), *hit1 = scratch.m_hit[1].data(), *hit2 = scratch.m_hit[2].data(), *hit3 = scratch.m_hit[3].data();
+            for (int p = 0; p < numPoints; ++p)
+            {
+                char first = hit0[p] ^ hit1[p], second = hit2[p] ^ hit3[p];
+                half[p] |= first ^ second;//only one triangulation hits, isInside returns 1 regardless of the other faces
+                toggle[p] ^= first;
+            }
+        }
+        int numTris = (int)m_tris.size();
+        char* hit = scratch.m_hit[0].data();
+        for (int i = 0; i < numTris; ++i)
+        {
+            m_tris[i].vertRayHitBatch(x, y, z, numPoints, hit);
+            for (int p = 0; p < numPoints; ++p)
+            {
+                toggle[p] ^= hit[p];
+            }
+        }
+        int ret = 0;
+        for (int p = 0; p < numPoints; ++p)
+        {
+            ret += (half[p] ? 1 : toggle[p] * 2);
+        }
+        return ret;
+    }
+    
+    void PolyInfo::prepareOverlap(const VolumeSpace& myVolSpace)
+    {
+        m_indexTris.clear();
+        int numTris = (int)m_tris.size(), numQuads = (int)m_quads.size();
+        m_indexTris.reserve(numTris + numQuads * 4);
+        IndexTri tempTri;
+        for (int i = 0; i < numTris + numQuads * 4; ++i)
+        {
+            TriInfo* thisTri;
+            if (i < numTris)
+            {
+                thisTri = &(m_tris[i]);
+                tempTri.m_weight = 1.0f;
+            } else {
+                int quad = (i - numTris) / 4, which = (i - numTris) % 4;
+                thisTri = &(m_quads[quad].m_tris[which / 2][which % 2]);
+                tempTri.m_weight = 0.5f;
+            }
+            for (int j = 0; j < 3; ++j)
+            {
+                myVolSpace.spaceToIndex(thisTri->m_xyz[j], tempTri.m_ijk[j]);
+            }
+            m_indexTris.push_back(tempTri);
+        }
+        double totalVolume = 0.0;//divergence theorem, to find whether the faces point inward or outward after the index space transform
+        for (int i = 0; i < (int)m_indexTris.size(); ++i)
+        {
+            const IndexTri& thisTri = m_indexTris[i];
+            totalVolume += thisTri.m_weight * thisTri.m_ijk[0].dot(thisTri.m_ijk[1].cross(thisTri.m_ijk[2]));
+        }
+        m_orientation = (totalVolume < 0.0 ? -1.0f : 1.0f);
+    }
+    
+    //keep the part of a convex polygon that has coordinate "axis" above (or below) the limit, returns the new number of vertices
+    int clipPolygon(const Vector3D* polyIn, const int numIn, const int axis, const float limit, const bool keepAbove, Vector3D* polyOut)
+    {
+        int numOut = 0;
+        for (int i = 0, prev = numIn - 1; i < numIn; prev = i, ++i)
+        {
+            float prevOffset = polyIn[prev][axis] - limit, thisOffset = polyIn[i][axis] - limit;
+            if (!keepAbove)
+            {
+                prevOffset = -prevOffset;
+                thisOffset = -thisOffset;
+            }
+            if ((prevOffset >= 0.0f) != (thisOffset >= 0.0f))
+            {//edge crosses the limit, add the crossing point
+                float t = prevOffset / (prevOffset - thisOffset);
+                polyOut[numOut] = polyIn[prev] + (polyIn[i] - polyIn[prev]) * t;
+                polyOut[numOut][axis] = limit;
+                ++numOut;
+            }
+            if (thisOffset >= 0.0f)
+            {
+                polyOut[numOut] = polyIn[i];
+                ++numOut;
+            }
+        }
+        return numOut;
+    }
+    
+    float PolyInfo::overlapFraction(const int64_t* ijk) const
+    {//the integral of F = (0, 0, clamp(z, zlow, zhigh) - zlow) over the surface of the part of the polyhedron inside the voxel's vertical column is the volume inside the voxel,
+        //the column walls contribute nothing, and the unit voxel makes the index space volume the fraction
+        const int MAX_VERTS = 12;//a triangle clipped by 6 planes has at most 9 vertices
+        float low[3], high[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            low[i] = ijk[i] - 0.5f;
+            high[i] = ijk[i] + 0.5f;
+        }
+        double volume = 0.0;
+        Vector3D bufferA[MAX_VERTS], bufferB[MAX_VERTS];
+        int numIndexTris = (int)m_indexTris.size();
+        for (int t = 0; t < numIndexTris; ++t)
+        {
+            const IndexTri& thisTri = m_indexTris[t];
+            bool outside = false;
+            for (int axis = 0; axis < 3 && !outside; ++axis)
+            {
+                float triMin = min(min(thisTri.m_ijk[0][axis], thisTri.m_ijk[1][axis]), thisTri.m_ijk[2][axis]);
+                float triMax = max(max(thisTri.m_ijk[0][axis], thisTri.m_ijk[1][axis]), thisTri.m_ijk[2][axis]);
+                if (triMax <= low[axis] || (axis < 2 && triMin >= high[axis]))
+                {//outside the column, or entirely below the voxel, where F is 0 - above the voxel, F is 1, so those count
+                    outside = true;
+                }
+            }
+            if (outside) continue;
+            bufferA[0] = thisTri.m_ijk[0]; bufferA[1] = thisTri.m_ijk[1]; bufferA[2] = thisTri.m_ijk[2];
+            int numVerts = 3;
+            numVerts = clipPolygon(bufferA, numVerts, 0, low[0], true, bufferB);
+            numVerts = clipPolygon(bufferB, numVerts, 0, high[0], false, bufferA);
+            numVerts = clipPolygon(bufferA, numVerts, 1, low[1], true, bufferB);
+            numVerts = clipPolygon(bufferB, numVerts, 1, high[1], false, bufferA);
+            if (numVerts < 3) continue;
+            double triVolume = 0.0;
+            Vector3D above[MAX_VERTS], middle[MAX_VERTS];
+            int numAbove = clipPolygon(bufferA, numVerts, 2, high[2], true, above);//F is constant (zhigh - zlow = 1) above the voxel
+            for (int i = 2; i < numAbove; ++i)
+            {
+                triVolume += ((above[i - 1][0] - above[0][0]) * (above[i][1] - above[0][1]) - (above[i][0] - above[0][0]) * (above[i - 1][1] - above[0][1])) * 0.5;
+            }
+            int numMiddle = clipPolygon(bufferA, numVerts, 2, low[2], true, bufferB);
+            numMiddle = clipPolygon(bufferB, numMiddle, 2, high[2], false, middle);//F is linear inside the voxel, so its integral is the area times its value at the centroid
+            for (int i = 2; i < numMiddle; ++i)
+            {
+                double area = ((middle[i - 1][0] - middle[0][0]) * (middle[i][1] - middle[0][1]) - (middle[i][0] - middle[0][0]) * (middle[i - 1][1] - middle[0][1])) * 0.5;
+                triVolume += area * ((middle[0][2] + middle[i - 1][2] + middle[i][2]) / 3.0 - low[2]);
+            }
+            volume += thisTri.m_weight * triVolume;
+        }
+        volume *= m_orientation;
+        if (volume < 0.0) return 0.0f;//self-intersecting polyhedra can give negative values
+        if (volume > 1.0) return 1.0f;
+        return (float)volume;
+    }
 
     PolyInfo::PolyInfo(const caret::SurfaceFile* innerSurf, const caret::SurfaceFile* outerSurf, const int32_t node, const bool& thinColumn)
     {
@@ -237,12 +422,54 @@ namespace
         return inside;
     }
     
+    void TriInfo::vertRayHitBatch(const float* x, const float* y, const float* z, const int numPoints, char* hitOut) const
+    {//same arithmetic as vertRayHit, with the per-edge parts hoisted out so the point loop can vectorize
+        if (!MathFunctions::isNumeric(m_planeEq[0]))
+        {
+            for (int p = 0; p < numPoints; ++p) hitOut[p] = 0;
+            return;
+        }
+        float edgeX[3], edgeY[3], edgeSlope[3], edgeEndX[3];
+        for (int j = 2, i = 0; i < 3; ++i)
+        {
+            int ti, tj;
+            if (m_xyz[i][0] < m_xyz[j][0])
+            {
+                ti = i; tj = j;
+            } else {
+                ti = j; tj = i;
+            }
+            edgeX[i] = m_xyz[tj][0];
+            edgeY[i] = m_xyz[tj][1];
+            edgeSlope[i] = (m_xyz[ti][1] - m_xyz[tj][1]) / (m_xyz[ti][0] - m_xyz[tj][0]);//inf or nan for vertical edges, but those never cross
+            edgeEndX[i] = m_xyz[ti][0];
+            j = i;
+        }
+        const float a = m_planeEq[0], b = m_planeEq[1], c = m_planeEq[2];
+        for (int p = 0; p < numPoints; ++p)
+        {
+            char inside = 0;
+            for (int e = 0; e < 3; ++e)
+            {
+                char crosses = ((edgeX[e] < x[p]) != (edgeEndX[e] < x[p]));
+                char isAbove = (edgeSlope[e] * (x[p] - edgeX[e]) + edgeY[e] > y[p]);
+                inside ^= (crosses & isAbove);
+            }
+            char below = (z[p] < x[p] * a + y[p] * b + c);
+            hitOut[p] = inside & below;
+        }
+    }
+    
     float computeVoxelFraction(const VolumeSpace& myVolSpace, const int64_t* ijk, PolyInfo& myPoly, const int divisions,
-                               const Vector3D& ivec, const Vector3D& jvec, const Vector3D& kvec)
+                               const Vector3D& ivec, const Vector3D& jvec, const Vector3D& kvec, SampleScratch& scratch, const bool& batched)
     {
+        if (divisions == 0)
+        {
+            return myPoly.overlapFraction(ijk);
+        }
         Vector3D myLowCorner;
         myVolSpace.indexToSpace(ijk[0] - 0.5f, ijk[1] - 0.5f, ijk[2] - 0.5f, myLowCorner);
-        int inside = 0;
+        int numPoints = 0;
         Vector3D istep = ivec / divisions;
         Vector3D jstep = jvec / divisions;
         Vector3D kstep = kvec / divisions;
@@ -256,25 +483,39 @@ namespace
                 for (int k = 0; k < divisions; ++k)
                 {
                     Vector3D thisPoint = tempVecj + kstep * k;
-                    inside += myPoly.isInside(thisPoint);
+                    scratch.m_x[numPoints] = thisPoint[0];
+                    scratch.m_y[numPoints] = thisPoint[1];
+                    scratch.m_z[numPoints] = thisPoint[2];
+                    ++numPoints;
                 }
             }
         }
+        int inside = 0;
+        if (batched)
+        {
+            inside = myPoly.countInside(scratch, numPoints);
+        } else {
+            for (int p = 0; p < numPoints; ++p)
+            {
+                float xyz[3] = { scratch.m_x[p], scratch.m_y[p], scratch.m_z[p] };
+                inside += myPoly.isInside(xyz);
+            }
+        }
         return ((float)inside) / (divisions * divisions * divisions * 2);
     }
     
 }
 
 void RibbonMappingHelper::computeWeightsRibbon(vector<vector<VoxelWeight> >& myWeightsOut, const VolumeSpace& myVolSpace, const SurfaceFile* innerSurf, const SurfaceFile* outerSurf,
-                                               const float* roiFrame, const int& numDivisions, const bool& thinColumn)
+                                               const float* roiFrame, const int& numDivisions, const bool& thinColumn, const bool& batchedSamples)
 {
     if (!innerSurf->hasNodeCorrespondence(*outerSurf))
     {
         throw CaretException("input surfaces to ribbon mapping do not have vertex correspondence");
     }
-    if (numDivisions < 1)
+    if (numDivisions < 0)
     {
-        throw CaretException("number of voxel subdivisions must be positive for ribbon mapping");
+        throw CaretException("number of voxel subdivisions must not be negative for ribbon mapping");
     }
     int64_t numNodes = outerSurf->getNumberOfNodes();
     myWeightsOut.resize(numNodes);
@@ -287,6 +528,8 @@ void RibbonMappingHelper::computeWeightsRibbon(vector<vector<VoxelWeight> >& myW
     {
         int maxVoxelCount = 10;//guess for preallocating vectors
         CaretPointer<TopologyHelper> myTopoHelp = innerSurf->getTopologyHelper();
+        SampleScratch scratch;
+        scratch.resize(numDivisions * numDivisions * numDivisions);
 #pragma omp CARET_FOR schedule(dynamic)
         for (int64_t node = 0; node < numNodes; ++node)
         {
@@ -295,6 +538,7 @@ void RibbonMappingHelper::computeWeightsRibbon(vector<vector<VoxelWeight> >& myW
             float tempf;
             int64_t node3 = node * 3;
             PolyInfo myPoly(innerSurf, outerSurf, node, thinColumn);//build the polygon
+            if (numDivisions == 0) myPoly.prepareOverlap(myVolSpace);
             Vector3D minIndex, maxIndex, tempvec;
             myVolSpace.spaceToIndex(innerCoords + node3, minIndex);//find the bounding box in VOLUME INDEX SPACE, starting with the center nodes
             maxIndex = minIndex;
@@ -339,7 +583,7 @@ void RibbonMappingHelper::computeWeightsRibbon(vector<vector<VoxelWeight> >& myW
                     {
                         if (roiFrame == NULL || roiFrame[myVolSpace.getIndex(ijk)] > 0.0f)
                         {
-                            tempf = computeVoxelFraction(myVolSpace, ijk, myPoly, numDivisions, ivec, jvec, kvec);
+                            tempf = computeVoxelFraction(myVolSpace, ijk, myPoly, numDivisions, ivec, jvec, kvec, scratch, batchedSamples);
                             if (tempf != 0.0f)
                             {
                                 myWeightsOut[node].push_back(VoxelWeight(tempf, ijk));
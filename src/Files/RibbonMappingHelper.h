@@ -49,9 +49,12 @@ namespace caret
     {
     public:
         ///compute per-vertex ribbon mapping weights - surfaces must have vertex correspondence, or an exception is thrown
+        ///numDivisions of 0 computes the exact overlap of each voxel with the polyhedron instead of sampling NxNxN points
+        ///batchedSamples false tests the sample points one at a time, which gives identical weights more slowly, for checking the batched test
         static void computeWeightsRibbon(std::vector<std::vector<VoxelWeight> >& myWeightsOut, const VolumeSpace& myVolSpace,
                                          const SurfaceFile* innerSurf, const SurfaceFile* outerSurf,
-                                         const float* roiFrame = NULL, const int& numDivisions = 3, const bool& thinColumn = false);
+                                         const float* roiFrame = NULL, const int& numDivisions = 3, const bool& thinColumn = false,
+                                         const bool& batchedSamples = true);
     };
 
 }
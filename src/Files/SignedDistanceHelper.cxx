@@ -56,6 +56,12 @@ using namespace std;
 using namespace caret;
 
 float SignedDistanceHelper::dist(const float coord[3], WindingLogic myWinding)
+{
+    Vector3D closestPoint;
+    return dist(coord, myWinding, closestPoint);
+}
+
+float SignedDistanceHelper::dist(const float coord[3], WindingLogic myWinding, Vector3D& closestPointOut)
 {
     CaretMutexLocker locked(&m_mutex);
     CaretSimpleMinHeap<Oct<SignedDistanceHelperBase::TriVector>*, float> myHeap;
@@ -110,6 +116,7 @@ float SignedDistanceHelper::dist(const float coord[3], WindingLogic myWinding)
     {
         m_triMarked[m_triMarkChanged[--numChanged]] = 0;//need to do this before computeSign
     }
+    closestPointOut = bestInfo.tempPoint;
     return bestTriDist * computeSign(coord, bestInfo, myWinding);
 }
 
@@ -112,6 +112,9 @@ namespace caret {
         ///return the signed distance value at the point
         float dist(const float coord[3], WindingLogic myWinding);
         
+        ///return the signed distance value at the point, and the closest point on the surface
+        float dist(const float coord[3], WindingLogic myWinding, Vector3D& closestPointOut);
+        
         ///find the closest point ON the surface, and return information about it
         ///will never have negative barycentric weights, or a point outside the triangle
         void barycentricWeights(const float coordIn[3], BarycentricInfo& baryInfoOut);
@@ -41,7 +41,8 @@
 #include "Matrix4x4.h"
 #include "Vector3D.h"
 
-#include "CaretPointLocator.h"
+#include "CaretKdTree.h"
+#include "CaretTriangleLocator.h"
 #include "GeodesicHelper.h"
 #include "PlainTextStringBuilder.h"
 #include "SignedDistanceHelper.h"
@@ -525,6 +526,10 @@ SurfaceFile::initializeMembersSurfaceFile()
     m_geoHelperIndex = 0;
     m_topoHelperIndex = 0;
     m_normalsComputed = false;
+    ++m_geometryModificationCount;
+    for (int32_t i = 0; i < 3 * BrainConstants::MAXIMUM_NUMBER_OF_BROWSER_TABS; i++) {
+        m_nodeColoringStamps[i] = 0;
+    }
 }
 
 /**
@@ -565,6 +570,7 @@ void
 SurfaceFile::invalidateNormals()
 {
     m_normalsComputed = false;
+    ++m_geometryModificationCount;
 }
 /**
  * Compute surface normals.
@@ -577,6 +583,7 @@ SurfaceFile::computeNormals()
         return;
     }
     m_normalsComputed = true;
+    ++m_geometryModificationCount;
     int32_t numCoords = this->getNumberOfNodes();
     if (numCoords > 0) {
         this->normalVectors.resize(numCoords * 3);
@@ -884,6 +891,11 @@ void SurfaceFile::invalidateHelpers()
         CaretMutexLocker myLock3(&m_locatorMutex);
         m_locator.grabNew(NULL);
     }
+    if (m_triangleLocator != NULL)
+    {
+        CaretMutexLocker myLock5(&m_triangleLocatorMutex);
+        m_triangleLocator.grabNew(NULL);
+    }
 }
 
 /**
@@ -1175,19 +1187,32 @@ int32_t SurfaceFile::closestNode(const float target[3], const float maxDist) con
     }
 }
 
-CaretPointer<const CaretPointLocator> SurfaceFile::getPointLocator() const
+CaretPointer<const CaretKdTree> SurfaceFile::getPointLocator() const
 {
     if (m_locator == NULL)//try to avoid locking even once
     {
         CaretMutexLocker myLock(&m_locatorMutex);
         if (m_locator == NULL)//test again AFTER lock to avoid race conditions
         {
-            m_locator.grabNew(new CaretPointLocator(getCoordinateData(), getNumberOfNodes()));
+            m_locator.grabNew(new CaretKdTree(getCoordinateData(), getNumberOfNodes()));
         }
     }
     return m_locator;
 }
 
+CaretPointer<const CaretTriangleLocator> SurfaceFile::getTriangleLocator() const
+{
+    if (m_triangleLocator == NULL)
+    {
+        CaretMutexLocker myLock(&m_triangleLocatorMutex);
+        if (m_triangleLocator == NULL)
+        {
+            m_triangleLocator.grabNew(new CaretTriangleLocator(getCoordinateData(), getNumberOfNodes(), (getNumberOfTriangles() > 0 ? getTriangle(0) : NULL), getNumberOfTriangles()));
+        }
+    }
+    return m_triangleLocator;
+}
+
 void SurfaceFile::clearCachedHelpers() const
 {
     {
@@ -1212,6 +1237,10 @@ void SurfaceFile::clearCachedHelpers() const
         CaretMutexLocker locked(&m_locatorMutex);
         m_locator.grabNew(NULL);
     }
+    {
+        CaretMutexLocker locked(&m_triangleLocatorMutex);
+        m_triangleLocator.grabNew(NULL);
+    }
 }
 
 /**
@@ -1337,6 +1366,47 @@ SurfaceFile::getNodesSpacingStatistics(FastStatistics& statsOut) const
 
 }
 
+/**
+ * Find which of this surface's node coloring arrays the given coloring is,
+ * so that graphics buffers can be keyed by the coloring instead of by its
+ * memory address, which may be reused after the coloring is freed.
+ *
+ * @param rgba
+ *    Coloring returned by one of the get...NodeColoringRgbaForBrowserTab() methods.
+ * @param coloringKeyOut
+ *    Output with key identifying the model type and tab of the coloring.
+ * @param coloringStampOut
+ *    Output with stamp that changes whenever the coloring is set.
+ * @return
+ *    True if the coloring is one of this surface's coloring arrays.
+ */
+bool
+SurfaceFile::getNodeColoringKeyAndStamp(const float* rgba,
+                                        int32_t& coloringKeyOut,
+                                        int64_t& coloringStampOut) const
+{
+    if (rgba == NULL) {
+        return false;
+    }
+    const std::vector<float>* allColorings[3] = {
+        this->surfaceNodeColoringForBrowserTabs,
+        this->surfaceMontageNodeColoringForBrowserTabs,
+        this->wholeBrainNodeColoringForBrowserTabs
+    };
+    for (int32_t iKind = 0; iKind < 3; iKind++) {
+        for (int32_t iTab = 0; iTab < BrainConstants::MAXIMUM_NUMBER_OF_BROWSER_TABS; iTab++) {
+            const std::vector<float>& coloring = allColorings[iKind][iTab];
+            if (( ! coloring.empty())
+                && (&coloring[0] == rgba)) {
+                coloringKeyOut = iKind * BrainConstants::MAXIMUM_NUMBER_OF_BROWSER_TABS + iTab;
+                coloringStampOut = m_nodeColoringStamps[coloringKeyOut];
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 /**
  * Invalidate surface coloring.
  */
@@ -1346,6 +1416,8 @@ SurfaceFile::invalidateNodeColoringForBrowserTabs()
     /*
      * Free memory since could have many tabs and many surfaces equals lots of memory
      */
+    ++m_nodeColoringModificationCount;
+    m_nodeColoringInvalidationStamp = m_nodeColoringModificationCount;
     for (int32_t i = 0; i < BrainConstants::MAXIMUM_NUMBER_OF_BROWSER_TABS; i++) {
         this->surfaceNodeColoringForBrowserTabs[i].clear();
         this->surfaceMontageNodeColoringForBrowserTabs[i].clear();
@@ -1479,6 +1551,8 @@ SurfaceFile::setSurfaceNodeColoringRgbaForBrowserTab(const int32_t browserTabInd
     for (int32_t i = 0; i < numberOfComponentsRGBA; i++) {
         rgba[i] = rgbaNodeColorComponents[i];
     }
+    ++m_nodeColoringModificationCount;
+    m_nodeColoringStamps[browserTabIndex] = m_nodeColoringModificationCount;
 }
 
 /**
@@ -1526,6 +1600,8 @@ SurfaceFile::setSurfaceMontageNodeColoringRgbaForBrowserTab(const int32_t browse
     for (int32_t i = 0; i < numberOfComponentsRGBA; i++) {
         rgba[i] = rgbaNodeColorComponents[i];
     }
+    ++m_nodeColoringModificationCount;
+    m_nodeColoringStamps[BrainConstants::MAXIMUM_NUMBER_OF_BROWSER_TABS + browserTabIndex] = m_nodeColoringModificationCount;
 }
 
 
@@ -1573,6 +1649,8 @@ SurfaceFile::setWholeBrainNodeColoringRgbaForBrowserTab(const int32_t browserTab
     for (int32_t i = 0; i < numberOfComponentsRGBA; i++) {
         rgba[i] = rgbaNodeColorComponents[i];
     }
+    ++m_nodeColoringModificationCount;
+    m_nodeColoringStamps[2 * BrainConstants::MAXIMUM_NUMBER_OF_BROWSER_TABS + browserTabIndex] = m_nodeColoringModificationCount;
 }
 
 /**
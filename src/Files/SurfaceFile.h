@@ -36,7 +36,8 @@
 namespace caret {
 
     class BoundingBox;
-    class CaretPointLocator;
+    class CaretKdTree;
+    class CaretTriangleLocator;
     class DescriptiveStatistics;
     class FastStatistics;
     class GeodesicHelper;
@@ -136,7 +137,9 @@ namespace caret {
         
         void getSignedDistanceHelper(CaretPointer<SignedDistanceHelper>& helpOut) const;
         
-        CaretPointer<const CaretPointLocator> getPointLocator() const;
+        CaretPointer<const CaretKdTree> getPointLocator() const;
+        
+        CaretPointer<const CaretTriangleLocator> getTriangleLocator() const;
         
         void clearCachedHelpers() const;
         
@@ -176,6 +179,16 @@ namespace caret {
 
         void invalidateNormals();
         
+        /** @return Count that changes whenever the coordinates, triangles, or normal vectors change. */
+        int64_t getGeometryModificationCount() const { return m_geometryModificationCount; }
+        
+        bool getNodeColoringKeyAndStamp(const float* rgba,
+                                        int32_t& coloringKeyOut,
+                                        int64_t& coloringStampOut) const;
+        
+        /** @return Stamp of the last invalidation of all node coloring, colorings stamped before it no longer exist. */
+        int64_t getNodeColoringInvalidationStamp() const { return m_nodeColoringInvalidationStamp; }
+        
         void translateToCenterOfMass();
         
         void flipNormals();
@@ -261,6 +274,18 @@ namespace caret {
         bool m_normalsComputed;
         
         bool m_skipSanityCheck;
+        
+        /** incremented whenever coordinates, triangles, or normals change, never reset so that graphics buffers can compare against it */
+        int64_t m_geometryModificationCount = 0;
+        
+        /** incremented whenever any node coloring changes or is invalidated, source of the coloring stamps */
+        int64_t m_nodeColoringModificationCount = 0;
+        
+        /** stamp of each coloring array when it was last set, indexed by coloring key (single surface, montage, whole brain, each for all tabs) */
+        int64_t m_nodeColoringStamps[3 * BrainConstants::MAXIMUM_NUMBER_OF_BROWSER_TABS];
+        
+        /** stamp when all node coloring was last invalidated */
+        int64_t m_nodeColoringInvalidationStamp = 0;
 
         ///topology base for surface
         mutable CaretPointer<TopologyHelperBase> m_topoBase;
@@ -290,14 +315,17 @@ namespace caret {
         mutable int32_t m_distHelperIndex;
         
         ///used to search for the closest point in the surface
-        mutable CaretPointer<CaretPointLocator> m_locator;
+        mutable CaretPointer<CaretKdTree> m_locator;
+        
+        ///used to find the triangle hit by a ray, for picking
+        mutable CaretPointer<CaretTriangleLocator> m_triangleLocator;
         
         ///used to track when the surface file gets changed
         void invalidateHelpers();
         
         mutable BoundingBox* boundingBox;
         
-        mutable CaretMutex m_topoHelperMutex, m_geoHelperMutex, m_locatorMutex, m_distHelperMutex;
+        mutable CaretMutex m_topoHelperMutex, m_geoHelperMutex, m_locatorMutex, m_distHelperMutex, m_triangleLocatorMutex;
     };
 
 } // namespace
@@ -22,6 +22,7 @@
 #include <sstream>
 #include <string>
 
+#include <QFileInfo>
 #include <QTemporaryFile>
 
 #include "CaretHttpManager.h"
@@ -53,6 +54,7 @@ using namespace std;
 
 const float VolumeFile::INVALID_INTERP_VALUE = 0.0f;//we may want NaN or something more obvious
 bool VolumeFile::s_voxelColoringEnabled = true;
+int64_t VolumeFile::s_onDiskFrameCacheBytes = ((int64_t)1) << 30;//1 GiB
 
 /**
  * Static method that sets the status of voxel coloring.  Coloring may take
@@ -74,6 +76,30 @@ VolumeFile::setVoxelColoringEnabled(const bool enabled)
                            : "Volume coloring is disabled."));
 }
 
+/**
+ * Static method that sets the memory limit for frames of volumes that are
+ * read on demand (see setPreferOnDiskReading()).  Applies to files read
+ * after this call.
+ *
+ * @param bytes
+ *    Approximate maximum bytes of frame data kept in memory per file.
+ */
+void
+VolumeFile::setOnDiskFrameCacheBytes(const int64_t& bytes)
+{
+    CaretAssert(bytes > 0);
+    s_onDiskFrameCacheBytes = bytes;
+}
+
+/**
+ * @return The memory limit for frames of volumes that are read on demand.
+ */
+int64_t
+VolumeFile::getOnDiskFrameCacheBytes()
+{
+    return s_onDiskFrameCacheBytes;
+}
+
 
 VolumeFile::VolumeFile()
 : VolumeBase(), CaretMappableDataFile(DataFileTypeEnum::VOLUME)
@@ -86,6 +112,7 @@ VolumeFile::VolumeFile()
         m_chartingEnabledForTab[i] = false;
     }
     m_volumeFileEditorDelegate.grabNew(NULL);
+    m_preferOnDiskReading = false;
     validateMembers();
 }
 
@@ -100,6 +127,7 @@ VolumeFile::VolumeFile(const vector<int64_t>& dimensionsIn, const vector<vector<
         m_chartingEnabledForTab[i] = false;
     }
     m_volumeFileEditorDelegate.grabNew(NULL);
+    m_preferOnDiskReading = false;
     validateMembers();
     setType(whatType);
 }
@@ -196,6 +224,74 @@ VolumeFile::clear()
     m_volumeFileEditorDelegate->clear();
 }
 
+namespace
+{
+    ///reads single frames from an open nifti file, for VolumeFile's on-demand reading
+    class NiftiFrameLoader : public VolumeFrameLoader
+    {
+        CaretPointer<NiftiIO> m_io;
+        int m_fullDims;
+        vector<int64_t> m_extraDims;
+        int m_numComponents;
+        int64_t m_frameSize;
+    public:
+        NiftiFrameLoader(const CaretPointer<NiftiIO>& io, const int& fullDims, const vector<int64_t>& extraDims, const int& numComponents, const int64_t& frameSize)
+        {
+            m_io = io;
+            m_fullDims = fullDims;
+            m_extraDims = extraDims;
+            m_numComponents = numComponents;
+            m_frameSize = frameSize;
+        }
+        void loadFrame(float* frameOut, const int64_t& brickIndex, const int64_t& component)
+        {
+            vector<int64_t> indexSelect(m_extraDims.size());//same decomposition as getNonSpatialIndexesFromBrickIndex
+            int64_t remaining = brickIndex;
+            for (int i = 0; i < (int)m_extraDims.size(); ++i)
+            {
+                indexSelect[i] = remaining % m_extraDims[i];
+                remaining /= m_extraDims[i];
+            }
+            if (m_numComponents == 1)
+            {
+                m_io->readData(frameOut, m_fullDims, indexSelect);
+                return;
+            }
+            vector<float> readBuffer(m_frameSize * m_numComponents);
+            m_io->readData(readBuffer.data(), m_fullDims, indexSelect);
+            for (int64_t i = 0; i < m_frameSize; ++i)
+            {
+                frameOut[i] = readBuffer[i * m_numComponents + component];
+            }
+        }
+        void loadVoxelAllBricks(float* valuesOut, const int64_t ijk[3], const int64_t& component)
+        {
+            CaretAssert(m_fullDims == 3);//only 4D and higher files are read on demand
+            vector<int64_t> indexSelect(3 + m_extraDims.size(), 0);
+            indexSelect[0] = ijk[0];
+            indexSelect[1] = ijk[1];
+            indexSelect[2] = ijk[2];
+            vector<float> voxelBuffer(m_numComponents);
+            int64_t numBricks = 1;
+            for (int i = 0; i < (int)m_extraDims.size(); ++i)
+            {
+                numBricks *= m_extraDims[i];
+            }
+            for (int64_t b = 0; b < numBricks; ++b)
+            {//extra indexes count up in the same order as brick index, so increment with carry
+                m_io->readData(voxelBuffer.data(), 0, indexSelect);//one seek and a few bytes per frame, rather than the whole frame
+                valuesOut[b] = voxelBuffer[component];
+                for (int i = 0; i < (int)m_extraDims.size(); ++i)
+                {
+                    ++indexSelect[3 + i];
+                    if (indexSelect[3 + i] < m_extraDims[i]) break;
+                    indexSelect[3 + i] = 0;
+                }
+            }
+        }
+    };
+}
+
 void VolumeFile::readFile(const AString& filename)
 {
     ElapsedTimer timer;
@@ -221,7 +317,8 @@ void VolumeFile::readFile(const AString& filename)
             fileToRead = filename;
         }
         checkFileReadability(fileToRead);
-        NiftiIO myIO;//begin nifti specific code - should this go somewhere else?
+        CaretPointer<NiftiIO> myIOPtr(new NiftiIO());//begin nifti specific code - should this go somewhere else?
+        NiftiIO& myIO = *myIOPtr;//pointer so that on-demand reading can keep the file open
         myIO.openRead(fileToRead);
         const NiftiHeader& inHeader = myIO.getHeader();
         for (int i = 0; i < (int)inHeader.m_extensions.size(); ++i)
@@ -256,8 +353,13 @@ void VolumeFile::readFile(const AString& filename)
         reinitialize(myDims, inHeader.getSForm(), numComponents);
         setFileName(filename);  // must be done after reinitialize() since it calls clear() which clears the name of the file
         int64_t frameSize = myDims[0] * myDims[1] * myDims[2];
-        if (numComponents != 1)
-        {
+        const int64_t* storeDims = getDimensionsPtr();
+        if (m_preferOnDiskReading && storeDims[3] > 1 && fileToRead == filename &&
+            storeDims[3] * storeDims[4] * frameSize * (int64_t)sizeof(float) > s_onDiskFrameCacheBytes)
+        {//large 4D volume, read frames when they are used, keeping the file open (temporary copies of network files get deleted, so those are read fully)
+            setFrameLoader(CaretPointer<VolumeFrameLoader>(new NiftiFrameLoader(myIOPtr, fullDims, extraDims, numComponents, frameSize)), s_onDiskFrameCacheBytes);
+            CaretLogFine("Reading frames of volume file " + filename + " on demand");
+        } else if (numComponents != 1) {
             vector<float> tempFrame(frameSize), readBuffer(frameSize * numComponents);
             for (MultiDimIterator<int64_t> myiter(extraDims); !myiter.atEnd(); ++myiter)
             {
@@ -304,6 +406,20 @@ void VolumeFile::readFile(const AString& filename)
                  + " seconds.");
 }
 
+/**
+ * Set preference for reading.  When true, 4D volumes whose data is larger
+ * than the on-disk frame cache limit keep the file open and read frames
+ * when they are used, and only recently used frames stay in memory.
+ *
+ * @param prefer
+ *    True to read large 4D volumes on demand.
+ */
+void
+VolumeFile::setPreferOnDiskReading(const bool& prefer)
+{
+    m_preferOnDiskReading = prefer;
+}
+
 /**
  * Write the data file.
  *
@@ -328,6 +444,11 @@ VolumeFile::writeFile(const AString& filename)
     }
     updateCaretExtension();
     
+    if (isReadingFramesOnDemand() && QFileInfo(filename).absoluteFilePath() == QFileInfo(getFileName()).absoluteFilePath())
+    {//opening the output truncates the file we are reading frames from
+        readAllFrames();
+    }
+    
     NiftiHeader outHeader;//begin nifti-specific code
     if (m_header != NULL && (m_header->getType() == AbstractHeader::NIFTI))
     {
@@ -1175,7 +1296,8 @@ VolumeFile::getFileData(std::vector<float>& dataOut) const
 {
     int64_t dimI, dimJ, dimK, dimTime, dimComp;
     getDimensions(dimI, dimJ, dimK, dimTime, dimComp);
-    const int64_t mapSize     = dimI * dimJ * dimK * dimComp;
+    const int64_t frameSize   = dimI * dimJ * dimK;
+    const int64_t mapSize     = frameSize * dimComp;
     const int64_t numMaps     = dimTime;
     const int64_t dataSize    = mapSize * numMaps;
     
@@ -1187,13 +1309,16 @@ VolumeFile::getFileData(std::vector<float>& dataOut) const
     dataOut.resize(dataSize);
     int64_t dataOffset = 0;
     
+    CaretArray<float> frameHold;
     for (int iMap = 0; iMap < numMaps; iMap++) {
-        const float* mapData = getFrame(iMap);
-        
-        for (int64_t i = 0; i < mapSize; i++) {
-            CaretAssertVectorIndex(dataOut, dataOffset);
-            dataOut[dataOffset] = mapData[i];
-            ++dataOffset;
+        for (int64_t iComp = 0; iComp < dimComp; iComp++) {
+            const float* mapData = getFrame(iMap, iComp, frameHold, false);//components of a map are separate frames when reading on demand
+            
+            for (int64_t i = 0; i < frameSize; i++) {
+                CaretAssertVectorIndex(dataOut, dataOffset);
+                dataOut[dataOffset] = mapData[i];
+                ++dataOffset;
+            }
         }
     }
     
@@ -1640,6 +1765,8 @@ VolumeFile::getVoxelValuesForSliceInMap(const int32_t mapIndex,
     
     int64_t dimI, dimJ, dimK, dimTime, dimMaps;
     getDimensions(dimI, dimJ, dimK, dimTime, dimMaps);
+    CaretArray<float> frameHold;
+    const float* mapData = getFrame(mapIndex, 0, frameHold);//one cache lookup, rather than one per voxel
     
     switch (slicePlane) {
         case VolumeSliceViewPlaneEnum::ALL:
@@ -1650,7 +1777,7 @@ VolumeFile::getVoxelValuesForSliceInMap(const int32_t mapIndex,
             int64_t counter = 0;
             for (int64_t j = 0; j < dimJ; j++) {
                 for (int64_t i = 0; i < dimI; i++) {
-                    sliceValuesOut[counter] = getValue(i, j, sliceIndex, 0, mapIndex);
+                    sliceValuesOut[counter] = mapData[getIndex(i, j, sliceIndex)];
                     counter++;
                 }
             }
@@ -1662,7 +1789,7 @@ VolumeFile::getVoxelValuesForSliceInMap(const int32_t mapIndex,
             int64_t counter = 0;
             for (int64_t k = 0; k < dimK; k++) {
                 for (int64_t i = 0; i < dimI; i++) {
-                    sliceValuesOut[counter] = getValue(i, sliceIndex, k, 0, mapIndex);
+                    sliceValuesOut[counter] = mapData[getIndex(i, sliceIndex, k)];
                     counter++;
                 }
             }
@@ -1674,7 +1801,7 @@ VolumeFile::getVoxelValuesForSliceInMap(const int32_t mapIndex,
             int64_t counter = 0;
             for (int64_t k = 0; k < dimK; k++) {
                 for (int64_t j = 0; j < dimJ; j++) {
-                    sliceValuesOut[counter] = getValue(sliceIndex, j, k, 0, mapIndex);
+                    sliceValuesOut[counter] = mapData[getIndex(sliceIndex, j, k)];
                     counter++;
                 }
             }
@@ -1797,14 +1924,19 @@ VolumeFile::getDataRangeFromAllMaps(float& dataRangeMinimumOut,
     m_dataRangeMinimum = std::numeric_limits<float>::max();
     
     const int64_t* dimensions = getDimensionsPtr();
-    int64_t m_dataSize = dimensions[0] * dimensions[1] * dimensions[2] * dimensions[3] * dimensions[4];
-    const float* data = getFrame();//HACK: use first frame knowing all data is contiguous after it
-    for (int64_t i = 0; i < m_dataSize; i++) {
-        if (data[i] > m_dataRangeMaximum) {
-            m_dataRangeMaximum = data[i];
-        }
-        if (data[i] < m_dataRangeMinimum) {
-            m_dataRangeMinimum = data[i];
+    const int64_t frameSize = dimensions[0] * dimensions[1] * dimensions[2];
+    CaretArray<float> frameHold;
+    for (int64_t c = 0; c < dimensions[4]; c++) {
+        for (int64_t b = 0; b < dimensions[3]; b++) {
+            const float* data = getFrame(b, c, frameHold, false);//frame by frame, they are not contiguous when reading on demand, and don't flush the displayed frames out of the cache
+            for (int64_t i = 0; i < frameSize; i++) {
+                if (data[i] > m_dataRangeMaximum) {
+                    m_dataRangeMaximum = data[i];
+                }
+                if (data[i] < m_dataRangeMinimum) {
+                    m_dataRangeMinimum = data[i];
+                }
+            }
         }
     }
     
@@ -1839,11 +1971,13 @@ VolumeFile::getVoxelIndicesWithLabelKey(const int32_t mapIndex,
     const int64_t dimI = dims[0];
     const int64_t dimJ = dims[1];
     const int64_t dimK = dims[2];
+    CaretArray<float> frameHold;
+    const float* mapData = getFrame(mapIndex, 0, frameHold);
     
     for (int64_t i = 0; i < dimI; i++) {
         for (int64_t j = 0; j < dimJ; j++) {
             for (int64_t k = 0; k < dimK; k++) {
-                const float keyValue = static_cast<int32_t>(getValue(i, j, k, mapIndex));
+                const float keyValue = static_cast<int32_t>(mapData[getIndex(i, j, k)]);
                 if (keyValue == labelKey) {
                     voxelIndicesOut.push_back(VoxelIJK(i, j, k));
                 }
@@ -1868,12 +2002,14 @@ VolumeFile::getUniqueLabelKeysUsedInMap(const int32_t mapIndex) const
     const int64_t dimI = dims[0];
     const int64_t dimJ = dims[1];
     const int64_t dimK = dims[2];
+    CaretArray<float> frameHold;
+    const float* mapData = getFrame(mapIndex, 0, frameHold);
     
     std::set<int32_t> uniqueKeys;
     for (int64_t i = 0; i < dimI; i++) {
         for (int64_t j = 0; j < dimJ; j++) {
             for (int64_t k = 0; k < dimK; k++) {
-                const float keyValue = static_cast<int32_t>(getValue(i, j, k, mapIndex));
+                const float keyValue = static_cast<int32_t>(mapData[getIndex(i, j, k)]);
                 uniqueKeys.insert(keyValue);
             }
         }
@@ -2206,12 +2342,8 @@ VolumeFile::loadLineSeriesChartDataForVoxelAtCoordinate(const float xyz[3])
                        ijk);
         
         if (indexValid(ijk)) {
-            std::vector<float> data;
-            
-            const int32_t numMaps = getNumberOfMaps();
-            for (int32_t iMap = 0; iMap < numMaps; iMap++) {
-                data.push_back(getValue(ijk, iMap));
-            }
+            std::vector<float> data(getNumberOfMaps());
+            getValueAllBricks(data.data(), ijk);//reads only this voxel of frames that aren't in memory
             
             try {
                 chartData = helpCreateCartesianChartData(data);
@@ -2268,10 +2400,8 @@ VolumeFile::getDataForSelector(const MapFileDataSelector& mapFileDataSelector,
                                ijk);
                 
                 if (indexValid(ijk)) {
-                    const int32_t numMaps = getNumberOfMaps();
-                    for (int32_t iMap = 0; iMap < numMaps; iMap++) {
-                        dataOut.push_back(getValue(ijk, iMap));
-                    }
+                    dataOut.resize(getNumberOfMaps());
+                    getValueAllBricks(dataOut.data(), ijk);//reads only this voxel of frames that aren't in memory
                 }
             }
         }
@@ -124,6 +124,12 @@ namespace caret {
         
         CaretPointer<VolumeFileEditorDelegate> m_volumeFileEditorDelegate;
         
+        /** read frames of large 4D volumes from disk as they are needed */
+        bool m_preferOnDiskReading;
+        
+        /** memory limit for frames that are read on demand */
+        static int64_t s_onDiskFrameCacheBytes;
+        
     protected:
         virtual void saveFileDataToScene(const SceneAttributes* sceneAttributes,
                                          SceneClass* sceneClass);
@@ -147,6 +153,10 @@ namespace caret {
         
         static void setVoxelColoringEnabled(const bool enabled);
         
+        static void setOnDiskFrameCacheBytes(const int64_t& bytes);
+        
+        static int64_t getOnDiskFrameCacheBytes();
+        
         VolumeFile();
         VolumeFile(const std::vector<int64_t>& dimensionsIn, const std::vector<std::vector<float> >& indexToSpace, const int64_t numComponents = 1, SubvolumeAttributes::VolumeType whatType = SubvolumeAttributes::ANATOMY);
         ~VolumeFile();
@@ -185,6 +195,8 @@ namespace caret {
         bool matchesVolumeSpace(const int64_t dims[3], const std::vector<std::vector<float> >& sform) const;
         
         void readFile(const AString& filename);
+        
+        virtual void setPreferOnDiskReading(const bool& prefer);
 
         void writeFile(const AString& filename);
 
@@ -28,6 +28,7 @@
 #include "PaletteColorMapping.h"
 #include "Vector3D.h"
 
+#include <algorithm>
 #include <cmath>
 
 using namespace caret;
@@ -37,6 +38,10 @@ AbstractHeader::~AbstractHeader()
 {
 }
 
+VolumeFrameLoader::~VolumeFrameLoader()
+{
+}
+
 void VolumeBase::reinitialize(const vector<int64_t>& dimensionsIn, const vector<vector<float> >& indexToSpace, const int64_t numComponents)
 {
     CaretAssert(numComponents > 0);
@@ -354,6 +359,10 @@ VolumeBase::VolumeStorage::VolumeStorage()
         m_dimensions[i] = 0;
         m_mult[i] = 0;
     }
+    m_onDemand = false;
+    m_useCounter = 0;
+    m_numCached = 0;
+    m_cacheMaxFrames = 0;
 }
 
 void VolumeBase::VolumeStorage::reinitialize(int64_t dims[5])
@@ -369,21 +378,148 @@ void VolumeBase::VolumeStorage::reinitialize(int64_t dims[5])
     {
         m_mult[i] = m_mult[i - 1] * m_dimensions[i];
     }
+    clearOnDemand();
     m_data.resize(m_mult[4]);
 }
 
 VolumeBase::VolumeStorage::VolumeStorage(int64_t dims[5])
 {
+    m_onDemand = false;
+    m_useCounter = 0;
+    m_numCached = 0;
+    m_cacheMaxFrames = 0;
     reinitialize(dims);
 }
 
 const float* VolumeBase::VolumeStorage::getFrame(const int64_t brickIndex, const int64_t component) const
 {
+    if (m_onDemand) return getCachedFrame(brickIndex + component * m_dimensions[3]).getArray();//the cache still holds it
     return m_data.data() + brickIndex * m_mult[2] + component * m_mult[3];//NOTE: do not use [4]
 }
 
+const float* VolumeBase::VolumeStorage::getFrame(const int64_t brickIndex, const int64_t component, CaretArray<float>& holdOut, const bool& addToCache) const
+{
+    if (m_onDemand)
+    {
+        holdOut = getCachedFrame(brickIndex + component * m_dimensions[3], addToCache);
+        return holdOut.getArray();
+    }
+    holdOut = CaretArray<float>();
+    return m_data.data() + brickIndex * m_mult[2] + component * m_mult[3];
+}
+
+void VolumeBase::VolumeStorage::getValueAllBricks(float* valuesOut, const int64_t& indexIn1, const int64_t& indexIn2, const int64_t& indexIn3, const int64_t component) const
+{
+    CaretAssert(indexValid(indexIn1, indexIn2, indexIn3, 0, component));
+    int64_t frameOffset = indexIn1 + m_mult[0] * indexIn2 + m_mult[1] * indexIn3;
+    if (!m_onDemand)
+    {
+        for (int64_t b = 0; b < m_dimensions[3]; ++b)
+        {
+            valuesOut[b] = m_data[frameOffset + b * m_mult[2] + component * m_mult[3]];
+        }
+        return;
+    }
+    CaretMutexLocker locked(&m_cacheMutex);
+    bool allCached = true;
+    for (int64_t b = 0; b < m_dimensions[3]; ++b)
+    {
+        if (m_frameCache[b + component * m_dimensions[3]].getArray() == NULL)
+        {
+            allCached = false;
+            break;
+        }
+    }
+    if (allCached)
+    {
+        for (int64_t b = 0; b < m_dimensions[3]; ++b)
+        {
+            valuesOut[b] = m_frameCache[b + component * m_dimensions[3]][frameOffset];
+        }
+    } else {//frames on disk are never modified while reading on demand, so cached frames have the same values
+        int64_t ijk[3] = { indexIn1, indexIn2, indexIn3 };
+        m_loader->loadVoxelAllBricks(valuesOut, ijk, component);
+    }
+}
+
+void VolumeBase::VolumeStorage::setFrameLoader(const CaretPointer<VolumeFrameLoader>& loader, const int64_t& cacheBytes)
+{
+    CaretAssert(loader != NULL && m_mult[4] > 0);
+    clearOnDemand();
+    vector<float>().swap(m_data);//actually release the memory
+    m_loader = loader;
+    int64_t numFrames = m_dimensions[3] * m_dimensions[4];
+    m_frameCache.resize(numFrames);
+    m_lastUsed.resize(numFrames, 0);
+    m_cacheMaxFrames = max(cacheBytes / (int64_t)(m_mult[2] * sizeof(float)), (int64_t)8);//callers may use a few frames at once, such as the components of an RGB volume
+    m_onDemand = true;
+}
+
+CaretArray<float> VolumeBase::VolumeStorage::getCachedFrame(const int64_t& frameIndex, const bool& addToCache) const
+{
+    CaretAssert(m_onDemand && frameIndex >= 0 && frameIndex < (int64_t)m_frameCache.size());
+    CaretMutexLocker locked(&m_cacheMutex);
+    if (m_frameCache[frameIndex].getArray() != NULL)
+    {
+        m_lastUsed[frameIndex] = ++m_useCounter;
+        return m_frameCache[frameIndex];
+    }
+    CaretArray<float> loaded(m_mult[2]);
+    m_loader->loadFrame(loaded.getArray(), frameIndex % m_dimensions[3], frameIndex / m_dimensions[3]);//load before evicting, so a failed read leaves the cache consistent
+    if (!addToCache) return loaded;
+    while (m_numCached >= m_cacheMaxFrames)
+    {//a linear search is nothing next to reading a frame
+        int64_t oldest = -1;
+        for (int64_t i = 0; i < (int64_t)m_frameCache.size(); ++i)
+        {
+            if (m_frameCache[i].getArray() != NULL && (oldest == -1 || m_lastUsed[i] < m_lastUsed[oldest])) oldest = i;
+        }
+        CaretAssert(oldest != -1);
+        m_frameCache[oldest] = CaretArray<float>();//anything still holding it keeps the memory until it is done
+        --m_numCached;
+    }
+    m_frameCache[frameIndex] = loaded;
+    m_lastUsed[frameIndex] = ++m_useCounter;
+    ++m_numCached;
+    return loaded;
+}
+
+void VolumeBase::VolumeStorage::loadAllFrames()
+{
+    if (!m_onDemand) return;
+    vector<float> data(m_mult[4]);
+    for (int64_t frameIndex = 0; frameIndex < (int64_t)m_frameCache.size(); ++frameIndex)
+    {
+        float* frameOut = data.data() + frameIndex * m_mult[2];//frame index is the same as brickIndex * m_mult[2] + component * m_mult[3]
+        if (m_frameCache[frameIndex].getArray() == NULL)
+        {
+            m_loader->loadFrame(frameOut, frameIndex % m_dimensions[3], frameIndex / m_dimensions[3]);
+        } else {
+            const CaretArray<float>& cached = m_frameCache[frameIndex];
+            for (int64_t i = 0; i < m_mult[2]; ++i)
+            {
+                frameOut[i] = cached[i];
+            }
+        }
+    }
+    clearOnDemand();
+    m_data.swap(data);
+}
+
+void VolumeBase::VolumeStorage::clearOnDemand()
+{
+    m_onDemand = false;
+    m_loader.grabNew(NULL);
+    m_frameCache.clear();
+    m_lastUsed.clear();
+    m_useCounter = 0;
+    m_numCached = 0;
+    m_cacheMaxFrames = 0;
+}
+
 void VolumeBase::VolumeStorage::setFrame(const float* frameIn, const int64_t brickIndex, const int64_t component)
 {
+    if (m_onDemand) loadAllFrames();
     int64_t start = brickIndex * m_mult[2] + component * m_mult[3];
     for (int64_t i = 0; i < m_mult[2]; ++i)
     {
@@ -393,6 +529,11 @@ void VolumeBase::VolumeStorage::setFrame(const float* frameIn, const int64_t bri
 
 void VolumeBase::VolumeStorage::setValueAllVoxels(const float value)
 {
+    if (m_onDemand)
+    {//no need to read anything
+        clearOnDemand();
+        m_data.resize(m_mult[4]);
+    }
     for (int64_t i = 0; i < m_mult[4]; ++i)
     {
         m_data[i] = value;
@@ -402,6 +543,15 @@ void VolumeBase::VolumeStorage::setValueAllVoxels(const float value)
 void VolumeBase::VolumeStorage::swap(VolumeStorage& rhs)
 {
     m_data.swap(rhs.m_data);
+    std::swap(m_onDemand, rhs.m_onDemand);
+    CaretPointer<VolumeFrameLoader> tempLoader = m_loader;
+    m_loader = rhs.m_loader;
+    rhs.m_loader = tempLoader;
+    m_frameCache.swap(rhs.m_frameCache);
+    m_lastUsed.swap(rhs.m_lastUsed);
+    std::swap(m_useCounter, rhs.m_useCounter);
+    std::swap(m_numCached, rhs.m_numCached);
+    std::swap(m_cacheMaxFrames, rhs.m_cacheMaxFrames);
     for (int i = 0; i < 5; ++i)
     {
         std::swap(m_dimensions[i], rhs.m_dimensions[i]);
@@ -436,6 +586,7 @@ vector<int64_t> VolumeBase::VolumeStorage::getDimensions() const
 
 void VolumeBase::VolumeStorage::clear()
 {
+    clearOnDemand();
     m_data.clear();
     for (int i = 0; i < 5; ++i)
     {
@@ -25,6 +25,7 @@
 #include "stdint.h"
 #include <vector>
 #include "CaretAssert.h"
+#include "CaretMutex.h"
 #include "CaretPointer.h"
 #include "VolumeMappableInterface.h"
 #include "VolumeSpace.h"
@@ -44,6 +45,14 @@ namespace caret {
         virtual ~AbstractHeader();
     };
     
+    ///source of frame data for volumes that read frames from disk only when they are used
+    struct VolumeFrameLoader
+    {
+        virtual void loadFrame(float* frameOut, const int64_t& brickIndex, const int64_t& component) = 0;//must fill dims[0] * dims[1] * dims[2] values
+        virtual void loadVoxelAllBricks(float* valuesOut, const int64_t ijk[3], const int64_t& component) = 0;//must fill dims[3] values, reading only the one voxel from each frame
+        virtual ~VolumeFrameLoader();
+    };
+    
     class VolumeBase : public VolumeMappableInterface
     {
         class VolumeStorage
@@ -51,6 +60,15 @@ namespace caret {
             std::vector<float> m_data;
             int64_t m_dimensions[5];//store internally as 4d+component
             int64_t m_mult[5];//precalculated multipliers for getIndex/getValue/setValue - NOTE: [0] is for index[1], [4] is the entire size of the data
+            bool m_onDemand;//when true, m_data is empty, and frames are read through m_loader into an LRU cache
+            CaretPointer<VolumeFrameLoader> m_loader;
+            mutable std::vector<CaretArray<float> > m_frameCache;//indexed by brickIndex + component * dims[3], empty when not loaded - refcounted, so evicting a frame doesn't free it while someone holds it
+            mutable std::vector<int64_t> m_lastUsed;//use stamp of each loaded frame, the lowest is evicted first
+            mutable int64_t m_useCounter, m_numCached;
+            int64_t m_cacheMaxFrames;
+            mutable CaretMutex m_cacheMutex;
+            CaretArray<float> getCachedFrame(const int64_t& frameIndex, const bool& addToCache = true) const;
+            void clearOnDemand();
             VolumeStorage(const VolumeStorage& rhs);//deny copy, assignment for now
             VolumeStorage& operator=(const VolumeStorage& rhs);
         public:
@@ -69,13 +87,14 @@ namespace caret {
 
             void swap(VolumeStorage& rhs);
             
-            ///get a value at three indexes and optionally timepoint
-            inline const float& getValue(const int64_t& indexIn1, const int64_t& indexIn2, const int64_t& indexIn3, const int64_t brickIndex, const int64_t component) const
+            ///get a value at three indexes and optionally timepoint - when reading on demand, this does a locked cache lookup, so loops over voxels should use getFrame with a hold instead
+            inline float getValue(const int64_t& indexIn1, const int64_t& indexIn2, const int64_t& indexIn3, const int64_t brickIndex, const int64_t component) const
             {
                 CaretAssert(indexValid(indexIn1, indexIn2, indexIn3, brickIndex, component));//assert so release version isn't slowed by checking
+                if (m_onDemand) return getCachedFrame(brickIndex + component * m_dimensions[3])[indexIn1 + m_mult[0] * indexIn2 + m_mult[1] * indexIn3];
                 return m_data[getIndex(indexIn1, indexIn2, indexIn3, brickIndex, component)];
             }
-            inline const float& getValue(const int64_t indexIn[3], const int64_t brickIndex, const int64_t component) const
+            inline float getValue(const int64_t indexIn[3], const int64_t brickIndex, const int64_t component) const
             {
                 return getValue(indexIn[0], indexIn[1], indexIn[2], brickIndex, component);
             }
@@ -110,6 +129,7 @@ namespace caret {
             inline void setValue(const float& valueIn, const int64_t& indexIn1, const int64_t& indexIn2, const int64_t& indexIn3, const int64_t brickIndex, const int64_t component)
             {
                 CaretAssert(indexValid(indexIn1, indexIn2, indexIn3, brickIndex, component));//assert so release version isn't slowed by checking
+                if (m_onDemand) loadAllFrames();
                 m_data[getIndex(indexIn1, indexIn2, indexIn3, brickIndex, component)] = valueIn;
             }
             inline void setValue(const float& valueIn, const int64_t indexIn[3], const int64_t brickIndex, const int64_t component)
@@ -120,9 +140,23 @@ namespace caret {
             /// set every voxel to the given value
             void setValueAllVoxels(const float value);
             
-            ///get a frame (const)
+            ///get a frame (const) - when reading on demand, the pointer stays valid until enough other frames are requested to evict it from the cache
             const float* getFrame(const int64_t brickIndex = 0, const int64_t component = 0) const;
             
+            ///get a frame that stays valid while holdOut keeps its reference - addToCache = false reads a missing frame without evicting others, for single passes over every frame
+            const float* getFrame(const int64_t brickIndex, const int64_t component, CaretArray<float>& holdOut, const bool& addToCache = true) const;
+            
+            ///get one voxel from every brick, reading only that voxel from disk when any of its frames aren't cached
+            void getValueAllBricks(float* valuesOut, const int64_t& indexIn1, const int64_t& indexIn2, const int64_t& indexIn3, const int64_t component) const;
+            
+            ///switch to reading frames on demand, keeping at most roughly cacheBytes of frames in memory
+            void setFrameLoader(const CaretPointer<VolumeFrameLoader>& loader, const int64_t& cacheBytes);
+            
+            bool isOnDemand() const { return m_onDemand; }
+            
+            ///read every frame that isn't cached, and leave on-demand mode - called before any modification
+            void loadAllFrames();
+            
             ///set a frame
             void setFrame(const float* frameIn, const int64_t brickIndex = 0, const int64_t component = 0);
         };
@@ -140,6 +174,12 @@ namespace caret {
         
         void addSubvolumes(const int64_t& numToAdd);
         
+        ///read frames through the loader when they are first used, instead of holding all of them in memory - call after reinitialize()
+        void setFrameLoader(const CaretPointer<VolumeFrameLoader>& loader, const int64_t& cacheBytes) { m_storage.setFrameLoader(loader, cacheBytes); }
+        
+        ///stop reading on demand, so the loader's file can be released or overwritten
+        void readAllFrames() { m_storage.loadAllFrames(); }
+        
     public:
         void clear();
         virtual ~VolumeBase();
@@ -218,13 +258,13 @@ namespace caret {
         inline const VolumeSpace& getVolumeSpace() const { return m_volSpace; }
 
         ///get a value at an index triplet and optionally timepoint
-        inline const float& getValue(const int64_t* indexIn, const int64_t brickIndex = 0, const int64_t component = 0) const
+        inline float getValue(const int64_t* indexIn, const int64_t brickIndex = 0, const int64_t component = 0) const
         {
             return m_storage.getValue(indexIn[0], indexIn[1], indexIn[2], brickIndex, component);
         }
         
         ///get a value at three indexes and optionally timepoint
-        inline const float& getValue(const int64_t& indexIn1, const int64_t& indexIn2, const int64_t& indexIn3, const int64_t brickIndex = 0, const int64_t component = 0) const
+        inline float getValue(const int64_t& indexIn1, const int64_t& indexIn2, const int64_t& indexIn3, const int64_t brickIndex = 0, const int64_t component = 0) const
         {
             return m_storage.getValue(indexIn1, indexIn2, indexIn3, brickIndex, component);
         }
@@ -308,9 +348,24 @@ namespace caret {
             return 0.0;
         }
         
-        ///get a frame (const)
+        ///get a frame (const) - when reading frames on demand, the pointer is only valid until the frame cache evicts the frame, use the version with holdOut for long use
         const float* getFrame(const int64_t brickIndex = 0, const int64_t component = 0) const { return m_storage.getFrame(brickIndex, component); }
         
+        ///get a frame (const) that stays valid for as long as holdOut is kept (holdOut stays empty unless reading frames on demand), addToCache = false avoids evicting other frames during a pass over every frame
+        const float* getFrame(const int64_t brickIndex, const int64_t component, CaretArray<float>& holdOut, const bool& addToCache = true) const
+        {
+            return m_storage.getFrame(brickIndex, component, holdOut, addToCache);
+        }
+        
+        ///get the value of one voxel in every brick, without reading whole frames from disk
+        void getValueAllBricks(float* valuesOut, const int64_t* indexIn, const int64_t component = 0) const
+        {
+            m_storage.getValueAllBricks(valuesOut, indexIn[0], indexIn[1], indexIn[2], component);
+        }
+        
+        ///whether frames are read from disk as they are used (any modification reads in all frames and ends this mode)
+        bool isReadingFramesOnDemand() const { return m_storage.isOnDemand(); }
+        
         ///set a value at an index triplet and optionally timepoint
         inline void setValue(const float& valueIn, const int64_t* indexIn, const int64_t brickIndex = 0, const int64_t component = 0)
         {
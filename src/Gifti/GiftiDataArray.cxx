@@ -579,7 +579,7 @@ GiftiDataArray::transferLabelIndices(const std::map<int32_t,int32_t>& indexConve
  * Data array should already be initialized and allocated.
  */
 void 
-GiftiDataArray::readFromText(const AString text,
+GiftiDataArray::readFromText(const std::string& text,
                              const GiftiEndianEnum::Enum dataEndianForReading,
                              const GiftiArrayIndexingOrderEnum::Enum arraySubscriptingOrderForReading,
                              const NiftiDataTypeEnum::Enum dataTypeForReading,
@@ -613,7 +613,7 @@ GiftiDataArray::readFromText(const AString text,
       switch (encoding) {
           case GiftiEncodingEnum::ASCII:
             {
-                std::istringstream stream(text.toStdString());
+                std::istringstream stream(text);
                 
                switch (dataType) {
                   case NiftiDataTypeEnum::NIFTI_TYPE_FLOAT32:
@@ -653,17 +653,18 @@ GiftiDataArray::readFromText(const AString text,
           case GiftiEncodingEnum::BASE64_BINARY:
             {
                //
-               // Decode the Base64 data using VTK's algorithm
+               // Decode the Base64 data directly into the array's data
                //
                const uint64_t numDecoded =
-                     Base64::decode((const unsigned char*)(text.toStdString().c_str()),
-                                                data.size(),
-                                                &data[0]);
+                     Base64::decodeText(text.data(),
+                                        text.size(),
+                                        &data[0],
+                                        data.size());
                if (numDecoded != data.size()) {
                   std::ostringstream str;
                   str << "Decoding of Base64 Binary data failed.\n"
                    << "Decoded " << AString::number(numDecoded).toStdString() << " bytes but should be "
-                      << AString::number(static_cast<int>(data.size())).toStdString() << " bytes.";
+                      << AString::number(static_cast<int64_t>(data.size())).toStdString() << " bytes.";
                   throw GiftiException(AString::fromStdString(str.str()));
                }
                
@@ -678,45 +679,23 @@ GiftiDataArray::readFromText(const AString text,
           case GiftiEncodingEnum::GZIP_BASE64_BINARY:
             {
                //
-               // Decode the Base64 data using VTK's algorithm
-               //
-               unsigned char* dataBuffer = new unsigned char[data.size()];
-               //const char* textChars = text.toLatin1().constData();
-               const uint64_t numDecoded =
-                     Base64::decode((unsigned char*)text.toStdString().c_str(),
-                                                data.size(),
-                                                dataBuffer);
-               if (numDecoded == 0) {
-                   std::ostringstream str;
-                   str << "Decoding of GZip Base64 Binary data failed."
-                   << "Decoded " << AString::number(numDecoded).toStdString() << " bytes but should be "
-                   << AString::number(static_cast<int>(data.size())).toStdString() << " bytes.";
-                   throw GiftiException(AString::fromStdString(str.str()));
-               }
-               
-               
-               //
-               // Uncompress the data using VTK's algorithm
+               // Decode the Base64 data in blocks, inflating each block
+               // directly into the array's data
                // 
                 DataCompressZLib compressor;
                 const uint64_t uncompressedDataLength = 
-                                   compressor.uncompressData(dataBuffer,
-                                                          numDecoded,
-                                                          (unsigned char*)&data[0],
-                                                          data.size());
+                                   compressor.uncompressBase64Data(text.data(),
+                                                                   text.size(),
+                                                                   (unsigned char*)&data[0],
+                                                                   data.size());
                if (uncompressedDataLength != data.size()) {
                   std::ostringstream str;
-                  str << "Decompression of Binary data failed.\n"
+                  str << "Decoding and decompression of GZip Base64 Binary data failed.\n"
                    << "Uncompressed " << AString::number(uncompressedDataLength).toStdString() << " bytes but should be "
                    << AString::number(static_cast<uint64_t>(data.size())).toStdString() << " bytes.";
                   throw GiftiException(AString::fromStdString(str.str()));
                }
                
-               //
-               // Free memory
-               //
-               delete[] dataBuffer;
-               
                //
                // Is byte swapping needed ? 
                //
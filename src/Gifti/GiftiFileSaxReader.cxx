@@ -18,10 +18,15 @@
  */
 /*LICENSE_END*/
 
+#include <cstring>
+#include <new>
 #include <sstream>
 
+#include "CaretAssert.h"
 #include "CaretLogger.h"
+#include "CaretOMP.h"
 #include "FileInformation.h"
+#include "GiftiDataArray.h"
 #include "GiftiEndianEnum.h"
 #include "GiftiLabel.h"
 #include "GiftiFile.h"
@@ -50,6 +55,7 @@ GiftiFileSaxReader::GiftiFileSaxReader(GiftiFile* giftiFileIn)
     this->labelTableSaxReader = NULL;
     this->metaDataSaxReader = NULL;
     this->dataArrayDataHasBeenRead = false;
+    this->pendingArrayDataTextBytes = 0;
 }
 
 /**
@@ -138,6 +144,30 @@ GiftiFileSaxReader::startElement(const AString& namespaceURI,
          }
          else if (qName == GiftiXmlElements::TAG_DATA) {
             this->state = STATE_DATA_ARRAY_DATA;
+            
+            /*
+             * Base64 text is 4 characters for every 3 bytes
+             */
+            this->dataArrayText.clear();
+            if (this->encodingForReadingArrayData == GiftiEncodingEnum::BASE64_BINARY) {
+                int64_t numBytes = 1;
+                for (std::vector<int64_t>::const_iterator iter = dimensionsForReadingArrayData.begin();
+                     iter != dimensionsForReadingArrayData.end();
+                     iter++) {
+                    numBytes *= *iter;
+                }
+                switch (this->dataTypeForReadingArrayData) {
+                    case NiftiDataTypeEnum::NIFTI_TYPE_FLOAT32:
+                    case NiftiDataTypeEnum::NIFTI_TYPE_INT32:
+                        numBytes *= 4;
+                        break;
+                    default:
+                        break;
+                }
+                if (numBytes > 0) {
+                    this->dataArrayText.reserve((numBytes + 2) / 3 * 4);
+                }
+            }
          }
          else if (qName == GiftiXmlElements::TAG_COORDINATE_TRANSFORMATION_MATRIX) {
             this->state = STATE_DATA_ARRAY_MATRIX;
@@ -228,6 +258,12 @@ GiftiFileSaxReader::endElement(const AString& namespaceURI,
       case STATE_NONE:
          break;
       case STATE_GIFTI:
+         /*
+          * Decode data of any remaining data arrays
+          */
+         if (qName == GiftiXmlElements::TAG_GIFTI) {
+             this->readPendingArrayData();
+         }
          break;
       case STATE_METADATA:
            this->metaDataSaxReader->endElement(namespaceURI, localName, qName);
@@ -508,6 +544,7 @@ GiftiFileSaxReader::createDataArray(const XmlAttributes& attributes)
 
 /**
  * process the array data into numbers.
+ * Data is decoded later, in parallel with other data arrays, by readPendingArrayData().
  */
 void 
 GiftiFileSaxReader::processArrayData()
@@ -515,19 +552,119 @@ GiftiFileSaxReader::processArrayData()
     this->dataArrayDataHasBeenRead = true;
 
     CaretAssert(dataArray);
-    try {
-        dataArray->readFromText(elementText,
-                                this->endianForReadingArrayData,
-                                arraySubscriptingOrderForReadingArrayData,
-                                dataTypeForReadingArrayData,
-                                dimensionsForReadingArrayData,
-                                encodingForReadingArrayData,
-                                externalFileNameForReadingData,
-                                externalFileOffsetForReadingData,
-                                this->giftiFile->getReadMetaDataOnlyFlag());
+    if (this->giftiFile->getReadMetaDataOnlyFlag()) {
+        try {
+            dataArray->readFromText(dataArrayText,
+                                    this->endianForReadingArrayData,
+                                    arraySubscriptingOrderForReadingArrayData,
+                                    dataTypeForReadingArrayData,
+                                    dimensionsForReadingArrayData,
+                                    encodingForReadingArrayData,
+                                    externalFileNameForReadingData,
+                                    externalFileOffsetForReadingData,
+                                    true);
+        }
+        catch (const GiftiException& e) {
+            throw XmlSaxParserException(e.whatString());
+        }
+        this->dataArrayText.clear();
+        return;
+    }
+    
+    PendingArrayData pending;
+    pending.dataArray              = dataArray;
+    pending.endian                 = this->endianForReadingArrayData;
+    pending.arraySubscriptingOrder = arraySubscriptingOrderForReadingArrayData;
+    pending.dataType               = dataTypeForReadingArrayData;
+    pending.dimensions             = dimensionsForReadingArrayData;
+    pending.encoding               = encodingForReadingArrayData;
+    pending.externalFileName       = externalFileNameForReadingData;
+    pending.externalFileOffset     = externalFileOffsetForReadingData;
+    this->pendingArrayData.push_back(pending);
+    this->pendingArrayData.back().text.swap(this->dataArrayText);
+    this->pendingArrayDataTextBytes += this->pendingArrayData.back().text.size();
+    
+    /*
+     * Enough arrays to keep every thread busy, without holding much text
+     */
+    int64_t maxPendingArrays = 1;
+#ifdef CARET_OMP
+    maxPendingArrays = 2 * omp_get_max_threads();
+#endif
+    const int64_t MAX_PENDING_TEXT_BYTES = ((int64_t)1) << 28;
+    if ((static_cast<int64_t>(this->pendingArrayData.size()) >= maxPendingArrays)
+        || (this->pendingArrayDataTextBytes >= MAX_PENDING_TEXT_BYTES)) {
+        this->readPendingArrayData();
+    }
+}
+
+/**
+ * decode the data of the pending data arrays, in parallel.
+ */
+void
+GiftiFileSaxReader::readPendingArrayData()
+{
+    const int64_t numPending = this->pendingArrayData.size();
+    std::vector<AString> errorMessages(numPending);
+    bool failed = false, badAlloc = false;
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int64_t i = 0; i < numPending; i++) {
+        PendingArrayData& pending = this->pendingArrayData[i];
+        try {
+            pending.dataArray->readFromText(pending.text,
+                                            pending.endian,
+                                            pending.arraySubscriptingOrder,
+                                            pending.dataType,
+                                            pending.dimensions,
+                                            pending.encoding,
+                                            pending.externalFileName,
+                                            pending.externalFileOffset,
+                                            false);
+        }
+        catch (const CaretException& e) {//exceptions can't leave a parallel region
+            errorMessages[i] = e.whatString();
+#pragma omp critical
+            {
+                failed = true;
+            }
+        }
+        catch (const std::bad_alloc&) {
+#pragma omp critical
+            {
+                badAlloc = true;
+            }
+        }
+        catch (const std::exception& e) {
+            errorMessages[i] = AString("exception while decoding data array: ") + e.what();
+#pragma omp critical
+            {
+                failed = true;
+            }
+        }
+        catch (...) {
+            errorMessages[i] = "unknown exception while decoding data array";
+#pragma omp critical
+            {
+                failed = true;
+            }
+        }
+        std::string().swap(pending.text);//free the text as soon as it is decoded
     }
-    catch (const GiftiException& e) {
-        throw XmlSaxParserException(e.whatString());
+    this->pendingArrayData.clear();
+    this->pendingArrayDataTextBytes = 0;
+    
+    if (badAlloc) {
+        throw std::bad_alloc();//rethrown as bad_alloc so the file reader reports it as out of memory
+    }
+    if (failed) {
+        /*
+         * Report the error of the first array that failed
+         */
+        for (int64_t i = 0; i < numPending; i++) {
+            if ( ! errorMessages[i].isEmpty()) {
+                throw XmlSaxParserException(errorMessages[i]);
+            }
+        }
     }
 }
 
@@ -543,6 +680,26 @@ GiftiFileSaxReader::characters(const char* ch)
     else if (this->labelTableSaxReader != NULL) {
         this->labelTableSaxReader->characters(ch);
     }
+    else if (this->state == STATE_DATA_ARRAY_DATA) {
+        switch (this->encodingForReadingArrayData) {
+            case GiftiEncodingEnum::BASE64_BINARY:
+            case GiftiEncodingEnum::GZIP_BASE64_BINARY:
+                /*
+                 * Base64 text is kept as bytes, without whitespace
+                 */
+                for (const char* ptr = ch; *ptr != '\0'; ) {
+                    const size_t runLength = strcspn(ptr, " \t\n\r");
+                    dataArrayText.append(ptr, runLength);
+                    ptr += runLength;
+                    ptr += strspn(ptr, " \t\n\r");
+                }
+                break;
+            case GiftiEncodingEnum::ASCII:
+            case GiftiEncodingEnum::EXTERNAL_FILE_BINARY:
+                dataArrayText += ch;
+                break;
+        }
+    }
     else {
         elementText += ch;
     }
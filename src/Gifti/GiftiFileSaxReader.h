@@ -23,6 +23,8 @@
 /*LICENSE_END*/
 
 #include <stack>
+#include <string>
+#include <vector>
 #include <AString.h>
 #include <stdint.h>
 
@@ -103,6 +105,22 @@ namespace caret {
         // process the array data into numbers
         void processArrayData();
         
+        // decode the data of the pending data arrays
+        void readPendingArrayData();
+        
+        /// data array whose data is decoded after more data arrays are parsed
+        struct PendingArrayData {
+            GiftiDataArray* dataArray;
+            std::string text;
+            GiftiEndianEnum::Enum endian;
+            GiftiArrayIndexingOrderEnum::Enum arraySubscriptingOrder;
+            NiftiDataTypeEnum::Enum dataType;
+            std::vector<int64_t> dimensions;
+            GiftiEncodingEnum::Enum encoding;
+            AString externalFileName;
+            int64_t externalFileOffset;
+        };
+        
         // create a data array
         void createDataArray(const XmlAttributes& attributes);
         
@@ -121,6 +139,15 @@ namespace caret {
         /// element text
         AString elementText;
         
+        /// text of the data array's Data element, Base64 is kept without whitespace
+        std::string dataArrayText;
+        
+        /// data arrays whose data is decoded in parallel
+        std::vector<PendingArrayData> pendingArrayData;
+        
+        /// bytes of text in the pending data arrays
+        int64_t pendingArrayDataTextBytes;
+        
         /// GIFTI data array being read
         CaretPointer<GiftiDataArray> dataArray;
         
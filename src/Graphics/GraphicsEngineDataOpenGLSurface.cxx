@@ -0,0 +1,313 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017 Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#define __GRAPHICS_ENGINE_DATA_OPEN_G_L_SURFACE_DECLARE__
+#include "GraphicsEngineDataOpenGLSurface.h"
+#undef __GRAPHICS_ENGINE_DATA_OPEN_G_L_SURFACE_DECLARE__
+
+#include "CaretAssert.h"
+#include "CaretLogger.h"
+#include "EventGraphicsOpenGLCreateBufferObject.h"
+#include "EventManager.h"
+#include "GraphicsOpenGLBufferObject.h"
+
+using namespace caret;
+
+
+    
+/**
+ * \class caret::GraphicsEngineDataOpenGLSurface 
+ * \brief OpenGL buffers for drawing a surface's triangles.
+ * \ingroup Graphics
+ *
+ * Coordinates, normal vectors, and triangles stay in buffer objects and are
+ * reloaded only when the surface's geometry modification count changes.
+ * Each coloring array (identified by the surface file's coloring key, one
+ * for each model type and tab) is packed to unsigned byte RGBA and reloaded
+ * only when its coloring stamp changes.
+ */
+
+/**
+ * Constructor.
+ *
+ * @param openglContextPointer
+ *     Context to which the OpenGL buffers apply.
+ */
+GraphicsEngineDataOpenGLSurface::GraphicsEngineDataOpenGLSurface(const void* openglContextPointer)
+: GraphicsEngineData(),
+m_openglContextPointer(openglContextPointer)
+{
+    
+}
+
+/**
+ * Destructor.
+ */
+GraphicsEngineDataOpenGLSurface::~GraphicsEngineDataOpenGLSurface()
+{
+    deleteBuffers();
+}
+
+/**
+ * @return The OpenGL context pointer.
+ */
+const void*
+GraphicsEngineDataOpenGLSurface::getOpenGLContextPointer() const
+{
+    return m_openglContextPointer;
+}
+
+/**
+ * Delete an OpenGL buffer object.
+ *
+ * @param bufferObject
+ *     Reference to pointer of buffer object for deletion.
+ *     If NULL, no action is taken.
+ *     Will be NULL upon exit.
+ */
+void
+GraphicsEngineDataOpenGLSurface::deleteBufferObjectHelper(GraphicsOpenGLBufferObject* &bufferObject)
+{
+    if (bufferObject != NULL) {
+        delete bufferObject;
+        bufferObject = NULL;
+    }
+}
+
+/**
+ * Delete the OpenGL buffer objects.
+ */
+void
+GraphicsEngineDataOpenGLSurface::deleteBuffers()
+{
+    deleteBufferObjectHelper(m_coordinateBufferObject);
+    deleteBufferObjectHelper(m_normalVectorBufferObject);
+    deleteBufferObjectHelper(m_triangleBufferObject);
+    for (auto& colorBuff : m_colorBuffers) {
+        deleteBufferObjectHelper(colorBuff.second.m_bufferObject);
+    }
+    m_colorBuffers.clear();
+    m_geometryModificationCount = -1;
+}
+
+/**
+ * @return A new buffer object.
+ */
+GraphicsOpenGLBufferObject*
+GraphicsEngineDataOpenGLSurface::createBufferObject()
+{
+    EventGraphicsOpenGLCreateBufferObject createEvent;
+    EventManager::get()->sendEvent(createEvent.getPointer());
+    GraphicsOpenGLBufferObject* bufferObject = createEvent.getOpenGLBufferObject();
+    CaretAssert(bufferObject);
+    CaretAssert(bufferObject->getBufferObjectName());
+    return bufferObject;
+}
+
+/**
+ * Load the coordinate, normal vector, and triangle buffers if the
+ * geometry has changed since they were last loaded.
+ *
+ * @param geometryModificationCount
+ *     Modification count of the surface's coordinates and topology.
+ * @param xyz
+ *     The coordinates.
+ * @param normalXYZ
+ *     The normal vectors.
+ * @param numberOfVertices
+ *     Number of vertices.
+ * @param triangles
+ *     The triangles (three vertex indices each).
+ * @param numberOfTriangles
+ *     Number of triangles.
+ */
+void
+GraphicsEngineDataOpenGLSurface::loadGeometry(const int64_t geometryModificationCount,
+                                              const float* xyz,
+                                              const float* normalXYZ,
+                                              const int32_t numberOfVertices,
+                                              const int32_t* triangles,
+                                              const int32_t numberOfTriangles)
+{
+    if ((geometryModificationCount == m_geometryModificationCount)
+        && (numberOfVertices == m_numberOfVertices)
+        && (numberOfTriangles == m_numberOfTriangles)) {
+        return;
+    }
+    
+    if (m_coordinateBufferObject == NULL) {
+        m_coordinateBufferObject   = createBufferObject();
+        m_normalVectorBufferObject = createBufferObject();
+        m_triangleBufferObject     = createBufferObject();
+    }
+    
+    /*
+     * Surfaces are drawn many times between changes to the geometry
+     */
+    glBindBuffer(GL_ARRAY_BUFFER,
+                 m_coordinateBufferObject->getBufferObjectName());
+    glBufferData(GL_ARRAY_BUFFER,
+                 numberOfVertices * 3 * sizeof(float),
+                 (const GLvoid*)xyz,
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER,
+                 m_normalVectorBufferObject->getBufferObjectName());
+    glBufferData(GL_ARRAY_BUFFER,
+                 numberOfVertices * 3 * sizeof(float),
+                 (const GLvoid*)normalXYZ,
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                 m_triangleBufferObject->getBufferObjectName());
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 numberOfTriangles * 3 * sizeof(int32_t),
+                 (const GLvoid*)triangles,
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    
+    m_numberOfVertices  = numberOfVertices;
+    m_numberOfTriangles = numberOfTriangles;
+    m_geometryModificationCount = geometryModificationCount;
+    
+    /*
+     * Color buffers are sized for the old number of vertices
+     */
+    for (auto& colorBuff : m_colorBuffers) {
+        colorBuff.second.m_coloringStamp = -1;
+    }
+}
+
+/**
+ * Load the color buffer for the given coloring if the coloring has changed
+ * since it was last loaded.  Colors are packed to unsigned bytes, which is
+ * one quarter of the size of the float coloring.
+ *
+ * @param coloringKey
+ *     Key of the coloring from SurfaceFile::getNodeColoringKeyAndStamp().
+ * @param rgba
+ *     The float RGBA coloring, four components for each vertex.
+ * @param coloringStamp
+ *     Stamp of the coloring from SurfaceFile::getNodeColoringKeyAndStamp().
+ */
+void
+GraphicsEngineDataOpenGLSurface::loadColors(const int32_t coloringKey,
+                                            const float* rgba,
+                                            const int64_t coloringStamp)
+{
+    CaretAssert(rgba);
+    ColorBuffer& colorBuffer = m_colorBuffers[coloringKey];
+    if (colorBuffer.m_coloringStamp == coloringStamp) {
+        return;
+    }
+    
+    if (colorBuffer.m_bufferObject == NULL) {
+        colorBuffer.m_bufferObject = createBufferObject();
+    }
+    
+    const int32_t numberOfComponents = m_numberOfVertices * 4;
+    m_packedRGBA.resize(numberOfComponents);
+    for (int32_t i = 0; i < numberOfComponents; i++) {
+        float value = rgba[i];
+        if (value < 0.0f) value = 0.0f;
+        if (value > 1.0f) value = 1.0f;
+        m_packedRGBA[i] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+    }
+    
+    glBindBuffer(GL_ARRAY_BUFFER,
+                 colorBuffer.m_bufferObject->getBufferObjectName());
+    glBufferData(GL_ARRAY_BUFFER,
+                 m_packedRGBA.size() * sizeof(uint8_t),
+                 (const GLvoid*)&m_packedRGBA[0],
+                 GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
+    colorBuffer.m_coloringStamp = coloringStamp;
+}
+
+/**
+ * Delete color buffers that were loaded before the given stamp.  Used
+ * when the surface file invalidates all of its coloring, so that buffers
+ * for colorings that are not set again (such as closed tabs) do not
+ * keep using graphics memory.
+ *
+ * @param coloringStamp
+ *     Buffers with a stamp older than this are deleted.
+ */
+void
+GraphicsEngineDataOpenGLSurface::deleteColorsOlderThan(const int64_t coloringStamp)
+{
+    std::map<int32_t, ColorBuffer>::iterator iter = m_colorBuffers.begin();
+    while (iter != m_colorBuffers.end()) {
+        if (iter->second.m_coloringStamp < coloringStamp) {
+            deleteBufferObjectHelper(iter->second.m_bufferObject);
+            iter = m_colorBuffers.erase(iter);
+        }
+        else {
+            ++iter;
+        }
+    }
+}
+
+/**
+ * Draw the triangles from the buffers.  Geometry must have been loaded
+ * and, if coloring is used, the coloring must have been loaded.
+ *
+ * @param coloringKey
+ *     Key of the coloring whose buffer is used or negative to use the current color.
+ */
+void
+GraphicsEngineDataOpenGLSurface::draw(const int32_t coloringKey)
+{
+    if (m_coordinateBufferObject == NULL) {
+        CaretLogSevere("Surface buffers drawn before geometry was loaded");
+        return;
+    }
+    
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, m_coordinateBufferObject->getBufferObjectName());
+    glVertexPointer(3, GL_FLOAT, 0, (GLvoid*)0);
+    
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, m_normalVectorBufferObject->getBufferObjectName());
+    glNormalPointer(GL_FLOAT, 0, (GLvoid*)0);
+    
+    if (coloringKey >= 0) {
+        std::map<int32_t, ColorBuffer>::iterator iter = m_colorBuffers.find(coloringKey);
+        CaretAssert(iter != m_colorBuffers.end());
+        if (iter != m_colorBuffers.end()) {
+            glEnableClientState(GL_COLOR_ARRAY);
+            glBindBuffer(GL_ARRAY_BUFFER, iter->second.m_bufferObject->getBufferObjectName());
+            glColorPointer(4, GL_UNSIGNED_BYTE, 0, (GLvoid*)0);
+        }
+    }
+    
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_triangleBufferObject->getBufferObjectName());
+    glDrawElements(GL_TRIANGLES,
+                   (3 * m_numberOfTriangles),
+                   GL_UNSIGNED_INT,
+                   (GLvoid*)0);
+    
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
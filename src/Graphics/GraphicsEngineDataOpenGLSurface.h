@@ -0,0 +1,108 @@
+#ifndef __GRAPHICS_ENGINE_DATA_OPEN_G_L_SURFACE_H__
+#define __GRAPHICS_ENGINE_DATA_OPEN_G_L_SURFACE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017 Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+
+#include <map>
+#include <stdint.h>
+#include <vector>
+
+#include "GraphicsEngineData.h"
+#include "CaretOpenGLInclude.h"
+
+namespace caret {
+
+    class GraphicsOpenGLBufferObject;
+    
+    class GraphicsEngineDataOpenGLSurface : public GraphicsEngineData {
+        
+    public:
+        GraphicsEngineDataOpenGLSurface(const void* openglContextPointer);
+        
+        virtual ~GraphicsEngineDataOpenGLSurface();
+        
+        void deleteBuffers();
+        
+        const void* getOpenGLContextPointer() const;
+        
+        void loadGeometry(const int64_t geometryModificationCount,
+                          const float* xyz,
+                          const float* normalXYZ,
+                          const int32_t numberOfVertices,
+                          const int32_t* triangles,
+                          const int32_t numberOfTriangles);
+        
+        void loadColors(const int32_t coloringKey,
+                        const float* rgba,
+                        const int64_t coloringStamp);
+        
+        void deleteColorsOlderThan(const int64_t coloringStamp);
+        
+        void draw(const int32_t coloringKey);
+
+        // ADD_NEW_METHODS_HERE
+
+    private:
+        /** Packed color buffer for one coloring array (a surface has coloring for each tab and model type) */
+        struct ColorBuffer {
+            GraphicsOpenGLBufferObject* m_bufferObject = NULL;
+            
+            int64_t m_coloringStamp = -1;
+        };
+        
+        GraphicsEngineDataOpenGLSurface(const GraphicsEngineDataOpenGLSurface&);
+
+        GraphicsEngineDataOpenGLSurface& operator=(const GraphicsEngineDataOpenGLSurface&);
+        
+        static GraphicsOpenGLBufferObject* createBufferObject();
+        
+        void deleteBufferObjectHelper(GraphicsOpenGLBufferObject* &bufferObject);
+        
+        const void* m_openglContextPointer;
+        
+        int64_t m_geometryModificationCount = -1;
+        
+        int32_t m_numberOfVertices = 0;
+        
+        int32_t m_numberOfTriangles = 0;
+        
+        GraphicsOpenGLBufferObject* m_coordinateBufferObject = NULL;
+        
+        GraphicsOpenGLBufferObject* m_normalVectorBufferObject = NULL;
+        
+        GraphicsOpenGLBufferObject* m_triangleBufferObject = NULL;
+        
+        /** color buffers keyed by the surface file's coloring key, not by address, since a freed coloring's memory may be reused */
+        std::map<int32_t, ColorBuffer> m_colorBuffers;
+        
+        std::vector<uint8_t> m_packedRGBA;
+
+        // ADD_NEW_MEMBERS_HERE
+
+    };
+    
+#ifdef __GRAPHICS_ENGINE_DATA_OPEN_G_L_SURFACE_DECLARE__
+    // <PLACE DECLARATIONS OF STATIC MEMBERS HERE>
+#endif // __GRAPHICS_ENGINE_DATA_OPEN_G_L_SURFACE_DECLARE__
+
+} // namespace
+#endif  //__GRAPHICS_ENGINE_DATA_OPEN_G_L_SURFACE_H__
@@ -25,9 +25,14 @@
 using namespace std;
 using namespace caret;
 
-void NiftiIO::openRead(const QString& filename)
+void NiftiIO::openRead(const QString& filename, const bool& memoryMap)
 {
-    m_file.open(filename);
+    if (memoryMap)
+    {
+        m_file.openMapped(filename);//falls back to normal reading if it can't be mapped
+    } else {
+        m_file.open(filename);
+    }
     m_header.read(m_file);
     if (m_header.getDataType() == DT_BINARY)
     {
@@ -69,6 +74,41 @@ void NiftiIO::close()
     m_dims.clear();
 }
 
+void NiftiIO::getElementRange(const int& fullDims, const vector<int64_t>& indexSelect, int64_t& numElemsOut, int64_t& numSkipOut) const
+{
+    CaretAssert(fullDims >= 0 && fullDims <= (int)m_dims.size());
+    CaretAssert((size_t)fullDims + indexSelect.size() == m_dims.size());//could be >=, but should catch more stupid mistakes as ==
+    numElemsOut = getNumComponents();//for now, calculate read size on the fly, as the read call will be the slowest part
+    int curDim;
+    for (curDim = 0; curDim < fullDims; ++curDim)
+    {
+        numElemsOut *= m_dims[curDim];
+    }
+    int64_t numDimSkip = numElemsOut;
+    numSkipOut = 0;
+    for (; curDim < (int)m_dims.size(); ++curDim)
+    {
+        CaretAssert(indexSelect[curDim - fullDims] >= 0 && indexSelect[curDim - fullDims] < m_dims[curDim]);
+        numSkipOut += indexSelect[curDim - fullDims] * numDimSkip;
+        numDimSkip *= m_dims[curDim];
+    }
+}
+
+const float* NiftiIO::getMappedFloatData(const int& fullDims, const vector<int64_t>& indexSelect)
+{
+    const char* mapped = m_file.getMappedData();
+    if (mapped == NULL) return NULL;
+    if (m_header.getDataType() != NIFTI_TYPE_FLOAT32 || m_header.isSwapped()) return NULL;
+    double mult, offset;
+    if (m_header.getDataScaling(mult, offset)) return NULL;
+    if (m_header.getDataOffset() % sizeof(float) != 0) return NULL;//mapping is page-aligned, so only the data offset can misalign it
+    int64_t numElems, numSkip;
+    getElementRange(fullDims, indexSelect, numElems, numSkip);
+    int64_t position = numSkip * sizeof(float) + m_header.getDataOffset();
+    if (position + numElems * (int64_t)sizeof(float) > m_file.size()) return NULL;//let readData give the truncation error
+    return (const float*)(mapped + position);
+}
+
 int NiftiIO::getNumComponents() const
 {
     return m_header.getNumComponents();
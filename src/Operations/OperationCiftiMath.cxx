@@ -24,10 +24,12 @@
 #include "CaretAssert.h"
 #include "CaretLogger.h"
 #include "CaretMathExpression.h"
+#include "CaretOMP.h"
 #include "CiftiFile.h"
 #include "CiftiXML.h"
 #include "MultiDimIterator.h"
 
+#include <algorithm>
 #include <iostream>
 
 using namespace caret;
@@ -235,57 +237,88 @@ void OperationCiftiMath::useParameters(OperationParameters* myParams, ProgressOb
     }
     if (outXML.getNumberOfDimensions() < 1) throw OperationException("output must have at least 1 dimension");
     myCiftiOut->setCiftiXML(outXML);
-    vector<float> values(numVars), scratchRow(outDims[0]);
-    vector<vector<float> > inputRows(numVars);
+    const int64_t BATCH_ELEMENTS = 1 << 20;//rows are gathered into batches of about this many elements, which are evaluated in parallel
+    int64_t rowLength = outDims[0], maxRowLength = outDims[0];
+    vector<int64_t> inputRowLength(numVars), strides(numVars);
+    for (int v = 0; v < numVars; ++v)
+    {
+        inputRowLength[v] = varCiftiFiles[v]->getCiftiXML().getDimensionLength(CiftiXML::ALONG_ROW);
+        maxRowLength = max(maxRowLength, inputRowLength[v]);
+        strides[v] = (selectInfo[v][0] == -1 ? 1 : 0);//select along row means a single value for the whole row
+    }
+    int64_t batchRows = max((int64_t)1, BATCH_ELEMENTS / maxRowLength);
+    vector<vector<float> > inputRows(numVars);//storage for up to batchRows loaded rows per variable
     vector<vector<int64_t> > loadedRow(numVars);//to detect and prevent rereading the same row
+    vector<int64_t> slotsUsed(numVars);
     for (int v = 0; v < numVars; ++v)
     {
-        inputRows[v].resize(varCiftiFiles[v]->getCiftiXML().getDimensionLength(CiftiXML::ALONG_ROW));
+        inputRows[v].resize(batchRows * inputRowLength[v]);
         loadedRow[v].resize(varCiftiFiles[v]->getCiftiXML().getNumberOfDimensions() - 1, -1);//we always load a full row, so ignore first dim
     }
-    for (MultiDimIterator<int64_t> iter(vector<int64_t>(outDims.begin() + 1, outDims.end())); !iter.atEnd(); ++iter)
+    vector<vector<const float*> > batchInputs(batchRows, vector<const float*>(numVars));
+    vector<vector<int64_t> > batchPositions;
+    vector<float> outBatch(batchRows * rowLength);
+    MultiDimIterator<int64_t> iter(vector<int64_t>(outDims.begin() + 1, outDims.end()));
+    while (!iter.atEnd())
     {
-        for (int v = 0; v < numVars; ++v)//first, retrieve whichever rows are needed
+        batchPositions.clear();
+        for (int v = 0; v < numVars; ++v)
         {
-            bool needToLoad = false;
-            for (int dim = 0; dim < (int)loadedRow[v].size(); ++dim)
+            slotsUsed[v] = 0;
+        }
+        for (; !iter.atEnd() && (int64_t)batchPositions.size() < batchRows; ++iter)
+        {
+            int64_t b = (int64_t)batchPositions.size();
+            for (int v = 0; v < numVars; ++v)//first, retrieve whichever rows are needed
             {
-                int64_t indexNeeded = -1;
-                if (selectInfo[v][dim + 1] == -1)
+                bool needToLoad = (slotsUsed[v] == 0);//slots are reused between batches
+                for (int dim = 0; dim < (int)loadedRow[v].size(); ++dim)
                 {
-                    CaretAssert(dim + 1 < (int)outDims.size());//"match to output index" can't work past output dimensionality
-                    indexNeeded = (*iter)[dim];//NOTE: iter also doesn't include the first dim
-                } else {
-                    indexNeeded = selectInfo[v][dim + 1];
+                    int64_t indexNeeded = -1;
+                    if (selectInfo[v][dim + 1] == -1)
+                    {
+                        CaretAssert(dim + 1 < (int)outDims.size());//"match to output index" can't work past output dimensionality
+                        indexNeeded = (*iter)[dim];//NOTE: iter also doesn't include the first dim
+                    } else {
+                        indexNeeded = selectInfo[v][dim + 1];
+                    }
+                    if (indexNeeded != loadedRow[v][dim])
+                    {
+                        needToLoad = true;
+                        loadedRow[v][dim] = indexNeeded;
+                    }
                 }
-                if (indexNeeded != loadedRow[v][dim])
+                if (needToLoad)
                 {
-                    needToLoad = true;
-                    loadedRow[v][dim] = indexNeeded;
+                    varCiftiFiles[v]->getRow(inputRows[v].data() + slotsUsed[v] * inputRowLength[v], loadedRow[v]);
+                    ++slotsUsed[v];
+                }
+                const float* rowStart = inputRows[v].data() + (slotsUsed[v] - 1) * inputRowLength[v];
+                if (selectInfo[v][0] == -1)//now we check for select along row
+                {
+                    batchInputs[b][v] = rowStart;
+                } else {
+                    batchInputs[b][v] = rowStart + selectInfo[v][0];
                 }
             }
-            if (needToLoad)
-            {
-                varCiftiFiles[v]->getRow(inputRows[v].data(), loadedRow[v]);
-            }
+            batchPositions.push_back(*iter);
         }
-        for (int j = 0; j < outDims[0]; ++j)
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int b = 0; b < (int)batchPositions.size(); ++b)
         {
-            for (int v = 0; v < numVars; ++v)//now we check for select along row
+            float* outRow = outBatch.data() + b * rowLength;
+            myExpr.evaluateMany(batchInputs[b], outRow, rowLength, &strides);
+            if (nanfix)
             {
-                if (selectInfo[v][0] == -1)
+                for (int64_t j = 0; j < rowLength; ++j)
                 {
-                    values[v] = inputRows[v][j];
-                } else {
-                    values[v] = inputRows[v][selectInfo[v][0]];
+                    if (outRow[j] != outRow[j]) outRow[j] = nanfixval;
                 }
             }
-            scratchRow[j] = (float)myExpr.evaluate(values);
-            if (nanfix && scratchRow[j] != scratchRow[j])
-            {
-                scratchRow[j] = nanfixval;
-            }
         }
-        myCiftiOut->setRow(scratchRow.data(), *iter);
+        for (int b = 0; b < (int)batchPositions.size(); ++b)
+        {
+            myCiftiOut->setRow(outBatch.data() + b * rowLength, batchPositions[b]);
+        }
     }
 }
@@ -21,6 +21,7 @@
 #include "OperationCiftiStats.h"
 #include "OperationException.h"
 
+#include "CaretOMP.h"
 #include "CiftiFile.h"
 #include "ReductionOperation.h"
 
@@ -65,11 +66,18 @@ OperationParameters* OperationCiftiStats::getParameters()
     
     ret->createOptionalParameter(6, "-show-map-name", "print column index and name before each output");
     
+    OptionalParameter* memLimitOpt = ret->createOptionalParameter(7, "-mem-limit", "restrict memory usage of MEDIAN, MODE and -percentile");
+    memLimitOpt->addDoubleParameter(1, "limit-GB", "memory limit in gigabytes (default 4)");
+    
     ret->setHelpText(
         AString("For each column of the input, a single number is printed, resulting from the specified reduction or percentile operation.  ") +
         "Use -column to only give output for a single column.  " +
         "Use -roi to consider only the data within a region.  " +
         "Exactly one of -reduce or -percentile must be specified.\n\n" +
+        "When -column is not specified, the file is read through once, a block of rows at a time, for most reductions.  " +
+        "MEDIAN, MODE and -percentile need every value of a column at once, so they hold as many whole columns as fit in the memory limit (4 GB by default), " +
+        "and read through the whole file again for each group of columns.  " +
+        "A limit much smaller than the file makes them read the file many times, a limit larger than the file reads it once.\n\n" +
         "The argument to the -reduce option must be one of the following:\n\n" +
         ReductionOperation::getHelpInfo());
     return ret;
@@ -119,13 +127,137 @@ namespace
             }
         }
         if (toUse.empty()) throw OperationException("roi is empty");
-        sort(toUse.begin(), toUse.end());
-        const float index = percent / 100.0f * (toUse.size() - 1);
-        if (index <= 0) return toUse[0];
-        if (index >= toUse.size() - 1) return toUse.back();
-        float ipart, fpart;
-        fpart = modf(index, &ipart);
-        return (1.0f - fpart) * toUse[(int)ipart] + fpart * toUse[((int)ipart) + 1];
+        return ReductionOperation::percentileInPlace(toUse.data(), toUse.size(), percent);
+    }
+    
+    const int64_t ROW_BLOCK_FLOATS = 1 << 24;//read this much of the file at once, 64MB
+    const float DEFAULT_MEM_LIMIT_GB = 4.0f;//MEDIAN, MODE and -percentile hold columns in memory, a 20GB dtseries shouldn't need 20GB of RAM
+    
+    void readRowBlock(const CiftiFile* input, const int64_t& startRow, const int64_t& numRows, const int64_t& rowLength, vector<float>& blockOut)
+    {
+        blockOut.resize(numRows * rowLength);
+        vector<int64_t> indices(numRows);
+        for (int64_t i = 0; i < numRows; ++i)
+        {
+            indices[i] = startRow + i;
+        }
+        input->getRows(blockOut.data(), indices);//adjacent rows get read in large contiguous chunks
+    }
+    
+    //stream the file by blocks of rows, accumulating every column in one pass, only keeps one block in memory
+    void streamingReduce(const CiftiFile* input, const ReductionEnum::Enum& myop, const vector<float>& roiData, const CiftiFile* matchRoi, vector<float>& resultsOut)
+    {
+        const CiftiXML& myXML = input->getCiftiXML();
+        const int64_t numCols = myXML.getDimensionLength(CiftiXML::ALONG_ROW), colLength = myXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
+        const int64_t rowsPerBlock = max((int64_t)1, ROW_BLOCK_FLOATS / numCols);
+        vector<ReductionAccumulator> accums(numCols, ReductionAccumulator(myop));
+        vector<float> dataBlock, roiBlock;
+        for (int64_t startRow = 0; startRow < colLength; startRow += rowsPerBlock)
+        {
+            const int64_t blockRows = min(rowsPerBlock, colLength - startRow);
+            readRowBlock(input, startRow, blockRows, numCols, dataBlock);//reading is serial, the accumulation is parallel across columns
+            if (matchRoi != NULL) readRowBlock(matchRoi, startRow, blockRows, numCols, roiBlock);
+#pragma omp CARET_PARFOR
+            for (int64_t col = 0; col < numCols; ++col)
+            {
+                ReductionAccumulator& myAccum = accums[col];
+                for (int64_t i = 0; i < blockRows; ++i)
+                {
+                    if (matchRoi != NULL)
+                    {
+                        if (!(roiBlock[i * numCols + col] > 0.0f)) continue;
+                    } else if (!roiData.empty()) {
+                        if (!(roiData[startRow + i] > 0.0f)) continue;
+                    }
+                    myAccum.addValue(dataBlock[i * numCols + col]);
+                }
+            }
+        }
+        resultsOut.resize(numCols);
+        for (int64_t col = 0; col < numCols; ++col)
+        {
+            if (accums[col].getCount() == 0) throw OperationException("roi column is empty");
+            resultsOut[col] = accums[col].getResult();
+        }
+    }
+    
+    //median, mode and percentile need whole columns, so gather as many columns as fit in the memory limit per pass through the file
+    //each pass reads the entire file, so the number of passes is the I/O cost: numCols / colsPerPass
+    void multiPassColumns(const CiftiFile* input, const ReductionEnum::Enum& myop, const bool& usePercentile, const float& percent,
+                          const vector<float>& roiData, const CiftiFile* matchRoi, const float& memLimitGB, vector<float>& resultsOut)
+    {
+        const CiftiXML& myXML = input->getCiftiXML();
+        const int64_t numCols = myXML.getDimensionLength(CiftiXML::ALONG_ROW), colLength = myXML.getDimensionLength(CiftiXML::ALONG_COLUMN);
+        const int64_t rowsPerBlock = max((int64_t)1, ROW_BLOCK_FLOATS / numCols);
+        int64_t blockBytes = rowsPerBlock * numCols * (int64_t)sizeof(float) * (matchRoi == NULL ? 1 : 2);//the row blocks are also in memory
+        int64_t columnBytes = (int64_t)min((double)memLimitGB * (1LL << 30), 1e18) - blockBytes;//clamp, so a huge limit doesn't overflow
+        int64_t colsPerPass = min(numCols, max((int64_t)1, columnBytes / (colLength * (int64_t)sizeof(float))));
+        resultsOut.resize(numCols);
+        vector<float> dataBlock, roiBlock;
+        for (int64_t passStart = 0; passStart < numCols; passStart += colsPerPass)
+        {
+            const int64_t passCols = min(colsPerPass, numCols - passStart);
+            vector<vector<float> > columns(passCols);
+            for (int64_t j = 0; j < passCols; ++j)
+            {
+                columns[j].reserve(colLength);//so the parallel gathering below doesn't reallocate
+            }
+            for (int64_t startRow = 0; startRow < colLength; startRow += rowsPerBlock)
+            {
+                const int64_t blockRows = min(rowsPerBlock, colLength - startRow);
+                readRowBlock(input, startRow, blockRows, numCols, dataBlock);
+                if (matchRoi != NULL) readRowBlock(matchRoi, startRow, blockRows, numCols, roiBlock);
+#pragma omp CARET_PARFOR
+                for (int64_t j = 0; j < passCols; ++j)
+                {
+                    const int64_t col = passStart + j;
+                    vector<float>& myColumn = columns[j];
+                    for (int64_t i = 0; i < blockRows; ++i)
+                    {
+                        if (matchRoi != NULL)
+                        {
+                            if (!(roiBlock[i * numCols + col] > 0.0f)) continue;
+                        } else if (!roiData.empty()) {
+                            if (!(roiData[startRow + i] > 0.0f)) continue;
+                        }
+                        myColumn.push_back(dataBlock[i * numCols + col]);
+                    }
+                }
+            }
+            for (int64_t j = 0; j < passCols; ++j)
+            {
+                if (columns[j].empty()) throw OperationException("roi column is empty");
+            }
+            bool failed = false;
+            AString errorMessage;
+#pragma omp CARET_PARFOR schedule(dynamic)
+            for (int64_t j = 0; j < passCols; ++j)
+            {
+                try
+                {
+                    if (usePercentile)
+                    {
+                        resultsOut[passStart + j] = ReductionOperation::percentileInPlace(columns[j].data(), columns[j].size(), percent);
+                    } else {
+                        resultsOut[passStart + j] = ReductionOperation::reduce(columns[j].data(), columns[j].size(), myop);
+                    }
+                } catch (CaretException& e) {//exceptions can't leave a parallel region
+#pragma omp critical
+                    {
+                        failed = true;
+                        errorMessage = e.whatString();
+                    }
+                } catch (...) {
+#pragma omp critical
+                    {
+                        failed = true;
+                        errorMessage = "unknown exception during reduction";
+                    }
+                }
+                vector<float>().swap(columns[j]);//release memory as we go
+            }
+            if (failed) throw OperationException(errorMessage);
+        }
     }
 }
 
@@ -187,36 +319,35 @@ void OperationCiftiStats::useParameters(OperationParameters* myParams, ProgressO
         }
     }
     bool showMapName = myParams->getOptionalParameter(6)->m_present;
+    float memLimitGB = DEFAULT_MEM_LIMIT_GB;
+    OptionalParameter* memLimitOpt = myParams->getOptionalParameter(7);
+    if (memLimitOpt->m_present)
+    {
+        memLimitGB = (float)memLimitOpt->getDouble(1);
+        if (memLimitGB < 0.0f)
+        {
+            throw OperationException("memory limit cannot be negative");
+        }
+    }
     const CiftiMappingType* rowMap = myXML.getMap(CiftiXML::ALONG_ROW);
     vector<float> colScratch(colLength);
     if (useColumn == -1)
     {
-        myInput->convertToInMemory();//we will be getting all columns, so read it all in first
-        if (matchColumnMode)
+        vector<float> results;//don't convert to in-memory, stream through the file instead so memory use doesn't depend on file size
+        if (reduceOpt->m_present && ReductionAccumulator::isSupported(myop))
         {
-            roiCifti->convertToInMemory();//ditto
+            streamingReduce(myInput, myop, roiData, (matchColumnMode ? roiCifti : NULL), results);
+        } else {
+            multiPassColumns(myInput, myop, percentileOpt->m_present, percent, roiData, (matchColumnMode ? roiCifti : NULL), memLimitGB, results);
         }
         for (int i = 0; i < numCols; ++i)
         {
-            myInput->getColumn(colScratch.data(), i);
-            if (matchColumnMode)
-            {
-                roiCifti->getColumn(roiData.data(), i);
-            }
-            float result;
-            if (reduceOpt->m_present)
-            {
-                result = reduce(colScratch, myop, roiData);
-            } else {
-                CaretAssert(percentileOpt->m_present);
-                result = percentile(colScratch, percent, roiData);
-            }
             if (showMapName)
             {
                 cout << AString::number(i + 1) << ": " << rowMap->getIndexName(i) << ": ";
             }
             stringstream resultsstr;
-            resultsstr << setprecision(7) << result;
+            resultsstr << setprecision(7) << results[i];
             cout << resultsstr.str() << endl;
         }
     } else {
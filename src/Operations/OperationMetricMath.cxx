@@ -24,8 +24,10 @@
 #include "CaretAssert.h"
 #include "CaretLogger.h"
 #include "CaretMathExpression.h"
+#include "CaretOMP.h"
 #include "MetricFile.h"
 
+#include <algorithm>
 #include <iostream>
 
 using namespace caret;
@@ -181,7 +183,8 @@ void OperationMetricMath::useParameters(OperationParameters* myParams, ProgressO
     {
         throw OperationException("all -var options used -repeat, there is no file to get number of desired output columns from");
     }
-    vector<float> values(numVars), colScratch(numNodes);
+    const int ELEMENT_CHUNK = 16384;//vertices per thread work unit
+    vector<float> colScratch(numNodes);
     vector<const float*> columnPointers(numVars);
     myMetricOut->setNumberOfNodesAndColumns(numNodes, numColumns);
     myMetricOut->setStructure(myStructure);
@@ -197,16 +200,22 @@ void OperationMetricMath::useParameters(OperationParameters* myParams, ProgressO
                 columnPointers[v] = varMetrics[v]->getValuePointerForColumn(metricColumns[v]);
             }
         }
-        for (int i = 0; i < numNodes; ++i)
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int start = 0; start < numNodes; start += ELEMENT_CHUNK)
         {
+            int count = min(ELEMENT_CHUNK, numNodes - start);
+            vector<const float*> chunkInputs(numVars);
             for (int v = 0; v < numVars; ++v)
             {
-                values[v] = columnPointers[v][i];
+                chunkInputs[v] = columnPointers[v] + start;
             }
-            colScratch[i] = (float)myExpr.evaluate(values);
-            if (nanfix && colScratch[i] != colScratch[i])
+            myExpr.evaluateMany(chunkInputs, colScratch.data() + start, count);
+            if (nanfix)
             {
-                colScratch[i] = nanfixval;
+                for (int i = start; i < start + count; ++i)
+                {
+                    if (colScratch[i] != colScratch[i]) colScratch[i] = nanfixval;
+                }
             }
         }
         myMetricOut->setValuesForColumn(j, colScratch.data());
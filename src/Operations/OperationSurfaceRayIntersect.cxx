@@ -0,0 +1,134 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "OperationSurfaceRayIntersect.h"
+#include "OperationException.h"
+
+#include "CaretOMP.h"
+#include "CaretTriangleLocator.h"
+#include "SurfaceFile.h"
+
+#include <fstream>
+
+using namespace caret;
+using namespace std;
+
+AString OperationSurfaceRayIntersect::getCommandSwitch()
+{
+    return "-surface-ray-intersect";
+}
+
+AString OperationSurfaceRayIntersect::getShortDescription()
+{
+    return "FIND WHERE RAYS FIRST HIT A SURFACE";
+}
+
+OperationParameters* OperationSurfaceRayIntersect::getParameters()
+{
+    OperationParameters* ret = new OperationParameters();
+    ret->addSurfaceParameter(1, "surface", "the surface to use");
+    ret->addStringParameter(2, "ray-list-file", "text file with ray start coordinates and directions");
+    ret->addStringParameter(3, "hit-list-out", "output - the output text file with the hits");//HACK: we don't currently have an "output text file" parameter type, fake the formatting
+    OptionalParameter* directionOpt = ret->createOptionalParameter(4, "-direction", "use the same direction for all rays, the input file then only contains start coordinates");
+    directionOpt->addDoubleParameter(1, "x", "x component of the direction");
+    directionOpt->addDoubleParameter(2, "y", "y component of the direction");
+    directionOpt->addDoubleParameter(3, "z", "z component of the direction");
+    ret->setHelpText(
+        AString("For each ray, find the first triangle of the surface that it hits, and output a line containing the vertex of that triangle closest to the hit, ") +
+        "the triangle number, the distance from the start of the ray, and the XYZ coordinate of the hit.  " +
+        "Rays that do not hit the surface output -1 for the vertex and triangle, and 0 for the other values.  " +
+        "Each ray in the input file is 6 numbers, the start XYZ followed by the direction XYZ (which does not need to be normalized), " +
+        "or 3 numbers if -direction is specified.  " +
+        "The input file should only use whitespace to separate numbers (spaces, newlines, tabs), for instance:\n\n" +
+        "20 30 100 0 0 -1\n30 -20 100 0 0 -1"
+    );
+    return ret;
+}
+
+void OperationSurfaceRayIntersect::useParameters(OperationParameters* myParams, ProgressObject* myProgObj)
+{
+    LevelProgress myProgress(myProgObj);
+    SurfaceFile* mySurf = myParams->getSurface(1);
+    AString rayFileName = myParams->getString(2);
+    fstream rayFile(rayFileName.toLocal8Bit().constData(), fstream::in);
+    if (!rayFile.good())
+    {
+        throw OperationException("error opening ray list file for reading");
+    }
+    AString hitFileName = myParams->getString(3);
+    fstream hitFile(hitFileName.toLocal8Bit().constData(), fstream::out);
+    if (!hitFile.good())
+    {
+        throw OperationException("error opening output file for writing");
+    }
+    float fixedDirection[3] = { 0.0f, 0.0f, 0.0f };
+    OptionalParameter* directionOpt = myParams->getOptionalParameter(4);
+    bool useFixedDirection = directionOpt->m_present;
+    if (useFixedDirection)
+    {
+        fixedDirection[0] = (float)directionOpt->getDouble(1);
+        fixedDirection[1] = (float)directionOpt->getDouble(2);
+        fixedDirection[2] = (float)directionOpt->getDouble(3);
+        if (fixedDirection[0] == 0.0f && fixedDirection[1] == 0.0f && fixedDirection[2] == 0.0f)
+        {
+            throw OperationException("direction must not be all zeros");
+        }
+    }
+    const int valuesPerRay = (useFixedDirection ? 3 : 6);
+    vector<float> rays;
+    float value;
+    while (rayFile >> value)
+    {
+        rays.push_back(value);
+        for (int i = 1; i < valuesPerRay; ++i)
+        {
+            if (!(rayFile >> value))
+            {
+                throw OperationException("read incomplete ray, would have been ray number " + AString::number(rays.size() / valuesPerRay + 1));
+            }
+            rays.push_back(value);
+        }
+    }
+    if (rays.empty())
+    {
+        throw OperationException("did not find any rays in file, make sure you use only whitespace to separate numbers");
+    }
+    int64_t numRays = (int64_t)(rays.size() / valuesPerRay);
+    vector<TriangleRayHit> hits(numRays);
+    CaretPointer<const CaretTriangleLocator> myLocator = mySurf->getTriangleLocator();
+#pragma omp CARET_PARFOR schedule(dynamic)
+    for (int64_t i = 0; i < numRays; ++i)
+    {
+        const float* start = rays.data() + i * valuesPerRay;
+        const float* direction = (useFixedDirection ? fixedDirection : start + 3);
+        myLocator->rayIntersects(start, direction, &(hits[i]));
+    }
+    for (int64_t i = 0; i < numRays; ++i)
+    {
+        const TriangleRayHit& thisHit = hits[i];
+        if (thisHit.triangle < 0)
+        {
+            hitFile << "-1 -1 0 0 0 0" << endl;
+        } else {
+            hitFile << thisHit.nearestVertex << " " << thisHit.triangle << " " << thisHit.distance << " "
+                    << thisHit.xyz[0] << " " << thisHit.xyz[1] << " " << thisHit.xyz[2] << endl;
+        }
+    }
+}
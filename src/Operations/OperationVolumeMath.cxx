@@ -24,8 +24,10 @@
 #include "CaretAssert.h"
 #include "CaretLogger.h"
 #include "CaretMathExpression.h"
+#include "CaretOMP.h"
 #include "VolumeFile.h"
 
+#include <algorithm>
 #include <iostream>
 
 using namespace caret;
@@ -189,7 +191,8 @@ void OperationVolumeMath::useParameters(OperationParameters* myParams, ProgressO
         throw OperationException("all -var options used -repeat, there is no file to get number of desired output subvolumes from");
     }
     int64_t frameSize = outDims[0] * outDims[1] * outDims[2];
-    vector<float> values(numVars), outFrame(frameSize);
+    const int64_t ELEMENT_CHUNK = 16384;//voxels per thread work unit
+    vector<float> outFrame(frameSize);
     vector<const float*> inputFrames(numVars);
     myVolOut->reinitialize(outDims, first->getSform());//DO NOT take volume type from first volume, because we don't check for or copy label tables, nor do we want to
     for (int s = 0; s < numSubvols; ++s)
@@ -204,18 +207,23 @@ void OperationVolumeMath::useParameters(OperationParameters* myParams, ProgressO
                 inputFrames[v] = varVolumes[v]->getFrame(varSubvolumes[v]);
             }
         }
-        for (int64_t i = 0; i < frameSize; ++i)
+#pragma omp CARET_PARFOR schedule(dynamic)
+        for (int64_t start = 0; start < frameSize; start += ELEMENT_CHUNK)
         {
+            int64_t count = min(ELEMENT_CHUNK, frameSize - start);
+            vector<const float*> chunkInputs(numVars);
             for (int v = 0; v < numVars; ++v)
             {
-                values[v] = inputFrames[v][i];
+                chunkInputs[v] = inputFrames[v] + start;
             }
-            float tempf = (float)myExpr.evaluate(values);
-            if (nanfix && tempf != tempf)
+            myExpr.evaluateMany(chunkInputs, outFrame.data() + start, count);
+            if (nanfix)
             {
-                tempf = nanfixval;
+                for (int64_t i = start; i < start + count; ++i)
+                {
+                    if (outFrame[i] != outFrame[i]) outFrame[i] = nanfixval;
+                }
             }
-            outFrame[i] = tempf;
         }
         myVolOut->setFrame(outFrame.data(), s);
     }
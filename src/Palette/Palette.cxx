@@ -481,6 +481,81 @@ Palette::getPaletteColor(
     }
 }
 
+/**
+ * Get the scalars, colors, and none color status that determine the
+ * content of a lookup table.
+ *
+ * @param keyOut - filled with six values for each scalar and color.
+ */
+void
+Palette::getPaletteColorLookupTableKey(std::vector<float>& keyOut) const
+{
+    const int32_t numScalarColors = this->getNumberOfScalarsAndColors();
+    keyOut.resize(numScalarColors * 6);
+    for (int32_t i = 0; i < numScalarColors; i++) {
+        const PaletteScalarAndColor* psac = this->paletteScalars[i];
+        const float* rgba = psac->getColor();
+        float* key = &keyOut[i * 6];
+        key[0] = psac->getScalar();
+        key[1] = rgba[0];
+        key[2] = rgba[1];
+        key[3] = rgba[2];
+        key[4] = rgba[3];
+        key[5] = (psac->isNoneColor() ? 1.0f : 0.0f);
+    }
+}
+
+/**
+ * Get a color lookup table for normalized scalars in [-1, 1].  The
+ * table has LOOKUP_TABLE_SIZE RGBA samples evenly spaced from -1 to 1
+ * and marks the cells between samples that contain one of the palette's
+ * scalars, use getLookupTableColor() to color a scalar.  The
+ * table is built on first use and rebuilt only when the palette's
+ * scalars or colors have changed.
+ *
+ * @param interpolateColorFlag - interpolate between palette colors.
+ * @return  Shared pointer to the table, remains valid even if the palette changes.
+ */
+CaretPointer<const Palette::ColorLookupTable>
+Palette::getPaletteColorLookupTable(const bool interpolateColorFlag) const
+{
+    const int32_t which = (interpolateColorFlag ? 1 : 0);
+    std::vector<float> key;
+    this->getPaletteColorLookupTableKey(key);
+    
+    CaretMutexLocker locker(&this->lookupTableMutex);
+    if (this->lookupTables[which] == NULL
+        || key != this->lookupTableKeys[which]) {
+        ColorLookupTable* table = new ColorLookupTable();
+        table->m_interpolateColorFlag = (interpolateColorFlag
+                                         || (this->getNumberOfScalarsAndColors() == 2));//getPaletteColor() always interpolates two colors
+        table->m_rgba.resize(LOOKUP_TABLE_SIZE * 4);
+        for (int32_t i = 0; i < LOOKUP_TABLE_SIZE; i++) {
+            this->getPaletteColor(getLookupTableScalar(i), table->m_interpolateColorFlag, &table->m_rgba[i * 4]);
+        }
+        
+        /*
+         * Colors change at palette scalars (a sample equal to a palette
+         * scalar may not have the color of the values next to it), so
+         * cells containing or bounded by a palette scalar are not sampled.
+         */
+        table->m_breakPointCells.resize(LOOKUP_TABLE_SIZE - 1, 0);
+        const int32_t numScalarColors = this->getNumberOfScalarsAndColors();
+        for (int32_t i = 0; i < numScalarColors; i++) {
+            const float scalar = this->paletteScalars[i]->getScalar();
+            for (int32_t cell = 0; cell < LOOKUP_TABLE_SIZE - 1; cell++) {
+                if ((scalar >= getLookupTableScalar(cell))
+                    && (scalar <= getLookupTableScalar(cell + 1))) {
+                    table->m_breakPointCells[cell] = 1;
+                }
+            }
+        }
+        this->lookupTables[which].grabNew(table);
+        this->lookupTableKeys[which] = key;
+    }
+    return this->lookupTables[which];
+}
+
 /**
  * Set this object has been modified.
  *
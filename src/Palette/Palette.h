@@ -25,7 +25,9 @@
 #include <vector>
 
 #include "CaretAssert.h"
+#include "CaretMutex.h"
 #include "CaretObject.h"
+#include "CaretPointer.h"
 #include "TracksModificationInterface.h"
 
 
@@ -96,6 +98,89 @@ namespace caret {
                              const bool interpolateColorFlag,
                              float rgbaOut[4]) const;
         
+        /**
+         * Colors of a palette sampled at LOOKUP_TABLE_SIZE evenly spaced
+         * normalized scalars from -1 to 1.
+         */
+        class ColorLookupTable {
+        public:
+            /**RGBA of each sample */
+            std::vector<float> m_rgba;
+            
+            /**For each cell between adjacent samples, nonzero if a palette scalar (a color break point) is in the cell */
+            std::vector<uint8_t> m_breakPointCells;
+            
+            /**Colors are interpolated between palette scalars (always true for two colors, as in getPaletteColor()) */
+            bool m_interpolateColorFlag;
+        };
+        
+        CaretPointer<const ColorLookupTable> getPaletteColorLookupTable(const bool interpolateColorFlag) const;
+        
+        /**
+         * Get the normalized scalar of a lookup table sample.
+         *
+         * @param index - index of the sample.
+         * @return The scalar, exact since the spacing is a power of two.
+         */
+        static inline float getLookupTableScalar(const int32_t index) {
+            return -1.0f + index * (2.0f / (LOOKUP_TABLE_SIZE - 1));
+        }
+        
+        /**
+         * Get the color of a normalized scalar using a lookup table from
+         * this palette.  Within a cell that has no palette scalar, the color
+         * is the same as from getPaletteColor(): it is constant without
+         * interpolation and linear (so interpolating the samples is exact)
+         * with interpolation.  Scalars in a cell that contains a palette
+         * scalar, and NaN, are colored with getPaletteColor().
+         *
+         * @param table - lookup table from getPaletteColorLookupTable().
+         * @param normalizedScalar - scalar, values outside [-1, 1] get the color of -1 or 1.
+         * @param rgbaOut - output color.
+         */
+        inline void getLookupTableColor(const ColorLookupTable& table,
+                                        const float normalizedScalar,
+                                        float rgbaOut[4]) const {
+            const float* rgba = NULL;
+            if (normalizedScalar >= 1.0f) {
+                rgba = &table.m_rgba[(LOOKUP_TABLE_SIZE - 1) * 4];
+            }
+            else if (normalizedScalar <= -1.0f) {
+                rgba = &table.m_rgba[0];
+            }
+            else if (normalizedScalar > -1.0f) {//false for NaN
+                int32_t cell = static_cast<int32_t>((normalizedScalar + 1.0f) * (0.5f * (LOOKUP_TABLE_SIZE - 1)));
+                if (cell > LOOKUP_TABLE_SIZE - 2) cell = LOOKUP_TABLE_SIZE - 2;
+                if (normalizedScalar < getLookupTableScalar(cell)) {//roundoff in the sum
+                    --cell;
+                }
+                else if (normalizedScalar > getLookupTableScalar(cell + 1)) {
+                    ++cell;
+                }
+                if (table.m_breakPointCells[cell] == 0) {
+                    rgba = &table.m_rgba[cell * 4];
+                    if (table.m_interpolateColorFlag) {
+                        const float* rgbaAbove = rgba + 4;
+                        const float t = (normalizedScalar - getLookupTableScalar(cell)) * (0.5f * (LOOKUP_TABLE_SIZE - 1));
+                        rgbaOut[0] = rgba[0] + t * (rgbaAbove[0] - rgba[0]);
+                        rgbaOut[1] = rgba[1] + t * (rgbaAbove[1] - rgba[1]);
+                        rgbaOut[2] = rgba[2] + t * (rgbaAbove[2] - rgba[2]);
+                        rgbaOut[3] = rgba[3];//alpha is constant within a palette segment
+                        return;
+                    }
+                }
+            }
+            if (rgba != NULL) {
+                rgbaOut[0] = rgba[0];
+                rgbaOut[1] = rgba[1];
+                rgbaOut[2] = rgba[2];
+                rgbaOut[3] = rgba[3];
+            }
+            else {
+                getPaletteColor(normalizedScalar, table.m_interpolateColorFlag, rgbaOut);
+            }
+        }
+        
         void setModified();
         
         void clearModified();
@@ -115,7 +200,13 @@ namespace caret {
         /** "ROY-BIG-BL" palette */
         static const AString ROY_BIG_BL_PALETTE_NAME;
         
+        /** Samples in a color lookup table, odd so that -1, 0, and 1 are sampled exactly */
+        static const int32_t LOOKUP_TABLE_SIZE = 4097;
+        
     private:
+        void getPaletteColorLookupTableKey(std::vector<float>& keyOut) const;
+        
+
         /**has this object been modified. (DO NOT CLONE) */
         bool modifiedFlag;
         
@@ -125,6 +216,14 @@ namespace caret {
         /**The scalars in the palette. */
         std::vector<PaletteScalarAndColor*> paletteScalars;
         
+        /**Color lookup tables, without and with interpolation (DO NOT CLONE) */
+        mutable CaretPointer<const ColorLookupTable> lookupTables[2];
+        
+        /**Scalars and colors the lookup tables were built from, colors can be changed without going through the palette */
+        mutable std::vector<float> lookupTableKeys[2];
+        
+        mutable CaretMutex lookupTableMutex;
+        
     };
 
     
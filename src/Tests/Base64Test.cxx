@@ -0,0 +1,222 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "Base64Test.h"
+
+#include "Base64.h"
+#include "DataCompressZLib.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    string encodeText(const vector<unsigned char>& data)
+    {
+        vector<unsigned char> encoded(data.size() / 3 * 4 + 8);
+        uint64_t length = Base64::encode(data.data(), data.size(), encoded.data());
+        return string(encoded.begin(), encoded.begin() + length);
+    }
+    
+    //line breaks every 76 characters like MIME, plus occasional runs of whitespace anywhere, including between padding characters
+    string addWhitespace(const string& text, mt19937& myRand)
+    {
+        const char* runs[4] = { " ", "\t", "\n  ", "\r\n\t" };
+        string ret = " \n";
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            if (i > 0 && i % 76 == 0) ret += ((i / 76) % 2 == 0 ? "\r\n" : "\n");
+            if (myRand() % 23 == 0) ret += runs[myRand() % 4];
+            ret += text[i];
+        }
+        ret += "\n\t ";
+        return ret;
+    }
+    
+    vector<unsigned char> randomBytes(const int64_t& count, mt19937& myRand)
+    {
+        vector<unsigned char> ret(count);
+        for (int64_t i = 0; i < count; ++i)
+        {
+            ret[i] = (unsigned char)(myRand() % 256);
+        }
+        return ret;
+    }
+}
+
+Base64Test::Base64Test(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void Base64Test::execute()
+{
+    checkDecodeText();
+    checkUncompressBase64();
+}
+
+void Base64Test::checkDecodeText()
+{
+    mt19937 myRand(4321);
+    vector<int64_t> lengths;
+    for (int64_t i = 0; i < 40; ++i) lengths.push_back(i);//every amount of padding, and lengths on both sides of the 8 character fast path
+    lengths.push_back(1000);
+    lengths.push_back(100001);
+    for (size_t test = 0; test < lengths.size(); ++test)
+    {
+        const vector<unsigned char> data = randomBytes(lengths[test], myRand);
+        const string text = encodeText(data);
+        const AString caseName = AString::number(data.size()) + " bytes";
+        vector<unsigned char> decoded(data.size() + 1);
+        uint64_t decodedLength = Base64::decodeText(text.data(), text.size(), decoded.data(), data.size());
+        if (decodedLength != data.size() || !equal(data.begin(), data.end(), decoded.begin()))
+        {
+            setFailed("decodeText did not reproduce " + caseName);
+            return;
+        }
+        vector<unsigned char> tripletDecoded(data.size() + 3);
+        Base64::decode(reinterpret_cast<const unsigned char*>(text.data()), data.size(), tripletDecoded.data());
+        if (!equal(data.begin(), data.end(), tripletDecoded.begin()))
+        {
+            setFailed("decode and decodeText disagree for " + caseName);
+            return;
+        }
+        const string spacedText = addWhitespace(text, myRand);
+        decodedLength = Base64::decodeText(spacedText.data(), spacedText.size(), decoded.data(), data.size());
+        if (decodedLength != data.size() || !equal(data.begin(), data.end(), decoded.begin()))
+        {
+            setFailed("decodeText did not reproduce " + caseName + " from text containing whitespace and line breaks");
+            return;
+        }
+        if (data.size() > 0 && Base64::decodeText(text.data(), text.size(), decoded.data(), data.size() - 1) != 0)
+        {
+            setFailed("decodeText did not fail when " + caseName + " did not fit in the output");
+            return;
+        }
+    }
+    struct KnownCase
+    {
+        const char* text;
+        const char* expected;//NULL for text that must fail
+    };
+    const KnownCase knownCases[] = {
+        { "QUFB", "AAA" },
+        { "QUE=", "AA" },
+        { "QQ==", "A" },
+        { "QUFBQUFBQUE=", "AAAAAAAA" },
+        { "QUFBQUFBQQ==", "AAAAAAA" },
+        { "QUFB====", "AAA" },//end mark from encode's mark_end
+        { "QQ\n=\r\n=\n", "A" },//whitespace inside the padding
+        { "QU FB\tQU\nFB", "AAAAAA" },
+        { "", "" },
+        { " \n\t", "" },
+        { "QU!B", NULL },//invalid character
+        { "QUFBQU-BQUFB", NULL },
+        { "QQ==QUFB", NULL },//padding before the end
+        { "QQ==\nQUFB", NULL },
+        { "Q===", NULL },//too much padding
+        { "QQ=A", NULL }
+    };
+    const int numKnown = sizeof(knownCases) / sizeof(knownCases[0]);
+    for (int i = 0; i < numKnown; ++i)
+    {
+        unsigned char decoded[16];
+        const string text = knownCases[i].text;
+        const uint64_t decodedLength = Base64::decodeText(text.data(), text.size(), decoded, sizeof(decoded));
+        if (knownCases[i].expected == NULL)
+        {
+            if (decodedLength != 0)
+            {
+                setFailed("decodeText accepted invalid text '" + AString(knownCases[i].text) + "'");
+            }
+        } else {
+            const string expected = knownCases[i].expected;
+            if (decodedLength != expected.size() || string(decoded, decoded + decodedLength) != expected)
+            {
+                setFailed("decodeText of '" + AString(knownCases[i].text) + "' did not give '" + AString(knownCases[i].expected) + "'");
+            }
+        }
+    }
+}
+
+void Base64Test::checkUncompressBase64()
+{
+    mt19937 myRand(8765);
+    const int64_t numFloats = 200000;//enough compressed data for several decoding blocks
+    vector<float> floats(numFloats);
+    for (int64_t i = 0; i < numFloats; ++i)
+    {
+        floats[i] = (i % 1000) * 0.25f + (myRand() % 16);//somewhat compressible, like real data
+    }
+    const unsigned char* dataBytes = reinterpret_cast<const unsigned char*>(floats.data());
+    const uint64_t dataSize = numFloats * sizeof(float);
+    DataCompressZLib myCompressor;
+    vector<unsigned char> compressed(myCompressor.getMaximumCompressionSpace(dataSize));
+    const uint64_t compressedSize = myCompressor.compressData(dataBytes, dataSize, compressed.data(), compressed.size());
+    if (compressedSize == 0)
+    {
+        setFailed("zlib compression failed");
+        return;
+    }
+    compressed.resize(compressedSize);
+    const string text = encodeText(compressed);
+    if (text.size() < (1 << 18))
+    {
+        setFailed("test data did not compress to enough text for several blocks");
+        return;
+    }
+    vector<unsigned char> uncompressed(dataSize + 1);
+    if (myCompressor.uncompressBase64Data(text.data(), text.size(), uncompressed.data(), dataSize) != dataSize ||
+        !equal(dataBytes, dataBytes + dataSize, uncompressed.begin()))
+    {
+        setFailed("zlib round trip through Base64 text failed");
+        return;
+    }
+    const string spacedText = addWhitespace(text, myRand);
+    uncompressed.assign(dataSize + 1, 0);
+    if (myCompressor.uncompressBase64Data(spacedText.data(), spacedText.size(), uncompressed.data(), dataSize) != dataSize ||
+        !equal(dataBytes, dataBytes + dataSize, uncompressed.begin()))
+    {
+        setFailed("zlib round trip through Base64 text containing whitespace and line breaks failed");
+        return;
+    }
+    if (myCompressor.uncompressBase64Data(text.data(), text.size(), uncompressed.data(), dataSize - 1) != 0)
+    {
+        setFailed("zlib data larger than the expected size was accepted");
+    }
+    if (myCompressor.uncompressBase64Data(text.data(), text.size(), uncompressed.data(), dataSize + 1) != 0)
+    {
+        setFailed("zlib data smaller than the expected size was accepted");
+    }
+    const uint64_t truncatedLength = (text.size() / 2) / 4 * 4;
+    if (myCompressor.uncompressBase64Data(text.data(), truncatedLength, uncompressed.data(), dataSize) != 0)
+    {
+        setFailed("truncated zlib data was accepted");
+    }
+    string corruptText = text;
+    corruptText[corruptText.size() / 2] = '!';
+    if (myCompressor.uncompressBase64Data(corruptText.data(), corruptText.size(), uncompressed.data(), dataSize) != 0)
+    {
+        setFailed("Base64 text with an invalid character was accepted");
+    }
+}
@@ -0,0 +1,262 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "ConnectedComponentsTest.h"
+
+#include "AlgorithmMetricFindClusters.h"
+#include "AlgorithmMetricRemoveIslands.h"
+#include "AlgorithmSurfaceCreateSphere.h"
+#include "ConnectedComponentsHelper.h"
+#include "MetricFile.h"
+#include "SurfaceFile.h"
+#include "TopologyHelper.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    //breadth-first search from each unvisited marked element in index order, the way clusters and islands used to be found
+    void bfsComponents(const vector<vector<int64_t> >& neighbors, const vector<char>& marked, const vector<float>& sizes,
+                       vector<int64_t>& labelsOut, vector<int64_t>& countsOut, vector<double>& sizesOut)
+    {
+        int64_t numElements = (int64_t)marked.size();
+        labelsOut.assign(numElements, -1);
+        countsOut.clear();
+        sizesOut.clear();
+        vector<int64_t> queue;
+        for (int64_t start = 0; start < numElements; ++start)
+        {
+            if (!marked[start] || labelsOut[start] != -1) continue;
+            int64_t component = (int64_t)countsOut.size();
+            countsOut.push_back(0);
+            sizesOut.push_back(0.0);
+            queue.assign(1, start);
+            labelsOut[start] = component;
+            for (size_t i = 0; i < queue.size(); ++i)
+            {
+                ++countsOut[component];
+                sizesOut[component] += sizes[queue[i]];
+                const vector<int64_t>& myNeighbors = neighbors[queue[i]];
+                for (size_t n = 0; n < myNeighbors.size(); ++n)
+                {
+                    if (marked[myNeighbors[n]] && labelsOut[myNeighbors[n]] == -1)
+                    {
+                        labelsOut[myNeighbors[n]] = component;
+                        queue.push_back(myNeighbors[n]);
+                    }
+                }
+            }
+        }
+    }
+    
+    AString compareComponents(const vector<int64_t>& labels, const vector<ConnectedComponentsHelper::Component>& components,
+                              const vector<int64_t>& bfsLabels, const vector<int64_t>& bfsCounts, const vector<double>& bfsSizes)
+    {
+        if (components.size() != bfsCounts.size())
+        {
+            return "found " + AString::number(components.size()) + " components, breadth-first search found " + AString::number(bfsCounts.size());
+        }
+        for (size_t i = 0; i < labels.size(); ++i)
+        {
+            if (labels[i] != bfsLabels[i])
+            {
+                return "element " + AString::number(i) + " has label " + AString::number(labels[i]) + ", breadth-first search gave " + AString::number(bfsLabels[i]);
+            }
+        }
+        for (size_t i = 0; i < components.size(); ++i)
+        {
+            if (components[i].count != bfsCounts[i] || labels[components[i].firstElement] != (int64_t)i ||
+                abs(components[i].size - bfsSizes[i]) > bfsSizes[i] * 0.000001)//summation order differs
+            {
+                return "component " + AString::number(i) + " has the wrong first element, count or size";
+            }
+        }
+        return "";
+    }
+}
+
+ConnectedComponentsTest::ConnectedComponentsTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void ConnectedComponentsTest::execute()
+{
+    checkSurface();
+    checkVolume();
+}
+
+void ConnectedComponentsTest::checkSurface()
+{
+    SurfaceFile mySurf;
+    AlgorithmSurfaceCreateSphere(NULL, 40962, &mySurf);//large enough for several union-find blocks, so the merge pass gets used
+    const int numNodes = mySurf.getNumberOfNodes();
+    float radius = 0.0f;
+    for (int i = 0; i < numNodes; ++i)
+    {
+        radius = max(radius, abs(mySurf.getCoordinate(i)[2]));
+    }
+    mt19937 myRand(2468);
+    vector<char> marked(numNodes, 0);
+    for (int i = 0; i < numNodes; ++i)
+    {//one large cap, and many small islands below percolation density
+        float z = mySurf.getCoordinate(i)[2];
+        if (z > 0.5f * radius || (z < 0.3f * radius && myRand() % 100 < 40)) marked[i] = 1;
+    }
+    CaretPointer<TopologyHelper> myTopoHelp = mySurf.getTopologyHelper();
+    vector<vector<int64_t> > neighbors(numNodes);
+    for (int i = 0; i < numNodes; ++i)
+    {
+        const vector<int32_t>& myNeighbors = myTopoHelp->getNodeNeighbors(i);
+        neighbors[i].assign(myNeighbors.begin(), myNeighbors.end());
+    }
+    vector<float> areas, ones(numNodes, 1.0f);
+    mySurf.computeNodeAreas(areas);
+    vector<int64_t> bfsLabels, bfsCounts, labels;
+    vector<double> bfsSizes;
+    vector<ConnectedComponentsHelper::Component> components;
+    bfsComponents(neighbors, marked, areas, bfsLabels, bfsCounts, bfsSizes);
+    if (bfsCounts.size() < 10)
+    {
+        setFailed("test surface has too few components");
+        return;
+    }
+    ConnectedComponentsHelper::labelVertices(myTopoHelp, marked.data(), areas.data(), labels, components);
+    AString message = compareComponents(labels, components, bfsLabels, bfsCounts, bfsSizes);
+    if (message != "")
+    {
+        setFailed("vertices with areas: " + message);
+        return;
+    }
+    vector<double> bfsCountSizes(bfsCounts.begin(), bfsCounts.end());
+    ConnectedComponentsHelper::labelVertices(myTopoHelp, marked.data(), NULL, labels, components);
+    message = compareComponents(labels, components, bfsLabels, bfsCounts, bfsCountSizes);
+    if (message != "")
+    {
+        setFailed("vertices without areas: " + message);
+        return;
+    }
+    vector<int64_t> offsets, members;
+    ConnectedComponentsHelper::getComponentMembers(labels, components, offsets, members);
+    for (size_t c = 0; c < components.size(); ++c)
+    {
+        for (int64_t m = offsets[c]; m < offsets[c + 1]; ++m)
+        {
+            if (bfsLabels[members[m]] != (int64_t)c || (m > offsets[c] && members[m] <= members[m - 1]))
+            {
+                setFailed("component members of component " + AString::number(c) + " are wrong or out of order");
+                return;
+            }
+        }
+    }
+    //the algorithms, with unit vertex areas so sizes are exact counts
+    MetricFile dataMetric, areaMetric, clusterMetric, islandMetric;
+    dataMetric.setNumberOfNodesAndColumns(numNodes, 1);
+    dataMetric.setStructure(mySurf.getStructure());
+    areaMetric.setNumberOfNodesAndColumns(numNodes, 1);
+    areaMetric.setStructure(mySurf.getStructure());
+    areaMetric.setValuesForColumn(0, ones.data());
+    vector<float> data(numNodes);
+    for (int i = 0; i < numNodes; ++i)
+    {
+        data[i] = (marked[i] ? 2.0f : 0.0f);
+    }
+    dataMetric.setValuesForColumn(0, data.data());
+    const float MIN_AREA = 3.5f;
+    AlgorithmMetricFindClusters(NULL, &mySurf, &dataMetric, 1.0f, MIN_AREA, &clusterMetric, false, NULL, &areaMetric);
+    AlgorithmMetricRemoveIslands(NULL, &mySurf, &dataMetric, &islandMetric, &areaMetric);
+    vector<float> expectedClusters(bfsCounts.size(), 0.0f);
+    int nextCluster = 1;
+    int64_t largest = 0;
+    for (size_t c = 0; c < bfsCounts.size(); ++c)
+    {
+        if (bfsCounts[c] > MIN_AREA) expectedClusters[c] = nextCluster++;
+        if (bfsCounts[c] > bfsCounts[largest]) largest = c;
+    }
+    if (nextCluster < 3)
+    {
+        setFailed("test surface has too few clusters above the minimum area");
+        return;
+    }
+    const float* clusterData = clusterMetric.getValuePointerForColumn(0);
+    const float* islandData = islandMetric.getValuePointerForColumn(0);
+    for (int i = 0; i < numNodes; ++i)
+    {
+        float expectedCluster = (bfsLabels[i] == -1 ? 0.0f : expectedClusters[bfsLabels[i]]);
+        if (clusterData[i] != expectedCluster)
+        {
+            setFailed("metric find clusters gave vertex " + AString::number(i) + " value " + AString::number(clusterData[i]) +
+                      ", breadth-first search gave " + AString::number(expectedCluster));
+            return;
+        }
+        float expectedIsland = (bfsLabels[i] == largest ? 1.0f : 0.0f);
+        if (islandData[i] != expectedIsland)
+        {
+            setFailed("metric remove islands gave vertex " + AString::number(i) + " value " + AString::number(islandData[i]) +
+                      ", breadth-first search gave " + AString::number(expectedIsland));
+            return;
+        }
+    }
+}
+
+void ConnectedComponentsTest::checkVolume()
+{
+    const int64_t dims[3] = { 41, 37, 43 };//several union-find blocks, with block edges in the middle of rows and slices
+    const int64_t numVoxels = dims[0] * dims[1] * dims[2];
+    const float VOXEL_SIZE = 2.0f;
+    mt19937 myRand(1357);
+    vector<char> marked(numVoxels);
+    for (int64_t i = 0; i < numVoxels; ++i)
+    {
+        marked[i] = (myRand() % 100 < 30 ? 1 : 0);//below the percolation threshold for face neighbors, so many components
+    }
+    vector<vector<int64_t> > neighbors(numVoxels);
+    for (int64_t k = 0; k < dims[2]; ++k)
+    {
+        for (int64_t j = 0; j < dims[1]; ++j)
+        {
+            for (int64_t i = 0; i < dims[0]; ++i)
+            {
+                int64_t index = i + dims[0] * (j + dims[1] * k);
+                if (i > 0) neighbors[index].push_back(index - 1);
+                if (i < dims[0] - 1) neighbors[index].push_back(index + 1);
+                if (j > 0) neighbors[index].push_back(index - dims[0]);
+                if (j < dims[1] - 1) neighbors[index].push_back(index + dims[0]);
+                if (k > 0) neighbors[index].push_back(index - dims[0] * dims[1]);
+                if (k < dims[2] - 1) neighbors[index].push_back(index + dims[0] * dims[1]);
+            }
+        }
+    }
+    vector<float> sizes(numVoxels, VOXEL_SIZE);
+    vector<int64_t> bfsLabels, bfsCounts, labels;
+    vector<double> bfsSizes;
+    vector<ConnectedComponentsHelper::Component> components;
+    bfsComponents(neighbors, marked, sizes, bfsLabels, bfsCounts, bfsSizes);
+    ConnectedComponentsHelper::labelVoxels(dims, marked.data(), VOXEL_SIZE, labels, components);
+    AString message = compareComponents(labels, components, bfsLabels, bfsCounts, bfsSizes);
+    if (message != "")
+    {
+        setFailed("voxels: " + message);
+    }
+}
@@ -113,6 +113,22 @@ void DotTest::checkVal(const float& correct, const float& test, const AString& d
     if (!(abs(test - correct) < TOLER_ABS + TOLER_RATIO * abs(correct))) setFailed(descrip + " got " + AString::number(test) + ", expected " + AString::number(correct));
 }//use "not less than" in order to catch NaNs
 
+void DotTest::checkBlock(const vector<const float*>& vecs, const int& length, const AString& descrip)
+{//compare the register-blocked kernel against the single dot product of the same implementation
+    CaretAssert(vecs.size() >= 6);
+    const float* a[2] = { vecs[0], vecs[1] };
+    const float* b[4] = { vecs[2], vecs[3], vecs[4], vecs[5] };
+    double res[8];
+    sddot2x4(a, b, length, res);
+    for (int i = 0; i < 2; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            checkVal(sddot(a[i], b[j], length), res[4 * i + j], descrip + " block element " + AString::number(i) + ", " + AString::number(j));
+        }
+    }
+}
+
 void DotTest::execute()
 {
     dot_flags impl_in_use = dot_set_impl(DOT_NAIVE);
@@ -130,6 +146,15 @@ void DotTest::execute()
     const float midsnr_naive = correlate(midsnrA, midsnrB);
     const float highsnr_naive = correlate(highsnrA, highsnrB);
     const float cross_snr_naive = correlate(lowsnrA, highsnrB);
+    vector<const float*> blockVecs;//offset some of them to test unaligned access, and use an odd length to test the remainder loop
+    blockVecs.push_back(rand1.data());
+    blockVecs.push_back(lowsnrA.data() + 1);
+    blockVecs.push_back(midsnrA.data() + 3);
+    blockVecs.push_back(highsnrB.data());
+    blockVecs.push_back(rand2.data() + 2);
+    blockVecs.push_back(rand3.data() + 1);
+    const int blockLength = ROWSIZE - 5;
+    checkBlock(blockVecs, blockLength, "naive");
     //sse2
     impl_in_use = dot_set_impl(DOT_SSE2);
     if (impl_in_use == DOT_SSE2)
@@ -140,6 +165,7 @@ void DotTest::execute()
         checkVal(midsnr_naive, correlate(midsnrA, midsnrB), "sse2 mid snr correlation");
         checkVal(highsnr_naive, correlate(highsnrA, highsnrB), "sse2 high snr correlation");
         checkVal(cross_snr_naive, correlate(lowsnrA, highsnrB), "sse2 cross snr correlation");
+        checkBlock(blockVecs, blockLength, "sse2");
     } else {
         cout << "skipping SSE2, not supported" << endl;
     }
@@ -153,6 +179,7 @@ void DotTest::execute()
         checkVal(midsnr_naive, correlate(midsnrA, midsnrB), "avx mid snr correlation");
         checkVal(highsnr_naive, correlate(highsnrA, highsnrB), "avx high snr correlation");
         checkVal(cross_snr_naive, correlate(lowsnrA, highsnrB), "avx cross snr correlation");
+        checkBlock(blockVecs, blockLength, "avx");
     } else {
         cout << "skipping AVX, not supported" << endl;
     }
@@ -166,6 +193,7 @@ void DotTest::execute()
         checkVal(midsnr_naive, correlate(midsnrA, midsnrB), "avxfma mid snr correlation");
         checkVal(highsnr_naive, correlate(highsnrA, highsnrB), "avxfma high snr correlation");
         checkVal(cross_snr_naive, correlate(lowsnrA, highsnrB), "avxfma cross snr correlation");
+        checkBlock(blockVecs, blockLength, "avxfma");
     } else {
         cout << "skipping AVXFMA, not supported" << endl;
     }
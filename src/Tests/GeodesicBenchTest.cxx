@@ -0,0 +1,82 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "GeodesicBenchTest.h"
+
+#include "AlgorithmSurfaceCreateSphere.h"
+#include "ElapsedTimer.h"
+#include "GeodesicHelper.h"
+#include "SurfaceFile.h"
+
+#include <iostream>
+#include <random>
+
+using namespace caret;
+using namespace std;
+
+GeodesicBenchTest::GeodesicBenchTest(const AString& identifier): TestInterface(identifier)
+{
+}
+
+//benchmark only, not run by ctest (geodesicqueue checks the results), run it with "test_driver geodesicbench"
+void GeodesicBenchTest::execute()
+{
+    SurfaceFile mySurf;
+    AlgorithmSurfaceCreateSphere(NULL, 163842, &mySurf);//the usual 164k mesh
+    int32_t numNodes = mySurf.getNumberOfNodes();
+    CaretPointer<GeodesicHelperBase> myBase(new GeodesicHelperBase(&mySurf));
+    CaretPointer<GeodesicHelper> heapHelp(new GeodesicHelper(myBase)), bucketHelp(new GeodesicHelper(myBase));
+    heapHelp->setUseBucketQueue(false);
+    if (!bucketHelp->isUsingBucketQueue())
+    {
+        setFailed("bucket queue was not enabled on a regular mesh");
+        return;
+    }
+    const int NUM_ROOTS = 2000;
+    const float MAX_GEO_DIST = 10.0f;//similar to the smoothing weight search for a 3mm sigma
+    mt19937 myRand(12345);//same roots every run, so timings are comparable
+    uniform_int_distribution<int32_t> nodeDist(0, numNodes - 1);
+    vector<int32_t> roots(NUM_ROOTS);
+    for (int i = 0; i < NUM_ROOTS; ++i)
+    {
+        roots[i] = nodeDist(myRand);
+    }
+    vector<int32_t> heapNodes, bucketNodes;
+    vector<float> heapDists, bucketDists;
+    ElapsedTimer myTimer;
+    int64_t heapCount = 0, bucketCount = 0;
+    myTimer.start();
+    for (int i = 0; i < NUM_ROOTS; ++i)
+    {
+        heapHelp->getNodesToGeoDist(roots[i], MAX_GEO_DIST, heapNodes, heapDists);
+        heapCount += heapNodes.size();
+    }
+    double heapTime = myTimer.getElapsedTimeSeconds();
+    myTimer.start();
+    for (int i = 0; i < NUM_ROOTS; ++i)
+    {
+        bucketHelp->getNodesToGeoDist(roots[i], MAX_GEO_DIST, bucketNodes, bucketDists);
+        bucketCount += bucketNodes.size();
+    }
+    double bucketTime = myTimer.getElapsedTimeSeconds();
+    if (heapCount != bucketCount) setFailed("heap and bucket queue searches visited different numbers of nodes");
+    cout << NUM_ROOTS << " searches to " << MAX_GEO_DIST << "mm on " << numNodes << " vertices, " << heapCount / NUM_ROOTS << " vertices each" << endl;
+    cout << "heap: " << heapTime << "s, bucket queue: " << bucketTime << "s" << endl;
+}
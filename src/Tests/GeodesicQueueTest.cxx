@@ -0,0 +1,89 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "GeodesicQueueTest.h"
+
+#include "AlgorithmSurfaceCreateSphere.h"
+#include "GeodesicHelper.h"
+#include "SurfaceFile.h"
+
+#include <random>
+
+using namespace caret;
+using namespace std;
+
+GeodesicQueueTest::GeodesicQueueTest(const AString& identifier): TestInterface(identifier)
+{
+}
+
+void GeodesicQueueTest::execute()
+{
+    SurfaceFile mySurf;
+    AlgorithmSurfaceCreateSphere(NULL, 10242, &mySurf);
+    int32_t numNodes = mySurf.getNumberOfNodes();
+    CaretPointer<GeodesicHelperBase> myBase(new GeodesicHelperBase(&mySurf));
+    CaretPointer<GeodesicHelper> heapHelp(new GeodesicHelper(myBase)), bucketHelp(new GeodesicHelper(myBase));
+    heapHelp->setUseBucketQueue(false);
+    if (!bucketHelp->isUsingBucketQueue())
+    {
+        setFailed("bucket queue was not enabled on a regular mesh");
+        return;
+    }
+    const int NUM_ROOTS = 50;
+    const float MAX_GEO_DIST = 20.0f;//several rings on a 10k vertex sphere of radius 100
+    mt19937 myRand(12345);//fixed seed, so failures are reproducible
+    uniform_int_distribution<int32_t> nodeDist(0, numNodes - 1);
+    vector<int32_t> heapNodes, bucketNodes, heapParents, bucketParents, parentByNode(numNodes, -2);
+    vector<float> heapDists, bucketDists, distByNode(numNodes, -1.0f);
+    for (int i = 0; !failed() && i < NUM_ROOTS; ++i)//same distances and parents, but nodes within a bucket may come out in a different order
+    {
+        int32_t root = nodeDist(myRand);
+        heapHelp->getNodesToGeoDist(root, MAX_GEO_DIST, heapNodes, heapDists, heapParents);
+        bucketHelp->getNodesToGeoDist(root, MAX_GEO_DIST, bucketNodes, bucketDists, bucketParents);
+        if (heapNodes.size() != bucketNodes.size())
+        {
+            setFailed("bucket queue found " + AString::number(bucketNodes.size()) + " nodes, heap found " + AString::number(heapNodes.size()));
+            break;
+        }
+        for (size_t j = 0; j < heapNodes.size(); ++j)
+        {
+            distByNode[heapNodes[j]] = heapDists[j];
+            parentByNode[heapNodes[j]] = heapParents[j];
+        }
+        for (size_t j = 0; j < bucketNodes.size(); ++j)
+        {
+            if (distByNode[bucketNodes[j]] != bucketDists[j])
+            {
+                setFailed("bucket queue distance differs at node " + AString::number(bucketNodes[j]) + " from root " + AString::number(root));
+                break;
+            }
+            if (parentByNode[bucketNodes[j]] != bucketParents[j])
+            {
+                setFailed("bucket queue parent differs at node " + AString::number(bucketNodes[j]) + " from root " + AString::number(root));
+                break;
+            }
+        }
+        for (size_t j = 0; j < heapNodes.size(); ++j)
+        {
+            distByNode[heapNodes[j]] = -1.0f;
+            parentByNode[heapNodes[j]] = -2;
+        }
+    }
+}
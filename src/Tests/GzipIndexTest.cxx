@@ -0,0 +1,150 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "GzipIndexTest.h"
+
+#include "CaretBinaryFile.h"
+
+#include <QTemporaryDir>
+#include "zlib.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int64_t TEST_SIZE = 24000013;//several checkpoint spans, and an odd length
+    
+    char expectedByte(const int64_t& i)
+    {//compressible, but not trivially so
+        return (char)((i / 7) ^ (i % 251));
+    }
+}
+
+GzipIndexTest::GzipIndexTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void GzipIndexTest::execute()
+{
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid())
+    {
+        setFailed("unable to create temporary directory");
+        return;
+    }
+    vector<char> buffer(1000000);
+    AString streamName = tempDir.path() + "/wb_gzip_index_stream.gz";
+    {//one deflate stream, so seeks inside it need the windowed checkpoints
+        gzFile zfile = gzopen(streamName.toLocal8Bit().constData(), "wb");
+        if (zfile == NULL)
+        {
+            setFailed("unable to open '" + streamName + "' for writing");
+            return;
+        }
+        for (int64_t start = 0; start < TEST_SIZE; start += buffer.size())
+        {
+            int64_t count = min((int64_t)buffer.size(), TEST_SIZE - start);
+            for (int64_t i = 0; i < count; ++i)
+            {
+                buffer[i] = expectedByte(start + i);
+            }
+            if (gzwrite(zfile, buffer.data(), count) != count)
+            {
+                setFailed("error writing '" + streamName + "'");
+                gzclose(zfile);
+                return;
+            }
+        }
+        gzclose(zfile);
+    }
+    checkReads(streamName, "single stream");
+    AString blockName = tempDir.path() + "/wb_gzip_index_blocks.gz";
+    {//written as independently compressed blocks, so reading also crosses gzip member boundaries
+        CaretBinaryFile writer(blockName, CaretBinaryFile::WRITE_TRUNCATE);
+        for (int64_t start = 0; start < TEST_SIZE; start += buffer.size())
+        {
+            int64_t count = min((int64_t)buffer.size(), TEST_SIZE - start);
+            for (int64_t i = 0; i < count; ++i)
+            {
+                buffer[i] = expectedByte(start + i);
+            }
+            writer.write(buffer.data(), count);
+        }
+    }
+    checkReads(blockName, "multiple members");
+}
+
+void GzipIndexTest::checkReads(const AString& fileName, const AString& description)
+{
+    vector<char> buffer(1000000);
+    CaretBinaryFile reader(fileName);
+    if (!reader.canReadAt())
+    {
+        setFailed(description + ": gzip file doesn't support positional reads");
+    }
+    for (int64_t start = TEST_SIZE - 100000; start > 0; start -= 2345678)
+    {//backwards seeks
+        reader.seek(start);
+        reader.read(buffer.data(), 100000);
+        for (int64_t i = 0; i < 100000; ++i)
+        {
+            if (buffer[i] != expectedByte(start + i))
+            {
+                setFailed(description + ": wrong data after seek to " + AString::number(start));
+                break;
+            }
+        }
+    }
+    for (int test = 0; test < 20; ++test)
+    {
+        int64_t start = ((int64_t)rand() * 1000 + rand() % 1000) % (TEST_SIZE - buffer.size());
+        reader.readAt(start, buffer.data(), buffer.size());
+        for (int64_t i = 0; i < (int64_t)buffer.size(); ++i)
+        {
+            if (buffer[i] != expectedByte(start + i))
+            {
+                setFailed(description + ": wrong data from positional read at " + AString::number(start));
+                break;
+            }
+        }
+    }
+    vector<char> whole(TEST_SIZE);
+    reader.readAt(0, whole.data(), TEST_SIZE);//spans multiple checkpoints, decompressed in parallel
+    for (int64_t i = 0; i < TEST_SIZE; ++i)
+    {
+        if (whole[i] != expectedByte(i))
+        {
+            setFailed(description + ": wrong data from full read at " + AString::number(i));
+            break;
+        }
+    }
+    int64_t numRead = 0;
+    reader.readAt(TEST_SIZE - 10, buffer.data(), 100, &numRead);
+    if (numRead != 10)
+    {
+        setFailed(description + ": read past end returned " + AString::number(numRead) + " bytes, expected 10");
+    }
+    reader.close();
+}
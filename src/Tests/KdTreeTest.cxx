@@ -0,0 +1,80 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+#include "KdTreeTest.h"
+
+#include "CaretKdTree.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+KdTreeTest::KdTreeTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void KdTreeTest::execute()
+{//compare against brute force, with duplicate points to exercise ties
+    const int NUM_POINTS = 5000;
+    const int NUM_QUERIES = 500;
+    const float RANGE = 5.0f;
+    vector<float> coords(NUM_POINTS * 3);
+    for (int i = 0; i < NUM_POINTS * 3; ++i)
+    {
+        coords[i] = (rand() % 10000) / 100.0f;
+    }
+    for (int i = 1; i < 20; ++i)
+    {
+        for (int j = 0; j < 3; ++j) coords[i * 30 + j] = coords[j];
+    }
+    CaretKdTree myTree(coords.data(), NUM_POINTS);
+    vector<float> targets(NUM_QUERIES * 3);
+    for (int i = 0; i < NUM_QUERIES * 3; ++i)
+    {
+        targets[i] = (rand() % 12000) / 100.0f - 10.0f;
+    }
+    vector<int64_t> batchClosest(NUM_QUERIES);
+    myTree.closestPoints(targets.data(), NUM_QUERIES, batchClosest.data());
+    vector<int64_t> inRange;
+    for (int q = 0; q < NUM_QUERIES && !failed(); ++q)
+    {
+        const float* target = targets.data() + q * 3;
+        float bestDist2 = -1.0f;
+        vector<int64_t> checkRange;
+        for (int i = 0; i < NUM_POINTS; ++i)
+        {
+            float dx = coords[i * 3] - target[0], dy = coords[i * 3 + 1] - target[1], dz = coords[i * 3 + 2] - target[2];
+            float dist2 = dx * dx + dy * dy + dz * dz;
+            if (bestDist2 < 0.0f || dist2 < bestDist2) bestDist2 = dist2;
+            if (dist2 <= RANGE * RANGE) checkRange.push_back(i);
+        }
+        int64_t closest = myTree.closestPoint(target);
+        float dx = coords[closest * 3] - target[0], dy = coords[closest * 3 + 1] - target[1], dz = coords[closest * 3 + 2] - target[2];
+        if (dx * dx + dy * dy + dz * dz != bestDist2) setFailed("closestPoint did not find the closest point for query " + AString::number(q));
+        if (batchClosest[q] != closest) setFailed("closestPoints disagrees with closestPoint for query " + AString::number(q));
+        int64_t limited = myTree.closestPointLimited(target, RANGE);
+        if ((limited != -1) != (bestDist2 <= RANGE * RANGE)) setFailed("closestPointLimited wrong about whether a point is in range for query " + AString::number(q));
+        myTree.pointsInRange(target, RANGE, inRange);
+        sort(inRange.begin(), inRange.end());
+        if (inRange != checkRange) setFailed("pointsInRange returned the wrong points for query " + AString::number(q));
+    }
+}
@@ -55,4 +55,46 @@ void MathExpressionTest::execute()
     {
         setFailed("output value incorrect, expected " + AString::number(correctresult) + ", got " + AString::number(testresult));
     }
+    //the compiled evaluator must agree exactly with the tree, including folded constants, shared subexpressions, and broadcast variables
+    CaretMathExpression compiledExpr("x * x + (x * x) / 2 - mod(x, y) + (x >= y) * 3 ^ 2 + !(x == y || y < 0) + clamp(y, -1, 1) + round(x)");
+    const int64_t COUNT = 1000;
+    vector<float> xVals(COUNT), yVals(COUNT), compiledOut(COUNT), broadcastOut(COUNT);
+    for (int64_t i = 0; i < COUNT; ++i)
+    {
+        xVals[i] = (i % 37) * 0.5f - 9.0f;
+        yVals[i] = ((i * 7) % 23) * 0.25f - 3.0f;
+        if (i % 5 == 0) yVals[i] = xVals[i];//exercise the equality fudge factor
+    }
+    vector<AString> compiledNames = compiledExpr.getVarNames();
+    if (compiledNames.size() != 2)
+    {
+        setFailed("incorrect number of variables found in second expression");
+        return;
+    }
+    int xIndex = (compiledNames[0] == "x" ? 0 : 1);
+    vector<const float*> arrays(2);
+    arrays[xIndex] = xVals.data();
+    arrays[1 - xIndex] = yVals.data();
+    compiledExpr.evaluateMany(arrays, compiledOut.data(), COUNT);
+    vector<int64_t> strides(2, 1);
+    strides[1 - xIndex] = 0;//y is the same value for every element
+    compiledExpr.evaluateMany(arrays, broadcastOut.data(), COUNT, &strides);
+    for (int64_t i = 0; i < COUNT; ++i)
+    {
+        vars[xIndex] = xVals[i];
+        vars[1 - xIndex] = yVals[i];
+        float treeResult = (float)compiledExpr.evaluate(vars);
+        if (treeResult != compiledOut[i])
+        {
+            setFailed("compiled evaluation differs at element " + AString::number(i) + ", expected " + AString::number(treeResult) + ", got " + AString::number(compiledOut[i]));
+            return;
+        }
+        vars[1 - xIndex] = yVals[0];
+        treeResult = (float)compiledExpr.evaluate(vars);
+        if (treeResult != broadcastOut[i])
+        {
+            setFailed("compiled evaluation with stride 0 differs at element " + AString::number(i));
+            return;
+        }
+    }
 }
@@ -0,0 +1,130 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+
+#include "MetricSmoothingTest.h"
+
+#include "AlgorithmSurfaceCreateSphere.h"
+#include "MetricFile.h"
+#include "MetricSmoothingObject.h"
+#include "SurfaceFile.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    //the block path does the same arithmetic in the same order as the per-column path, so the results must be identical
+    AString compareColumns(const MetricFile& blockOut, const MetricFile& columnOut)
+    {
+        for (int c = 0; c < columnOut.getNumberOfColumns(); ++c)
+        {
+            const float* blockData = blockOut.getValuePointerForColumn(c), *columnData = columnOut.getValuePointerForColumn(c);
+            for (int i = 0; i < columnOut.getNumberOfNodes(); ++i)
+            {
+                if (blockData[i] != columnData[i])
+                {
+                    return "column " + AString::number(c) + " vertex " + AString::number(i) + " is " + AString::number(blockData[i], 'g', 9) +
+                           " from block smoothing, " + AString::number(columnData[i], 'g', 9) + " from smoothing one column";
+                }
+            }
+        }
+        return "";
+    }
+}
+
+MetricSmoothingTest::MetricSmoothingTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void MetricSmoothingTest::execute()
+{
+    SurfaceFile mySurf;
+    AlgorithmSurfaceCreateSphere(NULL, 2562, &mySurf);//radius 100, about 7.5mm between vertices
+    const int numNodes = mySurf.getNumberOfNodes();
+    const int NUM_COLUMNS = 37;//more than two blocks, with a partial block at the end
+    const int FIRST_COLUMN = 2, FIRST_OUT_COLUMN = 1, NUM_SMOOTHED = 33;//start the range partway into the input and output
+    const float KERNEL = 8.0f;
+    mt19937 myRand(24680);//fixed seed, so failures are reproducible
+    normal_distribution<float> noiseDist;
+    uniform_real_distribution<float> unitDist;
+    MetricFile myMetric, myRoi;
+    myMetric.setNumberOfNodesAndColumns(numNodes, NUM_COLUMNS);
+    myMetric.setStructure(mySurf.getStructure());
+    vector<float> column(numNodes);
+    for (int c = 0; c < NUM_COLUMNS; ++c)
+    {
+        for (int i = 0; i < numNodes; ++i)
+        {
+            column[i] = (unitDist(myRand) < 0.2f ? 0.0f : noiseDist(myRand));//some zeros for -fix-zeros
+        }
+        myMetric.setValuesForColumn(c, column.data());
+    }
+    myRoi.setNumberOfNodesAndColumns(numNodes, 1);
+    myRoi.setStructure(mySurf.getStructure());
+    for (int i = 0; i < numNodes; ++i)
+    {//a large hole, and scattered vertices
+        column[i] = ((mySurf.getCoordinate(i)[2] > 50.0f || unitDist(myRand) < 0.1f) ? 0.0f : 1.0f);
+    }
+    myRoi.setValuesForColumn(0, column.data());
+    MetricSmoothingObject mySmooth(&mySurf, KERNEL), myRoiSmooth(&mySurf, KERNEL, &myRoi);
+    for (int test = 0; test < 6 && !failed(); ++test)
+    {
+        const bool fixZeros = (test % 2 == 1);
+        const MetricSmoothingObject* useSmooth = (test < 4 ? &mySmooth : &myRoiSmooth);
+        const MetricFile* useRoi = ((test / 2) == 1 ? &myRoi : NULL);
+        AString testName = AString(test < 4 ? "" : "roi in constructor, ") + (useRoi != NULL ? "roi" : "no roi") + (fixZeros ? ", fix zeros: " : ": ");
+        MetricFile blockOut, columnOut;
+        blockOut.setNumberOfNodesAndColumns(numNodes, FIRST_OUT_COLUMN + NUM_SMOOTHED);
+        columnOut.setNumberOfNodesAndColumns(numNodes, FIRST_OUT_COLUMN + NUM_SMOOTHED);
+        for (int c = 0; c < FIRST_OUT_COLUMN; ++c)
+        {
+            blockOut.initializeColumn(c);
+            columnOut.initializeColumn(c);
+        }
+        useSmooth->smoothColumns(&myMetric, FIRST_COLUMN, NUM_SMOOTHED, &blockOut, FIRST_OUT_COLUMN, useRoi, 0, fixZeros);
+        for (int c = 0; c < NUM_SMOOTHED; ++c)
+        {
+            useSmooth->smoothColumn(&myMetric, FIRST_COLUMN + c, &columnOut, FIRST_OUT_COLUMN + c, useRoi, 0, fixZeros);
+        }
+        AString message = compareColumns(blockOut, columnOut);
+        if (message != "")
+        {
+            setFailed(testName + "column range: " + message);
+            break;
+        }
+        MetricFile metricOut, allColumnsOut;//smoothMetric uses the block path for a single roi column
+        useSmooth->smoothMetric(&myMetric, &metricOut, useRoi, fixZeros);
+        allColumnsOut.setNumberOfNodesAndColumns(numNodes, NUM_COLUMNS);
+        for (int c = 0; c < NUM_COLUMNS; ++c)
+        {
+            useSmooth->smoothColumn(&myMetric, c, &allColumnsOut, c, useRoi, 0, fixZeros);
+        }
+        message = compareColumns(metricOut, allColumnsOut);
+        if (message != "")
+        {
+            setFailed(testName + "whole metric: " + message);
+        }
+    }
+}
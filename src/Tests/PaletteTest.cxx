@@ -0,0 +1,99 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "PaletteTest.h"
+
+#include "Palette.h"
+#include "PaletteFile.h"
+#include "PaletteScalarAndColor.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+PaletteTest::PaletteTest(const AString& identifier): TestInterface(identifier)
+{
+}
+
+void PaletteTest::execute()
+{
+    PaletteFile myPaletteFile;//has the default palettes
+    const int NUM_SWEEP = 200000;
+    const float SWEEP_MIN = -1.05f, SWEEP_MAX = 1.05f;//also check clamping outside [-1, 1]
+    const float INTERP_TOLERANCE = 1e-5f;//interpolating the samples only differs by roundoff
+    int numPalettes = myPaletteFile.getNumberOfPalettes();
+    if (numPalettes == 0)
+    {
+        setFailed("palette file has no default palettes");
+        return;
+    }
+    for (int p = 0; !failed() && p < numPalettes; ++p)
+    {
+        const Palette* myPalette = myPaletteFile.getPalette(p);
+        vector<float> scalars;
+        for (int i = 0; i <= NUM_SWEEP; ++i)
+        {
+            scalars.push_back(SWEEP_MIN + (SWEEP_MAX - SWEEP_MIN) * i / NUM_SWEEP);
+        }
+        for (int i = 0; i < myPalette->getNumberOfScalarsAndColors(); ++i)//values at and next to the color breaks, where a coarse table goes wrong
+        {
+            float breakScalar = myPalette->getScalarAndColor(i)->getScalar();
+            scalars.push_back(breakScalar);
+            scalars.push_back(nextafterf(breakScalar, 2.0f));
+            scalars.push_back(nextafterf(breakScalar, -2.0f));
+        }
+        for (int i = 0; i < Palette::LOOKUP_TABLE_SIZE; ++i)//and at the table samples
+        {
+            scalars.push_back(Palette::getLookupTableScalar(i));
+        }
+        scalars.push_back(numeric_limits<float>::quiet_NaN());
+        for (int interp = 0; !failed() && interp < 2; ++interp)
+        {
+            const bool interpolateFlag = (interp == 1);
+            CaretPointer<const Palette::ColorLookupTable> myTable = myPalette->getPaletteColorLookupTable(interpolateFlag);
+            for (size_t i = 0; i < scalars.size(); ++i)
+            {
+                float expected[4], lookup[4];
+                myPalette->getPaletteColor(scalars[i], interpolateFlag, expected);
+                myPalette->getLookupTableColor(*myTable, scalars[i], lookup);
+                bool matches = true;
+                for (int c = 0; c < 4; ++c)
+                {
+                    if (interpolateFlag)
+                    {
+                        if (abs(expected[c] - lookup[c]) > INTERP_TOLERANCE) matches = false;
+                    } else {
+                        if (expected[c] != lookup[c]) matches = false;
+                    }
+                }
+                if (!matches)
+                {
+                    setFailed("palette " + myPalette->getName() + (interpolateFlag ? " (interpolated)" : "") + " lookup color (" +
+                              AString::fromNumbers(lookup, 4, ", ") + ") differs from palette color (" +
+                              AString::fromNumbers(expected, 4, ", ") + ") for scalar " + AString::number(scalars[i], 'g', 9));
+                    break;
+                }
+            }
+        }
+    }
+}
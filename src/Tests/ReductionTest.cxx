@@ -0,0 +1,174 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "ReductionTest.h"
+
+#include "CaretException.h"
+#include "ReductionOperation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    //how percentiles were computed before percentileInPlace, by sorting a copy
+    float sortedPercentile(vector<float> data, const float& percent)
+    {
+        sort(data.begin(), data.end());
+        const float index = percent / 100.0f * (data.size() - 1);
+        if (index <= 0) return data[0];
+        if (index >= data.size() - 1) return data.back();
+        float ipart, fpart;
+        fpart = modf(index, &ipart);
+        return (1.0f - fpart) * data[(int)ipart] + fpart * data[((int)ipart) + 1];
+    }
+    
+    bool closeEnough(const float& value, const float& reference, const float& relTolerance)
+    {
+        if (value == reference) return true;//also handles matching infinities
+        return abs(value - reference) <= relTolerance * max(1.0f, abs(reference));
+    }
+}
+
+ReductionTest::ReductionTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void ReductionTest::execute()
+{
+    checkAccumulator();
+    checkPercentile();
+}
+
+void ReductionTest::checkAccumulator()
+{//the single pass accumulator must give the same answers as reducing the whole array
+    mt19937 myRand(2468);//fixed seed, so failures are reproducible
+    normal_distribution<float> centeredDist(0.0f, 1.0f), offsetDist(10.0f, 3.0f);
+    uniform_real_distribution<float> nearOneDist(0.5f, 1.5f);
+    vector<vector<float> > dataSets(4);
+    for (int i = 0; i < 1001; ++i)
+    {
+        dataSets[0].push_back(floor(centeredDist(myRand) * 4.0f + 0.5f) / 4.0f);//ties and zeros for the index and count reductions
+        dataSets[1].push_back(offsetDist(myRand));
+    }
+    for (int i = 0; i < 60; ++i)
+    {
+        dataSets[2].push_back(nearOneDist(myRand));//so PRODUCT stays in range
+    }
+    dataSets[3].push_back(-2.5f);
+    vector<ReductionEnum::Enum> allOps;
+    ReductionEnum::getAllEnums(allOps);
+    for (size_t whichOp = 0; whichOp < allOps.size(); ++whichOp)
+    {
+        ReductionEnum::Enum myop = allOps[whichOp];
+        if (!ReductionAccumulator::isSupported(myop))
+        {
+            if (myop != ReductionEnum::INVALID && myop != ReductionEnum::MEDIAN && myop != ReductionEnum::MODE)
+            {
+                setFailed("accumulator doesn't support " + ReductionEnum::toName(myop));
+            }
+            continue;
+        }
+        for (size_t whichSet = 0; whichSet < dataSets.size(); ++whichSet)
+        {
+            const vector<float>& data = dataSets[whichSet];
+            ReductionAccumulator myAccum(myop);
+            for (size_t i = 0; i < data.size(); ++i)
+            {
+                myAccum.addValue(data[i]);
+            }
+            bool referenceThrew = false, accumThrew = false;
+            float reference = 0.0f, result = 0.0f;
+            try
+            {
+                reference = ReductionOperation::reduce(data.data(), data.size(), myop);
+            } catch (CaretException&) {
+                referenceThrew = true;
+            }
+            try
+            {
+                result = myAccum.getResult();
+            } catch (CaretException&) {
+                accumThrew = true;
+            }
+            AString which = ReductionEnum::toName(myop) + " on data set " + AString::number(whichSet + 1);
+            if (referenceThrew != accumThrew)
+            {
+                setFailed(which + (accumThrew ? ": only the accumulator threw" : ": only reduce() threw"));
+                continue;
+            }
+            if (referenceThrew) continue;
+            if (!closeEnough(result, reference, 1e-4f))
+            {
+                setFailed(which + ": accumulator gave " + AString::number(result) + ", reduce() gave " + AString::number(reference));
+            }
+        }
+        ReductionAccumulator emptyAccum(myop);
+        try
+        {
+            emptyAccum.getResult();
+            setFailed(ReductionEnum::toName(myop) + ": accumulator with no data didn't throw");
+        } catch (CaretException&) {
+        }
+    }
+}
+
+void ReductionTest::checkPercentile()
+{//nth_element based percentiles and median must match sorting
+    mt19937 myRand(1357);
+    normal_distribution<float> valueDist(0.0f, 5.0f);
+    uniform_int_distribution<int> sizeDist(1, 300);
+    const float percents[] = { 0.0f, 0.1f, 1.0f, 10.0f, 25.0f, 33.3f, 50.0f, 66.7f, 75.0f, 90.0f, 99.9f, 100.0f };
+    const int NUM_PERCENTS = sizeof(percents) / sizeof(percents[0]);
+    for (int trial = 0; trial < 200 && !failed(); ++trial)
+    {
+        int numElems = sizeDist(myRand);
+        vector<float> data(numElems);
+        for (int i = 0; i < numElems; ++i)
+        {
+            data[i] = valueDist(myRand);
+            if (trial % 2 == 0) data[i] = floor(data[i]);//lots of ties
+        }
+        for (int p = 0; p < NUM_PERCENTS; ++p)
+        {
+            vector<float> scratch = data;
+            float result = ReductionOperation::percentileInPlace(scratch.data(), numElems, percents[p]);
+            float reference = sortedPercentile(data, percents[p]);
+            if (!closeEnough(result, reference, 1e-5f))
+            {
+                setFailed("percentile " + AString::number(percents[p]) + " of " + AString::number(numElems) + " values: got " + AString::number(result) +
+                          ", sorting gives " + AString::number(reference));
+            }
+        }
+        vector<float> sorted = data;
+        sort(sorted.begin(), sorted.end());
+        float referenceMedian = ((numElems & 1) == 0 ? (sorted[numElems / 2 - 1] + sorted[numElems / 2]) / 2.0f : sorted[numElems / 2]);
+        float median = ReductionOperation::reduce(data.data(), numElems, ReductionEnum::MEDIAN);
+        if (median != referenceMedian)
+        {
+            setFailed("median of " + AString::number(numElems) + " values: got " + AString::number(median) + ", sorting gives " + AString::number(referenceMedian));
+        }
+    }
+}
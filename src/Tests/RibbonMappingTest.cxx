@@ -0,0 +1,179 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+
+#include "RibbonMappingTest.h"
+
+#include "AlgorithmSurfaceCreateSphere.h"
+#include "RibbonMappingHelper.h"
+#include "SurfaceFile.h"
+#include "Vector3D.h"
+#include "VolumeSpace.h"
+
+#include <cmath>
+#include <map>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    //compares the weights of each vertex voxel by voxel, a voxel missing from one list counts as weight 0
+    AString compareWeights(const VolumeSpace& mySpace, const vector<vector<VoxelWeight> >& first, const vector<vector<VoxelWeight> >& second,
+                           const float& voxelTolerance, const float& vertexTolerance)
+    {
+        if (first.size() != second.size())
+        {
+            return "different number of vertices";
+        }
+        for (size_t node = 0; node < first.size(); ++node)
+        {
+            map<int64_t, float> difference;
+            double firstSum = 0.0, secondSum = 0.0;
+            for (size_t i = 0; i < first[node].size(); ++i)
+            {
+                difference[mySpace.getIndex(first[node][i].ijk)] += first[node][i].weight;
+                firstSum += first[node][i].weight;
+            }
+            for (size_t i = 0; i < second[node].size(); ++i)
+            {
+                difference[mySpace.getIndex(second[node][i].ijk)] -= second[node][i].weight;
+                secondSum += second[node][i].weight;
+            }
+            for (map<int64_t, float>::const_iterator iter = difference.begin(); iter != difference.end(); ++iter)
+            {
+                if (abs(iter->second) > voxelTolerance)
+                {
+                    return "vertex " + AString::number(node) + " weights differ by " + AString::number(iter->second) + " at voxel index " + AString::number(iter->first);
+                }
+            }
+            if (abs(firstSum - secondSum) > vertexTolerance)
+            {
+                return "vertex " + AString::number(node) + " total weights are " + AString::number(firstSum) + " and " + AString::number(secondSum);
+            }
+        }
+        return "";
+    }
+}
+
+RibbonMappingTest::RibbonMappingTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void RibbonMappingTest::execute()
+{
+    const float INNER_RADIUS = 100.0f, THICKNESS = 4.0f, VOXEL_SIZE = 3.0f, CAP_SIZE = 10.0f;
+    const float VOXEL_TOLERANCE = 0.03f;//20 subdivisions sample a voxel in 1/20 voxel steps, worst case error is about half a step for a face lying along a step
+    const float VERTEX_TOLERANCE = 0.1f;//errors of the partial voxels of a vertex partly cancel
+    SurfaceFile innerSurf;
+    AlgorithmSurfaceCreateSphere(NULL, 642, &innerSurf);
+    SurfaceFile outerSurf = innerSurf;
+    int32_t numNodes = innerSurf.getNumberOfNodes();
+    for (int32_t i = 0; i < numNodes; ++i)
+    {
+        Vector3D coord = innerSurf.getCoordinate(i);
+        coord = coord * ((INNER_RADIUS + THICKNESS) / coord.length());
+        outerSurf.setCoordinate(i, coord);
+    }
+    const float extent = INNER_RADIUS + THICKNESS + VOXEL_SIZE;
+    int64_t myDims[3];
+    vector<vector<float> > mySform(4, vector<float>(4, 0.0f));
+    for (int i = 0; i < 3; ++i)
+    {
+        myDims[i] = (int64_t)ceil(2.0f * extent / VOXEL_SIZE) + 1;
+        mySform[i][i] = VOXEL_SIZE;
+        mySform[i][3] = -extent + 0.3f * i;//don't line up the voxels with the vertices
+    }
+    mySform[3][3] = 1.0f;
+    VolumeSpace mySpace(myDims, mySform);
+    vector<float> roiFrame(myDims[0] * myDims[1] * myDims[2], 0.0f);//sampling every voxel of the ribbon 20x20x20 times is slow, so only check a small cap of it
+    int64_t ijk[3], roiCount = 0;
+    for (ijk[2] = 0; ijk[2] < myDims[2]; ++ijk[2])
+    {
+        for (ijk[1] = 0; ijk[1] < myDims[1]; ++ijk[1])
+        {
+            for (ijk[0] = 0; ijk[0] < myDims[0]; ++ijk[0])
+            {
+                Vector3D coord;
+                mySpace.indexToSpace(ijk, coord);
+                float radius = coord.length();
+                if (coord[2] > 0.0f && abs(coord[0]) < CAP_SIZE && abs(coord[1]) < CAP_SIZE &&
+                    radius > INNER_RADIUS - VOXEL_SIZE && radius < INNER_RADIUS + THICKNESS + VOXEL_SIZE)
+                {
+                    roiFrame[mySpace.getIndex(ijk)] = 1.0f;
+                    ++roiCount;
+                }
+            }
+        }
+    }
+    if (roiCount == 0)
+    {
+        setFailed("test roi has no voxels");
+        return;
+    }
+    for (int thin = 0; thin < 2; ++thin)
+    {
+        const bool thinColumn = (thin == 1);
+        AString columnString = (thinColumn ? "thin columns: " : "thick columns: ");
+        vector<vector<VoxelWeight> > exactWeights, sampledWeights;
+        RibbonMappingHelper::computeWeightsRibbon(exactWeights, mySpace, &innerSurf, &outerSurf, roiFrame.data(), 0, thinColumn);
+        RibbonMappingHelper::computeWeightsRibbon(sampledWeights, mySpace, &innerSurf, &outerSurf, roiFrame.data(), 20, thinColumn);
+        double exactTotal = 0.0;
+        for (int32_t i = 0; i < numNodes; ++i)
+        {
+            for (size_t j = 0; j < exactWeights[i].size(); ++j)
+            {
+                exactTotal += exactWeights[i][j].weight;
+            }
+        }
+        if (exactTotal < 1.0)
+        {
+            setFailed(columnString + "test roi barely overlaps the ribbon");
+            return;
+        }
+        AString message = compareWeights(mySpace, exactWeights, sampledWeights, VOXEL_TOLERANCE, VERTEX_TOLERANCE);
+        if (message != "")
+        {
+            setFailed(columnString + "exact overlap differs from 20 subdivisions: " + message);
+            return;
+        }
+        for (int subdiv = 3; subdiv <= 7; subdiv += 4)//the default, and a batch size that isn't a multiple of any vector width
+        {//a weight is the count of inside samples divided by a constant, so identical weights mean identical counts
+            vector<vector<VoxelWeight> > batchedWeights, perPointWeights;
+            RibbonMappingHelper::computeWeightsRibbon(batchedWeights, mySpace, &innerSurf, &outerSurf, roiFrame.data(), subdiv, thinColumn, true);
+            RibbonMappingHelper::computeWeightsRibbon(perPointWeights, mySpace, &innerSurf, &outerSurf, roiFrame.data(), subdiv, thinColumn, false);
+            for (int32_t i = 0; i < numNodes; ++i)
+            {
+                bool same = (batchedWeights[i].size() == perPointWeights[i].size());
+                for (size_t j = 0; same && j < batchedWeights[i].size(); ++j)
+                {
+                    const VoxelWeight& batched = batchedWeights[i][j], &perPoint = perPointWeights[i][j];
+                    same = (batched.weight == perPoint.weight && batched.ijk[0] == perPoint.ijk[0] && batched.ijk[1] == perPoint.ijk[1] && batched.ijk[2] == perPoint.ijk[2]);
+                }
+                if (!same)
+                {
+                    setFailed(columnString + "batched inside test differs from per-point test for vertex " + AString::number(i) + " with " + AString::number(subdiv) + " subdivisions");
+                    return;
+                }
+            }
+        }
+    }
+}
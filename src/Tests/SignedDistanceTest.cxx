@@ -0,0 +1,99 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+
+#include "SignedDistanceTest.h"
+
+#include "AlgorithmCreateSignedDistanceVolume.h"
+#include "AlgorithmSurfaceCreateSphere.h"
+#include "SurfaceFile.h"
+#include "VolumeFile.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+SignedDistanceTest::SignedDistanceTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void SignedDistanceTest::execute()
+{
+    const float VOXEL_SIZE = 5.0f, EXACT_LIMIT = 12.0f, FILL_VALUE = 12345.0f;
+    const float MAX_ERROR = 0.25f * VOXEL_SIZE;//the transform only knows the closest points of the band voxels, so it can slightly overestimate
+    const float MEAN_ERROR = 0.05f * VOXEL_SIZE;
+    const float UNDERESTIMATE_TOLERANCE = 0.01f;//any point on the surface is at least as far as the closest one, except for roundoff
+    const int NUM_SPHERE_VERTICES[2] = { 2562, 162 };//the coarse sphere has edges much longer than the voxels and the exact limit
+    vector<int64_t> myDims(3, 51);
+    vector<vector<float> > mySform(4, vector<float>(4, 0.0f));
+    for (int i = 0; i < 3; ++i)
+    {
+        mySform[i][i] = VOXEL_SIZE;
+        mySform[i][3] = -124.0f + i;//don't center the sphere on a voxel, or align it with the grid
+    }
+    mySform[3][3] = 1.0f;
+    for (int sphere = 0; sphere < 2; ++sphere)
+    {
+        SurfaceFile mySurf;
+        AlgorithmSurfaceCreateSphere(NULL, NUM_SPHERE_VERTICES[sphere], &mySurf);//radius 100 sphere
+        AString sphereString = AString::number(mySurf.getNumberOfNodes()) + " vertex sphere: ";
+        VolumeFile exactVol(myDims, mySform), transformVol(myDims, mySform), transformRoi;
+        AlgorithmCreateSignedDistanceVolume(NULL, &mySurf, &exactVol, NULL, FILL_VALUE, 1000.0f, 1000.0f);//exact limit covers the whole volume
+        AlgorithmCreateSignedDistanceVolume(NULL, &mySurf, &transformVol, &transformRoi, FILL_VALUE, EXACT_LIMIT, 1000.0f, 2, SignedDistanceHelper::EVEN_ODD, true);
+        double errorSum = 0.0;
+        int64_t numVoxels = 0;
+        int64_t ijk[3];
+        for (ijk[2] = 0; ijk[2] < myDims[2]; ++ijk[2])
+        {
+            for (ijk[1] = 0; ijk[1] < myDims[1]; ++ijk[1])
+            {
+                for (ijk[0] = 0; ijk[0] < myDims[0]; ++ijk[0])
+                {
+                    AString voxelString = "(" + AString::number(ijk[0]) + ", " + AString::number(ijk[1]) + ", " + AString::number(ijk[2]) + ")";
+                    float exact = exactVol.getValue(ijk), transformed = transformVol.getValue(ijk);
+                    if (transformRoi.getValue(ijk) != 1.0f)
+                    {
+                        setFailed(sphereString + "distance transform left voxel " + voxelString + " out of the roi");
+                        return;
+                    }
+                    if ((exact < 0.0f) != (transformed < 0.0f))
+                    {
+                        setFailed(sphereString + "distance transform gave voxel " + voxelString + " value " + AString::number(transformed) + ", exact value is " + AString::number(exact));
+                        return;
+                    }
+                    float error = abs(transformed) - abs(exact);
+                    if (error > MAX_ERROR || error < -UNDERESTIMATE_TOLERANCE)
+                    {
+                        setFailed(sphereString + "distance transform gave voxel " + voxelString + " value " + AString::number(transformed) + ", exact value is " + AString::number(exact));
+                        return;
+                    }
+                    errorSum += error;
+                    ++numVoxels;
+                }
+            }
+        }
+        if (errorSum / numVoxels > MEAN_ERROR)
+        {
+            setFailed(sphereString + "distance transform mean error is " + AString::number(errorSum / numVoxels) + " mm");
+        }
+    }
+}
@@ -0,0 +1,157 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2014  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "SparseFileTest.h"
+
+#include "CaretSparseFile.h"
+#include "CiftiSeriesMap.h"
+#include "CiftiXML.h"
+#include "FileInformation.h"
+
+#include <QTemporaryDir>
+
+#include <cstdlib>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    const int64_t NUM_COLUMNS = 3001, NUM_ROWS = 301;//more than one block of rows in the version 2 row index
+    
+    void makeRow(const int64_t& row, vector<int64_t>& indices, vector<int64_t>& values)
+    {//mix of dense and scattered rows, with counts, packed fiber values, and negative values
+        indices.clear();
+        values.clear();
+        if (row % 13 == 5) return;//empty rows
+        int64_t gapRange = (row % 3 == 0) ? 300 : 4;
+        for (int64_t col = rand() % gapRange; col < NUM_COLUMNS; col += 1 + rand() % gapRange)
+        {
+            indices.push_back(col);
+            switch (row % 4)
+            {
+                case 0:
+                    values.push_back(rand() % 200 + 1);
+                    break;
+                case 1:
+                    values.push_back((((int64_t)(rand() % 70000 + 1)) << 32) | (rand() & 0x3FFFFFFF));
+                    break;
+                case 2:
+                    values.push_back(-(int64_t)(rand() % 100 + 1));
+                    break;
+                default:
+                    values.push_back(((int64_t)rand() << 20) + rand());
+                    break;
+            }
+        }
+    }
+}
+
+SparseFileTest::SparseFileTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void SparseFileTest::execute()
+{
+    QTemporaryDir tempDir;//unique directory, so simultaneous runs don't collide, removed with its files when done
+    if (!tempDir.isValid())
+    {
+        setFailed("unable to create temporary directory");
+        return;
+    }
+    CiftiXML myXML;
+    myXML.setNumberOfDimensions(2);
+    myXML.setMap(CiftiXML::ALONG_ROW, CiftiSeriesMap(NUM_COLUMNS));
+    myXML.setMap(CiftiXML::ALONG_COLUMN, CiftiSeriesMap(NUM_ROWS));
+    vector<vector<int64_t> > rowIndices(NUM_ROWS), rowValues(NUM_ROWS);
+    for (int64_t i = 0; i < NUM_ROWS; ++i)
+    {
+        makeRow(i, rowIndices[i], rowValues[i]);
+    }
+    int64_t fileSizes[2];
+    for (int32_t version = 1; version <= 2; ++version)
+    {
+        AString fileName = tempDir.path() + "/sparse_test_v" + AString::number(version) + ".trajTEMP.wbsparse";
+        {
+            CaretSparseFileWriter writer(fileName, myXML, version);
+            vector<int64_t> denseRow(NUM_COLUMNS);
+            for (int64_t i = 0; i < NUM_ROWS; ++i)
+            {
+                if (rowIndices[i].empty()) continue;//skipped rows must read back as empty
+                if (i % 2 == 0)
+                {
+                    writer.writeRowSparse(i, rowIndices[i], rowValues[i]);
+                } else {
+                    denseRow.assign(NUM_COLUMNS, 0);
+                    for (size_t j = 0; j < rowIndices[i].size(); ++j)
+                    {
+                        denseRow[rowIndices[i][j]] = rowValues[i][j];
+                    }
+                    writer.writeRow(i, denseRow.data());
+                }
+            }
+        }
+        fileSizes[version - 1] = FileInformation(fileName).size();
+        CaretSparseFile reader(fileName);
+        if (reader.getVersion() != version)
+        {
+            setFailed("file written as version " + AString::number(version) + " was read as version " + AString::number(reader.getVersion()));
+        }
+        vector<int64_t> indices, values, denseRow(NUM_COLUMNS);
+        for (int64_t i = NUM_ROWS - 1; i >= 0; --i)
+        {//backwards, so row index blocks are not loaded in order
+            reader.getRowSparse(i, indices, values);
+            if (indices != rowIndices[i] || values != rowValues[i])
+            {
+                setFailed("version " + AString::number(version) + " sparse row " + AString::number(i) + " doesn't match what was written");
+            }
+            reader.getRow(i, denseRow.data());
+            int64_t nonzero = 0;
+            for (int64_t j = 0; j < NUM_COLUMNS; ++j)
+            {
+                if (denseRow[j] != 0) ++nonzero;
+            }
+            bool match = (nonzero == (int64_t)rowIndices[i].size());
+            for (size_t j = 0; match && j < rowIndices[i].size(); ++j)
+            {
+                match = (denseRow[rowIndices[i][j]] == rowValues[i][j]);
+            }
+            if (!match)
+            {
+                setFailed("version " + AString::number(version) + " dense row " + AString::number(i) + " doesn't match what was written");
+            }
+        }
+    }
+    if (fileSizes[1] >= fileSizes[0])
+    {
+        setFailed("version 2 file is not smaller than version 1 file");
+    }
+    AString defaultFileName = tempDir.path() + "/sparse_test_default.trajTEMP.wbsparse";
+    {
+        CaretSparseFileWriter writer(defaultFileName, myXML);
+        writer.writeRowSparse(0, rowIndices[0], rowValues[0]);
+    }
+    CaretSparseFile defaultReader(defaultFileName);
+    if (defaultReader.getVersion() != 1)
+    {
+        setFailed("writer without a version wrote version " + AString::number(defaultReader.getVersion()) + ", older readers need version 1");
+    }
+}
@@ -18,15 +18,56 @@
  */
 /*LICENSE_END*/
 #include "StatisticsTest.h"
+#include <algorithm>
 #include <cstdlib>
 #include <cmath>
+#include <limits>
+#include <random>
 
 #include "FastStatistics.h"
 #include "DescriptiveStatistics.h"
+#include "Histogram.h"
 
 using namespace caret;
 using namespace std;
 
+namespace
+{
+    bool isNumeric(const float& value)
+    {
+        return !std::isnan(value) && !std::isinf(value);
+    }
+    
+    //uniform values with zeros, negative zeros, NaNs and infs sprinkled in
+    vector<float> makeData(const int64_t& count, const unsigned& seed)
+    {
+        mt19937 myRand(seed);
+        uniform_real_distribution<float> myDist(-50.0f, 50.0f);
+        vector<float> ret(count);
+        for (int64_t i = 0; i < count; ++i)
+        {
+            ret[i] = myDist(myRand);
+            if (i % 89 == 0) ret[i] = 0.0f;
+            if (i % 97 == 0) ret[i] = numeric_limits<float>::quiet_NaN();
+            if (i % 101 == 0) ret[i] = numeric_limits<float>::infinity();
+            if (i % 103 == 0) ret[i] = -numeric_limits<float>::infinity();
+            if (i % 107 == 0) ret[i] = -0.0f;
+        }
+        return ret;
+    }
+    
+    //sorted is ascending, rank is in [0, size], tolerance is how far an approximate percentile can be from this
+    float sortedValueAtRank(const vector<float>& sorted, const float& rank, const float& bucketWidth, float& toleranceOut)
+    {
+        int64_t index = (int64_t)rank;
+        if (index < 0) index = 0;
+        if (index >= (int64_t)sorted.size()) index = (int64_t)sorted.size() - 1;
+        int64_t lowIndex = max(index - 1, (int64_t)0), highIndex = min(index + 1, (int64_t)sorted.size() - 1);
+        toleranceOut = 2.0f * bucketWidth + (sorted[highIndex] - sorted[lowIndex]);//sparse data can leave a gap between neighbors wider than a bucket
+        return sorted[index];
+    }
+}
+
 StatisticsTest::StatisticsTest(const AString& identifier) : TestInterface(identifier)
 {
 }
@@ -76,4 +117,268 @@ void StatisticsTest::execute()
     {
         setFailed(AString("mismatch in 90% negative percentile, full: ") + AString::number(myFullStats.getNegativePercentile(90.0f)) + ", fast: " + AString::number(myFastStats.getApproxNegativePercentile(90.0f)));
     }
+    const int64_t sizes[2] = { 1000, 1 << 18 };//the larger one uses the parallel path
+    for (int i = 0; i < 2; ++i)
+    {
+        vector<float> testData = makeData(sizes[i], 1234 + i);
+        checkFusedStatistics(testData, 0.0f, 0.0f, false);
+        checkFusedStatistics(testData, -10.0f, 30.0f, true);
+        checkFusedStatistics(testData, 5.0f, 20.0f, true);//positives only
+        checkHistogram(testData, 100);
+        checkHistogram(testData, 10000);
+        checkRangedHistogram(testData, 100);
+    }
+    vector<float> nothingNumeric(100);
+    for (int i = 0; i < 100; ++i)
+    {
+        switch (i % 3)
+        {
+            case 0:
+                nothingNumeric[i] = numeric_limits<float>::quiet_NaN();
+                break;
+            case 1:
+                nothingNumeric[i] = numeric_limits<float>::infinity();
+                break;
+            default:
+                nothingNumeric[i] = -numeric_limits<float>::infinity();
+        }
+    }
+    checkFusedStatistics(nothingNumeric, 0.0f, 0.0f, false);
+    checkHistogram(nothingNumeric, 100);
+}
+
+//two-pass reference: select the values that count, then get the mean, then the deviations and percentiles
+void StatisticsTest::checkFusedStatistics(const vector<float>& data, const float& minThresh, const float& maxThresh, const bool& thresholded)
+{
+    AString caseName = "fast statistics (" + AString::number(data.size()) + " values";
+    if (thresholded) caseName += ", threshold [" + AString::number(minThresh) + ", " + AString::number(maxThresh) + "]";
+    caseName += ")";
+    FastStatistics myFastStats;
+    if (thresholded)
+    {
+        myFastStats.update(data.data(), data.size(), minThresh, maxThresh);
+    } else {
+        myFastStats.update(data.data(), data.size());
+    }
+    vector<float> used, positives, negatives, absolutes;
+    int64_t refInf = 0, refNegInf = 0, refNan = 0, refZero = 0;
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        const float value = data[i];
+        if (std::isnan(value))
+        {
+            ++refNan;
+            continue;
+        }
+        if (std::isinf(value))
+        {
+            if (value > 0.0f) ++refInf; else ++refNegInf;
+            continue;//infs are counted regardless of the threshold
+        }
+        if (thresholded && (value < minThresh || value > maxThresh)) continue;
+        used.push_back(value);
+        if (value > 0.0f)
+        {
+            positives.push_back(value);
+            absolutes.push_back(value);
+        } else if (value < 0.0f) {
+            negatives.push_back(value);
+            absolutes.push_back(-value);
+        } else {
+            ++refZero;
+        }
+    }
+    int64_t posCount, zeroCount, negCount, infCount, negInfCount, nanCount;
+    myFastStats.getCounts(posCount, zeroCount, negCount, infCount, negInfCount, nanCount);
+    if (posCount != (int64_t)positives.size() || zeroCount != refZero || negCount != (int64_t)negatives.size() ||
+        infCount != refInf || negInfCount != refNegInf || nanCount != refNan)
+    {
+        setFailed("mismatch in value counts for " + caseName);
+        return;
+    }
+    if (used.empty()) return;//mean is undefined
+    sort(positives.begin(), positives.end());
+    sort(negatives.begin(), negatives.end());
+    sort(absolutes.begin(), absolutes.end());
+    double sum = 0.0;
+    float refMin = used[0], refMax = used[0];
+    for (size_t i = 0; i < used.size(); ++i)
+    {
+        sum += used[i];
+        refMin = min(refMin, used[i]);
+        refMax = max(refMax, used[i]);
+    }
+    const double mean = sum / used.size();
+    double sum2 = 0.0;
+    for (size_t i = 0; i < used.size(); ++i)
+    {
+        sum2 += (used[i] - mean) * (used[i] - mean);
+    }
+    const double popStdDev = sqrt(sum2 / used.size());
+    const double sampleStdDev = (used.size() > 1 ? sqrt(sum2 / (used.size() - 1)) : 0.0);
+    if (myFastStats.getMin() != refMin || myFastStats.getMax() != refMax)
+    {
+        setFailed("mismatch in min/max for " + caseName + ", reference: " + AString::number(refMin) + ", " + AString::number(refMax) +
+                  ", fast: " + AString::number(myFastStats.getMin()) + ", " + AString::number(myFastStats.getMax()));
+    }
+    const float meanTolerance = max(abs(refMin), abs(refMax)) * 0.00001f;//only summation order differs
+    if (abs(myFastStats.getMean() - mean) > meanTolerance)
+    {
+        setFailed("mismatch in mean for " + caseName + ", reference: " + AString::number(mean) + ", fast: " + AString::number(myFastStats.getMean()));
+    }
+    if (abs(myFastStats.getPopulationStdDev() - popStdDev) > popStdDev * 0.00001 ||
+        abs(myFastStats.getSampleStdDev() - sampleStdDev) > sampleStdDev * 0.00001)
+    {
+        setFailed("mismatch in standard deviation for " + caseName + ", reference: " + AString::number(popStdDev) + ", fast: " + AString::number(myFastStats.getPopulationStdDev()));
+    }
+    float mostNeg, leastNeg, leastPos, mostPos;
+    myFastStats.getNonzeroRanges(mostNeg, leastNeg, leastPos, mostPos);
+    if ((!positives.empty() && (leastPos != positives.front() || mostPos != positives.back())) ||
+        (!negatives.empty() && (mostNeg != negatives.front() || leastNeg != negatives.back())))
+    {
+        setFailed("mismatch in nonzero ranges for " + caseName);
+    }
+    const int numBuckets = (int)min((int64_t)10000, (int64_t)data.size());//FastStatistics' percentile histogram size
+    const float percents[3] = { 10.0f, 50.0f, 90.0f };
+    for (int i = 0; i < 3; ++i)
+    {
+        float tolerance, expected;
+        if (!positives.empty())
+        {
+            expected = sortedValueAtRank(positives, percents[i] / 100.0f * positives.size(), (positives.back() - positives.front()) / numBuckets, tolerance);
+            if (abs(myFastStats.getApproxPositivePercentile(percents[i]) - expected) > tolerance)
+            {
+                setFailed("mismatch in " + AString::number(percents[i]) + "% positive percentile for " + caseName + ", sorted: " + AString::number(expected) +
+                          ", fast: " + AString::number(myFastStats.getApproxPositivePercentile(percents[i])));
+            }
+        }
+        if (!negatives.empty())
+        {//negative percentiles count from zero toward the most negative value
+            expected = sortedValueAtRank(negatives, (1.0f - percents[i] / 100.0f) * negatives.size(), (negatives.back() - negatives.front()) / numBuckets, tolerance);
+            if (abs(myFastStats.getApproxNegativePercentile(percents[i]) - expected) > tolerance)
+            {
+                setFailed("mismatch in " + AString::number(percents[i]) + "% negative percentile for " + caseName + ", sorted: " + AString::number(expected) +
+                          ", fast: " + AString::number(myFastStats.getApproxNegativePercentile(percents[i])));
+            }
+        }
+        if (!absolutes.empty())
+        {
+            expected = sortedValueAtRank(absolutes, percents[i] / 100.0f * absolutes.size(), (absolutes.back() - absolutes.front()) / numBuckets, tolerance);
+            if (abs(myFastStats.getApproxAbsolutePercentile(percents[i]) - expected) > tolerance)
+            {
+                setFailed("mismatch in " + AString::number(percents[i]) + "% absolute percentile for " + caseName + ", sorted: " + AString::number(expected) +
+                          ", fast: " + AString::number(myFastStats.getApproxAbsolutePercentile(percents[i])));
+            }
+        }
+    }
+}
+
+//reference: find the range of numeric values in one pass, then bucket them in another
+void StatisticsTest::checkHistogram(const vector<float>& data, const int& numBuckets)
+{
+    const AString caseName = "histogram (" + AString::number(data.size()) + " values, " + AString::number(numBuckets) + " buckets)";
+    Histogram myHist(numBuckets, data.data(), data.size());
+    float refMin = numeric_limits<float>::max(), refMax = -numeric_limits<float>::max();
+    int64_t refPos = 0, refZero = 0, refNeg = 0, refInf = 0, refNegInf = 0, refNan = 0;
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        const float value = data[i];
+        if (std::isnan(value))
+        {
+            ++refNan;
+        } else if (std::isinf(value)) {
+            if (value > 0.0f) ++refInf; else ++refNegInf;
+        } else {
+            if (value > 0.0f) ++refPos; else if (value < 0.0f) ++refNeg; else ++refZero;
+            refMin = min(refMin, value);
+            refMax = max(refMax, value);
+        }
+    }
+    int64_t posCount, zeroCount, negCount, infCount, negInfCount, nanCount;
+    myHist.getCounts(posCount, zeroCount, negCount, infCount, negInfCount, nanCount);
+    if (posCount != refPos || zeroCount != refZero || negCount != refNeg || infCount != refInf || negInfCount != refNegInf || nanCount != refNan)
+    {
+        setFailed("mismatch in value counts for " + caseName);
+        return;
+    }
+    if (refMin >= refMax) return;//no range to bucket over
+    float histMin, histMax;
+    myHist.getRange(histMin, histMax);
+    if (histMin != refMin || histMax != refMax)
+    {
+        setFailed("mismatch in range for " + caseName);
+        return;
+    }
+    vector<int64_t> refBuckets(numBuckets, 0);
+    const float bucketSize = (refMax - refMin) / numBuckets;
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        if (!isNumeric(data[i])) continue;
+        int bucket = (int)((data[i] - refMin) / bucketSize);
+        bucket = max(0, min(numBuckets - 1, bucket));
+        ++refBuckets[bucket];
+    }
+    if (myHist.getHistogramCounts() != refBuckets)
+    {
+        setFailed("mismatch in bucket counts for " + caseName);
+        return;
+    }
+    const vector<int64_t>& cumulative = myHist.getHistogramCumulativeCounts();
+    int64_t accum = 0;
+    for (int i = 0; i < numBuckets; ++i)
+    {
+        accum += refBuckets[i];
+        if (cumulative[i] != accum)
+        {
+            setFailed("mismatch in cumulative counts for " + caseName);
+            return;
+        }
+    }
+}
+
+//the ranged update with zeros excluded, values in [-40, -1] and [1, 40] are bucketed over [-40, 40]
+void StatisticsTest::checkRangedHistogram(const vector<float>& data, const int& numBuckets)
+{
+    const AString caseName = "ranged histogram (" + AString::number(data.size()) + " values, " + AString::number(numBuckets) + " buckets)";
+    Histogram myHist;
+    myHist.update(numBuckets, data.data(), data.size(), 40.0f, 1.0f, -1.0f, -40.0f, false);
+    vector<int64_t> refBuckets(numBuckets, 0);
+    int64_t refPos = 0, refNeg = 0, refInf = 0, refNegInf = 0, refNan = 0;
+    const float bucketSize = 80.0f / numBuckets;
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        const float value = data[i];
+        if (std::isnan(value))
+        {
+            ++refNan;
+            continue;
+        }
+        if (std::isinf(value))
+        {
+            if (value > 0.0f) ++refInf; else ++refNegInf;
+            continue;
+        }
+        if (value >= 1.0f && value <= 40.0f)
+        {
+            ++refPos;
+        } else if (value <= -1.0f && value >= -40.0f) {
+            ++refNeg;
+        } else {
+            continue;
+        }
+        int bucket = (int)((value + 40.0f) / bucketSize);
+        bucket = max(0, min(numBuckets - 1, bucket));
+        ++refBuckets[bucket];
+    }
+    int64_t posCount, zeroCount, negCount, infCount, negInfCount, nanCount;
+    myHist.getCounts(posCount, zeroCount, negCount, infCount, negInfCount, nanCount);
+    if (posCount != refPos || zeroCount != 0 || negCount != refNeg || infCount != refInf || negInfCount != refNegInf || nanCount != refNan)
+    {
+        setFailed("mismatch in value counts for " + caseName);
+        return;
+    }
+    if (myHist.getHistogramCounts() != refBuckets)
+    {
+        setFailed("mismatch in bucket counts for " + caseName);
+    }
 }
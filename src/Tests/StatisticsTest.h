@@ -22,6 +22,8 @@
 /*LICENSE_END*/
 #include "TestInterface.h"
 
+#include <vector>
+
 namespace caret {
 
    class StatisticsTest : public TestInterface
@@ -29,6 +31,10 @@ namespace caret {
    public:
       StatisticsTest(const AString& identifier);
       virtual void execute();
+   private:
+      void checkFusedStatistics(const std::vector<float>& data, const float& minThresh, const float& maxThresh, const bool& thresholded);
+      void checkHistogram(const std::vector<float>& data, const int& numBuckets);
+      void checkRangedHistogram(const std::vector<float>& data, const int& numBuckets);
    };
 
 }
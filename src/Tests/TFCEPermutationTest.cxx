@@ -0,0 +1,202 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "TFCEPermutationTest.h"
+
+#include "AlgorithmMetricTFCE.h"
+#include "AlgorithmMetricTFCEPermutation.h"
+#include "AlgorithmSurfaceCreateSphere.h"
+#include "AlgorithmVolumeTFCEPermutation.h"
+#include "CaretOMP.h"
+#include "FloatMatrix.h"
+#include "MetricFile.h"
+#include "SurfaceFile.h"
+#include "VolumeFile.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    //p-values must be the fraction of the max distribution at least as large as the absolute TFCE, and the first entry of the distribution is the unpermuted data
+    AString checkConsistency(const float* tfceData, const float* pvalData, const int64_t& numElements, const vector<float>& maxDist)
+    {
+        float observedMax = 0.0f;
+        for (int64_t i = 0; i < numElements; ++i)
+        {
+            observedMax = max(observedMax, abs(tfceData[i]));
+            int numAtLeast = 0;
+            for (size_t perm = 0; perm < maxDist.size(); ++perm)
+            {
+                if (maxDist[perm] >= abs(tfceData[i])) ++numAtLeast;
+            }
+            if (pvalData[i] != ((float)numAtLeast) / maxDist.size()) return "p-value doesn't match the max distribution at element " + AString::number(i);
+        }
+        if (maxDist[0] != observedMax) return "first entry of the max distribution isn't the maximum of the unpermuted TFCE";
+        return "";
+    }
+}
+
+TFCEPermutationTest::TFCEPermutationTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void TFCEPermutationTest::execute()
+{
+    checkMetric();
+    if (!failed()) checkVolume();
+}
+
+void TFCEPermutationTest::checkMetric()
+{
+    SurfaceFile mySurf;
+    AlgorithmSurfaceCreateSphere(NULL, 2562, &mySurf);
+    const int numNodes = mySurf.getNumberOfNodes();
+    const int NUM_SUBJECTS = 8, NUM_PERMS = 40, SEED = 17;
+    mt19937 myRand(54321);//fixed seed, so failures are reproducible
+    normal_distribution<float> noiseDist;
+    MetricFile myMetric;
+    myMetric.setNumberOfNodesAndColumns(numNodes, NUM_SUBJECTS);
+    myMetric.setStructure(mySurf.getStructure());
+    vector<float> column(numNodes);
+    for (int c = 0; c < NUM_SUBJECTS; ++c)
+    {
+        for (int i = 0; i < numNodes; ++i)
+        {
+            column[i] = noiseDist(myRand);
+            if (i < numNodes / 10) column[i] += 1.0f;//some signal, so the unpermuted data stands out
+        }
+        myMetric.setValuesForColumn(c, column.data());
+    }
+    vector<int> groups(NUM_SUBJECTS, 0);
+    for (int c = 0; c < NUM_SUBJECTS / 2; ++c) groups[c] = 1;
+    for (int twoSample = 0; twoSample < 2 && !failed(); ++twoSample)
+    {
+        AString testName = (twoSample ? "two-sample metric: " : "one-sample metric: ");
+        const vector<int>* useGroups = (twoSample ? &groups : NULL);
+        MetricFile firstOut, secondOut, otherSeedOut;
+        vector<float> firstDist, secondDist, otherSeedDist;
+        AlgorithmMetricTFCEPermutation(NULL, &mySurf, &myMetric, &firstOut, NUM_PERMS, useGroups, NULL, 1.0f, 2.0f, NULL, SEED, &firstDist);
+#ifdef CARET_OMP
+        int oldThreads = omp_get_max_threads();
+        omp_set_num_threads(1);//the result must not depend on how permutations are split across threads
+#endif
+        AlgorithmMetricTFCEPermutation(NULL, &mySurf, &myMetric, &secondOut, NUM_PERMS, useGroups, NULL, 1.0f, 2.0f, NULL, SEED, &secondDist);
+#ifdef CARET_OMP
+        omp_set_num_threads(oldThreads);
+#endif
+        AlgorithmMetricTFCEPermutation(NULL, &mySurf, &myMetric, &otherSeedOut, NUM_PERMS, useGroups, NULL, 1.0f, 2.0f, NULL, SEED + 1, &otherSeedDist);
+        if ((int)firstDist.size() != NUM_PERMS || firstOut.getNumberOfColumns() != 3)
+        {
+            setFailed(testName + "wrong output size");
+            continue;
+        }
+        if (firstDist != secondDist) setFailed(testName + "max distribution changed between runs with the same seed");
+        for (int col = 0; col < 3; ++col)
+        {
+            const float* firstData = firstOut.getValuePointerForColumn(col), *secondData = secondOut.getValuePointerForColumn(col);
+            for (int i = 0; i < numNodes; ++i)
+            {
+                if (firstData[i] != secondData[i])
+                {
+                    setFailed(testName + "column " + AString::number(col + 1) + " changed between runs with the same seed at vertex " + AString::number(i));
+                    break;
+                }
+            }
+        }
+        if (otherSeedDist[0] != firstDist[0]) setFailed(testName + "unpermuted maximum depends on the seed");
+        if (otherSeedDist == firstDist) setFailed(testName + "max distribution doesn't depend on the seed");
+        AString message = checkConsistency(firstOut.getValuePointerForColumn(1), firstOut.getValuePointerForColumn(2), numNodes, firstDist);
+        if (message != "") setFailed(testName + message);
+        MetricFile statMetric, tfceMetric;//the TFCE column must be what -metric-tfce gives on the t-statistic
+        statMetric.setNumberOfNodesAndColumns(numNodes, 1);
+        statMetric.setStructure(mySurf.getStructure());
+        statMetric.setValuesForColumn(0, firstOut.getValuePointerForColumn(0));
+        AlgorithmMetricTFCE(NULL, &mySurf, &statMetric, &tfceMetric);
+        const float* checkData = tfceMetric.getValuePointerForColumn(0), *permData = firstOut.getValuePointerForColumn(1);
+        for (int i = 0; i < numNodes; ++i)
+        {
+            if (checkData[i] != permData[i])
+            {
+                setFailed(testName + "TFCE of the unpermuted data differs from -metric-tfce at vertex " + AString::number(i));
+                break;
+            }
+        }
+    }
+}
+
+void TFCEPermutationTest::checkVolume()
+{
+    vector<int64_t> myDims;
+    myDims.push_back(12);
+    myDims.push_back(11);
+    myDims.push_back(10);
+    const int NUM_SUBJECTS = 6, NUM_PERMS = 30, SEED = 3;
+    myDims.push_back(NUM_SUBJECTS);
+    VolumeFile myVol(myDims, FloatMatrix::identity(4).getMatrix());
+    const int64_t frameSize = myDims[0] * myDims[1] * myDims[2];
+    mt19937 myRand(9876);
+    normal_distribution<float> noiseDist;
+    vector<float> frame(frameSize);
+    for (int b = 0; b < NUM_SUBJECTS; ++b)
+    {
+        for (int64_t i = 0; i < frameSize; ++i)
+        {
+            frame[i] = noiseDist(myRand);
+            if (i < frameSize / 10) frame[i] += 1.0f;
+        }
+        myVol.setFrame(frame.data(), b);
+    }
+    VolumeFile firstOut, secondOut;
+    vector<float> firstDist, secondDist;
+    AlgorithmVolumeTFCEPermutation(NULL, &myVol, &firstOut, NUM_PERMS, NULL, NULL, 0.5f, 2.0f, SEED, &firstDist);
+#ifdef CARET_OMP
+    int oldThreads = omp_get_max_threads();
+    omp_set_num_threads(1);
+#endif
+    AlgorithmVolumeTFCEPermutation(NULL, &myVol, &secondOut, NUM_PERMS, NULL, NULL, 0.5f, 2.0f, SEED, &secondDist);
+#ifdef CARET_OMP
+    omp_set_num_threads(oldThreads);
+#endif
+    if ((int)firstDist.size() != NUM_PERMS || firstOut.getNumberOfMaps() != 3)
+    {
+        setFailed("volume: wrong output size");
+        return;
+    }
+    if (firstDist != secondDist) setFailed("volume: max distribution changed between runs with the same seed");
+    for (int b = 0; b < 3; ++b)
+    {
+        const float* firstData = firstOut.getFrame(b), *secondData = secondOut.getFrame(b);
+        for (int64_t i = 0; i < frameSize; ++i)
+        {
+            if (firstData[i] != secondData[i])
+            {
+                setFailed("volume: subvolume " + AString::number(b + 1) + " changed between runs with the same seed at voxel " + AString::number(i));
+                break;
+            }
+        }
+    }
+    AString message = checkConsistency(firstOut.getFrame(1), firstOut.getFrame(2), frameSize, firstDist);
+    if (message != "") setFailed("volume: " + message);
+}
@@ -0,0 +1,216 @@
+/*LICENSE_START*/
+/*
+ *  Copyright (C) 2017  Washington University School of Medicine
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+/*LICENSE_END*/
+
+#include "TriangleLocatorTest.h"
+
+#include "CaretTriangleLocator.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace caret;
+using namespace std;
+
+namespace
+{
+    //plane intersection followed by an inside test with edge cross products, deliberately not the same method as the locator
+    bool bruteForceHit(const vector<float>& coords, const vector<int32_t>& triangles, const int32_t triangle,
+                       const float start[3], const float direction[3], double& tOut)
+    {
+        const float* c[3];
+        for (int v = 0; v < 3; ++v) c[v] = coords.data() + triangles[triangle * 3 + v] * 3;
+        double edge1[3], edge2[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            edge1[i] = c[1][i] - c[0][i];
+            edge2[i] = c[2][i] - c[0][i];
+        }
+        double normal[3] = { edge1[1] * edge2[2] - edge1[2] * edge2[1],
+                             edge1[2] * edge2[0] - edge1[0] * edge2[2],
+                             edge1[0] * edge2[1] - edge1[1] * edge2[0] };
+        double denom = 0.0, numer = 0.0;
+        for (int i = 0; i < 3; ++i)
+        {
+            denom += normal[i] * direction[i];
+            numer += normal[i] * (c[0][i] - start[i]);
+        }
+        if (denom == 0.0) return false;
+        double t = numer / denom;
+        if (t < 0.0) return false;
+        double point[3];
+        for (int i = 0; i < 3; ++i) point[i] = start[i] + t * direction[i];
+        for (int v = 0; v < 3; ++v)
+        {
+            const float* a = c[v];
+            const float* b = c[(v + 1) % 3];
+            double edge[3], toPoint[3];
+            for (int i = 0; i < 3; ++i)
+            {
+                edge[i] = b[i] - a[i];
+                toPoint[i] = point[i] - a[i];
+            }
+            double cross[3] = { edge[1] * toPoint[2] - edge[2] * toPoint[1],
+                                edge[2] * toPoint[0] - edge[0] * toPoint[2],
+                                edge[0] * toPoint[1] - edge[1] * toPoint[0] };
+            if (cross[0] * normal[0] + cross[1] * normal[1] + cross[2] * normal[2] < 0.0) return false;
+        }
+        tOut = t;
+        return true;
+    }
+}
+
+TriangleLocatorTest::TriangleLocatorTest(const AString& identifier) : TestInterface(identifier)
+{
+}
+
+void TriangleLocatorTest::execute()
+{//compare against checking every triangle, on a closed sphere (shared edges) plus a soup of random triangles
+    const int NUM_RINGS = 40;
+    const float RADIUS = 50.0f;
+    const int NUM_SOUP = 1000;
+    const int NUM_QUERIES = 2000;
+    mt19937 myRand(20171017);//fixed seed so a failure can be reproduced
+    uniform_real_distribution<float> coordDist(-100.0f, 100.0f), offsetDist(-8.0f, 8.0f);
+    vector<float> coords;
+    vector<int32_t> triangles;
+    for (int i = 0; i <= NUM_RINGS; ++i)
+    {
+        for (int j = 0; j < NUM_RINGS; ++j)
+        {
+            float theta = M_PI * i / NUM_RINGS, phi = 2.0 * M_PI * j / NUM_RINGS;
+            coords.push_back(RADIUS * sin(theta) * cos(phi));
+            coords.push_back(RADIUS * sin(theta) * sin(phi));
+            coords.push_back(RADIUS * cos(theta));
+        }
+    }
+    for (int i = 0; i < NUM_RINGS; ++i)
+    {
+        for (int j = 0; j < NUM_RINGS; ++j)
+        {
+            int32_t a = i * NUM_RINGS + j, b = i * NUM_RINGS + (j + 1) % NUM_RINGS;
+            int32_t c = a + NUM_RINGS, d = b + NUM_RINGS;
+            if (i != 0)
+            {
+                triangles.push_back(a); triangles.push_back(b); triangles.push_back(d);
+            }
+            if (i != NUM_RINGS - 1)
+            {
+                triangles.push_back(a); triangles.push_back(d); triangles.push_back(c);
+            }
+        }
+    }
+    for (int i = 0; i < NUM_SOUP; ++i)
+    {
+        float center[3] = { coordDist(myRand), coordDist(myRand), coordDist(myRand) };
+        for (int v = 0; v < 3; ++v)
+        {
+            triangles.push_back((int32_t)(coords.size() / 3));
+            for (int axis = 0; axis < 3; ++axis) coords.push_back(center[axis] + offsetDist(myRand));
+        }
+    }
+    const int32_t numTriangles = (int32_t)(triangles.size() / 3);
+    CaretTriangleLocator myLocator(coords.data(), (int64_t)(coords.size() / 3), triangles.data(), numTriangles);
+    const double TOLERANCE = 1e-3;
+    for (int q = 0; q < NUM_QUERIES && !failed(); ++q)
+    {
+        float start[3], end[3], direction[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            start[i] = coordDist(myRand);
+            end[i] = coordDist(myRand);
+            direction[i] = end[i] - start[i];
+        }
+        double length = sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+        double bestT = -1.0;
+        vector<double> triangleT(numTriangles, -1.0);
+        for (int32_t t = 0; t < numTriangles; ++t)
+        {
+            double thisT;
+            if (bruteForceHit(coords, triangles, t, start, direction, thisT))
+            {
+                triangleT[t] = thisT;
+                if (bestT < 0.0 || thisT < bestT) bestT = thisT;
+            }
+        }
+        for (int segment = 0; segment < 2; ++segment)
+        {
+            TriangleRayHit myHit;
+            bool hit, expectHit;
+            if (segment == 0)
+            {
+                hit = myLocator.rayIntersects(start, direction, &myHit);
+                expectHit = (bestT >= 0.0);
+            } else {
+                hit = myLocator.lineSegmentIntersects(start, end, &myHit);
+                expectHit = (bestT >= 0.0 && bestT <= 1.0);
+            }
+            AString which = (segment == 0 ? "ray " : "segment ") + AString::number(q);
+            if (hit != expectHit)
+            {
+                setFailed(which + (hit ? " hit a triangle when nothing is in the way" : " missed a triangle"));
+                continue;
+            }
+            if (!hit)
+            {
+                if (myHit.triangle != -1) setFailed(which + " reported a triangle without a hit");
+                continue;
+            }
+            if (myHit.triangle < 0 || myHit.triangle >= numTriangles)
+            {
+                setFailed(which + " reported an invalid triangle");
+                continue;
+            }
+            if (abs(myHit.distance - bestT * length) > TOLERANCE)
+            {
+                setFailed(which + " hit at distance " + AString::number(myHit.distance) + ", closest triangle is at " + AString::number(bestT * length));
+            }
+            //ties on shared edges can go to either triangle, but the reported triangle must actually be hit at the closest distance
+            if (myHit.triangle != -1 && (triangleT[myHit.triangle] < 0.0 || (triangleT[myHit.triangle] - bestT) * length > TOLERANCE))
+            {
+                setFailed(which + " reported triangle " + AString::number(myHit.triangle) + ", which is not the closest one hit");
+            }
+            for (int i = 0; i < 3; ++i)
+            {
+                if (abs(myHit.xyz[i] - (start[i] + bestT * direction[i])) > TOLERANCE) setFailed(which + " reported the wrong hit coordinates");
+            }
+            //the soup has plenty of obtuse triangles, where the largest barycentric weight can be on a farther vertex
+            double vertexDist[3], nearestDist = -1.0;
+            for (int v = 0; v < 3; ++v)
+            {
+                int32_t vertex = triangles[myHit.triangle * 3 + v];
+                double dist2 = 0.0;
+                for (int i = 0; i < 3; ++i)
+                {
+                    double diff = coords[vertex * 3 + i] - myHit.xyz[i];
+                    dist2 += diff * diff;
+                }
+                vertexDist[v] = sqrt(dist2);
+                if (vertex == myHit.nearestVertex) nearestDist = vertexDist[v];
+            }
+            if (nearestDist < 0.0)
+            {
+                setFailed(which + " reported nearest vertex " + AString::number(myHit.nearestVertex) + ", which is not in the hit triangle");
+            } else if (nearestDist > min(min(vertexDist[0], vertexDist[1]), vertexDist[2]) + TOLERANCE) {
+                setFailed(which + " reported a nearest vertex that is farther from the hit than another vertex of the triangle");
+            }
+        }
+    }
+}
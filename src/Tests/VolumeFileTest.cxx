@@ -22,6 +22,9 @@
 #include "FloatMatrix.h"
 #include "VolumeFile.h"
 
+#include <QTemporaryDir>
+
+#include <algorithm>
 #include <cstdlib>
 
 using namespace caret;
@@ -110,4 +113,104 @@ void VolumeFileTest::execute()
             }
         }
     }
+    checkOnDemandReading();
+}
+
+void VolumeFileTest::checkOnDemandReading()
+{
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid())
+    {
+        setFailed("unable to create temporary directory");
+        return;
+    }
+    AString fileName = tempDir.path() + "/wb_on_demand_test.nii";
+    vector<int64_t> myDims;
+    myDims.push_back(10);
+    myDims.push_back(9);
+    myDims.push_back(8);
+    myDims.push_back(40);//enough frames that a small cache must evict
+    FloatMatrix indexSpace = FloatMatrix::identity(4);
+    VolumeFile inMemory(myDims, indexSpace.getMatrix());
+    const int64_t frameSize = myDims[0] * myDims[1] * myDims[2];
+    vector<float> frame(frameSize);
+    for (int64_t b = 0; b < myDims[3]; ++b)
+    {
+        for (int64_t i = 0; i < frameSize; ++i)
+        {
+            frame[i] = (float)(rand() % 10000) - 5000.0f;
+        }
+        inMemory.setFrame(frame.data(), b);
+    }
+    inMemory.writeFile(fileName);
+    const int64_t oldCacheBytes = VolumeFile::getOnDiskFrameCacheBytes();
+    VolumeFile::setOnDiskFrameCacheBytes(frameSize * sizeof(float) * 10);//10 frames
+    VolumeFile onDemand;
+    onDemand.setPreferOnDiskReading(true);
+    try
+    {
+        onDemand.readFile(fileName);
+    } catch (...) {
+        VolumeFile::setOnDiskFrameCacheBytes(oldCacheBytes);
+        throw;
+    }
+    VolumeFile::setOnDiskFrameCacheBytes(oldCacheBytes);
+    if (!onDemand.isReadingFramesOnDemand())
+    {
+        setFailed("volume larger than the frame cache was not read on demand");
+        return;
+    }
+    CaretArray<float> frameHold;
+    const float* heldFrame = onDemand.getFrame(3, 0, frameHold);//keep one frame while the rest of the file cycles through the cache
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (int64_t b = 0; b < myDims[3]; ++b)
+        {
+            for (int64_t k = 0; k < myDims[2]; ++k)
+            {
+                for (int64_t j = 0; j < myDims[1]; ++j)
+                {
+                    for (int64_t i = 0; i < myDims[0]; ++i)
+                    {
+                        if (onDemand.getValue(i, j, k, b) != inMemory.getValue(i, j, k, b))
+                        {
+                            setFailed("on-demand value differs at (" + AString::number(i) + ", " + AString::number(j) + ", " + AString::number(k) + ", " + AString::number(b) + ")");
+                            return;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    const float* expectFrame = inMemory.getFrame(3);
+    if (!equal(expectFrame, expectFrame + frameSize, heldFrame))
+    {
+        setFailed("held frame changed after being evicted from the cache");
+    }
+    vector<float> onDemandSeries(myDims[3]), inMemorySeries(myDims[3]);
+    for (int test = 0; test < 20; ++test)
+    {
+        int64_t ijk[3] = { rand() % myDims[0], rand() % myDims[1], rand() % myDims[2] };
+        onDemand.getValueAllBricks(onDemandSeries.data(), ijk);
+        inMemory.getValueAllBricks(inMemorySeries.data(), ijk);
+        if (onDemandSeries != inMemorySeries)
+        {
+            setFailed("on-demand values across bricks differ at (" + AString::number(ijk[0]) + ", " + AString::number(ijk[1]) + ", " + AString::number(ijk[2]) + ")");
+            break;
+        }
+    }
+    float onDemandMin, onDemandMax, inMemoryMin, inMemoryMax;
+    onDemand.getDataRangeFromAllMaps(onDemandMin, onDemandMax);
+    inMemory.getDataRangeFromAllMaps(inMemoryMin, inMemoryMax);
+    if (onDemandMin != inMemoryMin || onDemandMax != inMemoryMax)
+    {
+        setFailed("on-demand data range differs from fully loaded volume");
+    }
+    vector<float> onDemandData, inMemoryData;
+    onDemand.getFileData(onDemandData);
+    inMemory.getFileData(inMemoryData);
+    if (onDemandData != inMemoryData)
+    {
+        setFailed("on-demand file data differs from fully loaded volume");
+    }
 }
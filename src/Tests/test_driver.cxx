@@ -33,20 +33,34 @@
 #include "CaretException.h"
 
 //tests
+#include "Base64Test.h"
 #include "CiftiFileTest.h"
+#include "ConnectedComponentsTest.h"
 #include "DotTest.h"
+#include "GeodesicBenchTest.h"
 #include "GeodesicHelperTest.h"
+#include "GeodesicQueueTest.h"
+#include "GzipIndexTest.h"
 #include "HttpTest.h"
 #include "HeapTest.h"
+#include "KdTreeTest.h"
 #include "LookupTest.h"
 #include "MathExpressionTest.h"
+#include "MetricSmoothingTest.h"
 #include "NiftiTest.h"
+#include "PaletteTest.h"
 #include "PointerTest.h"
 #include "ProgressTest.h"
 #include "QuatTest.h"
+#include "ReductionTest.h"
+#include "RibbonMappingTest.h"
+#include "SignedDistanceTest.h"
+#include "SparseFileTest.h"
 #include "StatisticsTest.h"
+#include "TFCEPermutationTest.h"
 #include "TimerTest.h"
 #include "TopologyHelperTest.h"
+#include "TriangleLocatorTest.h"
 #include "VolumeFileTest.h"
 #include "XnatTest.h"
 
@@ -69,21 +83,35 @@ int main(int argc, char** argv)
         caret_global_commandLine_init(argc, argv);
         SessionManager::createSessionManager(ApplicationTypeEnum::APPLICATION_TYPE_COMMAND_LINE);
         vector<TestInterface*> mytests;
+        mytests.push_back(new Base64Test("base64"));
         mytests.push_back(new CiftiFileTest("ciftifile"));
+        mytests.push_back(new ConnectedComponentsTest("connectedcomponents"));
         mytests.push_back(new DotTest("dotsimd"));
+        mytests.push_back(new GeodesicBenchTest("geodesicbench"));//benchmark, not added to ctest
         mytests.push_back(new GeodesicHelperTest("geohelp"));
+        mytests.push_back(new GeodesicQueueTest("geodesicqueue"));
+        mytests.push_back(new GzipIndexTest("gzipindex"));
         mytests.push_back(new HeapTest("heap"));
         mytests.push_back(new HttpTest("http"));
+        mytests.push_back(new KdTreeTest("kdtree"));
         mytests.push_back(new LookupTest("lookup"));
         mytests.push_back(new MathExpressionTest("mathexpression"));
+        mytests.push_back(new MetricSmoothingTest("metricsmoothing"));
         mytests.push_back(new NiftiFileTest("niftifile"));
         mytests.push_back(new NiftiHeaderTest("niftiheader"));
+        mytests.push_back(new PaletteTest("palette"));
         mytests.push_back(new PointerTest("pointer"));
         mytests.push_back(new ProgressTest("progress"));
         mytests.push_back(new QuatTest("quaternion"));
+        mytests.push_back(new ReductionTest("reduction"));
+        mytests.push_back(new RibbonMappingTest("ribbonmapping"));
+        mytests.push_back(new SignedDistanceTest("signeddistance"));
+        mytests.push_back(new SparseFileTest("sparsefile"));
         mytests.push_back(new StatisticsTest("statistics"));
+        mytests.push_back(new TFCEPermutationTest("tfcepermutation"));
         mytests.push_back(new TimerTest("timer"));
         mytests.push_back(new TopologyHelperTest("topohelp"));
+        mytests.push_back(new TriangleLocatorTest("trianglelocator"));
         mytests.push_back(new VolumeFileTest("volumefile"));
         mytests.push_back(new XnatTest("xnat"));
         if (argc < 2)
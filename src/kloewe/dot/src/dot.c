@@ -12,6 +12,8 @@
 extern float  sdot  (const float  *a, const float  *b, int n);
 extern double ddot  (const double *a, const double *b, int n);
 extern double sddot (const float  *a, const float  *b, int n);
+extern void   sddot2x4 (const float *const *a, const float *const *b,
+                        int n, double *res);
 
 /*----------------------------------------------------------------------------
   Global Variables
@@ -19,6 +21,7 @@ extern double sddot (const float  *a, const float  *b, int n);
 sdot_func  *sdot_ptr  = &sdot_select;
 ddot_func  *ddot_ptr  = &ddot_select;
 sddot_func *sddot_ptr = &sddot_select;
+sddot2x4_func *sddot2x4_ptr = &sddot2x4_select;
 
 /*----------------------------------------------------------------------------
   Functions
@@ -39,6 +42,12 @@ double sddot_select (const float *a, const float *b, int n) {
   return (*sddot_ptr)(a,b,n);
 }
 
+void sddot2x4_select (const float *const *a, const float *const *b,
+                      int n, double *res) {
+  dot_set_impl(DOT_AUTO);
+  (*sddot2x4_ptr)(a,b,n,res);
+}
+
 dot_flags    dot_set_impl (dot_flags impl) {
   #ifndef DOT_NOFMA
   // the AVX-FMA implementations are currently slower than the AVX
@@ -47,6 +56,7 @@ dot_flags    dot_set_impl (dot_flags impl) {
     sdot_ptr  = &sdot_avxfma;
     ddot_ptr  = &ddot_avxfma;
     sddot_ptr = &sddot_avxfma;
+    sddot2x4_ptr = &sddot2x4_avxfma;
     return DOT_AVXFMA; }
   else if (hasAVX()              && (impl >= DOT_AVX)) {    // AVX
   #else
@@ -55,16 +65,19 @@ dot_flags    dot_set_impl (dot_flags impl) {
     sdot_ptr  = &sdot_avx;
     ddot_ptr  = &ddot_avx;
     sddot_ptr = &sddot_avx;
+    sddot2x4_ptr = &sddot2x4_avx;
     return DOT_AVX; }
   else if (hasSSE2()             && (impl >= DOT_SSE2)) {   // SSE2
     sdot_ptr  = &sdot_sse2;
     ddot_ptr  = &ddot_sse2;
     sddot_ptr = &sddot_sse2;
+    sddot2x4_ptr = &sddot2x4_sse2;
     return DOT_SSE2; }
   else {                                                    // naive
     sdot_ptr  = &sdot_naive;
     ddot_ptr  = &ddot_naive;
     sddot_ptr = &sddot_naive;
+    sddot2x4_ptr = &sddot2x4_naive;
     return DOT_NAIVE;
   }
 }
@@ -33,6 +33,8 @@ typedef enum {
 typedef float  (sdot_func)  (const float  *a, const float  *b, int n);
 typedef double (ddot_func)  (const double *a, const double *b, int n);
 typedef double (sddot_func) (const float  *a, const float  *b, int n);
+typedef void   (sddot2x4_func) (const float *const *a, const float *const *b,
+                                int n, double *res);
 
 /*----------------------------------------------------------------------------
   Global Variables
@@ -40,6 +42,7 @@ typedef double (sddot_func) (const float  *a, const float  *b, int n);
 extern sdot_func  *sdot_ptr;
 extern ddot_func  *ddot_ptr;
 extern sddot_func *sddot_ptr;
+extern sddot2x4_func *sddot2x4_ptr;
 
 /*----------------------------------------------------------------------------
   Function Prototypes
@@ -47,6 +50,23 @@ extern sddot_func *sddot_ptr;
 inline float  sdot         (const float  *a, const float  *b, int n);
 inline double ddot         (const double *a, const double *b, int n);
 inline double sddot        (const float  *a, const float  *b, int n);
+inline void   sddot2x4     (const float *const *a, const float *const *b,
+                            int n, double *res);
+
+/* sddot2x4
+ * --------
+ * register-blocked dot products of 2 vectors against 4 vectors
+ *
+ * Computes the 8 dot products a[i].b[j] in one pass over the data, so that
+ * every loaded element of a is reused 4 times and every loaded element of b
+ * is reused twice.  Intermediate sums are kept in double, as in sddot.
+ *
+ * parameters
+ * a    array of 2 pointers to vectors of length n
+ * b    array of 4 pointers to vectors of length n
+ * n    length of the vectors
+ * res  output array of 8 doubles, res[4*i+j] = a[i].b[j]
+ */
 
 /* dot_set_impl
  * ------------
@@ -73,24 +93,34 @@ extern dot_flags    dot_set_impl (dot_flags   impl);
 extern float  sdot_select  (const float  *a, const float  *b, int n);
 extern double ddot_select  (const double *a, const double *b, int n);
 extern double sddot_select (const float  *a, const float  *b, int n);
+extern void   sddot2x4_select (const float *const *a, const float *const *b,
+                               int n, double *res);
 
 #ifndef DOT_NOFMA
 extern float  sdot_avxfma  (const float  *a, const float  *b, int n);
 extern double ddot_avxfma  (const double *a, const double *b, int n);
 extern double sddot_avxfma (const float  *a, const float  *b, int n);
+extern void   sddot2x4_avxfma (const float *const *a, const float *const *b,
+                               int n, double *res);
 #endif
 
 extern float  sdot_avx     (const float  *a, const float  *b, int n);
 extern double ddot_avx     (const double *a, const double *b, int n);
 extern double sddot_avx    (const float  *a, const float  *b, int n);
+extern void   sddot2x4_avx (const float *const *a, const float *const *b,
+                            int n, double *res);
 
 extern float  sdot_sse2    (const float  *a, const float  *b, int n);
 extern double ddot_sse2    (const double *a, const double *b, int n);
 extern double sddot_sse2   (const float  *a, const float  *b, int n);
+extern void   sddot2x4_sse2 (const float *const *a, const float *const *b,
+                             int n, double *res);
 
 extern float  sdot_naive   (const float  *a, const float  *b, int n);
 extern double ddot_naive   (const double *a, const double *b, int n);
 extern double sddot_naive  (const float  *a, const float  *b, int n);
+extern void   sddot2x4_naive (const float *const *a, const float *const *b,
+                              int n, double *res);
 
 /*----------------------------------------------------------------------------
   Inline Functions
@@ -108,6 +138,11 @@ inline double sddot (const float *a, const float *b, int n) {
   return (*sddot_ptr)(a,b,n);
 }
 
+inline void sddot2x4 (const float *const *a, const float *const *b,
+                      int n, double *res) {
+  (*sddot2x4_ptr)(a,b,n,res);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -19,10 +19,14 @@
 inline float  sdot_avxfma  (const float  *a, const float  *b, int n);
 inline double ddot_avxfma  (const double *a, const double *b, int n);
 inline double sddot_avxfma (const float  *a, const float  *b, int n);
+inline void   sddot2x4_avxfma (const float *const *a, const float *const *b,
+                               int n, double *res);
 #else
 inline float  sdot_avx     (const float  *a, const float  *b, int n);
 inline double ddot_avx     (const double *a, const double *b, int n);
 inline double sddot_avx    (const float  *a, const float  *b, int n);
+inline void   sddot2x4_avx (const float *const *a, const float *const *b,
+                            int n, double *res);
 #endif
 
 /*----------------------------------------------------------------------------
@@ -136,4 +140,84 @@ inline double sddot_avx    (const float *a, const float *b, int n)
   return s;
 }  // sddot_avx()
 
+/*--------------------------------------------------------------------------*/
+
+// --- 2x4 block of dot products (input: single; intermediate: double)
+#ifdef __FMA__
+inline void sddot2x4_avxfma (const float *const *a, const float *const *b,
+                             int n, double *res)
+#else
+inline void sddot2x4_avx    (const float *const *a, const float *const *b,
+                             int n, double *res)
+#endif
+{
+  // initialize 4 sums for each of the 8 dot products
+  __m256d s00 = _mm256_setzero_pd(), s01 = _mm256_setzero_pd();
+  __m256d s02 = _mm256_setzero_pd(), s03 = _mm256_setzero_pd();
+  __m256d s10 = _mm256_setzero_pd(), s11 = _mm256_setzero_pd();
+  __m256d s12 = _mm256_setzero_pd(), s13 = _mm256_setzero_pd();
+  const float *a0 = a[0], *a1 = a[1];
+  const float *b0 = b[0], *b1 = b[1], *b2 = b[2], *b3 = b[3];
+
+  // in each iteration, load 4 elements of each of the 6 vectors once, and
+  // add 1 product to each of the 4 sums of all 8 dot products (8 accumulator
+  // and 6 operand registers, which fits in the 16 AVX registers)
+  for (int k = 0, nq = 4*(n/4); k < nq; k += 4) {
+    #ifdef __FMA__
+    __m256d va0 = _mm256_cvtps_pd(_mm_loadu_ps(a0+k));
+    __m256d va1 = _mm256_cvtps_pd(_mm_loadu_ps(a1+k));
+    __m256d vb  = _mm256_cvtps_pd(_mm_loadu_ps(b0+k));
+    s00 = _mm256_fmadd_pd(va0, vb, s00);
+    s10 = _mm256_fmadd_pd(va1, vb, s10);
+    vb  = _mm256_cvtps_pd(_mm_loadu_ps(b1+k));
+    s01 = _mm256_fmadd_pd(va0, vb, s01);
+    s11 = _mm256_fmadd_pd(va1, vb, s11);
+    vb  = _mm256_cvtps_pd(_mm_loadu_ps(b2+k));
+    s02 = _mm256_fmadd_pd(va0, vb, s02);
+    s12 = _mm256_fmadd_pd(va1, vb, s12);
+    vb  = _mm256_cvtps_pd(_mm_loadu_ps(b3+k));
+    s03 = _mm256_fmadd_pd(va0, vb, s03);
+    s13 = _mm256_fmadd_pd(va1, vb, s13);
+    #else
+    __m128 va0 = _mm_loadu_ps(a0+k);
+    __m128 va1 = _mm_loadu_ps(a1+k);
+    __m128 vb  = _mm_loadu_ps(b0+k);
+    s00 = _mm256_add_pd(_mm256_cvtps_pd(_mm_mul_ps(va0, vb)), s00);
+    s10 = _mm256_add_pd(_mm256_cvtps_pd(_mm_mul_ps(va1, vb)), s10);
+    vb  = _mm_loadu_ps(b1+k);
+    s01 = _mm256_add_pd(_mm256_cvtps_pd(_mm_mul_ps(va0, vb)), s01);
+    s11 = _mm256_add_pd(_mm256_cvtps_pd(_mm_mul_ps(va1, vb)), s11);
+    vb  = _mm_loadu_ps(b2+k);
+    s02 = _mm256_add_pd(_mm256_cvtps_pd(_mm_mul_ps(va0, vb)), s02);
+    s12 = _mm256_add_pd(_mm256_cvtps_pd(_mm_mul_ps(va1, vb)), s12);
+    vb  = _mm_loadu_ps(b3+k);
+    s03 = _mm256_add_pd(_mm256_cvtps_pd(_mm_mul_ps(va0, vb)), s03);
+    s13 = _mm256_add_pd(_mm256_cvtps_pd(_mm_mul_ps(va1, vb)), s13);
+    #endif
+  }
+
+  // compute horizontal sums, 2 dot products at a time
+  __m256d h;
+  h = _mm256_hadd_pd(s00, s01);   // (s00[0]+s00[1], s01[0]+s01[1], ...)
+  _mm_storeu_pd(res+0, _mm_add_pd(_mm256_castpd256_pd128(h),
+                                  _mm256_extractf128_pd(h, 1)));
+  h = _mm256_hadd_pd(s02, s03);
+  _mm_storeu_pd(res+2, _mm_add_pd(_mm256_castpd256_pd128(h),
+                                  _mm256_extractf128_pd(h, 1)));
+  h = _mm256_hadd_pd(s10, s11);
+  _mm_storeu_pd(res+4, _mm_add_pd(_mm256_castpd256_pd128(h),
+                                  _mm256_extractf128_pd(h, 1)));
+  h = _mm256_hadd_pd(s12, s13);
+  _mm_storeu_pd(res+6, _mm_add_pd(_mm256_castpd256_pd128(h),
+                                  _mm256_extractf128_pd(h, 1)));
+
+  // add the remaining products
+  for (int k = 4*(n/4); k < n; k++) {
+    res[0] += a0[k] * b0[k]; res[1] += a0[k] * b1[k];
+    res[2] += a0[k] * b2[k]; res[3] += a0[k] * b3[k];
+    res[4] += a1[k] * b0[k]; res[5] += a1[k] * b1[k];
+    res[6] += a1[k] * b2[k]; res[7] += a1[k] * b3[k];
+  }
+}  // sddot2x4_avx()
+
 #endif // DOT_AVX_H
@@ -12,6 +12,8 @@
 inline float  sdot_naive  (const float  *a, const float  *b, int n);
 inline double ddot_naive  (const double *a, const double *b, int n);
 inline double sddot_naive (const float  *a, const float  *b, int n);
+inline void   sddot2x4_naive (const float *const *a, const float *const *b,
+                              int n, double *res);
 
 /*----------------------------------------------------------------------------
   Inline Functions
@@ -60,4 +62,21 @@ inline double sddot_naive (const float *a, const float *b, int n)
   return sum;
 }  // sddot_naive()
 
+/*--------------------------------------------------------------------------*/
+
+// --- 2x4 block of dot products (input: single; intermediate: double)
+inline void sddot2x4_naive (const float *const *a, const float *const *b,
+                            int n, double *res)
+{
+  for (int i = 0; i < 8; i++)
+    res[i] = 0;
+  for (int k = 0; k < n; k++) {
+    for (int i = 0; i < 2; i++) {
+      float ai = a[i][k];
+      for (int j = 0; j < 4; j++)
+        res[4*i+j] += ai * b[j][k];
+    }
+  }
+}  // sddot2x4_naive()
+
 #endif // DOT_NAIVE_H
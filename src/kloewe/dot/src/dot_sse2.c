@@ -11,3 +11,5 @@
 extern float  sdot_sse2  (const float  *a, const float  *b, int n);
 extern double ddot_sse2  (const double *a, const double *b, int n);
 extern double sddot_sse2 (const float  *a, const float  *b, int n);
+extern void   sddot2x4_sse2 (const float *const *a, const float *const *b,
+                             int n, double *res);
@@ -39,6 +39,8 @@
 inline float  sdot_sse2  (const float  *a, const float  *b, int n);
 inline double ddot_sse2  (const double *a, const double *b, int n);
 inline double sddot_sse2 (const float  *a, const float  *b, int n);
+inline void   sddot2x4_sse2 (const float *const *a, const float *const *b,
+                             int n, double *res);
 
 /*----------------------------------------------------------------------------
   Inline Functions
@@ -188,4 +190,45 @@ inline double sddot_sse2 (const float *a, const float *b, int n)
   return s;
 }  // sddot_sse2()
 
+/*--------------------------------------------------------------------------*/
+
+// --- 2x4 block of dot products (input: single; intermediate: double)
+inline void sddot2x4_sse2 (const float *const *a, const float *const *b,
+                           int n, double *res)
+{
+  // initialize 2 sums for each of the 8 dot products
+  __m128d s[8];
+  for (int i = 0; i < 8; i++)
+    s[i] = _mm_setzero_pd();
+
+  // load 4 elements of each vector once, and use each load for 2 or 4
+  // products; the single precision products are converted to double in
+  // two halves, as in sddot_sse2
+  for (int k = 0, nq = 4*(n/4); k < nq; k += 4) {
+    __m128 a0 = _mm_loadu_ps(a[0]+k), a1 = _mm_loadu_ps(a[1]+k);
+    for (int j = 0; j < 4; j++) {
+      __m128 bj = _mm_loadu_ps(b[j]+k);
+      __m128 p0 = _mm_mul_ps(a0, bj), p1 = _mm_mul_ps(a1, bj);
+      s[j]   = _mm_add_pd(s[j], _mm_add_pd(_mm_cvtps_pd(p0),
+                          _mm_cvtps_pd(_mm_movehl_ps(p0, p0))));
+      s[4+j] = _mm_add_pd(s[4+j], _mm_add_pd(_mm_cvtps_pd(p1),
+                          _mm_cvtps_pd(_mm_movehl_ps(p1, p1))));
+    }
+  }
+
+  // compute horizontal sums and add the remaining products
+  for (int i = 0; i < 8; i++) {
+    #ifdef HORZSUM_SSE3
+    __m128d sh = _mm_hadd_pd(s[i], s[i]);
+    #else
+    __m128d sh = _mm_add_pd(s[i], _mm_shuffle_pd(s[i], s[i], 1));
+    #endif
+    res[i] = _mm_cvtsd_f64(sh);
+  }
+  for (int k = 4*(n/4); k < n; k++)
+    for (int i = 0; i < 2; i++)
+      for (int j = 0; j < 4; j++)
+        res[4*i+j] += a[i][k] * b[j][k];
+}  // sddot2x4_sse2()
+
 #endif // DOT_SSE2_H